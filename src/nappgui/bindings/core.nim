@@ -20,6 +20,7 @@ type
     ekEFILE
     ekEENTRY
     ekEEXIT
+    ekEREGEX
 
   sstate_t* {.cenum.} = enum
     ekSTOK
@@ -204,10 +205,12 @@ type
 
   Array*[T] {.importc.}   = object
   RBTree*[T] {.importc.}  = object
+  HashTab*[T] {.importc.} = object
   Buffer* {.importc.}     = object
   String* {.importc.}     = object
   Stream* {.importc.}     = object
   RegEx* {.importc.}      = object
+  RegExSet* {.importc.}   = object
   Event* {.importc.}      = object
   KeyBuf* {.importc.}     = object
   Listener* {.importc.}   = object
@@ -219,15 +222,22 @@ type
   EvFileDir* {.importc.}  = object
     pathname*: cstring
     level*: uint32_t
+  EvRegEx* {.importc.}    = object
+    line*: cstring
+    row*: uint32_t
+    start*: uint32_t
+    `end`*: uint32_t
   ResPack* {.importc.}    = object
   ResId* {.importc.}      = object
   Clock* {.importc.}      = object
+  HeapArena* {.importc.}  = object
 
   FPtr_remove* {.importc.} = proc(obj: pointer) {.noconv.}
   FPtr_event_handler* {.importc.} = proc(obj: pointer, evt: ptr Event) {.noconv.}
   FPtr_read* {.importc.} = proc(stream: ptr Stream): pointer {.noconv.}
   FPtr_read_init* {.importc.} = proc(stream: ptr Stream, obj: pointer) {.noconv.}
   FPtr_write* {.importc.} = proc(stream: ptr Stream, obj: pointer) {.noconv.}
+  FPtr_hash* {.importc.} = proc(obj: pointer): uint32_t {.noconv.}
 
 {. pop .} #====================================================================
 {. push importc, noconv, header: "nappgui/core/core.h" .}
@@ -244,6 +254,7 @@ proc core_finish*()
 
 proc heap_start_mt*()
 proc heap_end_mt*()
+proc heap_thread_end*()
 proc heap_verbose*(verbose: bool_t)
 proc heap_stats*(stats: bool_t)
 proc heap_leaks*(): bool_t
@@ -258,6 +269,8 @@ proc heap_aligned_calloc*(size: uint32_t, align: uint32_t,
 proc heap_aligned_realloc*(mem: ptr byte_t, size: uint32_t, new_size: uint32_t,
                            align: uint32_t, name: cstring): ptr byte_t
 proc heap_free*(mem: ptr ptr byte_t, size: uint32_t, name: cstring)                          
+proc heap_malloc64*(size: uint64_t, name: cstring): ptr byte_t
+proc heap_free64*(mem: ptr ptr byte_t, size: uint64_t, name: cstring)
 
 template mallocName(T: typedesc): cstring = ($T).cstring
 template genheapnew(T: typedesc, heapfunc: untyped): untyped =
@@ -302,6 +315,11 @@ template heap_delete_n*[T](obj: ptr ptr T, n: uint32_t) =
 
 proc heap_auditor_add*(name: cstring)
 proc heap_auditor_delete*(name: cstring)
+proc heap_arena_create*(chunk_size: uint32_t): ptr HeapArena
+proc heap_arena_destroy*(arena: ptr ptr HeapArena)
+proc heap_arena_push*(arena: ptr HeapArena)
+proc heap_arena_pop*(arena: ptr HeapArena)
+proc heap_arena_bytes*(arena: ptr HeapArena): uint64_t
 
 {. pop .} #====================================================================
 {. push importc, noconv, header: "nappgui/core/buffer.h" .}
@@ -309,9 +327,11 @@ proc heap_auditor_delete*(name: cstring)
 # Buffers
 
 proc buffer_create*(size: uint32_t): ptr Buffer
+proc buffer_create64*(size: uint64_t): ptr Buffer
 proc buffer_with_data*(data: ptr byte_t, size: uint32_t): ptr Buffer
 proc buffer_destroy*(buffer: ptr ptr Buffer)
 proc buffer_size*(buffer: ptr Buffer): uint32_t
+proc buffer_size64*(buffer: ptr Buffer): uint64_t
 proc buffer_data*(buffer: ptr Buffer): ptr byte_t
 proc buffer_const*(buffer: ptr Buffer): ptr byte_t
 
@@ -404,9 +424,15 @@ let
 proc stm_from_block*(data: ptr byte_t, size: uint32_t): ptr Stream
 proc stm_memory*(size: uint32_t): ptr Stream
 proc stm_from_file*(pathname: cstring, error: ptr ferror_t): ptr Stream
+proc stm_from_mmap*(pathname: cstring, error: ptr ferror_t): ptr Stream
 proc stm_to_file*(pathname: cstring, error: ptr ferror_t): ptr Stream
 proc stm_append_file*(pathname: cstring, error: ptr ferror_t): ptr Stream
 proc stm_socket*(socket: ptr Socket): ptr Stream
+proc stm_socket_async*(socket: ptr Socket): ptr Stream
+proc stm_sock_recv*(stm: ptr Stream): uint32_t
+proc stm_sock_available*(stm: ptr Stream): uint32_t
+proc stm_sock_pending*(stm: ptr Stream): uint32_t
+proc stm_sock_closed*(stm: ptr Stream): bool_t
 proc stm_close*(stm: ptr ptr Stream)
 proc stm_get_write_endian*(stm: ptr Stream): endian_t
 proc stm_get_read_endian*(stm: ptr Stream): endian_t
@@ -434,7 +460,9 @@ proc stm_corrupt*(stm: ptr Stream)
 proc stm_str*(stm: ptr Stream): ptr String
 proc stm_buffer*(stm: ptr Stream): ptr byte_t
 proc stm_buffer_size*(stm: ptr Stream): uint32_t
+proc stm_cache_size*(stm: ptr Stream, size: uint32_t)
 proc stm_write*(stm: ptr Stream, data: ptr byte_t, size: uint32_t)
+proc stm_write64*(stm: ptr Stream, data: ptr byte_t, size: uint64_t)
 proc stm_write_char*(stm: ptr Stream, codepoint: uint32_t)
 proc stm_printf*(stm: ptr Stream, format: cstring): uint32_t {.varargs.}
 proc stm_writef*(stm: ptr Stream, str: cstring): uint32_t
@@ -450,6 +478,7 @@ proc stm_write_u64*(stm: ptr Stream, value: uint64_t)
 proc stm_write_r32*(stm: ptr Stream, value: real32_t)
 proc stm_write_r64*(stm: ptr Stream, value: real64_t)
 proc stm_read*(stm: ptr Stream, data: ptr byte_t, size: uint32_t): uint32_t
+proc stm_read64*(stm: ptr Stream, data: ptr byte_t, size: uint64_t): uint64_t
 proc stm_read_char*(stm: ptr Stream): uint32_t
 proc stm_read_chars*(stm: ptr Stream, n: uint32_t): cstring
 proc stm_read_line*(stm: ptr Stream): cstring
@@ -477,10 +506,13 @@ proc stm_read_u64*(stm: ptr Stream): uint64_t
 proc stm_read_r32*(stm: ptr Stream): real32_t
 proc stm_read_r64*(stm: ptr Stream): real64_t
 proc stm_skip*(stm: ptr Stream, size: uint32_t)
+proc stm_skip64*(stm: ptr Stream, size: uint64_t)
+proc stm_peek*(stm: ptr Stream, size: ptr uint32_t): ptr byte_t
 proc stm_skip_bom*(stm: ptr Stream)
 proc stm_skip_token*(stm: ptr Stream, token: ltoken_t)
 proc stm_flush*(stm: ptr Stream)
 proc stm_pipe*(`from`: ptr Stream, to: ptr Stream, n: uint32_t)
+proc stm_pipe64*(`from`: ptr Stream, to: ptr Stream, n: uint64_t)
 
 template stm_read_enum*(stm: ptr Stream, T: typedesc[enum]): T =
   cast[T](stm_read_i32(stm))
@@ -554,6 +586,36 @@ proc rbtree_prev_ptr*[T: ptr](tree: ptr RBTree[T]): ptr byte_t
 proc rbtree_get_key*[T](tree: ptr RBTree[T]): cstring
 proc rbtree_check*[T](tree: ptr RBTree[T]): bool_t                                            
 
+{. pop .} #====================================================================
+{. push importc, noconv, header: "nappgui/core/hashtab.h" .}
+
+proc hashtab_create*[T](hash: FPtr_hash, cmp: FPtr_compare, esize: uint16_t,
+                        ty: cstring): ptr HashTab[T]
+proc hashtab_create_ptr*[T: ptr](hash: FPtr_hash, cmp: FPtr_compare,
+                                 ty: cstring): ptr HashTab[T]
+proc hashtab_read*[T](stream: ptr Stream, hash: FPtr_hash, cmp: FPtr_compare,
+                      esize: uint16_t, func_read_init: FPtr_read_init,
+                      ty: cstring): ptr HashTab[T]
+proc hashtab_read_ptr*[T: ptr](stream: ptr Stream, hash: FPtr_hash,
+                               cmp: FPtr_compare, func_read: FPtr_read,
+                               ty: cstring): ptr HashTab[T]
+proc hashtab_destroy*[T](tab: ptr ptr HashTab[T], rm: FPtr_remove, ty: cstring)
+proc hashtab_destroy_ptr*[T: ptr](tab: ptr ptr HashTab[T], destroy: FPtr_destroy,
+                                  ty: cstring)
+proc hashtab_clear*[T](tab: ptr HashTab[T], rm: FPtr_remove)
+proc hashtab_clear_ptr*[T: ptr](tab: ptr HashTab[T], destroy: FPtr_destroy)
+proc hashtab_write*[T](stream: ptr Stream, tab: ptr HashTab[T], func_write: FPtr_write)
+proc hashtab_size*[T](tab: ptr HashTab[T]): uint32_t
+proc hashtab_reserve*[T](tab: ptr HashTab[T], elems: uint32_t)
+proc hashtab_get*[T](tab: ptr HashTab[T], key: pointer): ptr byte_t
+proc hashtab_insert*[T](tab: ptr HashTab[T], key: pointer): ptr byte_t
+proc hashtab_insert_ptr*[T: ptr](tab: ptr HashTab[T], p: pointer): bool_t
+proc hashtab_delete*[T](tab: ptr HashTab[T], key: pointer, rm: FPtr_remove): bool_t
+proc hashtab_delete_ptr*[T: ptr](tab: ptr HashTab[T], key: pointer,
+                                 destroy: FPtr_destroy): bool_t
+proc hashtab_first*[T](tab: ptr HashTab[T], it: ptr uint32_t): ptr byte_t
+proc hashtab_next*[T](tab: ptr HashTab[T], it: ptr uint32_t): ptr byte_t
+
 {. pop .} #====================================================================
 {. push importc, noconv, header: "nappgui/core/regex.h" .}
 
@@ -562,6 +624,16 @@ proc rbtree_check*[T](tree: ptr RBTree[T]): bool_t
 proc regex_create*(pattern: cstring): ptr RegEx
 proc regex_destroy*(regex: ptr ptr RegEx)
 proc regex_match*(regex: ptr Regex, str: cstring): bool_t
+proc regex_search*(regex: ptr RegEx, str: cstring, start: ptr uint32_t,
+                   `end`: ptr uint32_t): bool_t
+proc regex_search_n*(regex: ptr RegEx, str: cstring, size: uint32_t,
+                     start: ptr uint32_t, `end`: ptr uint32_t): bool_t
+proc regex_search_stm*(regex: ptr RegEx, stm: ptr Stream,
+                       listener: ptr Listener): uint32_t
+proc regex_set_create*(patterns: cstringArray, n: uint32_t): ptr RegExSet
+proc regex_set_destroy*(set: ptr ptr RegExSet)
+proc regex_set_match*(set: ptr RegExSet, str: cstring, matches: ptr uint32_t,
+                      max: uint32_t): uint32_t
 
 {. pop .} #====================================================================
 {. push importc, noconv, header: "nappgui/core/dbind.h" .}
@@ -637,6 +709,10 @@ proc hfile_exists*(pathname: cstring, fileType: file_type_t): bool_t
 proc hfile_is_uptodate*(src: cstring, dest: cstring): bool_t
 proc hfile_copy*(pathFrom: cstring, pathTo: cstring, error: ptr ferror_t): bool_t
 proc hfile_buffer*(pathname: cstring, error: ptr ferror_t): ptr Buffer
+proc hfile_buffer64*(pathname: cstring, error: ptr ferror_t): ptr Buffer
+proc hfile_mmap*(pathname: cstring, size: ptr uint64_t,
+                 error: ptr ferror_t): ptr byte_t
+proc hfile_munmap*(data: ptr ptr byte_t, size: uint64_t)
 proc hfile_string*(pathname: cstring, error: ptr ferror_t): ptr String
 proc hfile_stream*(pathname: cstring, error: ptr ferror_t): ptr Stream
 proc hfile_from_string*(pathname: cstring, str: ptr String,
@@ -30,6 +30,12 @@ type
     ekBMP
     ekGIF
   
+  pixfilter_t* {.cenum.} = enum
+    ekPIXNEAREST = 1
+    ekPIXBILINEAR
+    ekPIXBICUBIC
+    ekPIXLANCZOS
+  
   fstyle_t* {.cenum.} = enum
     ekFNORMAL       = 0
     ekFBOLD         = 1
@@ -236,7 +242,7 @@ proc palette_gray2*(): ptr Palette
 proc palette_gray4*(): ptr Palette
 proc palette_gray8*(): ptr Palette
 proc palette_binary*(zero: color_t, one: color_t): ptr Palette
-proc palette_destoy*(palette: ptr ptr Palette)
+proc palette_destroy*(palette: ptr ptr Palette)
 proc palette_size*(palette: ptr Palette): uint32_t
 proc palette_colors*(palette: ptr Palette): ptr color_t
 proc palette_ccolors*(palette: ptr Palette): ptr color_t
@@ -253,6 +259,13 @@ proc pixbuf_trim*(pixbuf: ptr Pixbuf, x: uint32_t, y: uint32_t,
                   width: uint32_t, height: uint32_t): ptr Pixbuf           
 proc pixbuf_convert*(pixbuf: ptr Pixbuf, palette: ptr Palette,
                      oformat: pixformat_t): ptr Pixbuf
+proc pixbuf_quantize*(pixbuf: ptr Pixbuf, dither: bool_t,
+                      palette: ptr ptr Palette): ptr Pixbuf
+proc pixbuf_scale*(pixbuf: ptr Pixbuf, width: uint32_t, height: uint32_t,
+                   filter: pixfilter_t): ptr Pixbuf
+proc pixbuf_rotate*(pixbuf: ptr Pixbuf, angle: real32_t, nsize: bool_t,
+                    background: color_t, filter: pixfilter_t,
+                    t2d: ptr T2Df): ptr Pixbuf
 proc pixbuf_destroy*(pixbuf: ptr ptr Pixbuf)
 proc pixbuf_format*(pixbuf: ptr Pixbuf): pixformat_t
 proc pixbuf_width*(pixbuf: ptr Pixbuf): uint32_t
@@ -276,6 +289,11 @@ proc image_from_pixels*(width: uint32_t, height: uint32_t, format: pixformat_t,
 proc image_from_pixbuf*(pixbuf: ptr Pixbuf, palette: ptr Palette): ptr Image
 proc image_from_file*(pathname: cstring, error: ptr ferror_t): ptr Image
 proc image_from_data*(data: ptr byte_t, size: uint32_t): ptr Image
+proc image_from_data_scaled*(data: ptr byte_t, size: uint32_t, max_width: uint32_t,
+                             max_height: uint32_t): ptr Image
+proc image_probe*(data: ptr byte_t, size: uint32_t, codec: ptr codec_t,
+                  width: ptr uint32_t, height: ptr uint32_t,
+                  format: ptr pixformat_t, num_frames: ptr uint32_t): bool_t
 proc image_from_resource*(pack: ptr ResPack, id: ResId): ptr Image
 proc image_copy*(image: ptr Image): ptr Image
 proc image_trim*(image: ptr Image, x: uint32_t, y: uint32_t,
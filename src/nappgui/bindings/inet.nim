@@ -23,10 +23,44 @@ type
     ekIUNDEF
     ekIOK
 
+  inet_event_t* {.cenum.} = enum
+    ekEJSONELEM = 0x200
+
+  jevent_t* {.cenum.} = enum
+    ekJSON_BEGIN_OBJECT = 1
+    ekJSON_END_OBJECT
+    ekJSON_BEGIN_ARRAY
+    ekJSON_END_ARRAY
+    ekJSON_KEY
+    ekJSON_STRING
+    ekJSON_NUMBER
+    ekJSON_TRUE
+    ekJSON_FALSE
+    ekJSON_NULL
+    ekJSON_VALUE
+    ekJSON_EOF
+    ekJSON_ERROR
+
   Url* {.importc.}      = object
   Http* {.importc.}     = object
+  HttpPool* {.importc.} = object
   Json* {.importc.}     = object
   JsonOpts* {.importc.} = object
+    not_used*: uint32_t
+    arena*: ptr HeapArena
+  JsonReader* {.importc.} = object
+  JsonWriter* {.importc.} = object
+  EvJsonElem* {.importc.} = object
+    `type`*: cstring
+    mname*: cstring
+    etype*: cstring
+    index*: uint32_t
+    elem*: pointer
+
+  FPtr_http_done* {.importc.} = proc(data: pointer, http: ptr Http,
+                                     error: ierror_t) {.noconv.}
+  FPtr_http_chunk* {.importc.} = proc(data: pointer, chunk: ptr byte_t,
+                                      size: uint32_t) {.noconv.}
 
 {. pop .} #====================================================================
 {. push importc, noconv, header: "nappgui/inet/httpreq.h" .}
@@ -42,6 +76,18 @@ proc http_get*(http: ptr Http, path: cstring, data: ptr byte_t, size: uint32_t,
                error: ptr ierror_t): bool_t
 proc http_post*(http: ptr Http, path: cstring, data: ptr byte_t, size: uint32_t,
                 error: ptr ierror_t): bool_t               
+# macOS: the body stream is read into memory before sending the request
+proc http_post_stream*(http: ptr Http, path: cstring, body: ptr Stream,
+                       error: ptr ierror_t): bool_t
+# macOS: the whole body is delivered in a single call once the response completes
+proc http_response_chunks_imp*(http: ptr Http, data: pointer,
+                               func_chunk: ptr FPtr_http_chunk)
+template http_response_chunks*[T](
+  http: ptr Http,
+  data: ptr T,
+  func_chunk: ptr FPtr_http_chunk
+) =
+  http_response_chunks_imp(http, data, func_chunk)
 proc http_response_status*(http: ptr Http): uint32_t
 proc http_response_protocol*(http: ptr Http): cstring
 proc http_response_message*(http: ptr Http): cstring
@@ -54,6 +100,36 @@ proc http_response_body*(http: ptr Http, body: ptr Stream,
 proc http_dget*(url: cstring, result: ptr uint32_t,
                 error: ptr ierror_t): ptr Stream
 proc http_exists*(url: cstring)
+proc http_pool_create*(max_active: uint32_t,
+                       max_host_conns: uint32_t): ptr HttpPool
+proc http_pool_destroy*(pool: ptr ptr HttpPool)
+proc http_pool_add_header*(pool: ptr HttpPool, name: cstring, value: cstring)
+proc http_pool_get_imp*(pool: ptr HttpPool, url: cstring, body: ptr Stream,
+                        data: pointer,
+                        func_done: ptr FPtr_http_done): bool_t
+proc http_pool_post_imp*(pool: ptr HttpPool, url: cstring, content: ptr byte_t,
+                         size: uint32_t, body: ptr Stream, data: pointer,
+                         func_done: ptr FPtr_http_done): bool_t
+template http_pool_get*[T](
+  pool: ptr HttpPool,
+  url: cstring,
+  body: ptr Stream,
+  data: ptr T,
+  func_done: ptr FPtr_http_done
+): bool_t =
+  http_pool_get_imp(pool, url, body, data, func_done)
+template http_pool_post*[T](
+  pool: ptr HttpPool,
+  url: cstring,
+  content: ptr byte_t,
+  size: uint32_t,
+  body: ptr Stream,
+  data: ptr T,
+  func_done: ptr FPtr_http_done
+): bool_t =
+  http_pool_post_imp(pool, url, content, size, body, data, func_done)
+proc http_pool_run*(pool: ptr HttpPool, timeout_ms: uint32_t): uint32_t
+proc http_pool_wait*(pool: ptr HttpPool)
 
 {. pop .} #====================================================================
 {. push importc, noconv, header: "nappgui/inet/json.h" .}
@@ -65,6 +141,31 @@ proc json_write_imp*(stm: ptr Stream, data: pointer, opts: ptr JsonOpts,
                      ty: cstring)
 proc json_destroy_imp*(data: ptr pointer, ty: cstring)
 proc json_destopt_imp*(data: ptr pointer, ty: cstring)
+proc json_read_each_imp*(stm: ptr Stream, opts: ptr JsonOpts, ty: cstring,
+                         mname: cstring, listener: ptr Listener): pointer
+proc json_reader_create*(stm: ptr Stream): ptr JsonReader
+proc json_reader_destroy*(reader: ptr ptr JsonReader)
+proc json_reader_next*(reader: ptr JsonReader): jevent_t
+proc json_reader_event*(reader: ptr JsonReader): jevent_t
+proc json_reader_lexeme*(reader: ptr JsonReader, size: ptr uint32_t): cstring
+proc json_reader_depth*(reader: ptr JsonReader): uint32_t
+proc json_reader_skip*(reader: ptr JsonReader): bool_t
+proc json_reader_value_imp*(reader: ptr JsonReader, opts: ptr JsonOpts,
+                            ty: cstring): pointer
+proc json_writer_create*(stm: ptr Stream): ptr JsonWriter
+proc json_writer_destroy*(writer: ptr ptr JsonWriter)
+proc json_writer_begin_object*(writer: ptr JsonWriter)
+proc json_writer_end_object*(writer: ptr JsonWriter)
+proc json_writer_begin_array*(writer: ptr JsonWriter)
+proc json_writer_end_array*(writer: ptr JsonWriter)
+proc json_writer_key*(writer: ptr JsonWriter, name: cstring)
+proc json_writer_str*(writer: ptr JsonWriter, value: cstring)
+proc json_writer_int*(writer: ptr JsonWriter, value: int64_t)
+proc json_writer_uint*(writer: ptr JsonWriter, value: uint64_t)
+proc json_writer_real*(writer: ptr JsonWriter, value: real64_t)
+proc json_writer_bool*(writer: ptr JsonWriter, value: bool_t)
+proc json_writer_null*(writer: ptr JsonWriter)
+proc json_writer_value_imp*(writer: ptr JsonWriter, data: pointer, ty: cstring)
 
 {. pop .} #====================================================================
 {. push importc, noconv, header: "nappgui/inet/url.h" .}
@@ -109,6 +109,28 @@ type
     ekSSTREAM
     ekSUNDEF
     ekSOK
+    ekSAGAIN
+
+  sockev_t* {.cenum.} = enum
+    ekSOCK_READ = 1
+    ekSOCK_WRITE = 2
+    ekSOCK_CLOSE = 4
+    ekSOCK_ERROR = 8
+    ekSOCK_EDGE = 16
+
+  log_level_t* {.cenum.} = enum
+    ekLOG_TRACE = 1
+    ekLOG_DEBUG
+    ekLOG_INFO
+    ekLOG_WARN
+    ekLOG_ERROR
+
+  log_field_t* {.cenum.} = enum
+    ekLOG_INT = 1
+    ekLOG_UINT
+    ekLOG_REAL
+    ekLOG_BOOL
+    ekLOG_STR
 
 type
   Date* {.importc.}   = object
@@ -127,9 +149,28 @@ type
   DLib* {.importc.}   = object
   Thread* {.importc.} = object
   Socket* {.importc.} = object
+  SockPoll* {.importc.} = object
+
+  SockBuf* {.importc.} = object
+    data*: ptr byte_t
+    size*: uint32_t
+
+  LogFieldValue* {.union.} = object
+    i*: int64_t
+    u*: uint64_t
+    r*: real64_t
+    b*: bool_t
+    s*: cstring
+
+  LogField* {.importc.} = object
+    key*: cstring
+    `type`*: log_field_t
+    value*: LogFieldValue
   
   FPtr_thread_main* {.importc.} = proc(data: pointer): uint32_t {.noconv.}
   FPtr_libproc* {.importc.} = proc() {.noconv.}
+  FPtr_sock_event* {.importc.} = proc(data: pointer, socket: ptr Socket,
+                                      events: uint32_t) {.noconv.}
 
 {. pop .} # ===================================================================
 {. push importc, noconv, header: "nappgui/osbs/osbs.h" .}
@@ -168,10 +209,20 @@ proc bfile_read*(file: ptr File, data: ptr byte_t, size: uint32_t,
                  rsize: ptr uint32_t, error: ptr ferror_t): bool_t
 proc bfile_write*(file: ptr File, data: ptr byte_t, size: uint32_t,
                   wsize: ptr uint32_t, error: ptr ferror_t): bool_t
+proc bfile_read64*(file: ptr File, data: ptr byte_t, size: uint64_t,
+                   rsize: ptr uint64_t, error: ptr ferror_t): bool_t
+proc bfile_write64*(file: ptr File, data: ptr byte_t, size: uint64_t,
+                    wsize: ptr uint64_t, error: ptr ferror_t): bool_t
+proc bfile_copy*(`from`: ptr File, to: ptr File, size: uint64_t,
+                 csize: ptr uint64_t, error: ptr ferror_t): bool_t
 proc bfile_seek*(file: ptr File, offset: int64, whence: file_seek_t,
                  error: ptr ferror_t): bool_t
 proc bfile_pos*(file: ptr File): uint64
+proc bfile_mmap*(file: ptr File, offset: uint64_t, size: uint64_t,
+                 error: ptr ferror_t): ptr byte_t
+proc bfile_munmap*(data: ptr ptr byte_t, size: uint64_t)
 proc bfile_delete*(pathname: cstring, error: ptr ferror_t): bool_t
+proc bfile_rename*(`from`: cstring, to: cstring, error: ptr ferror_t): bool_t
 
 {. pop .} # ===================================================================
 {. push importc, noconv, header: "nappgui/osbs/bmutex.h" .}
@@ -207,17 +258,33 @@ proc bsocket_connect*(ip: uint32_t, port: uint16_t, timeout_ms: uint32_t,
                       error: ptr serror_t): ptr Socket
 proc bsocket_server*(port: uint16_t, max_connect: uint32_t,
                      error: ptr serror_t): ptr Socket
+proc bsocket_connect_host*(host: cstring, port: uint16_t, timeout_ms: uint32_t,
+                           error: ptr serror_t): ptr Socket
+proc bsocket_server_host*(host: cstring, port: uint16_t, max_connect: uint32_t,
+                          error: ptr serror_t): ptr Socket
 proc bsocket_accept*(socket: ptr Socket, timeout_ms: uint32_t,
                      error: ptr serror_t): ptr Socket
 proc bsocket_close*(socket: ptr ptr Socket)
 proc bsocket_local_ip*(socket: ptr Socket, ip: ptr uint32_t, port: ptr uint16_t)
 proc bsocket_remote_ip*(socket: ptr Socket, ip: ptr uint32_t, port: ptr uint16_t)
+proc bsocket_local_addr*(socket: ptr Socket, address: cstring, size: uint32_t,
+                         port: ptr uint16_t): bool_t
+proc bsocket_remote_addr*(socket: ptr Socket, address: cstring, size: uint32_t,
+                          port: ptr uint16_t): bool_t
 proc bsocket_read_timeout*(socket: ptr Socket, timeout_ms: uint32_t)
 proc bsocket_write_timeout*(socket: ptr Socket, timeout_ms: uint32_t)
+proc bsocket_nodelay*(socket: ptr Socket, nodelay: bool_t)
+proc bsocket_keepalive*(socket: ptr Socket, keepalive: bool_t, idle_s: uint32_t)
+proc bsocket_read_bufsize*(socket: ptr Socket, size: uint32_t)
+proc bsocket_write_bufsize*(socket: ptr Socket, size: uint32_t)
 proc bsocket_read*(socket: ptr Socket, data: ptr byte_t, size: uint32_t,
                    rsize: ptr uint32_t, error: ptr serror_t): bool_t
 proc bsocket_write*(socket: ptr Socket, data: ptr byte_t, size: uint32_t,
                     wsize: ptr uint32_t, error: ptr serror_t): bool_t                  
+proc bsocket_readv*(socket: ptr Socket, bufs: ptr SockBuf, n: uint32_t,
+                    rsize: ptr uint32_t, error: ptr serror_t): bool_t
+proc bsocket_writev*(socket: ptr Socket, bufs: ptr SockBuf, n: uint32_t,
+                     wsize: ptr uint32_t, error: ptr serror_t): bool_t
 proc bsocket_url_ip*(url: cstring, error: ptr serror_t): uint32_t
 proc bsocket_str_ip*(ip: cstring): uint32_t
 proc bsocket_host_name*(buffer: cstring, size: uint32_t): cstring
@@ -229,6 +296,24 @@ proc bsocket_hton8*(dest: ptr byte_t, src: ptr byte_t)
 proc bsocket_ntoh2*(dest: ptr byte_t, src: ptr byte_t)
 proc bsocket_ntoh4*(dest: ptr byte_t, src: ptr byte_t)
 proc bsocket_ntoh8*(dest: ptr byte_t, src: ptr byte_t)
+proc bsocket_nonblock*(socket: ptr Socket, nonblock: bool_t)
+proc bsocket_poll_create*(): ptr SockPoll
+proc bsocket_poll_destroy*(poll: ptr ptr SockPoll)
+proc bsocket_poll_add_imp*(poll: ptr SockPoll, socket: ptr Socket,
+                           events: uint32_t, data: pointer,
+                           func_event: ptr FPtr_sock_event): bool_t
+template bsocket_poll_add*[T](
+  poll: ptr SockPoll,
+  socket: ptr Socket,
+  events: uint32_t,
+  data: ptr T,
+  func_event: ptr FPtr_sock_event
+): bool_t =
+  bsocket_poll_add_imp(poll, socket, events, data, func_event)
+proc bsocket_poll_mod*(poll: ptr SockPoll, socket: ptr Socket,
+                       events: uint32_t): bool_t
+proc bsocket_poll_remove*(poll: ptr SockPoll, socket: ptr Socket)
+proc bsocket_poll_wait*(poll: ptr SockPoll, timeout_ms: uint32_t): uint32_t
 
 {. pop .} # ===================================================================
 {. push importc, noconv, header: "nappgui/osbs/bthread.h" .}
@@ -274,5 +359,26 @@ proc log_printf*(format: cstring): uint32_t {.varargs.}
 proc log_output*(std: bool_t, err: bool_t)
 proc log_file*(pathname: cstring)
 proc log_get_file*(): cstring
+proc log_async*(async: bool_t)
+proc log_rotate*(max_size: uint64_t, max_seconds: uint32_t, max_files: uint32_t)
+proc log_flush*()
+proc log_level*(level: log_level_t)
+proc log_category*(category: cstring, level: log_level_t)
+proc log_enabled*(level: log_level_t, category: cstring): bool_t
+proc log_msg*(level: log_level_t, category: cstring, format: cstring) {.varargs.}
+proc log_trace*(category: cstring, format: cstring) {.varargs.}
+proc log_debug*(category: cstring, format: cstring) {.varargs.}
+proc log_info*(category: cstring, format: cstring) {.varargs.}
+proc log_warn*(category: cstring, format: cstring) {.varargs.}
+proc log_error*(category: cstring, format: cstring) {.varargs.}
+proc log_fields*(level: log_level_t, category: cstring, message: cstring,
+                 fields: ptr LogField, nfields: uint32_t)
+proc log_int*(key: cstring, value: int64_t): LogField
+proc log_uint*(key: cstring, value: uint64_t): LogField
+proc log_real*(key: cstring, value: real64_t): LogField
+proc log_bool*(key: cstring, value: bool_t): LogField
+proc log_str*(key: cstring, value: cstring): LogField
+proc log_binary*(binary: bool_t)
+proc log_decode*(binpath: cstring, txtpath: cstring, error: ptr ferror_t): bool_t
 
 {. pop .} # ===================================================================
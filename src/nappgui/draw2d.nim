@@ -583,7 +583,7 @@ proc `=destroy`*(p: var Palette) =
   ## Destructor for `Palette`. Destroys the NAppGUI Palette reference.
   ##
   if p.impl != nil:
-    palette_destoy(p.impl.addr)
+    palette_destroy(p.impl.addr)
 proc `=copy`*(d: var Palette, s: Palette) {.error.}
   ## The Palette object is not copyable.
   ##
@@ -700,6 +700,15 @@ proc init*(T: typedesc[Pixbuf], pixbuf: Pixbuf, palette: Palette,
   ##
   result.impl = pixbuf_convert(pixbuf.impl, palette.impl, castEnum(format, pixformat_t))
 
+proc quantize*(pixbuf: Pixbuf, palette: var Palette, dither = false): Pixbuf =
+  ## Converts an rgb24 or rgba32 pixbuf to the smallest indexed format. Images
+  ## with more than 256 colors are reduced to a 256 color palette, with
+  ## optional Floyd-Steinberg dithering. The palette is returned in `palette`.
+  ##
+  `=destroy`(palette)
+  palette.impl = nil
+  result.impl = pixbuf_quantize(pixbuf.impl, dither.bool_t, palette.impl.addr)
+
 template format*(pixbuf: Pixbuf): Pixformat =
   ## Get the format of the pixbuf.
   ##
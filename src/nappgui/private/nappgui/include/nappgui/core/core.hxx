@@ -22,7 +22,8 @@ typedef enum _core_event_t
     ekEASSERT = 0x100,
     ekEFILE,
     ekEENTRY,
-    ekEEXIT
+    ekEEXIT,
+    ekEREGEX
 } core_event_t;
 
 typedef enum _sstate_t
@@ -222,26 +223,34 @@ typedef struct _string_t String;
 typedef struct _stream_t Stream;
 typedef struct _array_t Array;
 typedef struct _rbtree_t RBTree;
+typedef struct _hashtab_t HashTab;
 typedef struct _regex RegEx;
+typedef struct _regexset RegExSet;
 typedef struct _event_t Event;
 typedef struct _keybuf_t KeyBuf;
 typedef struct _listener_t Listener;
 typedef struct _direntry_t DirEntry;
 typedef struct _evfiledir_t EvFileDir;
+typedef struct _evregex_t EvRegEx;
 typedef struct _respack ResPack;
 typedef const char_t* ResId;
 typedef struct _clock_t Clock;
 typedef struct _object_t Object;
+typedef struct _heaparena_t HeapArena;
 
 #define HEAPARR         "::arr"
 #define ARRST           "ArrSt::"
 #define ARRPT           "ArrPt::"
 #define SETST           "SetSt::"
 #define SETPT           "SetPt::"
+#define HASHST          "HashSt::"
+#define HASHPT          "HashPt::"
 #define ArrPt(type)     struct Arr##Pt##type
 #define ArrSt(type)     struct Arr##St##type
 #define SetPt(type)     struct Set##Pt##type
 #define SetSt(type)     struct Set##St##type
+#define HashPt(type)    struct Hash##Pt##type
+#define HashSt(type)    struct Hash##St##type
 
 typedef void(*FPtr_remove)(void *obj);
 #define FUNC_CHECK_REMOVE(func, type)\
@@ -263,6 +272,10 @@ typedef void(*FPtr_write)(Stream *stream, const void *obj);
 #define FUNC_CHECK_WRITE(func, type)\
     (void)((void(*)(Stream*, const type*))func == func)
 
+typedef uint32_t(*FPtr_hash)(const void *obj);
+#define FUNC_CHECK_HASH(func, type)\
+    (void)((uint32_t(*)(const type*))func == func)
+
 /* Do not use! only for debugger inspection */
 struct _buffer_t
 {
@@ -296,24 +309,39 @@ struct _evfiledir_t
     uint32_t depth;
 };
 
+struct _evregex_t
+{
+    const char_t *line;
+    uint32_t row;
+    uint32_t start;
+    uint32_t end;
+};
+
 #include "nappgui/core/array.h"
 #include "nappgui/core/rbtree.h"
+#include "nappgui/core/hashtab.h"
 #include "nappgui/core/arrst.hxx"
 #include "nappgui/core/arrpt.hxx"
 #include "nappgui/core/setst.hxx"
 #include "nappgui/core/setpt.hxx"
+#include "nappgui/core/hashst.hxx"
+#include "nappgui/core/hashpt.hxx"
 
 #define DeclSt(type)\
     ArrStDebug(type);\
     SetStDebug(type);\
+    HashStDebug(type);\
     ArrStFuncs(type);\
-    SetStFuncs(type)
+    SetStFuncs(type);\
+    HashStFuncs(type)
 
 #define DeclPt(type)\
     ArrPtDebug(type);\
     SetPtDebug(type);\
+    HashPtDebug(type);\
     ArrPtFuncs(type);\
-    SetPtFuncs(type)
+    SetPtFuncs(type);\
+    HashPtFuncs(type)
 
 DeclSt(bool_t);
 DeclSt(int8_t);
@@ -0,0 +1,121 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: nappgui/core/hashst.hxx
+ *
+ */
+
+/* Hash table macros for type checking at compile time */
+
+#define HashStDebug(type)\
+struct Hash##St##type\
+{\
+    uint32_t elems;\
+    uint32_t used;\
+    uint32_t capacity;\
+    uint16_t esize;\
+    uint16_t isptr;\
+    uint32_t *hashes;\
+    type *data;\
+    FPtr_hash func_hash;\
+    FPtr_compare func_compare;\
+}
+
+#define HashStFuncs(type)\
+HashSt(type);\
+\
+static __TYPECHECK HashSt(type)* hashst_##type##_create(uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), const uint16_t esize);\
+static HashSt(type)* hashst_##type##_create(uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), const uint16_t esize)\
+{\
+    return (HashSt(type)*)hashtab_create((FPtr_hash)func_hash, (FPtr_compare)func_compare, esize, (const char_t*)(HASHST#type));\
+}\
+\
+static __TYPECHECK HashSt(type)* hashst_##type##_read(Stream *stream, uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), const uint16_t esize, void(func_read)(Stream*, type*));\
+static HashSt(type)* hashst_##type##_read(Stream *stream, uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), const uint16_t esize, void(func_read)(Stream*, type*))\
+{\
+    return (HashSt(type)*)hashtab_read(stream, (FPtr_hash)func_hash, (FPtr_compare)func_compare, esize, (FPtr_read_init)func_read, (const char_t*)(HASHST#type));\
+}\
+\
+static __TYPECHECK void hashst_##type##_destroy(struct Hash##St##type **table, void(func_remove)(type*));\
+static void hashst_##type##_destroy(struct Hash##St##type **table, void(func_remove)(type*))\
+{\
+    hashtab_destroy((HashTab**)table, (FPtr_remove)func_remove, (const char_t*)(HASHST#type));\
+}\
+\
+static __TYPECHECK void hashst_##type##_clear(struct Hash##St##type *table, void(func_remove)(type*));\
+static void hashst_##type##_clear(struct Hash##St##type *table, void(func_remove)(type*))\
+{\
+    hashtab_clear((HashTab*)table, (FPtr_remove)func_remove);\
+}\
+\
+static __TYPECHECK void hashst_##type##_write(Stream *stream, const struct Hash##St##type *table, void(func_write)(Stream*, const type*));\
+static void hashst_##type##_write(Stream *stream, const struct Hash##St##type *table, void(func_write)(Stream*, const type*))\
+{\
+	hashtab_write(stream, (const HashTab*)table, (FPtr_write)func_write);\
+}\
+\
+static __TYPECHECK uint32_t hashst_##type##_size(const struct Hash##St##type *table);\
+static uint32_t hashst_##type##_size(const struct Hash##St##type *table)\
+{\
+	return hashtab_size((const HashTab*)table);\
+}\
+\
+static __TYPECHECK void hashst_##type##_reserve(struct Hash##St##type *table, const uint32_t elems);\
+static void hashst_##type##_reserve(struct Hash##St##type *table, const uint32_t elems)\
+{\
+	hashtab_reserve((HashTab*)table, elems);\
+}\
+\
+static __TYPECHECK type *hashst_##type##_get(struct Hash##St##type *table, const type *key);\
+static type *hashst_##type##_get(struct Hash##St##type *table, const type *key)\
+{\
+	return (type*)hashtab_get((const HashTab*)table, (const void*)key);\
+}\
+\
+static __TYPECHECK const type *hashst_##type##_get_const(const struct Hash##St##type *table, const type *key);\
+static const type *hashst_##type##_get_const(const struct Hash##St##type *table, const type *key)\
+{\
+	return (const type*)hashtab_get((const HashTab*)table, (const void*)key);\
+}\
+\
+static __TYPECHECK type *hashst_##type##_insert(struct Hash##St##type *table, const type *key);\
+static type *hashst_##type##_insert(struct Hash##St##type *table, const type *key)\
+{\
+	return (type*)hashtab_insert((HashTab*)table, (const void*)key);\
+}\
+\
+static __TYPECHECK bool_t hashst_##type##_delete(struct Hash##St##type *table, const type *key, void(func_remove)(type*));\
+static bool_t hashst_##type##_delete(struct Hash##St##type *table, const type *key, void(func_remove)(type*))\
+{\
+	return hashtab_delete((HashTab*)table, (const void*)key, (FPtr_remove)func_remove);\
+}\
+\
+static __TYPECHECK type *hashst_##type##_first(struct Hash##St##type *table, uint32_t *it);\
+static type *hashst_##type##_first(struct Hash##St##type *table, uint32_t *it)\
+{\
+	return (type*)hashtab_first((const HashTab*)table, it);\
+}\
+\
+static __TYPECHECK const type *hashst_##type##_first_const(const struct Hash##St##type *table, uint32_t *it);\
+static const type *hashst_##type##_first_const(const struct Hash##St##type *table, uint32_t *it)\
+{\
+	return (const type*)hashtab_first((const HashTab*)table, it);\
+}\
+\
+static __TYPECHECK type *hashst_##type##_next(struct Hash##St##type *table, uint32_t *it);\
+static type *hashst_##type##_next(struct Hash##St##type *table, uint32_t *it)\
+{\
+	return (type*)hashtab_next((const HashTab*)table, it);\
+}\
+\
+static __TYPECHECK const type *hashst_##type##_next_const(const struct Hash##St##type *table, uint32_t *it);\
+static const type *hashst_##type##_next_const(const struct Hash##St##type *table, uint32_t *it)\
+{\
+	return (const type*)hashtab_next((const HashTab*)table, it);\
+}\
+\
+__INLINE void hashst_##type##_end(void)\
+
@@ -0,0 +1,54 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: nappgui/core/hashtab.h
+ *
+ */
+
+/* Open addressing hash tables */
+
+#include "nappgui/core/core.hxx"
+
+__EXTERN_C
+
+_core_api HashTab *hashtab_create(FPtr_hash func_hash, FPtr_compare func_compare, const uint16_t esize, const char_t *type);
+
+_core_api HashTab *hashtab_create_ptr(FPtr_hash func_hash, FPtr_compare func_compare, const char_t *type);
+
+_core_api HashTab *hashtab_read(Stream *stream, FPtr_hash func_hash, FPtr_compare func_compare, const uint16_t esize, FPtr_read_init func_read_init, const char_t *type);
+
+_core_api HashTab *hashtab_read_ptr(Stream *stream, FPtr_hash func_hash, FPtr_compare func_compare, FPtr_read func_read, const char_t *type);
+
+_core_api void hashtab_destroy(HashTab **tab, FPtr_remove func_remove, const char_t *type);
+
+_core_api void hashtab_destroy_ptr(HashTab **tab, FPtr_destroy func_destroy, const char_t *type);
+
+_core_api void hashtab_clear(HashTab *tab, FPtr_remove func_remove);
+
+_core_api void hashtab_clear_ptr(HashTab *tab, FPtr_destroy func_destroy);
+
+_core_api void hashtab_write(Stream *stream, const HashTab *tab, FPtr_write func_write);
+
+_core_api uint32_t hashtab_size(const HashTab *tab);
+
+_core_api void hashtab_reserve(HashTab *tab, const uint32_t elems);
+
+_core_api byte_t *hashtab_get(const HashTab *tab, const void *key);
+
+_core_api byte_t *hashtab_insert(HashTab *tab, const void *key);
+
+_core_api bool_t hashtab_insert_ptr(HashTab *tab, void *ptr);
+
+_core_api bool_t hashtab_delete(HashTab *tab, const void *key, FPtr_remove func_remove);
+
+_core_api bool_t hashtab_delete_ptr(HashTab *tab, const void *key, FPtr_destroy func_destroy);
+
+_core_api byte_t *hashtab_first(const HashTab *tab, uint32_t *it);
+
+_core_api byte_t *hashtab_next(const HashTab *tab, uint32_t *it);
+
+__END_C
+
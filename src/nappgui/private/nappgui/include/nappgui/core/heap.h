@@ -19,6 +19,8 @@ _core_api void heap_start_mt(void);
 
 _core_api void heap_end_mt(void);
 
+_core_api void heap_thread_end(void);
+
 _core_api void heap_verbose(const bool_t verbose);
 
 _core_api void heap_stats(const bool_t stats);
@@ -39,10 +41,24 @@ _core_api byte_t *heap_aligned_realloc(byte_t *mem, const uint32_t size, const u
 
 _core_api void heap_free(byte_t **mem, const uint32_t size, const char_t *name);
 
+_core_api byte_t *heap_malloc64(const uint64_t size, const char_t *name);
+
+_core_api void heap_free64(byte_t **mem, const uint64_t size, const char_t *name);
+
 _core_api void heap_auditor_add(const char_t *name);
 
 _core_api void heap_auditor_delete(const char_t *name);
 
+_core_api HeapArena *heap_arena_create(const uint32_t chunk_size);
+
+_core_api void heap_arena_destroy(HeapArena **arena);
+
+_core_api void heap_arena_push(HeapArena *arena);
+
+_core_api void heap_arena_pop(HeapArena *arena);
+
+_core_api uint64_t heap_arena_bytes(const HeapArena *arena);
+
 __END_C
 
 #define heap_malloc(size, name)\
@@ -21,12 +21,24 @@ _core_api Stream *stm_memory(const uint32_t size);
 
 _core_api Stream *stm_from_file(const char_t *pathname, ferror_t *error);
 
+_core_api Stream *stm_from_mmap(const char_t *pathname, ferror_t *error);
+
 _core_api Stream *stm_to_file(const char_t *pathname, ferror_t *error);
 
 _core_api Stream *stm_append_file(const char_t *pathname, ferror_t *error);
 
 _core_api Stream *stm_socket(Socket *socket);
 
+_core_api Stream *stm_socket_async(Socket *socket);
+
+_core_api uint32_t stm_sock_recv(Stream *stm);
+
+_core_api uint32_t stm_sock_available(const Stream *stm);
+
+_core_api uint32_t stm_sock_pending(const Stream *stm);
+
+_core_api bool_t stm_sock_closed(const Stream *stm);
+
 _core_api void stm_close(Stream **stm);
 
 
@@ -82,9 +94,13 @@ _core_api const byte_t *stm_buffer(const Stream *stm);
 
 _core_api uint32_t stm_buffer_size(const Stream *stm);
 
+_core_api void stm_cache_size(Stream *stm, const uint32_t size);
+
 
 _core_api void stm_write(Stream *stm, const byte_t *data, const uint32_t size);
 
+_core_api void stm_write64(Stream *stm, const byte_t *data, const uint64_t size);
+
 _core_api void stm_write_char(Stream *stm, const uint32_t codepoint);
 
 _core_api uint32_t stm_printf(Stream *stm, const char_t *format, ...) __PRINTF(2, 3);
@@ -116,6 +132,8 @@ _core_api void stm_write_r64(Stream *stm, const real64_t value);
 
 _core_api uint32_t stm_read(Stream *stm, byte_t *data, const uint32_t size);
 
+_core_api uint64_t stm_read64(Stream *stm, byte_t *data, const uint64_t size);
+
 _core_api uint32_t stm_read_char(Stream *stm);
 
 _core_api const char_t *stm_read_chars(Stream *stm, const uint32_t n);
@@ -172,6 +190,10 @@ _core_api real64_t stm_read_r64(Stream *stm);
 
 _core_api void stm_skip(Stream *stm, const uint32_t size);
 
+_core_api void stm_skip64(Stream *stm, const uint64_t size);
+
+_core_api const byte_t *stm_peek(Stream *stm, uint32_t *size);
+
 _core_api void stm_skip_bom(Stream *stm);
 
 _core_api void stm_skip_token(Stream *stm, const ltoken_t token);
@@ -180,6 +202,8 @@ _core_api void stm_flush(Stream *stm);
 
 _core_api void stm_pipe(Stream *from, Stream *to, const uint32_t n);
 
+_core_api void stm_pipe64(Stream *from, Stream *to, const uint64_t n);
+
 _core_api extern Stream *kSTDIN;
 
 _core_api extern Stream *kSTDOUT;
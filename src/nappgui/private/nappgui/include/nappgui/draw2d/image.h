@@ -23,6 +23,10 @@ _draw2d_api Image *image_from_file(const char_t *pathname, ferror_t *error);
 
 _draw2d_api Image *image_from_data(const byte_t *data, const uint32_t size);
 
+_draw2d_api Image *image_from_data_scaled(const byte_t *data, const uint32_t size, const uint32_t max_width, const uint32_t max_height);
+
+_draw2d_api bool_t image_probe(const byte_t *data, const uint32_t size, codec_t *codec, uint32_t *width, uint32_t *height, pixformat_t *format, uint32_t *num_frames);
+
 _draw2d_api const Image *image_from_resource(const ResPack *pack, const ResId id);
 
 _draw2d_api Image *image_copy(const Image *image);
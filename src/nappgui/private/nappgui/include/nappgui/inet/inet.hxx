@@ -29,14 +29,58 @@ typedef enum _ierror_t
     ekIOK
 } ierror_t;
 
+typedef enum _inet_event_t
+{
+    ekEJSONELEM = 0x200
+} inet_event_t;
+
+typedef enum _jevent_t
+{
+    ekJSON_BEGIN_OBJECT = 1,
+    ekJSON_END_OBJECT,
+    ekJSON_BEGIN_ARRAY,
+    ekJSON_END_ARRAY,
+    ekJSON_KEY,
+    ekJSON_STRING,
+    ekJSON_NUMBER,
+    ekJSON_TRUE,
+    ekJSON_FALSE,
+    ekJSON_NULL,
+    ekJSON_VALUE,
+    ekJSON_EOF,
+    ekJSON_ERROR
+} jevent_t;
+
 typedef struct _url_t Url;
 typedef struct _http_t Http;
+typedef struct _httppool_t HttpPool;
 typedef struct _json_t Json;
 typedef struct _jsonopts_t JsonOpts;
+typedef struct _jsonreader_t JsonReader;
+typedef struct _jsonwriter_t JsonWriter;
+typedef struct _evjsonelem_t EvJsonElem;
+
+typedef void(*FPtr_http_done)(void *data, Http *http, const ierror_t error);
+#define FUNC_CHECK_HTTP_DONE(func, type)\
+    (void)((void(*)(type*, Http*, const ierror_t))func == func)
+
+typedef void(*FPtr_http_chunk)(void *data, const byte_t *chunk, const uint32_t size);
+#define FUNC_CHECK_HTTP_CHUNK(func, type)\
+    (void)((void(*)(type*, const byte_t*, const uint32_t))func == func)
 
 struct _jsonopts_t
 {
     uint32_t not_used;
+    HeapArena *arena;
+};
+
+struct _evjsonelem_t
+{
+    const char_t *type;
+    const char_t *mname;
+    const char_t *etype;
+    uint32_t index;
+    const void *elem;
 };
 
 #endif
@@ -136,9 +136,37 @@ typedef enum _serror_t
     ekSTIMEOUT,
     ekSSTREAM,
     ekSUNDEF,
-    ekSOK
+    ekSOK,
+    ekSAGAIN
 } serror_t;
 
+typedef enum _sockev_t
+{
+    ekSOCK_READ     = 1 << 0,
+    ekSOCK_WRITE    = 1 << 1,
+    ekSOCK_CLOSE    = 1 << 2,
+    ekSOCK_ERROR    = 1 << 3,
+    ekSOCK_EDGE     = 1 << 4
+} sockev_t;
+
+typedef enum _log_level_t
+{
+    ekLOG_TRACE = 1,
+    ekLOG_DEBUG,
+    ekLOG_INFO,
+    ekLOG_WARN,
+    ekLOG_ERROR
+} log_level_t;
+
+typedef enum _log_field_t
+{
+    ekLOG_INT = 1,
+    ekLOG_UINT,
+    ekLOG_REAL,
+    ekLOG_BOOL,
+    ekLOG_STR
+} log_field_t;
+
 typedef struct _date_t Date;
 typedef struct _dir_t Dir;
 typedef struct _file_t File;
@@ -147,6 +175,9 @@ typedef struct _process_t Proc;
 typedef struct _dlib_t DLib;
 typedef struct _thread_t Thread;
 typedef struct _socket_t Socket;
+typedef struct _sockpoll_t SockPoll;
+typedef struct _sockbuf_t SockBuf;
+typedef struct _logfield_t LogField;
 
 typedef uint32_t(*FPtr_thread_main)(void *data);
 #define FUNC_CHECK_THREAD_MAIN(func, type)\
@@ -154,6 +185,10 @@ typedef uint32_t(*FPtr_thread_main)(void *data);
 
 typedef void(*FPtr_libproc)(void);
 
+typedef void(*FPtr_sock_event)(void *data, Socket *socket, const uint32_t events);
+#define FUNC_CHECK_SOCK_EVENT(func, type)\
+    (void)((void(*)(type*, Socket*, const uint32_t))func == func)
+
 struct _date_t
 {
     int16_t year;
@@ -165,5 +200,25 @@ struct _date_t
     uint8_t second;
 };
 
+struct _sockbuf_t
+{
+    byte_t *data;
+    uint32_t size;
+};
+
+struct _logfield_t
+{
+    const char_t *key;
+    log_field_t type;
+    union
+    {
+        int64_t i;
+        uint64_t u;
+        real64_t r;
+        bool_t b;
+        const char_t *s;
+    } value;
+};
+
 #endif
 
@@ -17,6 +17,8 @@ __EXTERN_C
 
 _sewer_api byte_t *bmem_aligned_malloc(const uint32_t size, const uint32_t align);
 
+_sewer_api byte_t *bmem_aligned_malloc64(const uint64_t size, const uint32_t align);
+
 _sewer_api byte_t *bmem_aligned_realloc(byte_t *mem, const uint32_t size, const uint32_t new_size, const uint32_t align);
 
 _sewer_api void bmem_free(byte_t *mem);
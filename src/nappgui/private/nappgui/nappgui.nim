@@ -64,6 +64,7 @@ func getPassL(): string =
     args.add "-lstdc++"
   elif defined(macosx):
     args.add "-framework Cocoa"
+    args.add "-framework ImageIO"
     const osxVersionMajor = block:
       var res = 0
       var parts = gorge("sw_vers -productVersion", "", "0").split('.')
@@ -228,6 +229,7 @@ when isMainModule:
     compile "clock.c"
     compile "date.c"
     compile "dbind.c"
+    compile "hashtab.c"
     compile "heap.c"
     compile "hfile.c"
     compile "keybuf.c"
@@ -268,6 +270,8 @@ when isMainModule:
     compile "imgutil.c"
     compile "palette.c"
     compile "pixbuf.c"
+    compile "pixconv.c"
+    compile "pixscale.c"
     compile "drawg.cpp"
 
     when defined(linux):
@@ -17,14 +17,22 @@
 
 /*---------------------------------------------------------------------------*/
 
-#define i_SIZE(buffer) *((uint32_t*)buffer)
-#define i_DATA(buffer) ((byte_t*)((byte_t*)buffer + sizeof(uint32_t)))
+#define i_SIZE(buffer) *((uint64_t*)buffer)
+#define i_DATA(buffer) ((byte_t*)((byte_t*)buffer + sizeof(uint64_t)))
 
 /*---------------------------------------------------------------------------*/
 
 Buffer *buffer_create(const uint32_t size)
 {
-    Buffer *buffer = (Buffer*)heap_malloc(size + sizeof32(uint32_t), "Buffer");
+    return buffer_create64((uint64_t)size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+Buffer *buffer_create64(const uint64_t size)
+{
+    Buffer *buffer = (Buffer*)heap_malloc64(size + sizeof(uint64_t), "Buffer");
+    cassert_msg(buffer != NULL, "Not enough memory for Buffer");
     i_SIZE(buffer) = size;
     return buffer;
 }
@@ -44,12 +52,21 @@ void buffer_destroy(Buffer **buffer)
 {
     cassert_no_null(buffer);
     cassert_no_null(*buffer);
-    heap_free((byte_t**)buffer, i_SIZE(*buffer) + sizeof32(uint32_t), "Buffer");
+    heap_free64((byte_t**)buffer, i_SIZE(*buffer) + sizeof(uint64_t), "Buffer");
 }
 
 /*---------------------------------------------------------------------------*/
 
 uint32_t buffer_size(const Buffer *buffer)
+{
+    cassert_no_null(buffer);
+    cassert_msg(i_SIZE(buffer) <= 0xFFFFFFFF, "Use buffer_size64");
+    return (uint32_t)i_SIZE(buffer);
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint64_t buffer_size64(const Buffer *buffer)
 {
     cassert_no_null(buffer);
     return i_SIZE(buffer);
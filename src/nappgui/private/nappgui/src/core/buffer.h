@@ -17,12 +17,16 @@ __EXTERN_C
 
 _core_api Buffer *buffer_create(const uint32_t size);
 
+_core_api Buffer *buffer_create64(const uint64_t size);
+
 _core_api Buffer *buffer_with_data(const byte_t *data, const uint32_t size);
 
 _core_api void buffer_destroy(Buffer **buffer);
 
 _core_api uint32_t buffer_size(const Buffer *buffer);
 
+_core_api uint64_t buffer_size64(const Buffer *buffer);
+
 _core_api byte_t *buffer_data(Buffer *buffer);
 
 _core_api const byte_t *buffer_const(const Buffer *buffer);
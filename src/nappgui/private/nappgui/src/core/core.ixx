@@ -16,6 +16,7 @@
 #include "core.hxx"
 
 typedef struct _nfa_t NFA;
+typedef struct _nfactx_t NFACtx;
 typedef struct _evassert_t EvAssert;
 typedef struct _lexscn_t LexScn;
 
@@ -27,6 +28,18 @@ typedef void(*FPtr_release)(void **item);
 #define FUNC_CHECK_RELEASE(func, type)\
     (void)((void(*)(type**))func == func)
 
+/* Matching state. Lives in caller's stack, the NFA is never modified */
+struct _nfactx_t
+{
+    const NFA *nfa;
+    uint32_t dstate;
+    bool_t floating;
+    ArrSt(uint32_t) *current;
+    ArrSt(uint32_t) *temp;
+    uint32_t *marks;
+    uint32_t mark;
+};
+
 struct _evassert_t
 {
     uint32_t group;
@@ -21,6 +21,8 @@
 #include "date.h"
 #include "dbind.h"
 #include "event.h"
+#include "hashpt.h"
+#include "hashst.h"
 #include "heap.h"
 #include "hfile.h"
 #include "keybuf.h"
@@ -16,13 +16,18 @@
 #include "tfilter.inl"
 #include "arrpt.h"
 #include "arrst.h"
+#include "bhash.h"
 #include "bmath.h"
 #include "bmem.h"
+#include "bmutex.h"
 #include "bstd.h"
 #include "buffer.h"
 #include "cassert.h"
+#include "hashst.h"
 #include "heap.h"
+#include "heap.inl"
 #include "log.h"
+#include "osbs.h"
 #include "ptr.h"
 #include "stream.h"
 #include "strings.h"
@@ -31,6 +36,10 @@ typedef union _attribs_t Attribs;
 typedef struct _enumbind_t EnumBind;
 typedef struct _enumvbind_t EnumVBind;
 typedef struct _databind_t DataBind;
+typedef struct _typebind_t TypeBind;
+typedef struct _dbindname_t DBindName;
+typedef struct _planop_t PlanOp;
+typedef struct _stplan_t StPlan;
 
 union _attribs_t
 {
@@ -116,6 +125,8 @@ struct _stbind_t
     FPtr_write func_write;
     FPtr_destroy func_destroy;
     ArrSt(DBind) *members;
+    HashSt(DBindName) *names;
+    StPlan *plan;
 };
 
 struct _enumvbind_t
@@ -131,10 +142,56 @@ struct _enumbind_t
     ArrSt(EnumVBind) *values;
 };
 
+/* Registry entry: basic type, struct or enum by name */
+struct _typebind_t
+{
+    const char_t *name;
+    dtype_t dtype;
+    uint16_t size;
+    StBind *stbind;
+    EnumBind *ebind;
+};
+
+/* Member index by name */
+struct _dbindname_t
+{
+    const char_t *name;
+    uint32_t index;
+};
+
+typedef enum _opcode_t
+{
+    i_ekOP_BLOCK,
+    i_ekOP_FIXUP,
+    i_ekOP_VALUE
+} opcode_t;
+
+/* Serialization step, offset from the object start */
+struct _planop_t
+{
+    opcode_t op;
+    uint32_t offset;
+    uint32_t size;
+    const DBind *member;
+};
+
+/* Precompiled binary serialization of a struct */
+struct _stplan_t
+{
+    uint32_t gen;
+    uint32_t refs;
+    bool_t packed;
+    ArrSt(PlanOp) *native;
+    ArrSt(PlanOp) *swap;
+};
+
 struct _databind_t
 {
     ArrPt(StBind) *stbinds;
     ArrPt(EnumBind) *ebinds;
+    HashSt(TypeBind) *types;
+    Mutex *mutex;
+    uint32_t gen;
 };
 
 /*---------------------------------------------------------------------------*/
@@ -143,55 +200,320 @@ DeclSt(EnumVBind);
 DeclPt(EnumBind);
 DeclSt(DBind);
 DeclPt(StBind);
+DeclSt(TypeBind);
+DeclSt(DBindName);
+DeclSt(PlanOp);
 
 static void i_remove_object(byte_t *data, const StBind *stbind, const uint16_t size);
 static void i_destroy_object(byte_t **data, const StBind *stbind, const uint16_t size);
 static void i_write_value(Stream *stm, DBind *dbind, dtype_t type, const char_t *subtype, const void *data);
 static bool_t i_read_value(Stream *stm, DBind *dbind, dtype_t type, const char_t *subtype, void *data);
-static DataBind i_DATABIND = { 0, 0 };
+static DataBind i_DATABIND = { 0, 0, 0, 0, 0 };
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_name_hash(const char_t *name)
+{
+    uint32_t size = str_len_c(name);
+    if (size > 0)
+        return bhash_from_block((const byte_t*)name, size);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_typebind_hash(const TypeBind *bind)
+{
+    cassert_no_null(bind);
+    return i_name_hash(bind->name);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int i_typebind_cmp(const TypeBind *bind1, const TypeBind *bind2)
+{
+    cassert_no_null(bind1);
+    cassert_no_null(bind2);
+    return str_cmp_c(bind1->name, bind2->name);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_dbindname_hash(const DBindName *name)
+{
+    cassert_no_null(name);
+    return i_name_hash(name->name);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int i_dbindname_cmp(const DBindName *name1, const DBindName *name2)
+{
+    cassert_no_null(name1);
+    cassert_no_null(name2);
+    return str_cmp_c(name1->name, name2->name);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE const TypeBind *i_find_type(const char_t *type)
+{
+    TypeBind key;
+    cassert_no_null(type);
+    key.name = type;
+    return hashst_get_const(i_DATABIND.types, &key, TypeBind);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static TypeBind *i_register_type(const char_t *type, const dtype_t dtype, const uint16_t size)
+{
+    TypeBind key;
+    TypeBind *bind = NULL;
+    key.name = type;
+    bind = hashst_get(i_DATABIND.types, &key, TypeBind);
+    if (bind == NULL)
+    {
+        bind = hashst_insert(i_DATABIND.types, &key, TypeBind);
+        bind->dtype = dtype;
+        bind->size = size;
+        bind->stbind = NULL;
+        bind->ebind = NULL;
+    }
+
+    return bind;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static StBind *i_find_stbind(const char_t *type)
+{
+    const TypeBind *bind = i_find_type(type);
+    return bind != NULL ? bind->stbind : NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static EnumBind *i_find_enum(const char_t *type)
+{
+    const TypeBind *bind = i_find_type(type);
+    return bind != NULL ? bind->ebind : NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static StBind *i_new_stbind(const char_t *type, const uint16_t size, const bool_t opaque)
+{
+    StBind *stbind = heap_new0(StBind);
+    TypeBind *bind = NULL;
+    arrpt_append(i_DATABIND.stbinds, stbind, StBind);
+    stbind->type = str_c(type);
+    stbind->size = size;
+    stbind->members = opaque == TRUE ? NULL : arrst_create(DBind);
+    stbind->names = opaque == TRUE ? NULL : hashst_create(i_dbindname_hash, i_dbindname_cmp, DBindName);
+    /* The registry name points to the StBind own string */
+    bind = i_register_type(tc(stbind->type), ekDTYPE_UNKNOWN, size);
+    cassert(bind->stbind == NULL);
+    bind->stbind = stbind;
+    return stbind;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_plan_op(ArrSt(PlanOp) *ops, const opcode_t op, const uint32_t offset, const uint32_t size, const DBind *member)
+{
+    PlanOp *pop = arrst_new(ops, PlanOp);
+    pop->op = op;
+    pop->offset = offset;
+    pop->size = size;
+    pop->member = member;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Types stored in stream with the same bytes as in memory (native endian) */
+static bool_t i_is_plain(const dtype_t type)
+{
+    switch (type) {
+    case ekDTYPE_BOOL:
+    case ekDTYPE_INT8:
+    case ekDTYPE_INT16:
+    case ekDTYPE_INT32:
+    case ekDTYPE_INT64:
+    case ekDTYPE_UINT8:
+    case ekDTYPE_UINT16:
+    case ekDTYPE_UINT32:
+    case ekDTYPE_UINT64:
+    case ekDTYPE_REAL32:
+    case ekDTYPE_REAL64:
+        return TRUE;
+    case ekDTYPE_ENUM:
+        return (bool_t)(sizeof(enum_t) == sizeof(int32_t));
+    default:
+        return FALSE;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Plain types that need validation after a raw read */
+static bool_t i_needs_fixup(const dtype_t type)
+{
+    return (bool_t)(type == ekDTYPE_BOOL || type == ekDTYPE_REAL32 || type == ekDTYPE_REAL64);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_plan_flush(StPlan *plan, ArrSt(PlanOp) *fixups, uint32_t *run_offset, uint32_t *run_size)
+{
+    cassert_no_null(plan);
+    cassert_no_null(run_offset);
+    cassert_no_null(run_size);
+    if (*run_size > 0)
+    {
+        i_plan_op(plan->native, i_ekOP_BLOCK, *run_offset, *run_size, NULL);
+        arrst_foreach(fixup, fixups, PlanOp)
+            i_plan_op(plan->native, fixup->op, fixup->offset, fixup->size, fixup->member);
+        arrst_end();
+        arrst_clear(fixups, NULL, PlanOp);
+        *run_size = 0;
+    }
+}
 
 /*---------------------------------------------------------------------------*/
 
-static StBind *i_find_stbind(const char_t *type, uint32_t *index)
+/* Nested structs are flattened. Contiguous plain members are merged in a single block */
+static void i_plan_members(StPlan *plan, ArrSt(PlanOp) *fixups, const StBind *stbind, const uint32_t base, uint32_t *run_offset, uint32_t *run_size)
 {
-    arrpt_foreach(bind, i_DATABIND.stbinds, StBind)
-        int compare = str_cmp(bind->type, type);
-        if (compare == 0)
+    cassert_no_null(stbind);
+    cassert_no_null(run_offset);
+    cassert_no_null(run_size);
+    arrst_foreach(member, stbind->members, DBind)
+        uint32_t offset = base + member->offset;
+        if (member->type == ekDTYPE_OBJECT)
         {
-            return bind;
+            i_plan_members(plan, fixups, member->attr.object.stbind, offset, run_offset, run_size);
         }
-        else if (compare > 0)
+        else
         {
-            ptr_assign(index, bind_i);
-            return NULL;
-        }
-    arrpt_end();
+            i_plan_op(plan->swap, i_ekOP_VALUE, offset, member->size, member);
+            if (i_is_plain(member->type) == TRUE)
+            {
+                if (*run_offset + *run_size != offset)
+                    i_plan_flush(plan, fixups, run_offset, run_size);
 
-    if (index != NULL)
-        *index = arrpt_size(i_DATABIND.stbinds, StBind);
-    return NULL;
+                if (*run_size == 0)
+                    *run_offset = offset;
+
+                *run_size += member->size;
+                if (i_needs_fixup(member->type) == TRUE)
+                    i_plan_op(fixups, i_ekOP_FIXUP, offset, member->size, member);
+            }
+            else
+            {
+                i_plan_flush(plan, fixups, run_offset, run_size);
+                i_plan_op(plan->native, i_ekOP_VALUE, offset, member->size, member);
+            }
+        }
+    arrst_end();
 }
 
 /*---------------------------------------------------------------------------*/
 
-static EnumBind *i_find_enum(const char_t *type, uint32_t *index)
+static StPlan *i_plan_create(const StBind *stbind)
 {
-    arrpt_foreach(bind, i_DATABIND.ebinds, EnumBind)
-        int compare = str_cmp(bind->type, type);
-        if (compare == 0)
-        {
-            return bind;
-        }
-        else if (compare > 0)
+    StPlan *plan = heap_new(StPlan);
+    ArrSt(PlanOp) *fixups = arrst_create(PlanOp);
+    uint32_t run_offset = 0, run_size = 0;
+    cassert_no_null(stbind);
+    cassert_no_null(stbind->members);
+    plan->gen = i_DATABIND.gen;
+    plan->refs = 1;
+    plan->native = arrst_create(PlanOp);
+    plan->swap = arrst_create(PlanOp);
+    i_plan_members(plan, fixups, stbind, 0, &run_offset, &run_size);
+    i_plan_flush(plan, fixups, &run_offset, &run_size);
+    arrst_destroy(&fixups, NULL, PlanOp);
+
+    /* The whole object is a single raw block (no padding, no pointers) */
+    plan->packed = FALSE;
+    if (arrst_size(plan->native, PlanOp) > 0)
+    {
+        const PlanOp *op = arrst_get_const(plan->native, 0, PlanOp);
+        if (op->op == i_ekOP_BLOCK && op->offset == 0 && op->size == stbind->size)
         {
-            ptr_assign(index, bind_i);
-            return NULL;
+            plan->packed = TRUE;
+            arrst_foreach(fop, plan->native, PlanOp)
+                if (fop_i > 0 && fop->op != i_ekOP_FIXUP)
+                    plan->packed = FALSE;
+            arrst_end();
         }
-    arrpt_end();
+    }
 
-    if (index != NULL)
-        *index = arrpt_size(i_DATABIND.ebinds, EnumBind);
-    return NULL;
+    return plan;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_plan_destroy(StPlan **plan)
+{
+    cassert_no_null(plan);
+    cassert_no_null(*plan);
+    arrst_destroy(&(*plan)->native, NULL, PlanOp);
+    arrst_destroy(&(*plan)->swap, NULL, PlanOp);
+    heap_delete(plan, StPlan);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Mutex must be locked */
+static void i_plan_unref(StPlan **plan)
+{
+    cassert_no_null(plan);
+    cassert_no_null(*plan);
+    cassert((*plan)->refs > 0);
+    (*plan)->refs -= 1;
+    if ((*plan)->refs == 0)
+        i_plan_destroy(plan);
+    else
+        *plan = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Plans are built on first use and rebuilt if any struct changes.
+   The caller holds a reference until 'i_plan_release', a rebuild in
+   other thread never frees a plan in use */
+static const StPlan *i_plan(const StBind *stbind)
+{
+    StBind *mstbind = (StBind*)stbind;
+    StPlan *plan = NULL;
+    cassert_no_null(stbind);
+    bmutex_lock(i_DATABIND.mutex);
+    if (stbind->plan == NULL || stbind->plan->gen != i_DATABIND.gen)
+    {
+        /* The plan is cached beyond any HeapArena region of this thread */
+        HeapArena *region = _heap_arena_pause();
+        if (stbind->plan != NULL)
+            i_plan_unref(&mstbind->plan);
+        mstbind->plan = i_plan_create(stbind);
+        _heap_arena_resume(region);
+    }
+
+    plan = stbind->plan;
+    plan->refs += 1;
+    bmutex_unlock(i_DATABIND.mutex);
+    return plan;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_plan_release(const StPlan *plan)
+{
+    StPlan *mplan = (StPlan*)plan;
+    bmutex_lock(i_DATABIND.mutex);
+    i_plan_unref(&mplan);
+    bmutex_unlock(i_DATABIND.mutex);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -272,6 +594,10 @@ static void i_remove_stbind(StBind *stbind)
     cassert_no_null(stbind);
     if (stbind->members != NULL)
         arrst_destroy(&stbind->members, i_remove_member, DBind);
+    if (stbind->names != NULL)
+        hashst_destroy(&stbind->names, NULL, DBindName);
+    if (stbind->plan != NULL)
+        i_plan_unref(&stbind->plan);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -313,6 +639,23 @@ void _dbind_start(void)
     {
         i_DATABIND.stbinds = arrpt_create(StBind);
         i_DATABIND.ebinds = arrpt_create(EnumBind);
+        i_DATABIND.types = hashst_create(i_typebind_hash, i_typebind_cmp, TypeBind);
+        hashst_reserve(i_DATABIND.types, 64, TypeBind);
+        i_DATABIND.mutex = bmutex_create();
+        i_DATABIND.gen = 0;
+        i_register_type("bool_t", ekDTYPE_BOOL, sizeof(bool_t));
+        i_register_type("int8_t", ekDTYPE_INT8, sizeof(int8_t));
+        i_register_type("int16_t", ekDTYPE_INT16, sizeof(int16_t));
+        i_register_type("int32_t", ekDTYPE_INT32, sizeof(int32_t));
+        i_register_type("int64_t", ekDTYPE_INT64, sizeof(int64_t));
+        i_register_type("uint8_t", ekDTYPE_UINT8, sizeof(uint8_t));
+        i_register_type("uint16_t", ekDTYPE_UINT16, sizeof(uint16_t));
+        i_register_type("uint32_t", ekDTYPE_UINT32, sizeof(uint32_t));
+        i_register_type("uint64_t", ekDTYPE_UINT64, sizeof(uint64_t));
+        i_register_type("real32_t", ekDTYPE_REAL32, sizeof(real32_t));
+        i_register_type("real64_t", ekDTYPE_REAL64, sizeof(real64_t));
+        i_register_type("String*", ekDTYPE_STRING_PTR, sizeof(String*));
+        i_register_type("String", ekDTYPE_STRING, sizeof(String*));
     }
 }
 
@@ -322,12 +665,16 @@ void _dbind_finish(void)
 {
     if (i_DATABIND.stbinds != NULL)
     {
+        /* Registry names are owned by binds */
+        hashst_destroy(&i_DATABIND.types, NULL, TypeBind);
+
         arrpt_foreach(stbind, i_DATABIND.stbinds, StBind)
             i_remove_stbind(stbind);
         arrpt_end();
         arrpt_destroy(&i_DATABIND.stbinds, i_destroy_stbind, StBind);
 
         arrpt_destroy(&i_DATABIND.ebinds, i_destroy_enumbind, EnumBind);
+        bmutex_close(&i_DATABIND.mutex);
     }
 }
 
@@ -422,85 +769,42 @@ static const char_t *i_subtype_str(const DBind *member)
 
 static dtype_t i_data_type(const char_t *mtype, String **subtype, uint16_t *size)
 {
+    const TypeBind *bind = NULL;
+
     if (subtype != NULL)
         *subtype = NULL;
 
-    if (str_equ_c(mtype, "bool_t") == TRUE)
+    bind = i_find_type(mtype);
+    if (bind != NULL)
     {
-        ptr_assign(size, sizeof(bool_t));
-        return ekDTYPE_BOOL;
-    }
-
-    if (str_equ_c(mtype, "uint32_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(uint32_t));
-        return ekDTYPE_UINT32;
-    }
-
-    if (str_equ_c(mtype, "real32_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(real32_t));
-        return ekDTYPE_REAL32;
-    }
-
-    if (str_equ_c(mtype, "int32_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(int32_t));
-        return ekDTYPE_INT32;
-    }
-
-    if (str_equ_c(mtype, "int8_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(int8_t));
-        return ekDTYPE_INT8;
-    }
-
-    if (str_equ_c(mtype, "int16_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(int16_t));
-        return ekDTYPE_INT16;
-    }
-
-    if (str_equ_c(mtype, "int64_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(int64_t));
-        return ekDTYPE_INT64;
-    }
-
-    if (str_equ_c(mtype, "uint8_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(uint8_t));
-        return ekDTYPE_UINT8;
-    }
-
-    if (str_equ_c(mtype, "uint16_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(uint16_t));
-        return ekDTYPE_UINT16;
-    }
-
-    if (str_equ_c(mtype, "uint64_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(uint64_t));
-        return ekDTYPE_UINT64;
-    }
+        if (bind->stbind != NULL)
+        {
+            ptr_assign(size, bind->stbind->size);
+            if (subtype != NULL)
+                *subtype = str_c(mtype);
 
-    if (str_equ_c(mtype, "real64_t") == TRUE)
-    {
-        ptr_assign(size, sizeof(real64_t));
-        return ekDTYPE_REAL64;
-    }
+            if (bind->stbind->members != NULL)
+            {
+                cassert(arrst_size(bind->stbind->members, DBind) > 0);
+                return ekDTYPE_OBJECT;
+            }
+            else
+            {
+                cassert(bind->stbind->size == sizeof(void*));
+                return ekDTYPE_OBJECT_OPAQUE;
+            }
+        }
 
-    if (str_equ_c(mtype, "String*") == TRUE)
-    {
-        ptr_assign(size, sizeof(String*));
-        return ekDTYPE_STRING_PTR;
-    }
+        if (bind->ebind != NULL)
+        {
+            ptr_assign(size, sizeof(enum_t));
+            if (subtype != NULL)
+                *subtype = str_c(mtype);
+            return ekDTYPE_ENUM;
+        }
 
-    if (str_equ_c(mtype, "String") == TRUE)
-    {
-        ptr_assign(size, sizeof(String*));
-        return ekDTYPE_STRING;
+        ptr_assign(size, bind->size);
+        return bind->dtype;
     }
 
     if (str_cmp_cn(mtype, "ArrSt(", 6) == 0)
@@ -550,7 +854,7 @@ static dtype_t i_data_type(const char_t *mtype, String **subtype, uint16_t *size
         if (mtype[n - 1] == '*')
         {
             String *lsubtype = str_cn(mtype, n - 1);
-            StBind *stbind = i_find_stbind(tc(lsubtype), NULL);
+            StBind *stbind = i_find_stbind(tc(lsubtype));
             if (stbind != NULL)
             {
                 ptr_assign(size, sizeof(void*));
@@ -580,41 +884,8 @@ static dtype_t i_data_type(const char_t *mtype, String **subtype, uint16_t *size
         }
         else
         {
-            StBind *stbind = i_find_stbind(mtype, NULL);
-            if (stbind != NULL)
-            {
-                ptr_assign(size, stbind->size);
-                if (subtype != NULL)
-                    *subtype = str_c(mtype);
-
-                if (stbind->members != NULL)
-                {
-                    cassert(arrst_size(stbind->members, DBind) > 0);
-                    return ekDTYPE_OBJECT;
-                }
-                else
-                {
-					cassert(stbind->size == sizeof(void*));
-                    return ekDTYPE_OBJECT_OPAQUE;
-                }
-            }
-            else
-            {
-                EnumBind *ebind = i_find_enum(mtype, NULL);
-                if (ebind != NULL)
-                {
-                    ptr_assign(size, sizeof(enum_t));
-                    if (subtype != NULL)
-                        *subtype = str_c(mtype);
-
-                    return ekDTYPE_ENUM;
-                }
-                else
-                {
-                    ptr_assign(size, 0);
-                    return ekDTYPE_UNKNOWN;
-                }
-            }
+            ptr_assign(size, 0);
+            return ekDTYPE_UNKNOWN;
         }
     }
 }
@@ -643,22 +914,38 @@ static DBind *i_find_member(ArrSt(DBind) *members, const uint16_t moffset, uint3
 
 static StBind *i_stbind(const char_t *type, const uint16_t size)
 {
-    uint32_t index = 0;
-    StBind *stbind = i_find_stbind(type, &index);
+    StBind *stbind = i_find_stbind(type);
     if (stbind == NULL)
-    {
-        stbind = heap_new0(StBind);
-        arrpt_insert(i_DATABIND.stbinds, index, stbind, StBind);
-        stbind->type = str_c(type);
-        stbind->size = size;
-        stbind->members = arrst_create(DBind);
-    }
-
+        stbind = i_new_stbind(type, size, FALSE);
     return stbind;
 }
 
 /*---------------------------------------------------------------------------*/
 
+static void i_index_name(StBind *stbind, const DBind *member, const uint32_t index)
+{
+    DBindName key, *name = NULL;
+    cassert_no_null(stbind);
+    cassert_no_null(member);
+    key.name = tc(member->name);
+    name = hashst_insert(stbind->names, &key, DBindName);
+    cassert_no_null(name);
+    name->index = index;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_index_names(StBind *stbind)
+{
+    cassert_no_null(stbind);
+    hashst_clear(stbind->names, NULL, DBindName);
+    arrst_foreach(member, stbind->members, DBind)
+        i_index_name(stbind, member, member_i);
+    arrst_end();
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void i_add_member(StBind *stbind, const char_t *mname, const char_t *mtype, const uint16_t moffset, const uint16_t msize)
 {
     DBind *member;
@@ -681,6 +968,15 @@ static void i_add_member(StBind *stbind, const char_t *mname, const char_t *mtyp
             member->offset = moffset;
             member->size = msize;
 
+            /* Any cached plan could embed this struct */
+            i_DATABIND.gen += 1;
+
+            /* Members are sorted by offset, usually appended */
+            if (index + 1 == arrst_size(stbind->members, DBind))
+                i_index_name(stbind, member, index);
+            else
+                i_index_names(stbind);
+
             switch (member->type) {
             case ekDTYPE_BOOL:
                 member->attr.boolt.def = FALSE;
@@ -778,7 +1074,7 @@ static void i_add_member(StBind *stbind, const char_t *mname, const char_t *mtyp
             {
                 const EnumVBind *first;
                 cassert(str_equ(subtype, mtype) == TRUE);
-                member->attr.enumt.ebind = i_find_enum(mtype, NULL);
+                member->attr.enumt.ebind = i_find_enum(mtype);
                 cassert_no_null(member->attr.enumt.ebind);
                 first = arrst_get(member->attr.enumt.ebind->values, 0, EnumVBind);
                 cassert_no_null(first);
@@ -808,12 +1104,12 @@ static void i_add_member(StBind *stbind, const char_t *mname, const char_t *mtyp
                     break;
 
                 case ekDTYPE_ENUM:
-                    member->attr.arrayt.ebind = i_find_enum(tc(subtype), NULL);
+                    member->attr.arrayt.ebind = i_find_enum(tc(subtype));
                     cassert_no_null(member->attr.arrayt.ebind);
                     break;
 
                 case ekDTYPE_OBJECT:
-                    member->attr.arrayt.stbind = i_find_stbind(tc(subtype), NULL);
+                    member->attr.arrayt.stbind = i_find_stbind(tc(subtype));
                     cassert_no_null(member->attr.arrayt.stbind);
                     break;
 
@@ -839,7 +1135,7 @@ static void i_add_member(StBind *stbind, const char_t *mname, const char_t *mtyp
                 /* Allowed pointer array types */
                 case ekDTYPE_OBJECT:
                 case ekDTYPE_OBJECT_OPAQUE:
-                    member->attr.arrayt.stbind = i_find_stbind(tc(subtype), NULL);
+                    member->attr.arrayt.stbind = i_find_stbind(tc(subtype));
                     cassert_no_null(member->attr.arrayt.stbind);
                     break;
 
@@ -871,7 +1167,7 @@ static void i_add_member(StBind *stbind, const char_t *mname, const char_t *mtyp
             case ekDTYPE_OBJECT_PTR:
             case ekDTYPE_OBJECT_OPAQUE:
                 cassert(subtype != NULL);
-                member->attr.object.stbind = i_find_stbind(tc(subtype), NULL);
+                member->attr.object.stbind = i_find_stbind(tc(subtype));
                 cassert_no_null(member->attr.object.stbind);
                 member->attr.object.def = NULL;
                 break;
@@ -904,17 +1200,7 @@ void dbind_imp(
             const uint16_t moffset,
             const uint16_t msize)
 {
-    uint32_t index = 0;
     StBind *stbind = i_stbind(type, size);
-    if (stbind == NULL)
-    {
-        stbind = heap_new0(StBind);
-        arrpt_insert(i_DATABIND.stbinds, index, stbind, StBind);
-        stbind->type = str_c(type);
-        stbind->size = size;
-        stbind->members = arrst_create(DBind);
-    }
-
     i_add_member(stbind, mname, mtype, moffset, msize);
 }
 
@@ -922,14 +1208,17 @@ void dbind_imp(
 
 static EnumBind *i_enum_bind(const char_t *type)
 {
-    uint32_t index = 0;
-    EnumBind *ebind = i_find_enum(type, &index);
+    EnumBind *ebind = i_find_enum(type);
     if (ebind == NULL)
     {
+        TypeBind *bind = NULL;
         ebind = heap_new(EnumBind);
         ebind->type = str_c(type);
         ebind->values = arrst_create(EnumVBind);
-        arrpt_insert(i_DATABIND.ebinds, index, ebind, EnumBind);
+        arrpt_append(i_DATABIND.ebinds, ebind, EnumBind);
+        bind = i_register_type(tc(ebind->type), ekDTYPE_ENUM, sizeof(enum_t));
+        cassert(bind->ebind == NULL);
+        bind->ebind = ebind;
     }
 
     return ebind;
@@ -982,14 +1271,9 @@ void dbind_opaque_imp(
                     FPtr_write func_write,
                     FPtr_destroy func_destroy)
 {
-    uint32_t index = 0;
-    StBind *stbind = i_find_stbind(type, &index);
+    StBind *stbind = i_find_stbind(type);
     cassert(stbind == NULL);
-    stbind = heap_new0(StBind);
-    arrpt_insert(i_DATABIND.stbinds, index, stbind, StBind);
-    stbind->type = str_c(type);
-    stbind->size = sizeof(void*);
-    stbind->members = NULL;
+    stbind = i_new_stbind(type, sizeof(void*), TRUE);
     stbind->func_data = func_data;
     stbind->func_buffer = func_buffer;
     stbind->func_copy = func_copy;
@@ -1152,7 +1436,7 @@ byte_t *dbind_create_imp(const char_t *type)
     switch (dtype) {
     case ekDTYPE_OBJECT:
     {
-        StBind *stbind = i_find_stbind(tc(subtype), NULL);
+        StBind *stbind = i_find_stbind(tc(subtype));
         data = heap_calloc_imp(size, type, TRUE);
         i_init_object(data, stbind, size);
         break;
@@ -1298,7 +1582,7 @@ void dbind_init_imp(byte_t *data, const char_t *type)
 
     case ekDTYPE_OBJECT:
     {
-        StBind *stbind = i_find_stbind(type, NULL);
+        StBind *stbind = i_find_stbind(type);
         bmem_set_zero(data, size);
         i_init_object(data, stbind, size);
         break;
@@ -1328,7 +1612,7 @@ static void i_destroy_array(Array **array, const char_t *type)
         char_t atype[128] = ARRST;
         if (dtype == ekDTYPE_OBJECT)
         {
-            StBind *stbind = i_find_stbind(tc(subtype), NULL);
+            StBind *stbind = i_find_stbind(tc(subtype));
             byte_t *data = array_all(*array);
             uint32_t i, n = array_size(*array);
             cassert(size == array_esize(*array));
@@ -1366,7 +1650,7 @@ static void i_destroy_arrpt(Array **array, const char_t *type)
         switch (dtype) {
         case ekDTYPE_OBJECT:
         {
-            StBind *stbind = i_find_stbind(tc(subtype), NULL);
+            StBind *stbind = i_find_stbind(tc(subtype));
             byte_t *data = array_all(*array);
             uint32_t i, n = array_size(*array);
             cassert(sizeof(void*) == array_esize(*array));
@@ -1429,7 +1713,7 @@ static void i_remove_object(byte_t *data, const StBind *stbind, const uint16_t s
         byte_t **obj = (byte_t**)(data + member->offset);
         if (*obj != NULL)
         {
-            StBind *mstb = i_find_stbind(i_subtype_str(member), NULL);
+            const StBind *mstb = member->attr.object.stbind;
             cassert_no_null(mstb);
             cassert_no_nullf(mstb->func_destroy);
             mstb->func_destroy((void**)obj);
@@ -1485,7 +1769,7 @@ void dbind_remove_imp(byte_t *data, const char_t *type)
     switch (dtype) {
     case ekDTYPE_OBJECT:
     {
-        StBind *stbind = i_find_stbind(tc(subtype), NULL);
+        StBind *stbind = i_find_stbind(tc(subtype));
         i_remove_object(data, stbind, size);
         break;
     }
@@ -1541,7 +1825,7 @@ void dbind_destroy_imp(byte_t **data, const char_t *type)
     switch (dtype) {
     case ekDTYPE_OBJECT:
     {
-        StBind *stbind = i_find_stbind(tc(subtype), NULL);
+        StBind *stbind = i_find_stbind(tc(subtype));
         i_destroy_object(data, stbind, size);
         break;
     }
@@ -1564,10 +1848,10 @@ void dbind_destroy_imp(byte_t **data, const char_t *type)
         heap_free(data, sizeof(int16_t), "int16_t");
         break;
     case ekDTYPE_INT32:
-        heap_free(data, sizeof(int16_t), "int16_t");
+        heap_free(data, sizeof(int32_t), "int32_t");
         break;
     case ekDTYPE_INT64:
-        heap_free(data, sizeof(int32_t), "int32_t");
+        heap_free(data, sizeof(int64_t), "int64_t");
         break;
     case ekDTYPE_UINT8:
         heap_free(data, sizeof(uint8_t), "uint8_t");
@@ -1592,7 +1876,7 @@ void dbind_destroy_imp(byte_t **data, const char_t *type)
         break;
     case ekDTYPE_OBJECT_OPAQUE:
     {
-        StBind *stbind = i_find_stbind(tc(subtype), NULL);
+        StBind *stbind = i_find_stbind(tc(subtype));
         cassert_no_null(stbind);
         cassert_no_nullf(stbind->func_destroy);
         stbind->func_destroy((void**)data);
@@ -1622,10 +1906,168 @@ void dbind_destopt_imp(byte_t **data, const char_t *type)
 
 /*---------------------------------------------------------------------------*/
 
+static __INLINE bool_t i_native_read(const Stream *stm)
+{
+    return (bool_t)(stm_get_read_endian(stm) == osbs_endian());
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE bool_t i_native_write(const Stream *stm)
+{
+    return (bool_t)(stm_get_write_endian(stm) == osbs_endian());
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_plan_fixup(const PlanOp *op, byte_t *data)
+{
+    cassert_no_null(op);
+    switch (op->member->type) {
+    case ekDTYPE_BOOL:
+        if (*(bool_t*)data != 0 && *(bool_t*)data != 1)
+        {
+            log_printf("Error reading boolean.");
+            *(bool_t*)data = FALSE;
+        }
+        break;
+
+    case ekDTYPE_REAL32:
+        *(real32_t*)data = dbind_real32(op->member, *(real32_t*)data);
+        break;
+
+    case ekDTYPE_REAL64:
+        *(real64_t*)data = dbind_real64(op->member, *(real64_t*)data);
+        break;
+
+    cassert_default();
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_plan_read(Stream *stm, const StPlan *plan, byte_t *object)
+{
+    bool_t ok = TRUE;
+    const ArrSt(PlanOp) *ops = NULL;
+    cassert_no_null(plan);
+    ops = i_native_read(stm) == TRUE ? plan->native : plan->swap;
+    arrst_foreach_const(op, ops, PlanOp)
+        switch (op->op) {
+        case i_ekOP_BLOCK:
+            stm_read(stm, object + op->offset, op->size);
+            break;
+
+        case i_ekOP_FIXUP:
+            i_plan_fixup(op, object + op->offset);
+            break;
+
+        case i_ekOP_VALUE:
+            ok &= i_read_value(stm, (DBind*)op->member, op->member->type, i_subtype_str(op->member), (void*)(object + op->offset));
+            break;
+
+        cassert_default();
+        }
+    arrst_end();
+
+    return (bool_t)(ok == TRUE && stm_state(stm) == ekSTOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_plan_write(Stream *stm, const StPlan *plan, const byte_t *object)
+{
+    const ArrSt(PlanOp) *ops = NULL;
+    cassert_no_null(plan);
+    ops = i_native_write(stm) == TRUE ? plan->native : plan->swap;
+    arrst_foreach_const(op, ops, PlanOp)
+        switch (op->op) {
+        case i_ekOP_BLOCK:
+            stm_write(stm, object + op->offset, op->size);
+            break;
+
+        case i_ekOP_FIXUP:
+            break;
+
+        case i_ekOP_VALUE:
+            i_write_value(stm, (DBind*)op->member, op->member->type, i_subtype_str(op->member), (const void*)(object + op->offset));
+            break;
+
+        cassert_default();
+        }
+    arrst_end();
+}
+
+/*---------------------------------------------------------------------------*/
+
 static bool_t i_read_array(Stream *stm, dtype_t type, const char_t *subtype, Array *array)
 {
     bool_t ok = TRUE;
     uint32_t i, n = stm_read_u32(stm);
+    uint32_t esize = array_esize(array);
+
+    if (n == 0)
+        return (bool_t)(stm_state(stm) == ekSTOK);
+
+    if (type == ekDTYPE_OBJECT)
+    {
+        const StBind *stbind = i_find_stbind(subtype);
+        const StPlan *plan = NULL;
+        cassert_msg(stbind != NULL, "DBind: Unknown struct type.");
+        plan = i_plan(stbind);
+
+        /* Packed structs: the whole array in a single read */
+        if (plan->packed == TRUE && i_native_read(stm) == TRUE && (uint64_t)n * esize <= UINT32_MAX)
+        {
+            byte_t *data = array_insert(array, UINT32_MAX, n);
+            stm_read(stm, data, n * esize);
+            if (arrst_size(plan->native, PlanOp) > 1)
+            {
+                for (i = 0; i < n; ++i, data += esize)
+                {
+                    arrst_foreach_const(op, plan->native, PlanOp)
+                        if (op->op == i_ekOP_FIXUP)
+                            i_plan_fixup(op, data + op->offset);
+                    arrst_end();
+                }
+            }
+
+            i_plan_release(plan);
+            return (bool_t)(stm_state(stm) == ekSTOK);
+        }
+
+        for (i = 0; i < n; ++i)
+        {
+            byte_t *obj = array_insert(array, UINT32_MAX, 1);
+            bmem_set_zero(obj, esize);
+            i_init_object(obj, stbind, (uint16_t)esize);
+            ok &= i_plan_read(stm, plan, obj);
+        }
+
+        i_plan_release(plan);
+        return ok;
+    }
+
+    /* Basic types (no clamping without member), in a single read */
+    if (i_is_plain(type) == TRUE && i_native_read(stm) == TRUE && (uint64_t)n * esize <= UINT32_MAX)
+    {
+        byte_t *data = array_insert(array, UINT32_MAX, n);
+        stm_read(stm, data, n * esize);
+        if (type == ekDTYPE_BOOL)
+        {
+            for (i = 0; i < n; ++i)
+            {
+                if (data[i] != 0 && data[i] != 1)
+                {
+                    log_printf("Error reading boolean.");
+                    data[i] = FALSE;
+                }
+            }
+        }
+
+        return (bool_t)(stm_state(stm) == ekSTOK);
+    }
+
     for (i = 0; i < n; ++i)
     {
         byte_t *obj = array_insert(array, UINT32_MAX, 1);
@@ -1662,29 +2104,39 @@ static bool_t i_read_arrpt(Stream *stm, const char_t *type, Array *array)
 
 /*---------------------------------------------------------------------------*/
 
+static bool_t i_read_members(Stream *stm, const StBind *stbind, void *object)
+{
+    cassert_no_null(stbind);
+    if (object != NULL)
+    {
+        const StPlan *plan = i_plan(stbind);
+        bool_t ok = i_plan_read(stm, plan, (byte_t*)object);
+        i_plan_release(plan);
+        return ok;
+    }
+
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
 static bool_t i_read_object(Stream *stm, const char_t *type, void *object)
 {
-    bool_t ok = TRUE;
     if (object != NULL)
     {
-        StBind *stbind = i_find_stbind(type, NULL);
+        StBind *stbind = i_find_stbind(type);
         cassert_msg(stbind != NULL, "DBind: Unknown struct type.");
-        arrst_foreach(member, stbind->members, DBind)
-            dtype_t mtype = member->type;
-            const char_t *mstype = i_subtype_str(member);
-            uint16_t moffset = member->offset;
-            ok &= i_read_value(stm, member, mtype, mstype, (void*)((byte_t*)object + moffset));
-        arrst_end();
+        return i_read_members(stm, stbind, object);
     }
 
-    return ok;
+    return TRUE;
 }
 
 /*---------------------------------------------------------------------------*/
 
 static void i_read_opaque(Stream *stm, const char_t *type, void **data)
 {
-    StBind *stbind = i_find_stbind(type, NULL);
+    StBind *stbind = i_find_stbind(type);
     uint32_t size = stm_read_u32(stm);
     void *obj = NULL;
     cassert(stbind->members == NULL);
@@ -1814,7 +2266,7 @@ static bool_t i_read_value(Stream *stm, DBind *dbind, dtype_t type, const char_t
         return i_read_object(stm, subtype, data);
 
     case ekDTYPE_OBJECT_PTR:
-        cassert_msg(i_find_stbind(subtype, NULL) != NULL, "DBind unknown struct type");
+        cassert_msg(i_find_stbind(subtype) != NULL, "DBind unknown struct type");
         cassert(*(void**)data == NULL);
         *(void**)data = dbind_create_imp(subtype);
         return i_read_object(stm, subtype, *(void**)data);
@@ -1862,7 +2314,7 @@ static void *i_create_type(Stream *stm, const char_t *type)
 
         case ekDTYPE_ARRAY:
         {
-            StBind *stbind = i_find_stbind(tc(subtype), NULL);
+            StBind *stbind = i_find_stbind(tc(subtype));
             uint16_t adsize;
             dtype_t adtype;
             Array *array;
@@ -1886,7 +2338,7 @@ static void *i_create_type(Stream *stm, const char_t *type)
         {
             char_t atype[128] = ARRPT;
             Array *array;
-            cassert_msg(i_find_stbind(tc(subtype), NULL) != NULL, "DBind unknown type");
+            cassert_msg(i_find_stbind(tc(subtype)) != NULL, "DBind unknown type");
             str_cat_c(atype, 128, tc(subtype));
             array = array_create(sizeof(void*), atype);
             if (i_read_arrpt(stm, tc(subtype), array) == TRUE)
@@ -1982,18 +2434,24 @@ void *dbind_read_imp(Stream *stm, const char_t *type)
 
 /*---------------------------------------------------------------------------*/
 
+static void i_write_members(Stream *stm, const StBind *stbind, const void *object)
+{
+    const StPlan *plan = NULL;
+    cassert_no_null(stbind);
+    plan = i_plan(stbind);
+    i_plan_write(stm, plan, (const byte_t*)object);
+    i_plan_release(plan);
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void i_write_object(Stream *stm, const void *object, const char_t *type)
 {
     if (object != NULL)
     {
-        StBind *stbind = i_find_stbind(type, NULL);
+        StBind *stbind = i_find_stbind(type);
         cassert_msg(stbind != NULL, "DBind: Unknown struct type.");
-        arrst_foreach(member, stbind->members, DBind)
-            dtype_t mtype = member->type;
-            const char_t *mstype = i_subtype_str(member);
-            uint16_t moffset = member->offset;
-            i_write_value(stm, member, mtype, mstype, (const void*)((byte_t*)object + moffset));
-        arrst_end();
+        i_write_members(stm, stbind, object);
     }
 }
 
@@ -2003,7 +2461,7 @@ static void i_write_opaque(Stream *stm, const void *object, const char_t *type)
 {
     if (object != NULL)
     {
-        StBind *stbind = i_find_stbind(type, NULL);
+        StBind *stbind = i_find_stbind(type);
         if (stbind != NULL)
         {
             cassert(stbind->members == NULL);
@@ -2057,8 +2515,34 @@ static void i_write_array(Stream *stm, const Array *array, const char_t *type)
         dtype_t atype = i_data_type(type, &subtype, NULL);
         const char_t *stype = subtype != NULL ? tc(subtype) : NULL;
         stm_write_u32(stm, n);
-        for (i = 0; i < n; ++i, data += es)
-            i_write_value(stm, NULL, atype, stype, (const void*)data);
+        if (atype == ekDTYPE_OBJECT)
+        {
+            const StBind *stbind = i_find_stbind(stype);
+            const StPlan *plan = NULL;
+            cassert_msg(stbind != NULL, "DBind: Unknown struct type.");
+            plan = i_plan(stbind);
+            /* Packed structs: the whole array in a single write */
+            if (plan->packed == TRUE && i_native_write(stm) == TRUE && (uint64_t)n * es <= UINT32_MAX)
+            {
+                stm_write(stm, data, n * es);
+            }
+            else
+            {
+                for (i = 0; i < n; ++i, data += es)
+                    i_plan_write(stm, plan, data);
+            }
+
+            i_plan_release(plan);
+        }
+        else if (i_is_plain(atype) == TRUE && i_native_write(stm) == TRUE && (uint64_t)n * es <= UINT32_MAX)
+        {
+            stm_write(stm, data, n * es);
+        }
+        else
+        {
+            for (i = 0; i < n; ++i, data += es)
+                i_write_value(stm, NULL, atype, stype, (const void*)data);
+        }
         str_destopt(&subtype);
     }
     else
@@ -2195,23 +2679,30 @@ void dbind_write_imp(Stream *stm, const void *data, const char_t *type)
 
 /*---------------------------------------------------------------------------*/
 
-static DBind *i_find_by_name(ArrSt(DBind) *members, const char_t *name)
+static DBind *i_find_by_name(const StBind *stbind, const char_t *name)
 {
-    arrst_foreach(member, members, DBind)
-        if (str_equ_c(tc(member->name), name) == TRUE)
-            return member;
-    arrst_end();
-    return NULL;
+    DBindName key;
+    const DBindName *mname = NULL;
+    cassert_no_null(stbind);
+    if (stbind->names == NULL)
+        return NULL;
+
+    key.name = name;
+    mname = hashst_get_const(stbind->names, &key, DBindName);
+    if (mname == NULL)
+        return NULL;
+
+    return arrst_get(stbind->members, mname->index, DBind);
 }
 
 /*---------------------------------------------------------------------------*/
 
 static DBind *i_member(const char_t *type, const char_t *name)
 {
-    StBind *stbind = i_find_stbind(type, NULL);
+    StBind *stbind = i_find_stbind(type);
     if (stbind == NULL)
         return NULL;
-    return i_find_by_name(stbind->members, name);
+    return i_find_by_name(stbind, name);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -2551,7 +3042,7 @@ dtype_t dbind_data_type(const char_t *type, String **subtype, uint16_t *size)
 
 const StBind* dbind_stbind(const char_t *type)
 {
-    return i_find_stbind(type, NULL);
+    return i_find_stbind(type);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -2590,8 +3081,7 @@ const DBind* dbind_stbind_member(const StBind *stbind, const uint32_t i)
 
 const DBind* dbind_stbind_find(const StBind *stbind, const char_t *name)
 {
-    cassert_no_null(stbind);
-    return i_find_by_name(stbind->members, name);
+    return i_find_by_name(stbind, name);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -2652,6 +3142,68 @@ void dbind_stbind_opaque_write(const StBind *stbind, const void *obj, Stream *st
 
 /*---------------------------------------------------------------------------*/
 
+byte_t *dbind_stbind_create(const StBind *stbind)
+{
+    byte_t *data = NULL;
+    cassert_no_null(stbind);
+    cassert(stbind->members != NULL);
+    data = heap_calloc_imp(stbind->size, tc(stbind->type), TRUE);
+    i_init_object(data, stbind, stbind->size);
+    return data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void dbind_stbind_init(const StBind *stbind, byte_t *data)
+{
+    cassert_no_null(stbind);
+    cassert(stbind->members != NULL);
+    bmem_set_zero(data, stbind->size);
+    i_init_object(data, stbind, stbind->size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void dbind_stbind_remove(const StBind *stbind, byte_t *data)
+{
+    cassert_no_null(stbind);
+    cassert_no_null(data);
+    cassert(stbind->members != NULL);
+    i_remove_object(data, stbind, stbind->size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void dbind_stbind_destroy(const StBind *stbind, byte_t **data)
+{
+    cassert_no_null(stbind);
+    cassert_no_null(data);
+    cassert(stbind->members != NULL);
+    i_destroy_object(data, stbind, stbind->size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *dbind_stbind_read(const StBind *stbind, Stream *stm)
+{
+    byte_t *obj = dbind_stbind_create(stbind);
+    if (i_read_members(stm, stbind, obj) == FALSE)
+        i_destroy_object(&obj, stbind, stbind->size);
+    return obj;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void dbind_stbind_write(const StBind *stbind, const void *obj, Stream *stm)
+{
+    cassert_no_null(stbind);
+    cassert_no_null(obj);
+    cassert(stbind->members != NULL);
+    i_write_members(stm, stbind, obj);
+}
+
+/*---------------------------------------------------------------------------*/
+
 dtype_t dbind_type(const DBind *dbind)
 {
     cassert_no_null(dbind);
@@ -2861,7 +3413,10 @@ real32_t dbind_real32(const DBind *dbind, const real32_t value)
     if (value != REAL32_MAX)
     {
         real32_t v = bmath_clampf(value, dbind->attr.real32t.min, dbind->attr.real32t.max);
-        return bmath_round_stepf(v, dbind->attr.real32t.prec);
+        /* Values beyond 2^23 steps are already coarser than the precision */
+        if (bmath_absf(v / dbind->attr.real32t.prec) < 8388608.f)
+            v = bmath_round_stepf(v, dbind->attr.real32t.prec);
+        return v;
     }
 
     return value;
@@ -2876,7 +3431,10 @@ real64_t dbind_real64(const DBind *dbind, const real64_t value)
     if (value != REAL64_MAX)
     {
         real64_t v = bmath_clampd(value, dbind->attr.real64t.min, dbind->attr.real64t.max);
-        return bmath_round_stepd(v, dbind->attr.real64t.prec);
+        /* Values beyond 2^52 steps are already coarser than the precision */
+        if (bmath_absd(v / dbind->attr.real64t.prec) < 4503599627370496.)
+            v = bmath_round_stepd(v, dbind->attr.real64t.prec);
+        return v;
     }
 
     return value;
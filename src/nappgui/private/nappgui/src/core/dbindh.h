@@ -45,6 +45,18 @@ _core_api void dbind_stbind_opaque_upd(const StBind *stbind, void *new_obj, void
 
 _core_api void dbind_stbind_opaque_write(const StBind *stbind, const void *obj, Stream *stm);
 
+_core_api byte_t *dbind_stbind_create(const StBind *stbind);
+
+_core_api void dbind_stbind_init(const StBind *stbind, byte_t *data);
+
+_core_api void dbind_stbind_remove(const StBind *stbind, byte_t *data);
+
+_core_api void dbind_stbind_destroy(const StBind *stbind, byte_t **data);
+
+_core_api void *dbind_stbind_read(const StBind *stbind, Stream *stm);
+
+_core_api void dbind_stbind_write(const StBind *stbind, const void *obj, Stream *stm);
+
 
 _core_api dtype_t dbind_type(const DBind *dbind);
 
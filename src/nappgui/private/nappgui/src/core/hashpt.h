@@ -0,0 +1,86 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: hashpt.h
+ *
+ */
+
+/* Hash tables of pointers */
+
+#define hashpt_create(func_hash, func_compare, type)\
+    hashpt_##type##_create(func_hash, func_compare)
+
+#define hashpt_read(stream, func_hash, func_compare, func_read, type)\
+    hashpt_##type##_read(stream, func_hash, func_compare, func_read)
+
+#define hashpt_destroy(table, func_destroy, type)\
+    hashpt_##type##_destroy(table, func_destroy)
+
+#define hashpt_clear(table, func_destroy, type)\
+    hashpt_##type##_clear(table, func_destroy)
+
+#define hashpt_write(stream, table, func_write, type)\
+    hashpt_##type##_write(stream, table, func_write)
+
+#define hashpt_size(table, type)\
+    hashpt_##type##_size(table)
+
+#define hashpt_reserve(table, elems, type)\
+    hashpt_##type##_reserve(table, elems)
+
+#define hashpt_get(table, key, type)\
+    hashpt_##type##_get(table, key)
+
+#define hashpt_get_const(table, key, type)\
+    hashpt_##type##_get_const(table, key)
+
+#define hashpt_insert(table, value, type)\
+    hashpt_##type##_insert(table, value)
+
+#define hashpt_delete(table, key, func_destroy, type)\
+    hashpt_##type##_delete(table, key, func_destroy)
+
+#define hashpt_first(table, it, type)\
+    hashpt_##type##_first(table, it)
+
+#define hashpt_first_const(table, it, type)\
+    hashpt_##type##_first_const(table, it)
+
+#define hashpt_next(table, it, type)\
+    hashpt_##type##_next(table, it)
+
+#define hashpt_next_const(table, it, type)\
+    hashpt_##type##_next_const(table, it)
+
+#define hashpt_foreach(elem, table, type)\
+    {\
+        uint32_t elem##_it = 0;\
+        register type *elem = hashpt_first(table, &elem##_it, type);\
+        register uint32_t elem##_i = 0, elem##_total = hashpt_size(table, type);\
+        while (elem != NULL)\
+        {
+
+#define hashpt_foreach_const(elem, table, type)\
+    {\
+        uint32_t elem##_it = 0;\
+        register const type *elem = hashpt_first_const(table, &elem##_it, type);\
+        register uint32_t elem##_i = 0, elem##_total = hashpt_size(table, type);\
+        while (elem != NULL)\
+        {
+
+#define hashpt_fornext(elem, table, type)\
+            elem = hashpt_next(table, &elem##_it, type);\
+            elem##_i += 1;\
+            unref(elem##_total);\
+        }\
+    }
+
+#define hashpt_fornext_const(elem, table, type)\
+            elem = hashpt_next_const(table, &elem##_it, type);\
+            elem##_i += 1;\
+            unref(elem##_total);\
+        }\
+    }
@@ -0,0 +1,198 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: hashpt.hpp
+ *
+ */
+
+/* Hash table of pointers */
+
+#ifndef __HASHPT_HPP__
+#define __HASHPT_HPP__
+
+#include "bstd.h"
+#include "nowarn.hxx"
+#include <typeinfo>
+#include "warn.hxx"
+
+template<class type>
+struct HashPt
+{
+	static HashPt<type>* create(uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*));
+
+	static HashPt<type>* read(Stream *stream, uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), type*(*func_read)(Stream*));
+
+	static void destroy(HashPt<type> **table, void(*func_destroy)(type**));
+
+	static void clear(HashPt<type> *table, void(*func_destroy)(type**));
+
+	static void write(Stream *stream, const HashPt<type> *table, void(*func_write)(Stream*, const type*));
+
+	static uint32_t size(const HashPt<type> *table);
+
+	static void reserve(HashPt<type> *table, const uint32_t elems);
+
+	static type* get(HashPt<type> *table, const type *key);
+
+	static const type* get(const HashPt<type> *table, const type *key);
+
+	static bool_t insert(HashPt<type> *table, type *value);
+
+	static bool_t ddelete(HashPt<type> *table, const type *key, void(*func_destroy)(type**));
+
+	static type* first(HashPt<type> *table, uint32_t *it);
+
+	static const type* first(const HashPt<type> *table, uint32_t *it);
+
+	static type* next(HashPt<type> *table, uint32_t *it);
+
+	static const type* next(const HashPt<type> *table, uint32_t *it);
+
+#if defined __ASSERTS__
+	// Only for debuggers inspector (non used)
+	uint32_t elems;
+    uint32_t used;
+    uint32_t capacity;
+    uint16_t esize;
+    uint16_t isptr;
+    uint32_t *hashes;
+    type **data;
+    FPtr_hash func_hash;
+    FPtr_compare func_compare;
+#endif
+};
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+static const char_t* i_hashpttype(void)
+{
+	static char_t dtype[64];
+	bstd_sprintf(dtype, sizeof(dtype), "HashPt<%s>", typeid(type).name());
+	return dtype;
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+HashPt<type>* HashPt<type>::create(uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*))
+{
+    return (HashPt<type>*)hashtab_create_ptr((FPtr_hash)func_hash, (FPtr_compare)func_compare, i_hashpttype<type>());
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+HashPt<type>* HashPt<type>::read(Stream *stream, uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), type*(*func_read)(Stream*))
+{
+    return (HashPt<type>*)hashtab_read_ptr(stream, (FPtr_hash)func_hash, (FPtr_compare)func_compare, (FPtr_read)func_read, i_hashpttype<type>());
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+void HashPt<type>::destroy(HashPt<type> **table, void(*func_destroy)(type**))
+{
+    hashtab_destroy_ptr((HashTab**)table, (FPtr_destroy)func_destroy, i_hashpttype<type>());
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+void HashPt<type>::clear(HashPt<type> *table, void(*func_destroy)(type**))
+{
+    hashtab_clear_ptr((HashTab*)table, (FPtr_destroy)func_destroy);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+void HashPt<type>::write(Stream *stream, const HashPt<type> *table, void(*func_write)(Stream*, const type*))
+{
+	hashtab_write(stream, (const HashTab*)table, (FPtr_write)func_write);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+uint32_t HashPt<type>::size(const HashPt<type> *table)
+{
+	return hashtab_size((const HashTab*)table);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+void HashPt<type>::reserve(HashPt<type> *table, const uint32_t elems)
+{
+	hashtab_reserve((HashTab*)table, elems);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+type* HashPt<type>::get(HashPt<type> *table, const type *key)
+{
+	return (type*)hashtab_get((const HashTab*)table, (const void*)key);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+const type* HashPt<type>::get(const HashPt<type> *table, const type *key)
+{
+	return (const type*)hashtab_get((const HashTab*)table, (const void*)key);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+bool_t HashPt<type>::insert(HashPt<type> *table, type *value)
+{
+	return hashtab_insert_ptr((HashTab*)table, (void*)value);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+bool_t HashPt<type>::ddelete(HashPt<type> *table, const type *key, void(*func_destroy)(type**))
+{
+	return hashtab_delete_ptr((HashTab*)table, (const void*)key, (FPtr_destroy)func_destroy);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+type* HashPt<type>::first(HashPt<type> *table, uint32_t *it)
+{
+	return (type*)hashtab_first((const HashTab*)table, it);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+const type* HashPt<type>::first(const HashPt<type> *table, uint32_t *it)
+{
+	return (const type*)hashtab_first((const HashTab*)table, it);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+type* HashPt<type>::next(HashPt<type> *table, uint32_t *it)
+{
+	return (type*)hashtab_next((const HashTab*)table, it);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+const type* HashPt<type>::next(const HashPt<type> *table, uint32_t *it)
+{
+	return (const type*)hashtab_next((const HashTab*)table, it);
+}
+
+#endif
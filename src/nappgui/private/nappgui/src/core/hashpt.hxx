@@ -0,0 +1,121 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: hashpt.hxx
+ *
+ */
+
+/* Hash table macros for type checking at compile time */
+
+#define HashPtDebug(type)\
+struct Hash##Pt##type\
+{\
+    uint32_t elems;\
+    uint32_t used;\
+    uint32_t capacity;\
+    uint16_t esize;\
+    uint16_t isptr;\
+    uint32_t *hashes;\
+    type **data;\
+    FPtr_hash func_hash;\
+    FPtr_compare func_compare;\
+}
+
+#define HashPtFuncs(type)\
+HashPt(type);\
+\
+static __TYPECHECK HashPt(type)* hashpt_##type##_create(uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*));\
+static HashPt(type)* hashpt_##type##_create(uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*))\
+{\
+    return (HashPt(type)*)hashtab_create_ptr((FPtr_hash)func_hash, (FPtr_compare)func_compare, (const char_t*)(HASHPT#type));\
+}\
+\
+static __TYPECHECK HashPt(type)* hashpt_##type##_read(Stream *stream, uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), type*(func_read)(Stream*));\
+static HashPt(type)* hashpt_##type##_read(Stream *stream, uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), type*(func_read)(Stream*))\
+{\
+    return (HashPt(type)*)hashtab_read_ptr(stream, (FPtr_hash)func_hash, (FPtr_compare)func_compare, (FPtr_read)func_read, (const char_t*)(HASHPT#type));\
+}\
+\
+static __TYPECHECK void hashpt_##type##_destroy(struct Hash##Pt##type **table, void(func_destroy)(type**));\
+static void hashpt_##type##_destroy(struct Hash##Pt##type **table, void(func_destroy)(type**))\
+{\
+    hashtab_destroy_ptr((HashTab**)table, (FPtr_destroy)func_destroy, (const char_t*)(HASHPT#type));\
+}\
+\
+static __TYPECHECK void hashpt_##type##_clear(struct Hash##Pt##type *table, void(func_destroy)(type**));\
+static void hashpt_##type##_clear(struct Hash##Pt##type *table, void(func_destroy)(type**))\
+{\
+    hashtab_clear_ptr((HashTab*)table, (FPtr_destroy)func_destroy);\
+}\
+\
+static __TYPECHECK void hashpt_##type##_write(Stream *stream, const struct Hash##Pt##type *table, void(func_write)(Stream*, const type*));\
+static void hashpt_##type##_write(Stream *stream, const struct Hash##Pt##type *table, void(func_write)(Stream*, const type*))\
+{\
+	hashtab_write(stream, (const HashTab*)table, (FPtr_write)func_write);\
+}\
+\
+static __TYPECHECK uint32_t hashpt_##type##_size(const struct Hash##Pt##type *table);\
+static uint32_t hashpt_##type##_size(const struct Hash##Pt##type *table)\
+{\
+	return hashtab_size((const HashTab*)table);\
+}\
+\
+static __TYPECHECK void hashpt_##type##_reserve(struct Hash##Pt##type *table, const uint32_t elems);\
+static void hashpt_##type##_reserve(struct Hash##Pt##type *table, const uint32_t elems)\
+{\
+	hashtab_reserve((HashTab*)table, elems);\
+}\
+\
+static __TYPECHECK type *hashpt_##type##_get(struct Hash##Pt##type *table, const type *key);\
+static type *hashpt_##type##_get(struct Hash##Pt##type *table, const type *key)\
+{\
+	return (type*)hashtab_get((const HashTab*)table, (const void*)key);\
+}\
+\
+static __TYPECHECK const type *hashpt_##type##_get_const(const struct Hash##Pt##type *table, const type *key);\
+static const type *hashpt_##type##_get_const(const struct Hash##Pt##type *table, const type *key)\
+{\
+	return (const type*)hashtab_get((const HashTab*)table, (const void*)key);\
+}\
+\
+static __TYPECHECK bool_t hashpt_##type##_insert(struct Hash##Pt##type *table, type *value);\
+static bool_t hashpt_##type##_insert(struct Hash##Pt##type *table, type *value)\
+{\
+	return hashtab_insert_ptr((HashTab*)table, (void*)value);\
+}\
+\
+static __TYPECHECK bool_t hashpt_##type##_delete(struct Hash##Pt##type *table, const type *key, void(func_destroy)(type**));\
+static bool_t hashpt_##type##_delete(struct Hash##Pt##type *table, const type *key, void(func_destroy)(type**))\
+{\
+	return hashtab_delete_ptr((HashTab*)table, (const void*)key, (FPtr_destroy)func_destroy);\
+}\
+\
+static __TYPECHECK type *hashpt_##type##_first(struct Hash##Pt##type *table, uint32_t *it);\
+static type *hashpt_##type##_first(struct Hash##Pt##type *table, uint32_t *it)\
+{\
+	return (type*)hashtab_first((const HashTab*)table, it);\
+}\
+\
+static __TYPECHECK const type *hashpt_##type##_first_const(const struct Hash##Pt##type *table, uint32_t *it);\
+static const type *hashpt_##type##_first_const(const struct Hash##Pt##type *table, uint32_t *it)\
+{\
+	return (const type*)hashtab_first((const HashTab*)table, it);\
+}\
+\
+static __TYPECHECK type *hashpt_##type##_next(struct Hash##Pt##type *table, uint32_t *it);\
+static type *hashpt_##type##_next(struct Hash##Pt##type *table, uint32_t *it)\
+{\
+	return (type*)hashtab_next((const HashTab*)table, it);\
+}\
+\
+static __TYPECHECK const type *hashpt_##type##_next_const(const struct Hash##Pt##type *table, uint32_t *it);\
+static const type *hashpt_##type##_next_const(const struct Hash##Pt##type *table, uint32_t *it)\
+{\
+	return (const type*)hashtab_next((const HashTab*)table, it);\
+}\
+\
+__INLINE void hashpt_##type##_end(void)\
+
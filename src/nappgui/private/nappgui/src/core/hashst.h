@@ -0,0 +1,86 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: hashst.h
+ *
+ */
+
+/* Hash tables of structures */
+
+#define hashst_create(func_hash, func_compare, type)\
+    hashst_##type##_create(func_hash, func_compare, (uint16_t)sizeof(type))
+
+#define hashst_read(stream, func_hash, func_compare, func_read, type)\
+    hashst_##type##_read(stream, func_hash, func_compare, (uint16_t)sizeof(type), func_read)
+
+#define hashst_destroy(table, func_remove, type)\
+    hashst_##type##_destroy(table, func_remove)
+
+#define hashst_clear(table, func_remove, type)\
+    hashst_##type##_clear(table, func_remove)
+
+#define hashst_write(stream, table, func_write, type)\
+    hashst_##type##_write(stream, table, func_write)
+
+#define hashst_size(table, type)\
+    hashst_##type##_size(table)
+
+#define hashst_reserve(table, elems, type)\
+    hashst_##type##_reserve(table, elems)
+
+#define hashst_get(table, key, type)\
+    hashst_##type##_get(table, key)
+
+#define hashst_get_const(table, key, type)\
+    hashst_##type##_get_const(table, key)
+
+#define hashst_insert(table, key, type)\
+    hashst_##type##_insert(table, key)
+
+#define hashst_delete(table, key, func_remove, type)\
+    hashst_##type##_delete(table, key, func_remove)
+
+#define hashst_first(table, it, type)\
+    hashst_##type##_first(table, it)
+
+#define hashst_first_const(table, it, type)\
+    hashst_##type##_first_const(table, it)
+
+#define hashst_next(table, it, type)\
+    hashst_##type##_next(table, it)
+
+#define hashst_next_const(table, it, type)\
+    hashst_##type##_next_const(table, it)
+
+#define hashst_foreach(elem, table, type)\
+    {\
+        uint32_t elem##_it = 0;\
+        register type *elem = hashst_first(table, &elem##_it, type);\
+        register uint32_t elem##_i = 0, elem##_total = hashst_size(table, type);\
+        while (elem != NULL)\
+        {
+
+#define hashst_foreach_const(elem, table, type)\
+    {\
+        uint32_t elem##_it = 0;\
+        register const type *elem = hashst_first_const(table, &elem##_it, type);\
+        register uint32_t elem##_i = 0, elem##_total = hashst_size(table, type);\
+        while (elem != NULL)\
+        {
+
+#define hashst_fornext(elem, table, type)\
+            elem = hashst_next(table, &elem##_it, type);\
+            elem##_i += 1;\
+            unref(elem##_total);\
+        }\
+    }
+
+#define hashst_fornext_const(elem, table, type)\
+            elem = hashst_next_const(table, &elem##_it, type);\
+            elem##_i += 1;\
+            unref(elem##_total);\
+        }\
+    }
@@ -0,0 +1,198 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: hashst.hpp
+ *
+ */
+
+/* Hash table of structures */
+
+#ifndef __HASHST_HPP__
+#define __HASHST_HPP__
+
+#include "bstd.h"
+#include "nowarn.hxx"
+#include <typeinfo>
+#include "warn.hxx"
+
+template<class type>
+struct HashSt
+{
+	static HashSt<type>* create(uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*));
+
+	static HashSt<type>* read(Stream *stream, uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), void(*func_read)(Stream*, type*));
+
+	static void destroy(HashSt<type> **table, void(*func_remove)(type*));
+
+	static void clear(HashSt<type> *table, void(*func_remove)(type*));
+
+	static void write(Stream *stream, const HashSt<type> *table, void(*func_write)(Stream*, const type*));
+
+	static uint32_t size(const HashSt<type> *table);
+
+	static void reserve(HashSt<type> *table, const uint32_t elems);
+
+	static type* get(HashSt<type> *table, const type *key);
+
+	static const type* get(const HashSt<type> *table, const type *key);
+
+	static type* insert(HashSt<type> *table, const type *key);
+
+	static bool_t ddelete(HashSt<type> *table, const type *key, void(*func_remove)(type*));
+
+	static type* first(HashSt<type> *table, uint32_t *it);
+
+	static const type* first(const HashSt<type> *table, uint32_t *it);
+
+	static type* next(HashSt<type> *table, uint32_t *it);
+
+	static const type* next(const HashSt<type> *table, uint32_t *it);
+
+#if defined __ASSERTS__
+	// Only for debuggers inspector (non used)
+	uint32_t elems;
+    uint32_t used;
+    uint32_t capacity;
+    uint16_t esize;
+    uint16_t isptr;
+    uint32_t *hashes;
+    type *data;
+    FPtr_hash func_hash;
+    FPtr_compare func_compare;
+#endif
+};
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+static const char_t* i_hashsttype(void)
+{
+	static char_t dtype[64];
+	bstd_sprintf(dtype, sizeof(dtype), "HashSt<%s>", typeid(type).name());
+	return dtype;
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+HashSt<type>* HashSt<type>::create(uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*))
+{
+    return (HashSt<type>*)hashtab_create((FPtr_hash)func_hash, (FPtr_compare)func_compare, (uint16_t)sizeof(type), i_hashsttype<type>());
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+HashSt<type>* HashSt<type>::read(Stream *stream, uint32_t(func_hash)(const type*), int(func_compare)(const type*, const type*), void(*func_read)(Stream*, type*))
+{
+    return (HashSt<type>*)hashtab_read(stream, (FPtr_hash)func_hash, (FPtr_compare)func_compare, (uint16_t)sizeof(type), (FPtr_read_init)func_read, i_hashsttype<type>());
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+void HashSt<type>::destroy(HashSt<type> **table, void(*func_remove)(type*))
+{
+    hashtab_destroy((HashTab**)table, (FPtr_remove)func_remove, i_hashsttype<type>());
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+void HashSt<type>::clear(HashSt<type> *table, void(*func_remove)(type*))
+{
+    hashtab_clear((HashTab*)table, (FPtr_remove)func_remove);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+void HashSt<type>::write(Stream *stream, const HashSt<type> *table, void(*func_write)(Stream*, const type*))
+{
+	hashtab_write(stream, (const HashTab*)table, (FPtr_write)func_write);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+uint32_t HashSt<type>::size(const HashSt<type> *table)
+{
+	return hashtab_size((const HashTab*)table);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+void HashSt<type>::reserve(HashSt<type> *table, const uint32_t elems)
+{
+	hashtab_reserve((HashTab*)table, elems);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+type* HashSt<type>::get(HashSt<type> *table, const type *key)
+{
+	return (type*)hashtab_get((const HashTab*)table, (const void*)key);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+const type* HashSt<type>::get(const HashSt<type> *table, const type *key)
+{
+	return (const type*)hashtab_get((const HashTab*)table, (const void*)key);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+type* HashSt<type>::insert(HashSt<type> *table, const type *key)
+{
+	return (type*)hashtab_insert((HashTab*)table, (const void*)key);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+bool_t HashSt<type>::ddelete(HashSt<type> *table, const type *key, void(*func_remove)(type*))
+{
+	return hashtab_delete((HashTab*)table, (const void*)key, (FPtr_remove)func_remove);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+type* HashSt<type>::first(HashSt<type> *table, uint32_t *it)
+{
+	return (type*)hashtab_first((const HashTab*)table, it);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+const type* HashSt<type>::first(const HashSt<type> *table, uint32_t *it)
+{
+	return (const type*)hashtab_first((const HashTab*)table, it);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+type* HashSt<type>::next(HashSt<type> *table, uint32_t *it)
+{
+	return (type*)hashtab_next((const HashTab*)table, it);
+}
+
+/*---------------------------------------------------------------------------*/
+
+template<typename type> 
+const type* HashSt<type>::next(const HashSt<type> *table, uint32_t *it)
+{
+	return (const type*)hashtab_next((const HashTab*)table, it);
+}
+
+#endif
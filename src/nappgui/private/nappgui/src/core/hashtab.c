@@ -0,0 +1,539 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: hashtab.c
+ *
+ */
+
+/* Open addressing hash tables */
+
+#include "hashtab.h"
+#include "bhash.h"
+#include "bmem.h"
+#include "cassert.h"
+#include "heap.h"
+#include "stream.h"
+
+/*
+ * Linear probing over a power of two slot array. Each slot keeps the
+ * cached hash of its element, so probing and rehashing rarely call
+ * the user functions. Hash values 0 and 1 are reserved to mark empty
+ * and deleted slots.
+ */
+#define i_EMPTY         0
+#define i_DELETED       1
+#define i_NO_SLOT       0xFFFFFFFF
+#define i_MIN_CAPACITY  8
+
+struct _hashtab_t
+{
+    uint32_t elems;
+    uint32_t used;
+    uint32_t capacity;
+    uint16_t esize;
+    uint16_t isptr;
+    uint32_t *hashes;
+    byte_t *data;
+    FPtr_hash func_hash;
+    FPtr_compare func_compare;
+};
+
+/*---------------------------------------------------------------------------*/
+
+static HashTab *i_create(FPtr_hash func_hash, FPtr_compare func_compare, const uint16_t esize, const bool_t isptr, const char_t *type)
+{
+    HashTab *tab = (HashTab*)heap_malloc(sizeof(HashTab), type);
+    cassert(esize > 0);
+    tab->elems = 0;
+    tab->used = 0;
+    tab->capacity = 0;
+    tab->esize = esize;
+    tab->isptr = (uint16_t)isptr;
+    tab->hashes = NULL;
+    tab->data = NULL;
+    tab->func_hash = func_hash;
+    tab->func_compare = func_compare;
+    return tab;
+}
+
+/*---------------------------------------------------------------------------*/
+
+HashTab *hashtab_create(FPtr_hash func_hash, FPtr_compare func_compare, const uint16_t esize, const char_t *type)
+{
+    return i_create(func_hash, func_compare, esize, FALSE, type);
+}
+
+/*---------------------------------------------------------------------------*/
+
+HashTab *hashtab_create_ptr(FPtr_hash func_hash, FPtr_compare func_compare, const char_t *type)
+{
+    /* Pointed objects size is unknown, no default hash or equality */
+    cassert_no_nullf(func_hash);
+    cassert_no_nullf(func_compare);
+    return i_create(func_hash, func_compare, sizeof(void*), TRUE, type);
+}
+
+/*---------------------------------------------------------------------------*/
+
+HashTab *hashtab_read(Stream *stream, FPtr_hash func_hash, FPtr_compare func_compare, const uint16_t esize, FPtr_read_init func_read_init, const char_t *type)
+{
+    uint32_t i, elems = stm_read_u32(stream);
+    HashTab *tab = i_create(func_hash, func_compare, esize, FALSE, type);
+    byte_t *elem = heap_malloc(esize, "HashTabRead");
+    cassert_no_nullf(func_read_init);
+    hashtab_reserve(tab, elems);
+    for (i = 0; i < elems; ++i)
+    {
+        byte_t *slot = NULL;
+        func_read_init(stream, (void*)elem);
+        slot = hashtab_insert(tab, (const void*)elem);
+        cassert_unref(slot != NULL, slot);
+    }
+
+    heap_free(&elem, esize, "HashTabRead");
+    return tab;
+}
+
+/*---------------------------------------------------------------------------*/
+
+HashTab *hashtab_read_ptr(Stream *stream, FPtr_hash func_hash, FPtr_compare func_compare, FPtr_read func_read, const char_t *type)
+{
+    uint32_t i, elems = stm_read_u32(stream);
+    HashTab *tab = hashtab_create_ptr(func_hash, func_compare, type);
+    cassert_no_nullf(func_read);
+    hashtab_reserve(tab, elems);
+    for (i = 0; i < elems; ++i)
+    {
+        void *elem = func_read(stream);
+        bool_t ok = hashtab_insert_ptr(tab, elem);
+        cassert_unref(ok == TRUE, ok);
+    }
+
+    return tab;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_remove_elems(HashTab *tab, FPtr_remove func_remove, FPtr_destroy func_destroy)
+{
+    cassert_no_null(tab);
+    if (func_remove != NULL || func_destroy != NULL)
+    {
+        register uint32_t i;
+        register byte_t *slot = tab->data;
+        cassert(func_remove == NULL || func_destroy == NULL);
+        for (i = 0; i < tab->capacity; ++i, slot += tab->esize)
+        {
+            if (tab->hashes[i] > i_DELETED)
+            {
+                if (func_remove != NULL)
+                {
+                    func_remove((void*)slot);
+                }
+                else
+                {
+                    if (*(void**)slot != NULL)
+                        func_destroy((void**)slot);
+                }
+            }
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_dealloc(HashTab *tab)
+{
+    cassert_no_null(tab);
+    if (tab->capacity > 0)
+    {
+        heap_free(&tab->data, tab->capacity * tab->esize, "HashTabData");
+        heap_delete_n(&tab->hashes, tab->capacity, uint32_t);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void hashtab_destroy(HashTab **tab, FPtr_remove func_remove, const char_t *type)
+{
+    cassert_no_null(tab);
+    cassert_no_null(*tab);
+    cassert((*tab)->isptr == FALSE);
+    i_remove_elems(*tab, func_remove, NULL);
+    i_dealloc(*tab);
+    heap_free((byte_t**)tab, sizeof(HashTab), type);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void hashtab_destroy_ptr(HashTab **tab, FPtr_destroy func_destroy, const char_t *type)
+{
+    cassert_no_null(tab);
+    cassert_no_null(*tab);
+    cassert((*tab)->isptr == TRUE);
+    i_remove_elems(*tab, NULL, func_destroy);
+    i_dealloc(*tab);
+    heap_free((byte_t**)tab, sizeof(HashTab), type);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_clear(HashTab *tab, FPtr_remove func_remove, FPtr_destroy func_destroy)
+{
+    i_remove_elems(tab, func_remove, func_destroy);
+    if (tab->capacity > 0)
+        bmem_zero_n(tab->hashes, tab->capacity, uint32_t);
+    tab->elems = 0;
+    tab->used = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void hashtab_clear(HashTab *tab, FPtr_remove func_remove)
+{
+    cassert_no_null(tab);
+    cassert(tab->isptr == FALSE);
+    i_clear(tab, func_remove, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void hashtab_clear_ptr(HashTab *tab, FPtr_destroy func_destroy)
+{
+    cassert_no_null(tab);
+    cassert(tab->isptr == TRUE);
+    i_clear(tab, NULL, func_destroy);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE const void *i_elem(const HashTab *tab, const byte_t *slot)
+{
+    if (tab->isptr == TRUE)
+        return *(const void**)slot;
+    return (const void*)slot;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void hashtab_write(Stream *stream, const HashTab *tab, FPtr_write func_write)
+{
+    register uint32_t i;
+    register const byte_t *slot;
+    cassert_no_null(tab);
+    cassert_no_nullf(func_write);
+    stm_write_u32(stream, tab->elems);
+    slot = tab->data;
+    for (i = 0; i < tab->capacity; ++i, slot += tab->esize)
+    {
+        if (tab->hashes[i] > i_DELETED)
+            func_write(stream, i_elem(tab, slot));
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t hashtab_size(const HashTab *tab)
+{
+    cassert_no_null(tab);
+    return tab->elems;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_capacity(const uint32_t elems)
+{
+    /* Max load factor 3/4 */
+    uint32_t capacity = i_MIN_CAPACITY;
+    while ((uint64_t)elems * 4 > (uint64_t)capacity * 3)
+    {
+        cassert(capacity < 0x80000000);
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rehash(HashTab *tab, const uint32_t capacity)
+{
+    uint32_t *hashes = NULL;
+    byte_t *data = NULL;
+    register uint32_t i, mask = capacity - 1;
+    register const byte_t *slot;
+
+    cassert_no_null(tab);
+    cassert((capacity & mask) == 0);
+    cassert(capacity >= tab->elems);
+    cassert((uint64_t)capacity * (uint64_t)tab->esize <= 0xFFFFFFFF);
+    hashes = heap_new_n0(capacity, uint32_t);
+    data = heap_malloc((uint32_t)((uint64_t)capacity * (uint64_t)tab->esize), "HashTabData");
+    slot = tab->data;
+    for (i = 0; i < tab->capacity; ++i, slot += tab->esize)
+    {
+        register uint32_t hash = tab->hashes[i];
+        if (hash > i_DELETED)
+        {
+            register uint32_t idx = hash & mask;
+            while (hashes[idx] != i_EMPTY)
+                idx = (idx + 1) & mask;
+
+            hashes[idx] = hash;
+            bmem_copy(data + idx * tab->esize, slot, tab->esize);
+        }
+    }
+
+    i_dealloc(tab);
+    tab->hashes = hashes;
+    tab->data = data;
+    tab->capacity = capacity;
+    tab->used = tab->elems;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void hashtab_reserve(HashTab *tab, const uint32_t elems)
+{
+    uint32_t capacity = i_capacity(elems);
+    cassert_no_null(tab);
+    if (capacity > tab->capacity)
+        i_rehash(tab, capacity);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint32_t i_hash(const HashTab *tab, const void *key)
+{
+    uint32_t hash = 0;
+    if (tab->func_hash != NULL)
+        hash = tab->func_hash(key);
+    else
+        hash = bhash_from_block((const byte_t*)key, (uint32_t)tab->esize);
+
+    return hash > i_DELETED ? hash : hash + 2;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE bool_t i_equal(const HashTab *tab, const byte_t *slot, const void *key)
+{
+    const void *elem = i_elem(tab, slot);
+    if (tab->func_compare != NULL)
+        return (bool_t)(tab->func_compare(elem, key) == 0);
+    return (bool_t)(bmem_cmp((const byte_t*)elem, (const byte_t*)key, (uint32_t)tab->esize) == 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_find(const HashTab *tab, const void *key, const uint32_t hash)
+{
+    register uint32_t idx, mask;
+    cassert_no_null(tab);
+    if (tab->elems == 0)
+        return i_NO_SLOT;
+
+    mask = tab->capacity - 1;
+    idx = hash & mask;
+    while (tab->hashes[idx] != i_EMPTY)
+    {
+        if (tab->hashes[idx] == hash && i_equal(tab, tab->data + idx * tab->esize, key) == TRUE)
+            return idx;
+        idx = (idx + 1) & mask;
+    }
+
+    return i_NO_SLOT;
+}
+
+/*---------------------------------------------------------------------------*/
+
+byte_t *hashtab_get(const HashTab *tab, const void *key)
+{
+    uint32_t idx = 0;
+    cassert_no_null(tab);
+    if (tab->elems == 0)
+        return NULL;
+
+    idx = i_find(tab, key, i_hash(tab, key));
+    if (idx == i_NO_SLOT)
+        return NULL;
+
+    return (byte_t*)i_elem(tab, tab->data + idx * tab->esize);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static byte_t *i_insert(HashTab *tab, const void *key, bool_t *exists)
+{
+    uint32_t hash, idx, mask, free_idx = i_NO_SLOT;
+    cassert_no_null(tab);
+    cassert_no_null(exists);
+
+    /* Deleted slots count as used, rehash also purges them */
+    if ((uint64_t)(tab->used + 1) * 4 > (uint64_t)tab->capacity * 3)
+        i_rehash(tab, i_capacity(tab->elems + 1));
+
+    hash = i_hash(tab, key);
+    mask = tab->capacity - 1;
+    idx = hash & mask;
+    while (tab->hashes[idx] != i_EMPTY)
+    {
+        if (tab->hashes[idx] == i_DELETED)
+        {
+            if (free_idx == i_NO_SLOT)
+                free_idx = idx;
+        }
+        else if (tab->hashes[idx] == hash && i_equal(tab, tab->data + idx * tab->esize, key) == TRUE)
+        {
+            *exists = TRUE;
+            return tab->data + idx * tab->esize;
+        }
+
+        idx = (idx + 1) & mask;
+    }
+
+    if (free_idx != i_NO_SLOT)
+        idx = free_idx;
+    else
+        tab->used += 1;
+
+    tab->hashes[idx] = hash;
+    tab->elems += 1;
+    *exists = FALSE;
+    return tab->data + idx * tab->esize;
+}
+
+/*---------------------------------------------------------------------------*/
+
+byte_t *hashtab_insert(HashTab *tab, const void *key)
+{
+    bool_t exists = FALSE;
+    byte_t *slot = NULL;
+    cassert_no_null(tab);
+    cassert(tab->isptr == FALSE);
+    slot = i_insert(tab, key, &exists);
+    if (exists == TRUE)
+        return NULL;
+
+    bmem_copy(slot, (const byte_t*)key, tab->esize);
+    return slot;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t hashtab_insert_ptr(HashTab *tab, void *ptr)
+{
+    bool_t exists = FALSE;
+    byte_t *slot = NULL;
+    cassert_no_null(tab);
+    cassert(tab->isptr == TRUE);
+    slot = i_insert(tab, ptr, &exists);
+    if (exists == TRUE)
+        return FALSE;
+
+    *(void**)slot = ptr;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_delete_slot(HashTab *tab, const uint32_t idx)
+{
+    register uint32_t mask = tab->capacity - 1;
+    cassert(tab->hashes[idx] > i_DELETED);
+    tab->elems -= 1;
+
+    /* Slot ends a probe chain, it can be emptied (and deleted ones behind it) */
+    if (tab->hashes[(idx + 1) & mask] == i_EMPTY)
+    {
+        register uint32_t i = idx;
+        do
+        {
+            tab->hashes[i] = i_EMPTY;
+            tab->used -= 1;
+            i = (i - 1) & mask;
+        } while (tab->hashes[i] == i_DELETED);
+    }
+    else
+    {
+        tab->hashes[idx] = i_DELETED;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t hashtab_delete(HashTab *tab, const void *key, FPtr_remove func_remove)
+{
+    uint32_t idx = 0;
+    cassert_no_null(tab);
+    cassert(tab->isptr == FALSE);
+    idx = i_find(tab, key, i_hash(tab, key));
+    if (idx == i_NO_SLOT)
+        return FALSE;
+
+    if (func_remove != NULL)
+        func_remove((void*)(tab->data + idx * tab->esize));
+
+    i_delete_slot(tab, idx);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t hashtab_delete_ptr(HashTab *tab, const void *key, FPtr_destroy func_destroy)
+{
+    uint32_t idx = 0;
+    cassert_no_null(tab);
+    cassert(tab->isptr == TRUE);
+    idx = i_find(tab, key, i_hash(tab, key));
+    if (idx == i_NO_SLOT)
+        return FALSE;
+
+    if (func_destroy != NULL)
+        func_destroy((void**)(tab->data + idx * tab->esize));
+
+    i_delete_slot(tab, idx);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static byte_t *i_iterate(const HashTab *tab, uint32_t *it)
+{
+    register uint32_t i;
+    cassert_no_null(tab);
+    cassert_no_null(it);
+    for (i = *it; i < tab->capacity; ++i)
+    {
+        if (tab->hashes[i] > i_DELETED)
+        {
+            *it = i;
+            return (byte_t*)i_elem(tab, tab->data + i * tab->esize);
+        }
+    }
+
+    *it = tab->capacity;
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+byte_t *hashtab_first(const HashTab *tab, uint32_t *it)
+{
+    cassert_no_null(it);
+    *it = 0;
+    return i_iterate(tab, it);
+}
+
+/*---------------------------------------------------------------------------*/
+
+byte_t *hashtab_next(const HashTab *tab, uint32_t *it)
+{
+    cassert_no_null(tab);
+    cassert_no_null(it);
+    if (*it < tab->capacity)
+        *it += 1;
+    return i_iterate(tab, it);
+}
@@ -21,9 +21,27 @@
 #include "log.h"
 #include "strings.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 typedef struct i_page_t i_Page;
+typedef struct i_slab_t i_Slab;
+typedef struct i_slabclass_t i_SlabClass;
+typedef struct i_chunk_t i_Chunk;
+typedef struct i_arena_t i_Arena;
 typedef struct i_memory_t i_Memory;
 
+#define PAGE_MARK 0xA16F9B0C
+#define PAGE_CREDITS 0x7FFFFFFF
+#define SLAB_MARK 0x5EAB1C4D
+#define CHUNK_MARK 0x4E61C3A7
+#define DEFAULT_CHUNK_SIZE 65536
+#define SLAB_SIZE 16384
+#define SLAB_GRANULE 16
+#define SLAB_MAX_SIZE 256
+#define NUM_SLAB_CLASSES (SLAB_MAX_SIZE / SLAB_GRANULE)
+
 #if defined (__MEMORY_AUDITOR__)
 
 #define OBJECT_NAME_SIZE 64
@@ -51,22 +69,87 @@ struct i_access_t
 
 #endif
 
+/*
+ * Pages are owned by one arena (thread), but any thread can free their blocks.
+ * When a page becomes the arena current page, it is charged with PAGE_CREDITS
+ * references. The owner bump-allocates without atomics (num_allocs), each
+ * free (local or remote) atomically consumes one reference, and when the page
+ * is retired the unused credits are returned. Whoever drops 'refs' to zero
+ * destroys the page.
+ */
 struct i_page_t
 {
+    uint32_t mark;
+    volatile int32_t refs;
     uint32_t num_allocs;
-    uint32_t used_memory;
     uint32_t offset;
+    i_Arena *arena;
+};
+
+/*
+ * Small 'equal_sized' objects (heap_new) are stored in segregated size-class
+ * slabs. Freed slots are reused immediately through the slab free list.
+ * Slots released by other threads are pushed in 'remote_list' (lock-free)
+ * and collected by the owner when it runs out of local slots.
+ */
+struct i_slab_t
+{
     uint32_t mark;
-    i_Page *next;
-    i_Page *prev;
+    uint32_t sclass;
+    uint32_t used;
+    uint32_t bump;
+    byte_t *free_list;
+    void *volatile remote_list;
+    i_Arena *arena;
+    i_Slab *prev;
+    i_Slab *next;
+    i_Slab *prev_partial;
+    i_Slab *next_partial;
+    bool_t in_partial;
 };
 
-struct i_memory_t
+struct i_slabclass_t
+{
+    i_Slab *slabs;
+    i_Slab *partial;
+    volatile int32_t remote_pending;
+    uint32_t num_slabs;
+    uint32_t max_slabs;
+    uint32_t used_slots;
+    uint32_t max_used_slots;
+    uint32_t slabs_alloc;
+    uint32_t slabs_dealloc;
+    uint64_t num_allocs;
+    uint64_t bytes_requested;
+};
+
+/*
+ * HeapArena (region) memory is bump-allocated in chunks. heap_free over a
+ * region block does nothing, the whole region is released at once in
+ * heap_arena_destroy.
+ */
+struct i_chunk_t
+{
+    uint32_t mark;
+    uint32_t offset;
+    uint32_t size;
+    i_Chunk *next;
+    HeapArena *region;
+};
+
+struct _heaparena_t
+{
+    i_Chunk *chunk;
+    uint32_t chunk_size;
+    uint32_t num_chunks;
+    uint64_t num_allocs;
+    uint64_t bytes_allocated;
+    HeapArena *prev;
+    bool_t active;
+};
+
+struct i_arena_t
 {
-    int main_thread_id;
-    Mutex *mutex;
-    uint32_t mtcount;
-    uint32_t page_size;
     i_Page *current_page;
     uint64_t num_allocs;
     uint64_t total_bytes_allocated;
@@ -75,12 +158,18 @@ struct i_memory_t
     uint64_t num_reallocs;
     uint64_t num_effective_reallocs;
     uint64_t total_bytes_moved_in_reallocs;
-    uint64_t bytes_allocated;
-    uint64_t max_bytes_allocated;
     uint32_t std_pages_alloc;
     uint32_t great_pages_alloc;
-    uint32_t std_pages_dealloc;
+    /* Updated by any thread that frees the last block of a page */
+    volatile uint32_t std_pages_dealloc;
     uint32_t great_pages_dealloc;
+    i_SlabClass slabs[NUM_SLAB_CLASSES];
+    HeapArena *region;
+    uint32_t num_regions;
+    uint64_t region_allocs;
+    uint64_t region_bytes;
+    bool_t orphan;
+    i_Arena *next;
 
     #if defined (__MEMORY_AUDITOR__)
     i_Object *objects;
@@ -89,6 +178,20 @@ struct i_memory_t
     #endif
 };
 
+struct i_memory_t
+{
+    int main_thread_id;
+    Mutex *mutex;
+    uint32_t mtcount;
+    uint32_t page_size;
+    uint32_t num_arenas;
+    /* Live bytes are shared by all arenas (blocks can be freed by other thread) */
+    volatile int64_t bytes_allocated;
+    volatile int64_t max_bytes_allocated;
+    i_Arena main_arena;
+    i_Arena *thread_arenas;
+};
+
 /*---------------------------------------------------------------------------*/
 
 static i_Memory i_MEMORY;
@@ -103,40 +206,374 @@ static i_Memory i_MEMORY;
     #define DEFAULT_PAGE_SIZE   65536
 #endif
 
+#if defined(__GNUC__)
+    #define i_THREAD_LOCAL          __thread
+    #define i_atomic_sub(ptr, n)    __atomic_sub_fetch(ptr, n, __ATOMIC_ACQ_REL)
+    #define i_atomic_xchg(ptr, v)   __atomic_exchange_n(ptr, v, __ATOMIC_ACQ_REL)
+    #define i_atomic_xchg32(ptr, v) __atomic_exchange_n(ptr, v, __ATOMIC_ACQ_REL)
+    #define i_atomic_cas(ptr, expected, v) __atomic_compare_exchange_n(ptr, expected, v, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+    #define i_atomic_add32(ptr, n)  __atomic_add_fetch(ptr, n, __ATOMIC_RELAXED)
+    #define i_atomic_add64(ptr, n)  __atomic_add_fetch(ptr, n, __ATOMIC_RELAXED)
+    #define i_atomic_cas64(ptr, expected, v) __atomic_compare_exchange_n(ptr, expected, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+    #define i_THREAD_LOCAL          __declspec(thread)
+    #define i_atomic_sub(ptr, n)    (_InterlockedExchangeAdd((volatile long*)(ptr), -(long)(n)) - (long)(n))
+    #define i_atomic_xchg(ptr, v)   _InterlockedExchangePointer((void*volatile*)(ptr), v)
+    #define i_atomic_xchg32(ptr, v) _InterlockedExchange((volatile long*)(ptr), (long)(v))
+    #define i_atomic_cas(ptr, expected, v) i_msvc_cas((void*volatile*)(ptr), (void**)(expected), v)
+    #define i_atomic_add32(ptr, n)  (_InterlockedExchangeAdd((volatile long*)(ptr), (long)(n)) + (long)(n))
+    #define i_atomic_add64(ptr, n)  (_InterlockedExchangeAdd64((volatile __int64*)(ptr), (__int64)(n)) + (__int64)(n))
+    #define i_atomic_cas64(ptr, expected, v) i_msvc_cas64((volatile __int64*)(ptr), (__int64*)(expected), (__int64)(v))
+    static __INLINE bool_t i_msvc_cas(void *volatile *ptr, void **expected, void *value)
+    {
+        void *prev = _InterlockedCompareExchangePointer(ptr, value, *expected);
+        if (prev == *expected)
+            return TRUE;
+        *expected = prev;
+        return FALSE;
+    }
+    static __INLINE bool_t i_msvc_cas64(volatile __int64 *ptr, __int64 *expected, __int64 value)
+    {
+        __int64 prev = _InterlockedCompareExchange64(ptr, value, *expected);
+        if (prev == *expected)
+            return TRUE;
+        *expected = prev;
+        return FALSE;
+    }
+#endif
+
 #define OBJECTS_ARRAY_GROW_SIZE 128
 static uint32_t i_PAGESIZE = DEFAULT_PAGE_SIZE;
 static bool_t i_HEAP_VERBOSE = FALSE;
 static bool_t i_HEAP_STATS = TRUE;
 static bool_t i_HEAP_LEAKS = FALSE;
+static i_THREAD_LOCAL i_Arena *i_THREAD_ARENA = NULL;
 
 /*---------------------------------------------------------------------------*/
 
 static void i_init_page(i_Page *page)
 {
     cassert_no_null(page);
+    page->refs = PAGE_CREDITS;
     page->num_allocs = 0;
-    page->used_memory = 0;
     page->offset = sizeof(i_Page);
-    page->mark = 0xA16F9B0C;
+    page->mark = PAGE_MARK;
 }
 
 /*---------------------------------------------------------------------------*/
 
-static void i_new_page(const uint32_t page_size, i_Page **current_page, uint32_t *num_pages)
+static void i_release_page(i_Arena *arena, i_Page *page, const int32_t refs)
+{
+    cassert_no_null(arena);
+    cassert_no_null(page);
+    if (i_atomic_sub(&page->refs, refs) == 0)
+    {
+        bmem_free((byte_t*)page);
+        i_atomic_add32(&arena->std_pages_dealloc, 1);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_new_page(const uint32_t page_size, i_Arena *arena)
 {
     i_Page *new_page = NULL;
-    cassert_no_null(current_page);
-    cassert_no_null(num_pages);
+    cassert_no_null(arena);
     new_page = (i_Page*)bmem_malloc(page_size);
-    *num_pages += 1;
+    arena->std_pages_alloc += 1;
     i_init_page(new_page);
-    new_page->next = NULL;
-    new_page->prev = *current_page;
+    new_page->arena = arena;
 
-    if ((*current_page) != NULL)
-        (*current_page)->next = new_page;
+    /* Retire the previous page, returning the unused credits */
+    if (arena->current_page != NULL)
+    {
+        i_Page *page = arena->current_page;
+        arena->current_page = new_page;
+        i_release_page(arena, page, PAGE_CREDITS - (int32_t)page->num_allocs);
+    }
+    else
+    {
+        arena->current_page = new_page;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint32_t i_slab_class(const uint32_t size)
+{
+    cassert(size > 0 && size <= SLAB_MAX_SIZE);
+    return (size - 1) / SLAB_GRANULE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint32_t i_slab_stride(const uint32_t sclass)
+{
+    return (sclass + 1) * SLAB_GRANULE + (uint32_t)sizeof(void*);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint32_t i_slab_slots(const uint32_t sclass)
+{
+    return (SLAB_SIZE - (uint32_t)sizeof(i_Slab)) / i_slab_stride(sclass);
+}
+
+/*---------------------------------------------------------------------------*/
 
-    *current_page = new_page;
+static void i_partial_add(i_SlabClass *sclass, i_Slab *slab)
+{
+    cassert_no_null(sclass);
+    cassert_no_null(slab);
+    cassert(slab->in_partial == FALSE);
+    slab->prev_partial = NULL;
+    slab->next_partial = sclass->partial;
+    if (sclass->partial != NULL)
+        sclass->partial->prev_partial = slab;
+    sclass->partial = slab;
+    slab->in_partial = TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_partial_remove(i_SlabClass *sclass, i_Slab *slab)
+{
+    cassert_no_null(sclass);
+    cassert_no_null(slab);
+    cassert(slab->in_partial == TRUE);
+    if (slab->prev_partial != NULL)
+        slab->prev_partial->next_partial = slab->next_partial;
+    else
+        sclass->partial = slab->next_partial;
+    if (slab->next_partial != NULL)
+        slab->next_partial->prev_partial = slab->prev_partial;
+    slab->prev_partial = NULL;
+    slab->next_partial = NULL;
+    slab->in_partial = FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_Slab *i_new_slab(i_Arena *arena, const uint32_t sclass)
+{
+    i_SlabClass *cls = NULL;
+    i_Slab *slab = NULL;
+    cassert_no_null(arena);
+    cls = arena->slabs + sclass;
+    slab = (i_Slab*)bmem_malloc(SLAB_SIZE);
+    bmem_zero(slab, i_Slab);
+    slab->mark = SLAB_MARK;
+    slab->sclass = sclass;
+    slab->arena = arena;
+    slab->next = cls->slabs;
+    if (cls->slabs != NULL)
+        cls->slabs->prev = slab;
+    cls->slabs = slab;
+    cls->num_slabs += 1;
+    cls->slabs_alloc += 1;
+    if (cls->num_slabs > cls->max_slabs)
+        cls->max_slabs = cls->num_slabs;
+    i_partial_add(cls, slab);
+    return slab;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_delete_slab(i_Arena *arena, i_Slab *slab)
+{
+    i_SlabClass *cls = NULL;
+    cassert_no_null(arena);
+    cassert_no_null(slab);
+    cassert(slab->used == 0);
+    cls = arena->slabs + slab->sclass;
+    if (slab->in_partial == TRUE)
+        i_partial_remove(cls, slab);
+    if (slab->prev != NULL)
+        slab->prev->next = slab->next;
+    else
+        cls->slabs = slab->next;
+    if (slab->next != NULL)
+        slab->next->prev = slab->prev;
+    cls->num_slabs -= 1;
+    cls->slabs_dealloc += 1;
+    bmem_free((byte_t*)slab);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Move the slots released by other threads to the local free list */
+static bool_t i_slab_collect(i_Arena *arena, i_Slab *slab)
+{
+    byte_t *list = NULL;
+    cassert_no_null(arena);
+    cassert_no_null(slab);
+    if (slab->remote_list == NULL)
+        return FALSE;
+
+    list = (byte_t*)i_atomic_xchg(&slab->remote_list, NULL);
+    if (list != NULL)
+    {
+        uint32_t n = 0;
+        byte_t *last = list;
+        for (;;)
+        {
+            byte_t *next = *((byte_t**)last);
+            n += 1;
+            if (next == NULL)
+                break;
+            last = next;
+        }
+
+        *((byte_t**)last) = slab->free_list;
+        slab->free_list = list;
+        cassert(slab->used >= n);
+        slab->used -= n;
+        arena->slabs[slab->sclass].used_slots -= n;
+        if (slab->in_partial == FALSE)
+            i_partial_add(arena->slabs + slab->sclass, slab);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static byte_t *i_slab_malloc(i_Arena *arena, const uint32_t size)
+{
+    uint32_t sclass = i_slab_class(size);
+    i_SlabClass *cls = arena->slabs + sclass;
+    i_Slab *slab = cls->partial;
+    byte_t *mem = NULL;
+
+    /* No local slots, check slots released by other threads */
+    if (slab == NULL && i_atomic_xchg32(&cls->remote_pending, 0) != 0)
+    {
+        i_Slab *rslab = cls->slabs;
+        while (rslab != NULL)
+        {
+            i_slab_collect(arena, rslab);
+            rslab = rslab->next;
+        }
+
+        slab = cls->partial;
+    }
+
+    if (slab == NULL)
+        slab = i_new_slab(arena, sclass);
+
+    if (slab->free_list != NULL)
+    {
+        mem = slab->free_list;
+        slab->free_list = *((byte_t**)mem);
+    }
+    else
+    {
+        cassert(slab->bump < i_slab_slots(sclass));
+        mem = (byte_t*)slab + sizeof(i_Slab) + slab->bump * i_slab_stride(sclass);
+        slab->bump += 1;
+    }
+
+    slab->used += 1;
+    cls->used_slots += 1;
+    cls->num_allocs += 1;
+    cls->bytes_requested += size;
+    if (cls->used_slots > cls->max_used_slots)
+        cls->max_used_slots = cls->used_slots;
+
+    /* Slab exhausted, it leaves the partial list */
+    if (slab->free_list == NULL && slab->bump == i_slab_slots(sclass))
+    {
+        if (i_slab_collect(arena, slab) == FALSE)
+            i_partial_remove(cls, slab);
+    }
+
+    *((void**)(mem + size)) = (void*)slab;
+    return mem;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_slab_free(i_Arena *arena, i_Slab *slab, byte_t *mem)
+{
+    cassert_no_null(arena);
+    cassert_no_null(slab);
+
+    /* Local free, the slot will be reused in next allocation */
+    if (slab->arena == arena)
+    {
+        i_SlabClass *cls = arena->slabs + slab->sclass;
+        cassert(slab->used > 0);
+        *((byte_t**)mem) = slab->free_list;
+        slab->free_list = mem;
+        slab->used -= 1;
+        cls->used_slots -= 1;
+
+        if (slab->used == 0 && cls->num_slabs > 1)
+            i_delete_slab(arena, slab);
+        else if (slab->in_partial == FALSE)
+            i_partial_add(cls, slab);
+    }
+    /* Remote free, lock-free push in owner slab */
+    else
+    {
+        /* Once the slot is published, the owner can collect it and delete
+           the slab. Nothing can be read through 'slab' after the CAS. */
+        volatile int32_t *pending = &slab->arena->slabs[slab->sclass].remote_pending;
+        void *head = slab->remote_list;
+        do
+        {
+            *((void**)mem) = head;
+        } while (i_atomic_cas(&slab->remote_list, &head, (void*)mem) == 0);
+
+        i_atomic_xchg32(pending, 1);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_init_arena(i_Arena *arena, const uint32_t page_size)
+{
+    cassert_no_null(arena);
+    bmem_zero(arena, i_Arena);
+    i_new_page(page_size, arena);
+
+    #if defined (__MEMORY_AUDITOR__)
+    arena->objects_alloc = OBJECTS_ARRAY_GROW_SIZE;
+    arena->objects = (i_Object*)bmem_malloc((uint32_t)(arena->objects_alloc * sizeof(i_Object)));
+    arena->num_objects = 0;
+    #endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_remove_arena(i_Arena *arena)
+{
+    register uint32_t i;
+    cassert_no_null(arena);
+    bmem_free((byte_t*)arena->current_page);
+    arena->current_page = NULL;
+
+    for (i = 0; i < NUM_SLAB_CLASSES; ++i)
+    {
+        i_Slab *slab = arena->slabs[i].slabs;
+        while (slab != NULL)
+        {
+            i_Slab *next = slab->next;
+            bmem_free((byte_t*)slab);
+            slab = next;
+        }
+
+        arena->slabs[i].slabs = NULL;
+        arena->slabs[i].partial = NULL;
+    }
+
+    #if defined (__MEMORY_AUDITOR__)
+    bmem_free((byte_t*)arena->objects);
+    arena->objects = NULL;
+    arena->num_objects = 0;
+    arena->objects_alloc = 0;
+    #endif
 }
 
 /*---------------------------------------------------------------------------*/
@@ -146,77 +583,153 @@ static void i_init_memory(i_Memory *memory, const uint32_t page_size)
     cassert_no_null(memory);
     /* Page size is power of 2 */
     cassert((page_size != 0) && (page_size & (page_size - 1)) == 0);
+
+    /* Audit of the blocks allocated before heap start is discarded */
+    #if defined (__MEMORY_AUDITOR__)
+    if (memory->main_arena.objects != NULL)
+        bmem_free((byte_t*)memory->main_arena.objects);
+    #endif
+
     bmem_zero(memory, i_Memory);
     memory->main_thread_id = bthread_current_id();
     memory->mutex = bmutex_create();
     memory->mtcount = 0;
     memory->page_size = page_size;
-    i_new_page(memory->page_size, &memory->current_page, &memory->std_pages_alloc);
-
-    #if defined (__MEMORY_AUDITOR__)
-    memory->objects_alloc = OBJECTS_ARRAY_GROW_SIZE;
-    memory->objects = (i_Object*)bmem_malloc((uint32_t)(memory->objects_alloc * sizeof(i_Object)));
-    memory->num_objects = 0;
-    #endif
+    memory->num_arenas = 1;
+    memory->thread_arenas = NULL;
+    i_init_arena(&memory->main_arena, page_size);
+    i_THREAD_ARENA = &memory->main_arena;
 }
 
 /*---------------------------------------------------------------------------*/
 
 static void i_remove_memory(i_Memory *memory)
 {
+    i_Arena *arena = NULL;
     cassert_no_null(memory);
     cassert(bthread_current_id() == memory->main_thread_id);
     cassert(memory->mtcount == 0);
 
-    bmem_free((byte_t*)memory->current_page);
-    memory->current_page = NULL;
+    arena = memory->thread_arenas;
+    while (arena != NULL)
+    {
+        i_Arena *next = arena->next;
+        i_remove_arena(arena);
+        bmem_free((byte_t*)arena);
+        arena = next;
+    }
+
+    i_remove_arena(&memory->main_arena);
+    memory->thread_arenas = NULL;
+    memory->num_arenas = 0;
+    memory->page_size = 0;
+    i_THREAD_ARENA = NULL;
     bmutex_close(&memory->mutex);
+}
 
-    #if defined (__MEMORY_AUDITOR__)
-    bmem_free((byte_t*)memory->objects);
-    memory->objects = NULL;
-    memory->num_objects = 0;
-    memory->objects_alloc = 0;
-    #endif
+/*---------------------------------------------------------------------------*/
+
+static i_Arena *i_acquire_arena(i_Memory *memory)
+{
+    i_Arena *arena = NULL;
+    cassert_no_null(memory);
+
+    /* Heap not started yet: unpaged blocks in main arena, not cached,
+       so the thread picks its arena after '_heap_start' */
+    if (memory->mutex == NULL)
+        return &memory->main_arena;
+
+    if (bthread_current_id() == memory->main_thread_id)
+    {
+        arena = &memory->main_arena;
+    }
+    else
+    {
+        bmutex_lock(memory->mutex);
+
+        /* Reuse the arena of a finished thread */
+        arena = memory->thread_arenas;
+        while (arena != NULL && arena->orphan == FALSE)
+            arena = arena->next;
+
+        if (arena != NULL)
+        {
+            arena->orphan = FALSE;
+        }
+        else
+        {
+            arena = (i_Arena*)bmem_malloc(sizeof32(i_Arena));
+            i_init_arena(arena, memory->page_size);
+            arena->next = memory->thread_arenas;
+            memory->thread_arenas = arena;
+            memory->num_arenas += 1;
+        }
+
+        bmutex_unlock(memory->mutex);
+    }
+
+    i_THREAD_ARENA = arena;
+    return arena;
 }
 
 /*---------------------------------------------------------------------------*/
 
-static byte_t* i_malloc(i_Memory *memory, const uint32_t size, const uint32_t align)
+static __INLINE i_Arena *i_arena(void)
+{
+    if (__TRUE_EXPECTED(i_THREAD_ARENA != NULL))
+        return i_THREAD_ARENA;
+    return i_acquire_arena(&i_MEMORY);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE bool_t i_is_paged(const uint32_t size, const uint32_t align)
+{
+    return (bool_t)(size + align + sizeof(i_Page) + sizeof(void*) < i_MEMORY.page_size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static byte_t* i_malloc(i_Arena *arena, const uint32_t size, const uint32_t align)
 {
     byte_t *mem = NULL;
 
-    cassert_no_null(memory);
-    cassert_no_null(memory->current_page);
+    cassert_no_null(arena);
 
     /* Block can be stored by paged allocator */
-    if (__TRUE_EXPECTED(size + align + sizeof(i_Page) + sizeof(void*) < memory->page_size))
+    if (__TRUE_EXPECTED(i_is_paged(size, align) == TRUE))
     {
-        register uint32_t mod = memory->current_page->offset % align;
-        register uint32_t offset = memory->current_page->offset;
+        register uint32_t mod = 0;
+        register uint32_t offset = 0;
+        cassert_no_null(arena->current_page);
+        mod = arena->current_page->offset % align;
+        offset = arena->current_page->offset;
 
         if (mod > 0)
             offset += align - mod;
 
         /* Block can't be stored in current page */
-        if (offset + size + sizeof(void*) >= memory->page_size)
+        if (offset + size + sizeof(void*) >= i_MEMORY.page_size)
         {
-            i_new_page(memory->page_size, &memory->current_page, &memory->std_pages_alloc);
-            offset = memory->current_page->offset + (memory->current_page->offset % align);
+            i_new_page(i_MEMORY.page_size, arena);
+            offset = arena->current_page->offset;
+            mod = offset % align;
+            if (mod > 0)
+                offset += align - mod;
         }
 
-        cassert(offset + size + sizeof(void*) < memory->page_size);
-        memory->current_page->num_allocs += 1;
-        memory->current_page->used_memory += size;
-        memory->current_page->offset = offset + size + (uint32_t)sizeof(void*);
-        mem = (byte_t*)memory->current_page + offset;
-        *((void**)(mem + size)) = (void*)memory->current_page;
+        cassert(offset + size + sizeof(void*) < i_MEMORY.page_size);
+        arena->current_page->num_allocs += 1;
+        arena->current_page->offset = offset + size + (uint32_t)sizeof(void*);
+        mem = (byte_t*)arena->current_page + offset;
+        *((void**)(mem + size)) = (void*)arena->current_page;
     }
-    /* Block needs its own allocation */
+    /* Block needs its own allocation, with a NULL trailer */
     else
     {
-        mem = bmem_aligned_malloc(size, align);
-        memory->great_pages_alloc += 1;
+        mem = bmem_aligned_malloc(size + sizeof32(void*), align);
+        *((void**)(mem + size)) = NULL;
+        arena->great_pages_alloc += 1;
     }
 
     cassert_fatal((mem != NULL) && ((intptr_t)mem % (intptr_t)align) == 0);
@@ -225,9 +738,9 @@ static byte_t* i_malloc(i_Memory *memory, const uint32_t size, const uint32_t al
 
 /*---------------------------------------------------------------------------*/
 
-static void i_free(i_Memory *memory, byte_t *mem, const uint32_t size, const uint32_t align)
+static void i_free(i_Arena *arena, byte_t *mem, const uint32_t size, const uint32_t align)
 {
-    cassert_no_null(memory);
+    cassert_no_null(arena);
 
     /* Block filled with waste */
     #if defined (__ASSERTS__)
@@ -235,71 +748,66 @@ static void i_free(i_Memory *memory, byte_t *mem, const uint32_t size, const uin
     #endif
 
     /* Block was stored by paged allocator */
-    if (__TRUE_EXPECTED(size + align + sizeof(i_Page) + sizeof(void*) < memory->page_size))
+    if (__TRUE_EXPECTED(i_is_paged(size, align) == TRUE))
     {
         i_Page *page = (i_Page*)*((void**)(mem + size));
+        int32_t refs = 0;
         cassert_no_null(page);
-        cassert(page->mark == 0xA16F9B0C);
-        cassert(page->num_allocs > 0);
-        cassert(page->used_memory >= size);
-        page->num_allocs -= 1;
-        page->used_memory -= size;
-
-        /* The whole page is freeded, we destroy the page */
-        if (page->num_allocs == 0)
+
+        /* Block was stored in a size-class slab */
+        if (page->mark == SLAB_MARK)
         {
-            cassert(page->used_memory == 0);
+            i_slab_free(arena, (i_Slab*)page, mem);
+            return;
+        }
 
-            /* The page isn't the current page. Update list pointers and free. */
-            if (__TRUE_EXPECTED(page != memory->current_page))
-            {
-                cassert(page->next != NULL);
-                page->next->prev = page->prev;
-                if (page->prev != NULL)
-                    page->prev->next = page->next;
+        cassert(page->mark == PAGE_MARK);
+        refs = i_atomic_sub(&page->refs, 1);
+        cassert(refs >= 0);
 
-                bmem_free((byte_t*)page);
-                memory->std_pages_dealloc += 1;
-            }
-            /* Page for free is current page, we can reuse it. */
-            else
-            {
-                cassert(page->next == NULL);
-                i_init_page(page);
-            }
+        /* The whole page is freeded, we destroy the page (owner arena stats) */
+        if (refs == 0)
+        {
+            i_Arena *owner = page->arena;
+            bmem_free((byte_t*)page);
+            i_atomic_add32(&owner->std_pages_dealloc, 1);
+        }
+        /* Current page of this thread without live blocks, we can reuse it. */
+        else if (page == arena->current_page && refs == PAGE_CREDITS - (int32_t)page->num_allocs)
+        {
+            i_init_page(page);
         }
     }
     /* Block was stored using an own block */
     else
     {
         bmem_free(mem);
-        memory->great_pages_dealloc += 1;
+        arena->great_pages_dealloc += 1;
     }
 }
 
 /*---------------------------------------------------------------------------*/
 
-static byte_t* i_realloc(i_Memory *memory, byte_t *prev_mem, const uint32_t size, const uint32_t prev_size, const uint32_t align)
+static byte_t* i_realloc(i_Arena *arena, byte_t *prev_mem, const uint32_t size, const uint32_t prev_size, const uint32_t align)
 {
     byte_t *mem = NULL;
-    cassert_no_null(memory);
-    cassert_no_null(memory->current_page);
+    cassert_no_null(arena);
 
     /* Some of new/previous block can be/is stored in paged allocator */
-    if (__TRUE_EXPECTED((prev_size + align + sizeof(i_Page) + sizeof(void*) < memory->page_size)
-        || (size + align + sizeof(i_Page) + sizeof(void*) < memory->page_size)))
+    if (__TRUE_EXPECTED(i_is_paged(prev_size, align) == TRUE || i_is_paged(size, align) == TRUE))
     {
         register uint32_t min_size;
-        mem = i_malloc(memory, size, align);
+        mem = i_malloc(arena, size, align);
         min_size = prev_size < size ? prev_size : size;
         bmem_copy(mem, prev_mem, min_size);
-        i_free(memory, prev_mem, prev_size, align);
+        i_free(arena, prev_mem, prev_size, align);
     }
     /* Previous block is in own allocation and new block needs its own allocation too. */
     /* We can call to system realloc. */
     else
     {
-        mem = bmem_aligned_realloc(prev_mem, prev_size, size, align);
+        mem = bmem_aligned_realloc(prev_mem, prev_size + sizeof32(void*), size + sizeof32(void*), align);
+        *((void**)(mem + size)) = NULL;
     }
 
     cassert_fatal((mem != NULL) && ((intptr_t)mem % (intptr_t)align) == 0);
@@ -308,6 +816,194 @@ static byte_t* i_realloc(i_Memory *memory, byte_t *prev_mem, const uint32_t size
 
 /*---------------------------------------------------------------------------*/
 
+static __INLINE HeapArena *i_region_of(const byte_t *mem, const uint32_t size)
+{
+    const i_Chunk *chunk = (const i_Chunk*)*((void**)(mem + size));
+    if (chunk != NULL && chunk->mark == CHUNK_MARK)
+        return chunk->region;
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_Chunk *i_new_chunk(HeapArena *region, const uint32_t size)
+{
+    i_Chunk *chunk = NULL;
+    cassert_no_null(region);
+    chunk = (i_Chunk*)bmem_malloc(size);
+    chunk->mark = CHUNK_MARK;
+    chunk->offset = sizeof32(i_Chunk);
+    chunk->size = size;
+    chunk->region = region;
+    region->num_chunks += 1;
+    return chunk;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint32_t i_chunk_offset(const i_Chunk *chunk, const uint32_t align)
+{
+    uint32_t offset = chunk->offset;
+    uint32_t mod = (uint32_t)(((uintptr_t)chunk + offset) % align);
+    if (mod > 0)
+        offset += align - mod;
+    return offset;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static byte_t *i_region_malloc(i_Arena *arena, HeapArena *region, const uint32_t size, const uint32_t align)
+{
+    i_Chunk *chunk = NULL;
+    uint32_t offset = 0;
+    byte_t *mem = NULL;
+    cassert_no_null(arena);
+    cassert_no_null(region);
+
+    chunk = region->chunk;
+    if (chunk != NULL)
+        offset = i_chunk_offset(chunk, align);
+
+    /* Block can't be stored in current chunk */
+    if (chunk == NULL || offset + size + sizeof(void*) > chunk->size)
+    {
+        uint32_t need = sizeof32(i_Chunk) + align + size + sizeof32(void*);
+
+        /* Big block, own chunk behind the current one */
+        if (need > region->chunk_size / 2 && chunk != NULL)
+        {
+            chunk = i_new_chunk(region, need);
+            chunk->next = region->chunk->next;
+            region->chunk->next = chunk;
+        }
+        else
+        {
+            chunk = i_new_chunk(region, need > region->chunk_size ? need : region->chunk_size);
+            chunk->next = region->chunk;
+            region->chunk = chunk;
+        }
+
+        offset = i_chunk_offset(chunk, align);
+    }
+
+    cassert(offset + size + sizeof(void*) <= chunk->size);
+    mem = (byte_t*)chunk + offset;
+    chunk->offset = offset + size + sizeof32(void*);
+    *((void**)(mem + size)) = (void*)chunk;
+    region->num_allocs += 1;
+    region->bytes_allocated += size;
+    arena->region_allocs += 1;
+    arena->region_bytes += size;
+    cassert_fatal(((intptr_t)mem % (intptr_t)align) == 0);
+    return mem;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static byte_t *i_region_realloc(i_Arena *arena, HeapArena *region, byte_t *mem, const uint32_t size, const uint32_t new_size, const uint32_t align)
+{
+    byte_t *new_mem = NULL;
+    i_Chunk *chunk = NULL;
+    uint32_t offset = 0;
+    cassert_no_null(region);
+
+    /* Last block of current chunk, grow/shrink in place */
+    chunk = region->chunk;
+    offset = (uint32_t)(mem - (byte_t*)chunk);
+    if (*((void**)(mem + size)) == (void*)chunk
+        && offset + size + sizeof32(void*) == chunk->offset
+        && offset + new_size + sizeof(void*) <= chunk->size)
+    {
+        chunk->offset = offset + new_size + sizeof32(void*);
+        *((void**)(mem + new_size)) = (void*)chunk;
+        if (new_size > size)
+        {
+            region->bytes_allocated += new_size - size;
+            arena->region_bytes += new_size - size;
+        }
+        return mem;
+    }
+
+    new_mem = i_region_malloc(arena, region, new_size, align);
+    bmem_copy(new_mem, mem, size < new_size ? size : new_size);
+    return new_mem;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_merge_arena(i_Arena *dest, const i_Arena *src)
+{
+    cassert_no_null(dest);
+    cassert_no_null(src);
+    dest->num_allocs += src->num_allocs;
+    dest->total_bytes_allocated += src->total_bytes_allocated;
+    dest->num_deallocs += src->num_deallocs;
+    dest->total_bytes_deallocated += src->total_bytes_deallocated;
+    dest->num_reallocs += src->num_reallocs;
+    dest->num_effective_reallocs += src->num_effective_reallocs;
+    dest->total_bytes_moved_in_reallocs += src->total_bytes_moved_in_reallocs;
+    dest->std_pages_alloc += src->std_pages_alloc;
+    dest->great_pages_alloc += src->great_pages_alloc;
+    dest->std_pages_dealloc += src->std_pages_dealloc;
+    dest->great_pages_dealloc += src->great_pages_dealloc;
+    dest->num_regions += src->num_regions;
+    dest->region_allocs += src->region_allocs;
+    dest->region_bytes += src->region_bytes;
+
+    {
+        register uint32_t i;
+        for (i = 0; i < NUM_SLAB_CLASSES; ++i)
+        {
+            i_SlabClass *dcls = dest->slabs + i;
+            const i_SlabClass *scls = src->slabs + i;
+            dcls->num_slabs += scls->num_slabs;
+            dcls->max_slabs += scls->max_slabs;
+            dcls->used_slots += scls->used_slots;
+            dcls->max_used_slots += scls->max_used_slots;
+            dcls->slabs_alloc += scls->slabs_alloc;
+            dcls->slabs_dealloc += scls->slabs_dealloc;
+            dcls->num_allocs += scls->num_allocs;
+            dcls->bytes_requested += scls->bytes_requested;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_slab_stats(const i_Arena *arena)
+{
+    register uint32_t i;
+    bool_t header = FALSE;
+    cassert_no_null(arena);
+    for (i = 0; i < NUM_SLAB_CLASSES; ++i)
+    {
+        const i_SlabClass *cls = arena->slabs + i;
+        if (cls->num_allocs > 0)
+        {
+            uint32_t class_size = (i + 1) * SLAB_GRANULE;
+            uint64_t total_slots = (uint64_t)cls->max_slabs * (uint64_t)i_slab_slots(i);
+            uint32_t occupancy = total_slots > 0 ? (uint32_t)((100 * (uint64_t)cls->max_used_slots) / total_slots) : 0;
+            uint32_t fragmentation = (uint32_t)(100 - (100 * cls->bytes_requested) / (cls->num_allocs * class_size));
+
+            if (header == FALSE)
+            {
+                log_printf("Slab allocations (%u bytes per slab):", SLAB_SIZE);
+                header = TRUE;
+            }
+
+            log_printf("    %3u bytes: %" PRIu64 " allocs, %u slabs (max %u), peak %u slots, occupancy %u%%, fragmentation %u%%", class_size, cls->num_allocs, cls->slabs_alloc, cls->max_slabs, cls->max_used_slots, occupancy, fragmentation);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if defined (__MEMORY_AUDITOR__)
+static void i_merge_objects(i_Arena *dest, const i_Arena *src);
+#endif
+
+/*---------------------------------------------------------------------------*/
+
 void _heap_start(void)
 {
     i_init_memory(&i_MEMORY, i_PAGESIZE);
@@ -317,14 +1013,29 @@ void _heap_start(void)
 
 void _heap_finish(void)
 {
+    i_Arena *memory = &i_MEMORY.main_arena;
+
+    /* Merge the counters of all thread arenas in main arena */
+    {
+        const i_Arena *arena = i_MEMORY.thread_arenas;
+        while (arena != NULL)
+        {
+            i_merge_arena(memory, arena);
+            #if defined(__MEMORY_AUDITOR__)
+            i_merge_objects(memory, arena);
+            #endif
+            arena = arena->next;
+        }
+    }
+
     /* Show Objects Leaks*/
     #if defined(__MEMORY_AUDITOR__)
     {
         bool_t with_object_leaks = FALSE;
         register uint32_t i;
-        for (i = 0; i < i_MEMORY.num_objects; ++i)
+        for (i = 0; i < memory->num_objects; ++i)
         {
-            if (i_MEMORY.objects[i].num_allocs != i_MEMORY.objects[i].num_deallocs)
+            if (memory->objects[i].num_allocs != memory->objects[i].num_deallocs)
             {
                 if (with_object_leaks == FALSE)
                 {
@@ -333,9 +1044,9 @@ void _heap_finish(void)
                     with_object_leaks = TRUE;
                 }
 
-                log_printf("'%s' a/deallocations: %u, %u (%u leaks)", i_MEMORY.objects[i].name, i_MEMORY.objects[i].num_allocs, i_MEMORY.objects[i].num_deallocs, (i_MEMORY.objects[i].num_allocs - i_MEMORY.objects[i].num_deallocs));
+                log_printf("'%s' a/deallocations: %u, %u (%u leaks)", memory->objects[i].name, memory->objects[i].num_allocs, memory->objects[i].num_deallocs, (memory->objects[i].num_allocs - memory->objects[i].num_deallocs));
             }
-            else if (i_MEMORY.objects[i].bytes_alloc != i_MEMORY.objects[i].bytes_dealloc)
+            else if (memory->objects[i].bytes_alloc != memory->objects[i].bytes_dealloc)
             {
                 if (with_object_leaks == FALSE)
                 {
@@ -344,7 +1055,7 @@ void _heap_finish(void)
                     with_object_leaks = TRUE;
                 }
 
-                log_printf("'%s' bytes a/deallocated: %" PRIu64 ", %" PRIu64 " (%" PRIu64 " bytes)", i_MEMORY.objects[i].name, i_MEMORY.objects[i].bytes_alloc, i_MEMORY.objects[i].bytes_dealloc, i_MEMORY.objects[i].bytes_alloc - i_MEMORY.objects[i].bytes_dealloc);
+                log_printf("'%s' bytes a/deallocated: %" PRIu64 ", %" PRIu64 " (%" PRIu64 " bytes)", memory->objects[i].name, memory->objects[i].bytes_alloc, memory->objects[i].bytes_dealloc, memory->objects[i].bytes_alloc - memory->objects[i].bytes_dealloc);
             }
         }
 
@@ -353,15 +1064,15 @@ void _heap_finish(void)
     }
     #endif
 
-    if (i_MEMORY.num_allocs != i_MEMORY.num_deallocs
-        || i_MEMORY.total_bytes_allocated != i_MEMORY.total_bytes_deallocated
+    if (memory->num_allocs != memory->num_deallocs
+        || memory->total_bytes_allocated != memory->total_bytes_deallocated
         || i_MEMORY.bytes_allocated > 0)
     {
         log_printf("[FAIL] Heap Global Memory Leaks!!!");
         log_printf("==================================");
-        log_printf("Total a/dellocations: %" PRIu64 ", %" PRIu64 " (%" PRIu64 " leaks)", i_MEMORY.num_allocs, i_MEMORY.num_deallocs, i_MEMORY.num_allocs - i_MEMORY.num_deallocs);
-        log_printf("Total bytes a/dellocated: %" PRIu64 ", %" PRIu64 " (%" PRIu64 " bytes)", i_MEMORY.total_bytes_allocated, i_MEMORY.total_bytes_deallocated, i_MEMORY.total_bytes_allocated - i_MEMORY.total_bytes_deallocated);
-        log_printf("Max bytes allocated: %" PRIu64, i_MEMORY.max_bytes_allocated);
+        log_printf("Total a/dellocations: %" PRIu64 ", %" PRIu64 " (%" PRIu64 " leaks)", memory->num_allocs, memory->num_deallocs, memory->num_allocs - memory->num_deallocs);
+        log_printf("Total bytes a/dellocated: %" PRIu64 ", %" PRIu64 " (%" PRIu64 " bytes)", memory->total_bytes_allocated, memory->total_bytes_deallocated, memory->total_bytes_allocated - memory->total_bytes_deallocated);
+        log_printf("Max bytes allocated: %" PRIu64, (uint64_t)i_MEMORY.max_bytes_allocated);
         log_printf("==================================");
         i_HEAP_LEAKS = TRUE;
     }
@@ -371,21 +1082,26 @@ void _heap_finish(void)
         {
             log_printf("[OK] Heap Memory Staticstics");
             log_printf("============================");
-            log_printf("Total a/dellocations: %" PRIu64 ", %" PRIu64, i_MEMORY.num_allocs, i_MEMORY.num_deallocs);
-            log_printf("Total bytes a/dellocated: %" PRIu64 ", %" PRIu64, i_MEMORY.total_bytes_allocated, i_MEMORY.total_bytes_deallocated);
-            log_printf("Max bytes allocated: %" PRIu64, i_MEMORY.max_bytes_allocated);
-            log_printf("Effective reallocations: (%" PRIu64 "/%" PRIu64 ")", i_MEMORY.num_effective_reallocs, i_MEMORY.num_reallocs);
-            log_printf("Real allocations: %u pages of %u bytes", i_MEMORY.std_pages_alloc, i_MEMORY.page_size);
-            if (i_MEMORY.great_pages_alloc > 0)
-            log_printf("                  %u pages greater than %u bytes", i_MEMORY.great_pages_alloc, i_MEMORY.page_size);
+            log_printf("Total a/dellocations: %" PRIu64 ", %" PRIu64, memory->num_allocs, memory->num_deallocs);
+            log_printf("Total bytes a/dellocated: %" PRIu64 ", %" PRIu64, memory->total_bytes_allocated, memory->total_bytes_deallocated);
+            log_printf("Max bytes allocated: %" PRIu64, (uint64_t)i_MEMORY.max_bytes_allocated);
+            log_printf("Effective reallocations: (%" PRIu64 "/%" PRIu64 ")", memory->num_effective_reallocs, memory->num_reallocs);
+            log_printf("Real allocations: %u pages of %u bytes", memory->std_pages_alloc, i_MEMORY.page_size);
+            if (memory->great_pages_alloc > 0)
+            log_printf("                  %u pages greater than %u bytes", memory->great_pages_alloc, i_MEMORY.page_size);
+            i_slab_stats(memory);
+            if (memory->num_regions > 0)
+            log_printf("Region allocations: %" PRIu64 " (%" PRIu64 " bytes) in %u arenas", memory->region_allocs, memory->region_bytes, memory->num_regions);
+            if (i_MEMORY.num_arenas > 1)
+            log_printf("Thread arenas: %u", i_MEMORY.num_arenas);
             log_printf("============================");
 
             #if defined(__MEMORY_AUDITOR__)
             if (i_HEAP_VERBOSE == TRUE)
             {
                 register uint32_t i;
-                for (i = 0; i < i_MEMORY.num_objects; ++i)
-                    log_printf("'%s' a/deallocations: %u, %u (%" PRIu64 ") bytes", i_MEMORY.objects[i].name, i_MEMORY.objects[i].num_allocs, i_MEMORY.objects[i].num_deallocs, i_MEMORY.objects[i].bytes_alloc);
+                for (i = 0; i < memory->num_objects; ++i)
+                    log_printf("'%s' a/deallocations: %u, %u (%" PRIu64 ") bytes", memory->objects[i].name, memory->objects[i].num_allocs, memory->objects[i].num_deallocs, memory->objects[i].bytes_alloc);
             }
             #endif
         }
@@ -427,7 +1143,7 @@ static uint32_t i_next_pow2(const uint32_t value)
 
 void _heap_page_size(const uint32_t size)
 {
-    cassert(i_MEMORY.current_page == NULL);
+    cassert(i_MEMORY.main_arena.current_page == NULL);
     i_PAGESIZE = i_next_pow2(size);
     if (i_PAGESIZE < 1024)
         i_PAGESIZE = 1024;
@@ -456,51 +1172,78 @@ static int i_object_key(const i_Object *object, const char_t *name)
 
 /*---------------------------------------------------------------------------*/
 
-static i_Object *i_get_object(const char_t *name, const bool_t equal_sized, const uint32_t size)
+static i_Object *i_new_object(i_Arena *arena, const char_t *name, const uint32_t index, const bool_t equal_sized, const uint32_t size)
+{
+    i_Object *new_object = NULL;
+    cassert_no_null(arena);
+    if (arena->num_objects == arena->objects_alloc)
+    {
+        /* Main arena used before heap start has no array yet */
+        if (arena->objects == NULL)
+            arena->objects = (i_Object*)bmem_malloc(OBJECTS_ARRAY_GROW_SIZE * (uint32_t)sizeof(i_Object));
+        else
+            arena->objects = (i_Object*)bmem_realloc((byte_t*)arena->objects, arena->objects_alloc * (uint32_t)sizeof(i_Object), (arena->objects_alloc + OBJECTS_ARRAY_GROW_SIZE) * (uint32_t)sizeof(i_Object));
+        arena->objects_alloc += OBJECTS_ARRAY_GROW_SIZE;
+    }
+
+    /* Move all elems from index 1 postion right (keep the array sorted) */
+    if ((arena->num_objects - index) > 0)
+    {
+        bmem_move((byte_t*)(arena->objects + index + 1),
+                    (const byte_t*)(arena->objects + index),
+                    (arena->num_objects - index) * (uint32_t)sizeof(i_Object));
+    }
+
+    new_object = arena->objects + index;
+    bmem_zero(new_object, i_Object);
+    str_copy_c(new_object->name, OBJECT_NAME_SIZE, name);
+    new_object->equal_sized = equal_sized;
+    new_object->size = size;
+    arena->num_objects += 1;
+    return new_object;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_Object *i_get_object(i_Arena *arena, const char_t *name, const bool_t equal_sized, const uint32_t size)
 {
     uint32_t index = UINT32_MAX;
-    if (blib_bsearch((const byte_t*)i_MEMORY.objects, (const byte_t*)name, i_MEMORY.num_objects, sizeof(i_Object), (FPtr_compare)i_object_key, &index) == TRUE)
+    cassert_no_null(arena);
+    if (blib_bsearch((const byte_t*)arena->objects, (const byte_t*)name, arena->num_objects, sizeof(i_Object), (FPtr_compare)i_object_key, &index) == TRUE)
     {
-        i_Object *object = i_MEMORY.objects + index;
+        i_Object *object = arena->objects + index;
+
+        /* Object created by a remote free, first allocation in this thread */
+        if (object->num_allocs == 0 && object->num_deallocs > 0)
+        {
+            object->equal_sized = equal_sized;
+            object->size = size;
+        }
+
         cassert_msg(object->equal_sized == equal_sized, "heap auditor: Not 'equal_sized' property with same 'name'.");
         cassert_msg(object->equal_sized == FALSE || object->size == size, "heap auditor: alloc 'equal_sized' object type with different size.");
         return object;
     }
     else
     {
-        i_Object *new_object = NULL;
-        if (i_MEMORY.num_objects == i_MEMORY.objects_alloc)
-        {
-            i_MEMORY.objects = (i_Object*)bmem_realloc((byte_t*)i_MEMORY.objects, i_MEMORY.objects_alloc * (uint32_t)sizeof(i_Object), (i_MEMORY.objects_alloc + OBJECTS_ARRAY_GROW_SIZE) * (uint32_t)sizeof(i_Object));
-            i_MEMORY.objects_alloc += OBJECTS_ARRAY_GROW_SIZE;
-        }
-
-        /* Move all elems from index 1 postion right (keep the array sorted) */
-        if ((i_MEMORY.num_objects - index) > 0)
-        {
-            bmem_move((byte_t*)(i_MEMORY.objects + index + 1),
-                        (const byte_t*)(i_MEMORY.objects + index),
-                        (i_MEMORY.num_objects - index) * (uint32_t)sizeof(i_Object));
-        }
-
-        new_object = i_MEMORY.objects + index;
-        bmem_zero(new_object, i_Object);
-        str_copy_c(new_object->name, OBJECT_NAME_SIZE, name);
-        new_object->equal_sized = equal_sized;
-        new_object->size = size;
-        i_MEMORY.num_objects += 1;
-        return new_object;
+        return i_new_object(arena, name, index, equal_sized, size);
     }
 }
 
 /*---------------------------------------------------------------------------*/
 
-static i_Object *i_get_existing_object(const char_t *name)
+static i_Object *i_get_existing_object(i_Arena *arena, const char_t *name, const uint32_t size)
 {
     uint32_t index = UINT32_MAX;
-    if (blib_bsearch((const byte_t*)i_MEMORY.objects, (const byte_t*)name, i_MEMORY.num_objects, sizeof(i_Object), (FPtr_compare)i_object_key, &index) == TRUE)
+    cassert_no_null(arena);
+    if (blib_bsearch((const byte_t*)arena->objects, (const byte_t*)name, arena->num_objects, sizeof(i_Object), (FPtr_compare)i_object_key, &index) == TRUE)
+    {
+        return arena->objects + index;
+    }
+    /* Object allocated by other thread and released in this one */
+    else if (i_MEMORY.num_arenas > 1)
     {
-        return i_MEMORY.objects + index;
+        return i_new_object(arena, name, index, FALSE, size);
     }
     else
     {
@@ -509,28 +1252,56 @@ static i_Object *i_get_existing_object(const char_t *name)
     }
 }
 
+/*---------------------------------------------------------------------------*/
+
+static void i_merge_objects(i_Arena *dest, const i_Arena *src)
+{
+    register uint32_t i;
+    cassert_no_null(dest);
+    cassert_no_null(src);
+    for (i = 0; i < src->num_objects; ++i)
+    {
+        const i_Object *sobj = src->objects + i;
+        uint32_t index = UINT32_MAX;
+        i_Object *dobj = NULL;
+        if (blib_bsearch((const byte_t*)dest->objects, (const byte_t*)sobj->name, dest->num_objects, sizeof(i_Object), (FPtr_compare)i_object_key, &index) == TRUE)
+            dobj = dest->objects + index;
+        else
+            dobj = i_new_object(dest, sobj->name, index, sobj->equal_sized, sobj->size);
+
+        dobj->num_allocs += sobj->num_allocs;
+        dobj->num_deallocs += sobj->num_deallocs;
+        dobj->bytes_alloc += sobj->bytes_alloc;
+        dobj->bytes_dealloc += sobj->bytes_dealloc;
+    }
+}
+
 #endif
 
 /*---------------------------------------------------------------------------*/
 
-static __INLINE byte_t *i_malloc_imp(const uint32_t size, const uint32_t align, const char_t *name, const bool_t equal_sized)
+static __INLINE void i_count_live(const int64_t bytes)
 {
-    byte_t *mem = NULL;
-
-    cassert(size > 0);
+    int64_t live = i_atomic_add64(&i_MEMORY.bytes_allocated, bytes);
+    cassert_fatal(live >= 0);
+    if (bytes > 0)
+    {
+        int64_t peak = i_MEMORY.max_bytes_allocated;
+        while (live > peak && i_atomic_cas64(&i_MEMORY.max_bytes_allocated, &peak, live) == 0) {}
+    }
+}
 
-    if (i_MEMORY.mutex != NULL)
-        bmutex_lock(i_MEMORY.mutex);
+/*---------------------------------------------------------------------------*/
 
-    i_MEMORY.num_allocs += 1;
-    i_MEMORY.total_bytes_allocated += size;
-    i_MEMORY.bytes_allocated += size;
-    if (i_MEMORY.bytes_allocated > i_MEMORY.max_bytes_allocated)
-        i_MEMORY.max_bytes_allocated = i_MEMORY.bytes_allocated;
+static __INLINE void i_count_alloc(i_Arena *arena, const uint32_t size, const char_t *name, const bool_t equal_sized)
+{
+    arena->num_allocs += 1;
+    arena->total_bytes_allocated += size;
+    i_count_live((int64_t)size);
 
     #if defined (__MEMORY_AUDITOR__)
     {
-        i_Object *object = i_get_object(name, equal_sized, size);
+        i_Object *object = i_get_object(arena, name, equal_sized, size);
         object->num_allocs += 1;
         object->bytes_alloc += size;
     }
@@ -538,13 +1309,48 @@ static __INLINE byte_t *i_malloc_imp(const uint32_t size, const uint32_t align,
     unref(name);
     unref(equal_sized);
     #endif
+}
 
-    mem = i_malloc(&i_MEMORY, size, align);
+/*---------------------------------------------------------------------------*/
 
-    if (i_MEMORY.mutex != NULL)
-        bmutex_unlock(i_MEMORY.mutex);
+static __INLINE void i_count_free(i_Arena *arena, const uint32_t size, const char_t *name)
+{
+    arena->num_deallocs += 1;
+    arena->total_bytes_deallocated += size;
+    i_count_live(-(int64_t)size);
 
-    return mem;
+    #if defined (__MEMORY_AUDITOR__)
+    {
+        i_Object *object = i_get_existing_object(arena, name, size);
+        cassert_msg(object->equal_sized == FALSE || object->size == size, "heap auditor: free 'equal_sized' object type with different size.");
+        cassert_msg(i_MEMORY.num_arenas > 1 || object->num_allocs > 0, "heap auditor: free object type without allocs.");
+        object->num_deallocs += 1;
+        object->bytes_dealloc += size;
+    }
+    #else
+    unref(name);
+    #endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE byte_t *i_malloc_imp(const uint32_t size, const uint32_t align, const char_t *name, const bool_t equal_sized)
+{
+    i_Arena *arena = i_arena();
+
+    cassert(size > 0);
+
+    /* Active region in this thread */
+    if (arena->region != NULL)
+        return i_region_malloc(arena, arena->region, size, align);
+
+    i_count_alloc(arena, size, name, equal_sized);
+
+    /* Slab blocks are freed through the paged path, not available before heap start */
+    if (equal_sized == TRUE && size <= SLAB_MAX_SIZE && align <= sizeof(void*) && i_MEMORY.page_size > 0)
+        return i_slab_malloc(arena, size);
+
+    return i_malloc(arena, size, align);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -571,6 +1377,23 @@ void heap_end_mt(void)
 
 /*---------------------------------------------------------------------------*/
 
+void heap_thread_end(void)
+{
+    i_Arena *arena = i_THREAD_ARENA;
+    if (arena != NULL && arena != &i_MEMORY.main_arena)
+    {
+        bmutex_lock(i_MEMORY.mutex);
+        arena->orphan = TRUE;
+        bmutex_unlock(i_MEMORY.mutex);
+    }
+
+    cassert(arena == NULL || arena->region == NULL);
+    if (arena != &i_MEMORY.main_arena)
+        i_THREAD_ARENA = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void heap_verbose(const bool_t verbose)
 {
     i_HEAP_VERBOSE = verbose;
@@ -616,39 +1439,31 @@ static __INLINE byte_t *i_realloc_imp(byte_t *mem, const uint32_t size, const ui
 
     if (__TRUE_EXPECTED(size != new_size))
     {
+        i_Arena *arena = i_arena();
+        HeapArena *region = i_region_of(mem, size);
         byte_t *new_mem = NULL;
-        bool_t locked = FALSE;
 
-        if (i_MEMORY.mtcount > 0)
-        {
-            bmutex_lock(i_MEMORY.mutex);
-            locked = TRUE;
-        }
+        /* Region blocks grow in their own region. Heap blocks stay in the heap,
+           even with an active region: they can outlive it (containers created
+           before heap_arena_push) */
+        if (region != NULL)
+            return i_region_realloc(arena, region, mem, size, new_size, align);
 
-        new_mem = i_realloc(&i_MEMORY, mem, new_size, size, align);
-        i_MEMORY.num_reallocs += 1;
-        i_MEMORY.total_bytes_deallocated += size;
-        i_MEMORY.total_bytes_allocated += new_size;
+        new_mem = i_realloc(arena, mem, new_size, size, align);
+        arena->num_reallocs += 1;
+        arena->total_bytes_deallocated += size;
+        arena->total_bytes_allocated += new_size;
 
         if (new_mem != mem)
-            i_MEMORY.total_bytes_moved_in_reallocs += size;
+            arena->total_bytes_moved_in_reallocs += size;
         else
-            i_MEMORY.num_effective_reallocs += 1;
+            arena->num_effective_reallocs += 1;
 
-        if (new_size > size)
-        {
-            i_MEMORY.bytes_allocated += new_size - size;
-            if (i_MEMORY.bytes_allocated > i_MEMORY.max_bytes_allocated)
-                i_MEMORY.max_bytes_allocated = i_MEMORY.bytes_allocated;
-        }
-        else
-        {
-            i_MEMORY.bytes_allocated -= size - new_size;
-        }
+        i_count_live((int64_t)new_size - (int64_t)size);
 
         #if defined (__MEMORY_AUDITOR__)
         {
-            i_Object *object = i_get_object(name, FALSE, UINT32_MAX);
+            i_Object *object = i_get_object(arena, name, FALSE, UINT32_MAX);
             object->bytes_alloc += new_size;
             object->bytes_dealloc += size;
         }
@@ -656,9 +1471,6 @@ static __INLINE byte_t *i_realloc_imp(byte_t *mem, const uint32_t size, const ui
         unref(name);
         #endif
 
-        if (locked == TRUE)
-            bmutex_unlock(i_MEMORY.mutex);
-
         return new_mem;
     }
     else
@@ -702,41 +1514,54 @@ byte_t *heap_aligned_realloc(byte_t *mem, const uint32_t size, const uint32_t ne
 
 void heap_free(byte_t **mem, const uint32_t size, const char_t *name)
 {
+    i_Arena *arena = i_arena();
     byte_t *mem_ptr = NULL;
-    bool_t locked = FALSE;
     cassert_no_null(mem);
     cassert_no_null(*mem);
     cassert(size > 0);
 
-    if (i_MEMORY.mtcount > 0)
-    {
-        bmutex_lock(i_MEMORY.mutex);
-        locked = TRUE;
-    }
-
     mem_ptr = *mem;
     *mem = NULL;
-    i_free(&i_MEMORY, mem_ptr, size, sizeof(void*));
 
-    i_MEMORY.num_deallocs += 1;
-    i_MEMORY.total_bytes_deallocated += size;
-    cassert_fatal(i_MEMORY.bytes_allocated >= size);
-    i_MEMORY.bytes_allocated -= size;
+    /* Region blocks are released in heap_arena_destroy */
+    if (i_region_of(mem_ptr, size) != NULL)
+        return;
 
-    #if defined (__MEMORY_AUDITOR__)
+    i_free(arena, mem_ptr, size, sizeof(void*));
+    i_count_free(arena, size, name);
+}
+
+/*---------------------------------------------------------------------------*/
+
+byte_t *heap_malloc64(const uint64_t size, const char_t *name)
+{
+    byte_t *mem = NULL;
+    if (size <= 0xFFFFFFFF)
+        return heap_malloc_imp((uint32_t)size, name, FALSE);
+
+    /* Huge blocks skip arenas and slabs. Only the object count is audited */
+    mem = bmem_aligned_malloc64(size, sizeof32(void*));
+    if (mem != NULL)
+        heap_auditor_add(name);
+    return mem;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void heap_free64(byte_t **mem, const uint64_t size, const char_t *name)
+{
+    if (size <= 0xFFFFFFFF)
     {
-        i_Object *object = i_get_existing_object(name);
-        cassert_msg(object->equal_sized == FALSE || object->size == size, "heap auditor: free 'equal_sized' object type with different size.");
-        cassert_msg(object->num_allocs > 0, "heap auditor: free object type without allocs.");
-        object->num_deallocs += 1;
-        object->bytes_dealloc += size;
+        heap_free(mem, (uint32_t)size, name);
+    }
+    else
+    {
+        cassert_no_null(mem);
+        cassert_no_null(*mem);
+        bmem_free(*mem);
+        *mem = NULL;
+        heap_auditor_delete(name);
     }
-    #else
-    unref(name);
-    #endif
-
-    if (locked == TRUE)
-        bmutex_unlock(i_MEMORY.mutex);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -745,21 +1570,10 @@ void heap_auditor_add(const char_t *name)
 {
     #if defined (__MEMORY_AUDITOR__)
     {
-        i_Object *object = NULL;
-        bool_t locked = FALSE;
-
-        if (i_MEMORY.mtcount > 0)
-        {
-            bmutex_lock(i_MEMORY.mutex);
-            locked = TRUE;
-        }
-
-        object = i_get_object(name, TRUE, 0);
+        i_Arena *arena = i_arena();
+        i_Object *object = i_get_object(arena, name, TRUE, 0);
         object->num_allocs += 1;
-        i_MEMORY.num_allocs += 1;
-
-        if (locked == TRUE)
-            bmutex_unlock(i_MEMORY.mutex);
+        arena->num_allocs += 1;
     }
     #else
     unref(name);
@@ -772,24 +1586,98 @@ void heap_auditor_delete(const char_t *name)
 {
     #if defined (__MEMORY_AUDITOR__)
     {
-        i_Object *object = NULL;
-        bool_t locked = FALSE;
-
-        if (i_MEMORY.mtcount > 0)
-        {
-            bmutex_lock(i_MEMORY.mutex);
-            locked = TRUE;
-        }
-
-        object = i_get_existing_object(name);
-        cassert_msg(object->num_allocs > 0, "heap auditor: free auditor object type without allocs.");
+        i_Arena *arena = i_arena();
+        i_Object *object = i_get_existing_object(arena, name, 0);
+        cassert_msg(i_MEMORY.num_arenas > 1 || object->num_allocs > 0, "heap auditor: free auditor object type without allocs.");
         object->num_deallocs += 1;
-        i_MEMORY.num_deallocs += 1;
-
-        if (locked == TRUE)
-            bmutex_unlock(i_MEMORY.mutex);
+        arena->num_deallocs += 1;
     }
     #else
     unref(name);
     #endif
 }
+
+/*---------------------------------------------------------------------------*/
+
+HeapArena *heap_arena_create(const uint32_t chunk_size)
+{
+    i_Arena *arena = i_arena();
+    HeapArena *region = (HeapArena*)bmem_malloc(sizeof32(HeapArena));
+    bmem_zero(region, HeapArena);
+    region->chunk_size = chunk_size > 0 ? chunk_size : DEFAULT_CHUNK_SIZE;
+    if (region->chunk_size < 1024)
+        region->chunk_size = 1024;
+    arena->num_regions += 1;
+    return region;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void heap_arena_destroy(HeapArena **region)
+{
+    i_Chunk *chunk = NULL;
+    cassert_no_null(region);
+    cassert_no_null(*region);
+    cassert_msg((*region)->active == FALSE, "heap: destroying an active region");
+    chunk = (*region)->chunk;
+    while (chunk != NULL)
+    {
+        i_Chunk *next = chunk->next;
+        bmem_free((byte_t*)chunk);
+        chunk = next;
+    }
+
+    bmem_free((byte_t*)*region);
+    *region = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void heap_arena_push(HeapArena *region)
+{
+    i_Arena *arena = i_arena();
+    cassert_no_null(region);
+    cassert_msg(region->active == FALSE, "heap: region already active");
+    region->prev = arena->region;
+    region->active = TRUE;
+    arena->region = region;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void heap_arena_pop(HeapArena *region)
+{
+    i_Arena *arena = i_arena();
+    cassert_no_null(region);
+    cassert_msg(arena->region == region, "heap: region is not the active one");
+    arena->region = region->prev;
+    region->prev = NULL;
+    region->active = FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint64_t heap_arena_bytes(const HeapArena *region)
+{
+    cassert_no_null(region);
+    return region->bytes_allocated;
+}
+
+/*---------------------------------------------------------------------------*/
+
+HeapArena *_heap_arena_pause(void)
+{
+    i_Arena *arena = i_arena();
+    HeapArena *region = arena->region;
+    arena->region = NULL;
+    return region;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void _heap_arena_resume(HeapArena *region)
+{
+    i_Arena *arena = i_arena();
+    cassert(arena->region == NULL);
+    arena->region = region;
+}
@@ -20,6 +20,10 @@ void _heap_finish(void);
 
 void _heap_page_size(const uint32_t size);
 
+HeapArena *_heap_arena_pause(void);
+
+void _heap_arena_resume(HeapArena *arena);
+
 __END_C
 
 
@@ -14,11 +14,14 @@
 #include "hfileh.h"
 #include "arrst.h"
 #include "bfile.h"
+#include "bmutex.h"
 #include "bstd.h"
+#include "bthread.h"
 #include "buffer.h"
 #include "cassert.h"
 #include "date.h"
 #include "event.h"
+#include "heap.h"
 #include "ptr.h"
 #include "stream.h"
 #include "strings.h"
@@ -31,6 +34,29 @@ enum i_flag_t
     i_ekHIDDEN_SUBDIRS          = 4
 };
 
+#define i_SYNC_THREADS  8
+
+typedef struct _copy_t i_Copy;
+typedef struct _sync_t i_Sync;
+
+struct _copy_t
+{
+    String *from;
+    String *dest;
+};
+
+struct _sync_t
+{
+    const i_Copy *copies;
+    uint32_t n;
+    uint32_t next;
+    Mutex *mutex;
+    bool_t ok;
+    ferror_t error;
+};
+
+DeclSt(i_Copy);
+
 /*---------------------------------------------------------------------------*/
 
 bool_t hfile_dir(const char_t *pathname)
@@ -234,7 +260,25 @@ static bool_t i_except(const char_t *name, const char_t **except, const uint32_t
 
 /*---------------------------------------------------------------------------*/
 
-bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recursive, const bool_t remove_in_dest, const char_t **except, const uint32_t except_size, ferror_t *error)
+static void i_add_copy(ArrSt(i_Copy) *copies, const char_t *src, const char_t *name, const char_t *dest)
+{
+    i_Copy *copy = arrst_new(copies, i_Copy);
+    copy->from = str_cpath("%s/%s", src, name);
+    copy->dest = str_c(dest);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_remove_copy(i_Copy *copy)
+{
+    cassert_no_null(copy);
+    str_destroy(&copy->from);
+    str_destroy(&copy->dest);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_dir_sync(const char_t *src, const char_t *dest, const bool_t recursive, const bool_t remove_in_dest, const char_t **except, const uint32_t except_size, ArrSt(i_Copy) *copies, ferror_t *error)
 {
     ArrSt(DirEntry) *dir1, *dir2;
     const DirEntry *files1, *files2;
@@ -274,8 +318,8 @@ bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recurs
                     if (recursive == TRUE)
                     {
                         String *path1 = str_cpath("%s/%s", src, tc(files1[i1].name));
-                        String *path2 = str_cpath("%s/%s", src, tc(files2[i2].name));
-                        ok = hfile_dir_sync(tc(path1), tc(path2), recursive, remove_in_dest, except, except_size, error);
+                        String *path2 = str_cpath("%s/%s", dest, tc(files1[i1].name));
+                        ok = i_dir_sync(tc(path1), tc(path2), recursive, remove_in_dest, except, except_size, copies, error);
                         str_destroy(&path1);
                         str_destroy(&path2);
                     }
@@ -285,11 +329,7 @@ bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recurs
                 {
                     /* Source file is more recent --> Copy */
                     if (date_cmp(&files1[i1].date, &files2[i2].date) > 0)
-                    {
-                        String *path = str_cpath("%s/%s", src, tc(files1[i1].name));
-                        ok = hfile_copy(tc(path), dest, error);
-                        str_destroy(&path);
-                    }
+                        i_add_copy(copies, src, tc(files1[i1].name), dest);
                 }
             }
 
@@ -307,10 +347,10 @@ bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recurs
                     if (recursive == TRUE)
                     {
                         String *path1 = str_cpath("%s/%s", src, tc(files1[i1].name));
-                        String *path2 = str_cpath("%s/%s", src, tc(files2[i2].name));
+                        String *path2 = str_cpath("%s/%s", dest, tc(files1[i1].name));
                         ok = hfile_dir_create(tc(path2), error);
                         if (ok == TRUE)
-                            ok = hfile_dir_sync(tc(path1), tc(path2), recursive, remove_in_dest, except, except_size, error);
+                            ok = i_dir_sync(tc(path1), tc(path2), recursive, remove_in_dest, except, except_size, copies, error);
                         str_destroy(&path1);
                         str_destroy(&path2);
                     }
@@ -318,9 +358,7 @@ bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recurs
                 /* This is a file */
                 else
                 {
-                    String *path = str_cpath("%s/%s", src, tc(files1[i1].name));
-                    ok = hfile_copy(tc(path), dest, error);
-                    str_destroy(&path);
+                    i_add_copy(copies, src, tc(files1[i1].name), dest);
                 }
             }
 
@@ -357,7 +395,7 @@ bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recurs
                 {
                     String *path1 = str_cpath("%s/%s", src, tc(files1[i1].name));
                     String *path2 = str_cpath("%s/%s", dest, tc(files1[i1].name));
-                    ok = hfile_dir_sync(tc(path1), tc(path2), recursive, remove_in_dest, except, except_size, error);
+                    ok = i_dir_sync(tc(path1), tc(path2), recursive, remove_in_dest, except, except_size, copies, error);
                     str_destroy(&path1);
                     str_destroy(&path2);
                 }
@@ -365,9 +403,7 @@ bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recurs
             /* This is a file */
             else
             {
-                String *path = str_cpath("%s/%s", src, tc(files1[i1].name));
-                ok = hfile_copy(tc(path), dest, error);
-                str_destroy(&path);
+                i_add_copy(copies, src, tc(files1[i1].name), dest);
             }
         }
 
@@ -403,6 +439,91 @@ bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recurs
 
 /*---------------------------------------------------------------------------*/
 
+static uint32_t i_copy_thread(i_Sync *sync)
+{
+    cassert_no_null(sync);
+    for (;;)
+    {
+        const i_Copy *copy = NULL;
+        ferror_t err = ekFOK;
+
+        bmutex_lock(sync->mutex);
+        if (sync->ok == TRUE && sync->next < sync->n)
+            copy = sync->copies + sync->next++;
+        bmutex_unlock(sync->mutex);
+
+        if (copy == NULL)
+            break;
+
+        if (hfile_copy(tc(copy->from), tc(copy->dest), &err) == FALSE)
+        {
+            bmutex_lock(sync->mutex);
+            if (sync->ok == TRUE)
+            {
+                sync->ok = FALSE;
+                sync->error = err;
+            }
+            bmutex_unlock(sync->mutex);
+        }
+    }
+
+    heap_thread_end();
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Copies are I/O bound. A worker pool overlaps them */
+static bool_t i_run_copies(const ArrSt(i_Copy) *copies, ferror_t *error)
+{
+    i_Sync sync;
+    Thread *threads[i_SYNC_THREADS];
+    uint32_t i, nthreads;
+    sync.copies = arrst_all_const(copies, i_Copy);
+    sync.n = arrst_size(copies, i_Copy);
+    sync.next = 0;
+    sync.ok = TRUE;
+    sync.error = ekFOK;
+
+    if (sync.n == 0)
+        return TRUE;
+
+    if (sync.n == 1)
+        return hfile_copy(tc(sync.copies[0].from), tc(sync.copies[0].dest), error);
+
+    nthreads = sync.n < i_SYNC_THREADS ? sync.n : i_SYNC_THREADS;
+    sync.mutex = bmutex_create();
+    heap_start_mt();
+    for (i = 0; i < nthreads; ++i)
+        threads[i] = bthread_create(i_copy_thread, &sync, i_Sync);
+
+    for (i = 0; i < nthreads; ++i)
+    {
+        bthread_wait(threads[i]);
+        bthread_close(&threads[i]);
+    }
+
+    heap_end_mt();
+    bmutex_close(&sync.mutex);
+    if (sync.ok == FALSE)
+        ptr_assign(error, sync.error);
+    return sync.ok;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t hfile_dir_sync(const char_t *src, const char_t *dest, const bool_t recursive, const bool_t remove_in_dest, const char_t **except, const uint32_t except_size, ferror_t *error)
+{
+    ArrSt(i_Copy) *copies = arrst_create(i_Copy);
+    bool_t ok = i_dir_sync(src, dest, recursive, remove_in_dest, except, except_size, copies, error);
+    if (ok == TRUE)
+        ok = i_run_copies(copies, error);
+    arrst_destroy(&copies, i_remove_copy, i_Copy);
+    return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+
 bool_t hfile_exists(const char_t *pathname, file_type_t *file_type)
 {
     file_type_t lfile_type;
@@ -467,8 +588,8 @@ bool_t hfile_copy(const char_t *from, const char_t *to, ferror_t *error)
         if (type == ekARCHIVE)
         {
             String *tofile = NULL;
-            Stream *sfrom = NULL;
-            Stream *sto = NULL;
+            File *fin = NULL;
+            File *fout = NULL;
 
             if (hfile_dir(to) == TRUE)
             {
@@ -480,17 +601,17 @@ bool_t hfile_copy(const char_t *from, const char_t *to, ferror_t *error)
                 tofile = str_c(to);
             }
 
-            sfrom = stm_from_file(from, error);
-            sto = stm_to_file(tc(tofile), error);
-            if (sfrom != NULL && sto != NULL)
-            {
-                stm_pipe(sfrom, sto, (uint32_t)size);
-                ok = TRUE;
-            }
+            /* Kernel-side copy when available (bfile_copy) */
+            fin = bfile_open(from, ekREAD, error);
+            if (fin != NULL)
+                fout = bfile_create(tc(tofile), error);
+
+            if (fin != NULL && fout != NULL)
+                ok = bfile_copy(fin, fout, size, NULL, error);
 
             str_destroy(&tofile);
-            ptr_destopt(stm_close, &sfrom, Stream);
-            ptr_destopt(stm_close, &sto, Stream);
+            ptr_destopt(bfile_close, &fin, File);
+            ptr_destopt(bfile_close, &fout, File);
         }
         else
         {
@@ -536,6 +657,71 @@ Buffer *hfile_buffer(const char_t *pathname, ferror_t *error)
 
 /*---------------------------------------------------------------------------*/
 
+Buffer *hfile_buffer64(const char_t *pathname, ferror_t *error)
+{
+    Buffer *buffer = NULL;
+    uint64_t file_size = 0, readed = 0;
+    File *file = bfile_open(pathname, ekREAD, error);
+    if (__FALSE_EXPECTED(file == NULL))
+        return NULL;
+
+    if (bfile_fstat(file, NULL, &file_size, NULL, error) == TRUE)
+    {
+        buffer = buffer_create64(file_size);
+        if (file_size > 0)
+        {
+            bfile_read64(file, buffer_data(buffer), file_size, &readed, error);
+            if (readed != file_size)
+                buffer_destroy(&buffer);
+        }
+    }
+
+    bfile_close(&file);
+    return buffer;
+}
+
+/*---------------------------------------------------------------------------*/
+
+const byte_t *hfile_mmap(const char_t *pathname, uint64_t *size, ferror_t *error)
+{
+    const byte_t *data = NULL;
+    uint64_t file_size = 0;
+    File *file = NULL;
+    cassert_no_null(size);
+    *size = 0;
+    file = bfile_open(pathname, ekREAD, error);
+    if (__FALSE_EXPECTED(file == NULL))
+        return NULL;
+
+    if (bfile_fstat(file, NULL, &file_size, NULL, error) == TRUE)
+    {
+        /* Empty files can't be mapped. NULL with ekFOK */
+        if (file_size > 0)
+        {
+            data = bfile_mmap(file, 0, file_size, error);
+            if (data != NULL)
+                *size = file_size;
+        }
+        else
+        {
+            ptr_assign(error, ekFOK);
+        }
+    }
+
+    /* The mapping remains valid after closing the file */
+    bfile_close(&file);
+    return data;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void hfile_munmap(const byte_t **data, const uint64_t size)
+{
+    bfile_munmap(data, size);
+}
+
+/*---------------------------------------------------------------------------*/
+
 String *hfile_string(const char_t *pathname, ferror_t *error)
 {
     file_type_t file_type;
@@ -37,6 +37,12 @@ _core_api bool_t hfile_copy(const char_t *from, const char_t *to, ferror_t *erro
 
 _core_api Buffer *hfile_buffer(const char_t *pathname, ferror_t *error);
 
+_core_api Buffer *hfile_buffer64(const char_t *pathname, ferror_t *error);
+
+_core_api const byte_t *hfile_mmap(const char_t *pathname, uint64_t *size, ferror_t *error);
+
+_core_api void hfile_munmap(const byte_t **data, const uint64_t size);
+
 _core_api String *hfile_string(const char_t *pathname, ferror_t *error);
 
 _core_api Stream *hfile_stream(const char_t *pathname, ferror_t *error);
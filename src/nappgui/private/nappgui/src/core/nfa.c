@@ -14,13 +14,18 @@
 #include "arrpt.h"
 #include "arrst.h"
 #include "bmem.h"
+#include "bmutex.h"
+#include "bhash.h"
 #include "cassert.h"
+#include "hashst.h"
 #include "heap.h"
 #include "stream.h"
 #include "unicode.h"
 
 typedef struct _ntoken_t NToken;
 typedef struct _trans_t Trans;
+typedef struct _dstate_t DState;
+typedef struct _dkey_t DKey;
 
 typedef enum _symbol_t
 {
@@ -46,11 +51,41 @@ struct _trans_t
     uint32_t extra;
 };
 
+/* Lazy DFA state (subset of NFA states) */
+struct _dstate_t
+{
+    uint32_t *next;
+    uint32_t *set;
+    uint32_t size;
+    uint32_t *ids;
+    uint32_t nids;
+    bool_t floating;
+};
+
+struct _dkey_t
+{
+    const uint32_t *set;
+    uint32_t size;
+    bool_t floating;
+    uint32_t id;
+};
+
 struct _nfa_t
 {
     ArrSt(Trans) *ttable;
-    ArrSt(uint32_t) *current;
-    ArrSt(uint32_t) *temp;
+    uint32_t *accepts;
+    uint32_t npatterns;
+    Mutex *mutex;
+    uint32_t nclasses;
+    uint32_t nbounds;
+    uint32_t *bounds;
+    uint32_t ascii[128];
+    uint32_t nstates;
+    DState ***states;
+    HashSt(DKey) *keys;
+    uint32_t *marks;
+    uint32_t mark;
+    NFA *reverse;
 };
 
 #define MIN_UNICODE 5
@@ -58,6 +93,34 @@ struct _nfa_t
 DeclSt(NToken);
 DeclSt(Trans);
 DeclSt(symbol_t);
+DeclSt(DKey);
+
+static void i_dfa_accepts(NFA *nfa, const uint32_t *accepts, const uint32_t n);
+static void i_dfa_init(NFA *nfa);
+
+/* DFA transitions. States are cached on first use, up to i_MAX_DSTATES.
+   They are stored in blocks allocated on demand; the block directory never
+   moves, so matchers can read it without locks */
+#define i_MAX_DSTATES   4096
+#define i_DBLOCK_BITS   6
+#define i_DBLOCK        (1 << i_DBLOCK_BITS)
+#define i_NUM_DBLOCKS   (i_MAX_DSTATES / i_DBLOCK)
+#define i_dstate(nfa, id) ((nfa)->states[(id) >> i_DBLOCK_BITS][(id) & (i_DBLOCK - 1)])
+#define i_NEXT_UNKNOWN  UINT32_MAX
+#define i_NEXT_DEAD     (UINT32_MAX - 1)
+#define i_NEXT_NFA      (UINT32_MAX - 2)
+
+/* Transitions are published without locks to concurrent matchers */
+#if defined(__GNUC__)
+    #define i_load_acquire(ptr)     __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+    #define i_store_release(ptr, v) __atomic_store_n(ptr, v, __ATOMIC_RELEASE)
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+    #define i_load_acquire(ptr)     (uint32_t)__ldar32((unsigned __int32 volatile*)(ptr))
+    #define i_store_release(ptr, v) __stlr32((unsigned __int32 volatile*)(ptr), (unsigned __int32)(v))
+#elif defined(_MSC_VER)
+    #define i_load_acquire(ptr)     (*(volatile uint32_t*)(ptr))
+    #define i_store_release(ptr, v) _InterlockedExchange((volatile long*)(ptr), (long)(v))
+#endif
 
 /*---------------------------------------------------------------------------*/
 
@@ -218,26 +281,50 @@ NFA *_nfa_string(const char_t *str)
     trans->state = UINT32_MAX;
     trans->symbol = 0;
     trans->extra = 0;
+    i_dfa_init(nfa);
     return nfa;
 }
 
 /*---------------------------------------------------------------------------*/
 
+static void i_remove_dstate(DState *dstate, const uint32_t nclasses)
+{
+    cassert_no_null(dstate);
+    heap_delete_n(&dstate->next, nclasses, uint32_t);
+    heap_delete_n(&dstate->set, dstate->size, uint32_t);
+    if (dstate->ids != NULL)
+        heap_delete_n(&dstate->ids, dstate->nids, uint32_t);
+    heap_delete(&dstate, DState);
+}
+
+/*---------------------------------------------------------------------------*/
+
 void _nfa_destroy(NFA **nfa)
 {
     cassert_no_null(nfa);
     cassert_no_null(*nfa);
-    arrst_destroy(&(*nfa)->ttable, NULL, Trans);
-    if ((*nfa)->current != NULL)
-    {
-        arrst_destroy(&(*nfa)->current, NULL, uint32_t);
-        arrst_destroy(&(*nfa)->temp, NULL, uint32_t);
-    }
-    else
+    if ((*nfa)->reverse != NULL)
+        _nfa_destroy(&(*nfa)->reverse);
+
+    if ((*nfa)->states != NULL)
     {
-        cassert((*nfa)->temp == NULL);
+        uint32_t i, nblocks = ((*nfa)->nstates + i_DBLOCK - 1) / i_DBLOCK;
+        for (i = 0; i < (*nfa)->nstates; ++i)
+            i_remove_dstate(i_dstate(*nfa, i), (*nfa)->nclasses);
+
+        for (i = 0; i < nblocks; ++i)
+            heap_delete_n(&(*nfa)->states[i], i_DBLOCK, DState*);
+
+        heap_delete_n(&(*nfa)->states, i_NUM_DBLOCKS, DState**);
+        heap_delete_n(&(*nfa)->marks, arrst_size((*nfa)->ttable, Trans), uint32_t);
+        heap_delete_n(&(*nfa)->accepts, arrst_size((*nfa)->ttable, Trans), uint32_t);
+        hashst_destroy(&(*nfa)->keys, NULL, DKey);
+        bmutex_close(&(*nfa)->mutex);
+        if ((*nfa)->bounds != NULL)
+            heap_delete_n(&(*nfa)->bounds, (*nfa)->nbounds, uint32_t);
     }
 
+    arrst_destroy(&(*nfa)->ttable, NULL, Trans);
     heap_delete(nfa, NFA);
 }
 
@@ -684,7 +771,7 @@ static void i_nfa_closure(NFA *nfa1)
 
 /*---------------------------------------------------------------------------*/
 
-static NFA *i_infix_to_NFA(const ArrSt(NToken) *tokens)
+static NFA *i_infix_to_NFA(const ArrSt(NToken) *tokens, const bool_t reverse)
 {
     ArrPt(NFA) *stack = arrpt_create(NFA);
     NFA *nfa = NULL;
@@ -717,7 +804,20 @@ static NFA *i_infix_to_NFA(const ArrSt(NToken) *tokens)
             nfa2 = arrpt_last(stack, NFA);
             arrpt_pop(stack, NULL, NFA);
             nfa1 = arrpt_last(stack, NFA);
-            i_nfa_concat(nfa1, nfa2);
+
+            /* Reverse automaton: the right operand goes first */
+            if (reverse == TRUE)
+            {
+                i_nfa_concat(nfa2, nfa1);
+                arrpt_pop(stack, NULL, NFA);
+                arrpt_append(stack, nfa2, NFA);
+                bmem_swap_type(&nfa1, &nfa2, NFA*);
+            }
+            else
+            {
+                i_nfa_concat(nfa1, nfa2);
+            }
+
             cassert(i_check_nfa(nfa1) == TRUE);
             _nfa_destroy(&nfa2);
             break;
@@ -746,7 +846,7 @@ static NFA *i_infix_to_NFA(const ArrSt(NToken) *tokens)
 
 /*---------------------------------------------------------------------------*/
 
-NFA *_nfa_regex(const char_t *regex, const bool_t verbose)
+static NFA *i_nfa_regex(const char_t *regex, const bool_t reverse, const bool_t verbose)
 {
     ArrSt(NToken) *tokens = i_tokens_unix_regex(regex);
     NFA *nfa = NULL;
@@ -775,7 +875,7 @@ NFA *_nfa_regex(const char_t *regex, const bool_t verbose)
         i_write_tokens(kSTDOUT, tokens);
     }
 
-    nfa = i_infix_to_NFA(tokens);
+    nfa = i_infix_to_NFA(tokens, reverse);
     arrst_destroy(&tokens, NULL, NToken);
     cassert(i_check_nfa(nfa) == TRUE);
 
@@ -791,94 +891,481 @@ NFA *_nfa_regex(const char_t *regex, const bool_t verbose)
 
 /*---------------------------------------------------------------------------*/
 
-static void i_add_state(ArrSt(uint32_t) *states, const uint32_t state)
+NFA *_nfa_regex(const char_t *regex, const bool_t verbose)
 {
-    arrst_foreach(cstate, states, uint32_t)
-        if (*cstate == state)
-            return;
+    NFA *nfa = i_nfa_regex(regex, FALSE, verbose);
+    if (nfa != NULL)
+    {
+        /* Matches the reversed language, to find where matches start */
+        i_dfa_init(nfa);
+        nfa->reverse = i_nfa_regex(regex, TRUE, FALSE);
+        cassert_no_null(nfa->reverse);
+        i_dfa_init(nfa->reverse);
+    }
 
-        if (*cstate > state)
-        {
-            arrst_insert(states, cstate_i, state, uint32_t);
-            return;
-        }
-    arrst_end();
+    return nfa;
+}
+
+/*---------------------------------------------------------------------------*/
 
-    arrst_append(states, state, uint32_t);
+const NFA *_nfa_reverse(const NFA *nfa)
+{
+    cassert_no_null(nfa);
+    cassert_no_null(nfa->reverse);
+    return nfa->reverse;
 }
 
 /*---------------------------------------------------------------------------*/
 
-static void i_add_closure(const ArrSt(Trans) *ttable, ArrSt(uint32_t) *states, const uint32_t state)
+NFA *_nfa_set(const char_t **regex, const uint32_t n)
 {
-    const Trans *trans = arrst_get_const(ttable, state, Trans);
+    NFA *nfa = NULL;
+    NFA **nfas = NULL;
+    uint32_t *accepts = NULL;
+    uint32_t i, offset = n;
+    bool_t ok = TRUE;
+    cassert_no_null(regex);
+    cassert(n > 0);
+    nfas = heap_new_n0(n, NFA*);
+    accepts = heap_new_n(n, uint32_t);
+    for (i = 0; i < n && ok == TRUE; ++i)
+    {
+        nfas[i] = i_nfa_regex(regex[i], FALSE, FALSE);
+        ok = (bool_t)(nfas[i] != NULL);
+    }
+
+    if (ok == TRUE)
+    {
+        Trans *trans = NULL;
+        nfa = heap_new0(NFA);
+        nfa->ttable = arrst_create(Trans);
+
+        /* A chain of epsilon-transitions to each automaton '0' */
+        for (i = 0; i < n; ++i)
+        {
+            trans = arrst_new(nfa->ttable, Trans);
+            trans->state = offset;
+            trans->symbol = UINT32_MAX;
+            trans->extra = i + 1 < n ? i + 1 : UINT32_MAX;
+            offset += arrst_size(nfas[i]->ttable, Trans);
+        }
+
+        offset = n;
+        for (i = 0; i < n; ++i)
+        {
+            uint32_t ni = arrst_size(nfas[i]->ttable, Trans);
+            i_offset(nfas[i]->ttable, offset);
+            arrst_grow(nfa->ttable, ni, Trans);
+            bmem_copy_n(arrst_all(nfa->ttable, Trans) + offset, arrst_all(nfas[i]->ttable, Trans), ni, Trans);
+            offset += ni;
+            accepts[i] = offset - 1;
+        }
+
+        i_dfa_accepts(nfa, accepts, n);
+        i_dfa_init(nfa);
+    }
 
-    if (trans->symbol != UINT32_MAX)
+    for (i = 0; i < n; ++i)
     {
-        i_add_state(states, state);
+        if (nfas[i] != NULL)
+            _nfa_destroy(&nfas[i]);
     }
-    else
+
+    heap_delete_n(&nfas, n, NFA*);
+    heap_delete_n(&accepts, n, uint32_t);
+    return nfa;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Epsilon-closure. Visited states are marked, so cycles end */
+static void i_closure(const NFA *nfa, uint32_t *marks, const uint32_t mark, ArrSt(uint32_t) *states, const uint32_t state)
+{
+    const Trans *trans = NULL;
+    if (marks[state] == mark)
+        return;
+
+    marks[state] = mark;
+    trans = arrst_get_const(nfa->ttable, state, Trans);
+    if (trans->symbol != UINT32_MAX || nfa->accepts[state] != 0)
+        arrst_append(states, state, uint32_t);
+
+    if (trans->symbol == UINT32_MAX)
     {
         cassert(trans->state != UINT32_MAX);
-     
-        /* Closure last state (accept) */
-        if (state == arrst_size(ttable, Trans) - 1)
-            i_add_state(states, state);
-
-        i_add_closure(ttable, states, trans->state);
+        i_closure(nfa, marks, mark, states, trans->state);
 
         /* Two epsilons */
         if (trans->extra != UINT32_MAX)
-            i_add_closure(ttable, states, trans->extra);
+            i_closure(nfa, marks, mark, states, trans->extra);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int i_cmp_u32(const uint32_t *v1, const uint32_t *v2)
+{
+    return *v1 < *v2 ? -1 : (*v1 > *v2 ? 1 : 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* NFA states reached from 'set' with 'codepoint'. Floating automata restart in each step */
+static void i_move(const NFA *nfa, uint32_t *marks, const uint32_t mark, const uint32_t *set, const uint32_t size, const uint32_t codepoint, const bool_t floating, ArrSt(uint32_t) *next)
+{
+    uint32_t i;
+    arrst_clear(next, NULL, uint32_t);
+    for (i = 0; i < size; ++i)
+    {
+        const Trans *trans = arrst_get_const(nfa->ttable, set[i], Trans);
+        if (trans->state != UINT32_MAX && codepoint >= trans->symbol && codepoint <= trans->extra)
+            i_closure(nfa, marks, mark, next, trans->state);
+    }
+
+    if (floating == TRUE)
+        i_closure(nfa, marks, mark, next, 0);
+
+    arrst_sort(next, i_cmp_u32, uint32_t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_dkey_hash(const DKey *key)
+{
+    cassert_no_null(key);
+    return bhash_append_uint32(bhash_from_block((const byte_t*)key->set, key->size * sizeof(uint32_t)), (uint32_t)key->floating);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int i_dkey_cmp(const DKey *key1, const DKey *key2)
+{
+    cassert_no_null(key1);
+    cassert_no_null(key2);
+    if (key1->floating != key2->floating)
+        return key1->floating == FALSE ? -1 : 1;
+    if (key1->size != key2->size)
+        return key1->size < key2->size ? -1 : 1;
+    return bmem_cmp((const byte_t*)key1->set, (const byte_t*)key2->set, key1->size * sizeof(uint32_t));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Patterns accepted by a set of NFA states */
+static uint32_t i_accepts(const NFA *nfa, const uint32_t *set, const uint32_t size, uint32_t *ids, const uint32_t max)
+{
+    uint32_t i, n = 0;
+    for (i = 0; i < size; ++i)
+    {
+        if (nfa->accepts[set[i]] != 0)
+        {
+            if (ids != NULL && n < max)
+                ids[n] = nfa->accepts[set[i]] - 1;
+            n += 1;
+        }
     }
+
+    return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Returns the DFA state for a sorted set of NFA states (mutex locked) */
+static uint32_t i_dfa_state(NFA *nfa, const ArrSt(uint32_t) *set, const bool_t floating)
+{
+    DKey key;
+    const DKey *ckey = NULL;
+    key.set = arrst_all_const(set, uint32_t);
+    key.size = arrst_size(set, uint32_t);
+    key.floating = floating;
+    key.id = UINT32_MAX;
+    if (key.size == 0)
+        return i_NEXT_DEAD;
+
+    ckey = hashst_get_const(nfa->keys, &key, DKey);
+    if (ckey != NULL)
+        return ckey->id;
+
+    if (nfa->nstates < i_MAX_DSTATES)
+    {
+        DState *dstate = heap_new(DState);
+        DKey *nkey = NULL;
+        uint32_t i;
+        dstate->next = heap_new_n(nfa->nclasses, uint32_t);
+        dstate->set = heap_new_n(key.size, uint32_t);
+        dstate->size = key.size;
+        dstate->floating = floating;
+        bmem_copy_n(dstate->set, key.set, key.size, uint32_t);
+        for (i = 0; i < nfa->nclasses; ++i)
+            dstate->next[i] = i_NEXT_UNKNOWN;
+
+        dstate->nids = i_accepts(nfa, key.set, key.size, NULL, 0);
+        dstate->ids = NULL;
+        if (dstate->nids > 0)
+        {
+            dstate->ids = heap_new_n(dstate->nids, uint32_t);
+            i_accepts(nfa, key.set, key.size, dstate->ids, dstate->nids);
+        }
+
+        key.set = dstate->set;
+        nkey = hashst_insert(nfa->keys, &key, DKey);
+        nkey->id = nfa->nstates;
+        if ((nfa->nstates & (i_DBLOCK - 1)) == 0)
+            nfa->states[nfa->nstates >> i_DBLOCK_BITS] = heap_new_n0(i_DBLOCK, DState*);
+
+        i_dstate(nfa, nfa->nstates) = dstate;
+        nfa->nstates += 1;
+        return nkey->id;
+    }
+
+    /* Cache full, the caller continues with NFA simulation */
+    return i_NEXT_NFA;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Equivalence classes: codepoints with the same behavior in all transitions */
+static void i_dfa_classes(NFA *nfa)
+{
+    ArrSt(uint32_t) *bounds = arrst_create(uint32_t);
+    uint32_t i, n = 0, last = UINT32_MAX;
+
+    arrst_foreach_const(trans, nfa->ttable, Trans)
+        if (trans->symbol != UINT32_MAX && trans->extra != 0)
+        {
+            arrst_append(bounds, trans->symbol, uint32_t);
+            arrst_append(bounds, trans->extra + 1, uint32_t);
+        }
+    arrst_end();
+
+    arrst_sort(bounds, i_cmp_u32, uint32_t);
+    arrst_foreach(bound, bounds, uint32_t)
+        if (*bound != last)
+        {
+            last = *bound;
+            *arrst_get(bounds, n, uint32_t) = last;
+            n += 1;
+        }
+    arrst_end();
+
+    nfa->nbounds = n;
+    nfa->nclasses = n + 1;
+    nfa->bounds = n > 0 ? heap_new_n(n, uint32_t) : NULL;
+    if (n > 0)
+        bmem_copy_n(nfa->bounds, arrst_all(bounds, uint32_t), n, uint32_t);
+
+    for (i = 0, n = 0; i < 128; ++i)
+    {
+        while (n < nfa->nbounds && nfa->bounds[n] <= i)
+            n += 1;
+        nfa->ascii[i] = n;
+    }
+
+    arrst_destroy(&bounds, NULL, uint32_t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_dfa_accepts(NFA *nfa, const uint32_t *accepts, const uint32_t n)
+{
+    uint32_t i;
+    cassert_no_null(nfa);
+    cassert(nfa->accepts == NULL);
+    nfa->accepts = heap_new_n0(arrst_size(nfa->ttable, Trans), uint32_t);
+    nfa->npatterns = n;
+    for (i = 0; i < n; ++i)
+        nfa->accepts[accepts[i]] = i + 1;
 }
 
 /*---------------------------------------------------------------------------*/
 
-void _nfa_start(NFA *nfa)
+static void i_dfa_init(NFA *nfa)
 {
+    ArrSt(uint32_t) *set = arrst_create(uint32_t);
+    uint32_t n = arrst_size(nfa->ttable, Trans);
+    uint32_t start, fstart;
     cassert_no_null(nfa);
-    if (nfa->current == NULL)
+
+    /* Single automaton: the last state accepts */
+    if (nfa->accepts == NULL)
+    {
+        uint32_t accept = n - 1;
+        i_dfa_accepts(nfa, &accept, 1);
+    }
+
+    i_dfa_classes(nfa);
+    nfa->mutex = bmutex_create();
+    nfa->states = heap_new_n0(i_NUM_DBLOCKS, DState**);
+    nfa->keys = hashst_create(i_dkey_hash, i_dkey_cmp, DKey);
+    nfa->marks = heap_new_n0(n, uint32_t);
+    nfa->mark = 1;
+    nfa->nstates = 0;
+    i_closure(nfa, nfa->marks, nfa->mark, set, 0);
+    arrst_sort(set, i_cmp_u32, uint32_t);
+    start = i_dfa_state(nfa, set, FALSE);
+    fstart = i_dfa_state(nfa, set, TRUE);
+    cassert_unref(start == 0, start);
+    cassert_unref(fstart == 1, fstart);
+    arrst_destroy(&set, NULL, uint32_t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint32_t i_class(const NFA *nfa, const uint32_t codepoint)
+{
+    if (codepoint < 128)
     {
-        cassert(nfa->temp == NULL);
-        nfa->current = arrst_create(uint32_t);
-        nfa->temp = arrst_create(uint32_t);
+        return nfa->ascii[codepoint];
     }
     else
     {
-        arrst_clear(nfa->current, NULL, uint32_t);
+        /* Number of bounds <= codepoint */
+        uint32_t lo = 0, hi = nfa->nbounds;
+        while (lo < hi)
+        {
+            uint32_t mid = (lo + hi) / 2;
+            if (nfa->bounds[mid] <= codepoint)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return lo;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Subset construction of a single transition */
+static uint32_t i_dfa_build(NFA *nfa, const uint32_t dstate, const uint32_t cls)
+{
+    uint32_t next;
+    bmutex_lock(nfa->mutex);
+    next = i_dstate(nfa, dstate)->next[cls];
+
+    /* Another thread has built it */
+    if (next == i_NEXT_UNKNOWN)
+    {
+        const DState *src = i_dstate(nfa, dstate);
+        uint32_t codepoint = cls == 0 ? 0 : nfa->bounds[cls - 1];
+        ArrSt(uint32_t) *set = arrst_create(uint32_t);
+        nfa->mark += 1;
+        i_move(nfa, nfa->marks, nfa->mark, src->set, src->size, codepoint, src->floating, set);
+        next = i_dfa_state(nfa, set, src->floating);
+        i_store_release(&i_dstate(nfa, dstate)->next[cls], next);
+        arrst_destroy(&set, NULL, uint32_t);
     }
 
-    i_add_closure(nfa->ttable, nfa->current, 0);
+    bmutex_unlock(nfa->mutex);
+    return next;
 }
 
 /*---------------------------------------------------------------------------*/
 
-bool_t _nfa_next(NFA *nfa, const uint32_t codepoint)
+void _nfa_start(const NFA *nfa, const bool_t floating, NFACtx *ctx)
 {
     cassert_no_null(nfa);
-    arrst_clear(nfa->temp, NULL, uint32_t);
-    arrst_foreach(state, nfa->current, uint32_t)
-        const Trans *trans = arrst_get(nfa->ttable, *state, Trans);
-        if (codepoint >= trans->symbol && codepoint <= trans->extra)
-            i_add_closure(nfa->ttable, nfa->temp, trans->state);
-    arrst_end();
+    cassert_no_null(ctx);
+    ctx->nfa = nfa;
+    ctx->dstate = floating == TRUE ? 1 : 0;
+    ctx->floating = floating;
+    ctx->current = NULL;
+    ctx->temp = NULL;
+    ctx->marks = NULL;
+    ctx->mark = 0;
+}
 
-    bmem_swap_type(&nfa->current, &nfa->temp, ArrSt(uint32_t)*);
-    return (bool_t)(arrst_size(nfa->current, uint32_t) > 0);
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_nfa_next(NFACtx *ctx, const uint32_t codepoint)
+{
+    ctx->mark += 1;
+    i_move(ctx->nfa, ctx->marks, ctx->mark, arrst_all_const(ctx->current, uint32_t), arrst_size(ctx->current, uint32_t), codepoint, ctx->floating, ctx->temp);
+    bmem_swap_type(&ctx->current, &ctx->temp, ArrSt(uint32_t)*);
+    return (bool_t)(arrst_size(ctx->current, uint32_t) > 0);
 }
 
 /*---------------------------------------------------------------------------*/
 
-bool_t _nfa_accept(NFA *nfa)
+bool_t _nfa_next(NFACtx *ctx, const uint32_t codepoint)
 {
-    register uint32_t accept;
-    cassert_no_null(nfa);
-    accept = arrst_size(nfa->ttable, Trans) - 1;
-    arrst_foreach(state, nfa->current, uint32_t)
-        if (*state == accept)
-            return TRUE;
-    arrst_end();
-    return FALSE;
+    const NFA *nfa = NULL;
+    uint32_t cls, next;
+    cassert_no_null(ctx);
+    nfa = ctx->nfa;
+
+    if (ctx->dstate == i_NEXT_NFA)
+        return i_nfa_next(ctx, codepoint);
+
+    if (ctx->dstate == i_NEXT_DEAD)
+        return FALSE;
+
+    cls = i_class(nfa, codepoint);
+    next = i_load_acquire(&i_dstate(nfa, ctx->dstate)->next[cls]);
+    if (next == i_NEXT_UNKNOWN)
+        next = i_dfa_build((NFA*)nfa, ctx->dstate, cls);
+
+    /* DFA cache full: continue from the current subset */
+    if (next == i_NEXT_NFA)
+    {
+        const DState *dstate = i_dstate(nfa, ctx->dstate);
+        ctx->current = arrst_create(uint32_t);
+        ctx->temp = arrst_create(uint32_t);
+        ctx->marks = heap_new_n0(arrst_size(nfa->ttable, Trans), uint32_t);
+        arrst_grow(ctx->current, dstate->size, uint32_t);
+        bmem_copy_n(arrst_all(ctx->current, uint32_t), dstate->set, dstate->size, uint32_t);
+        ctx->dstate = i_NEXT_NFA;
+        return i_nfa_next(ctx, codepoint);
+    }
+
+    ctx->dstate = next;
+    return (bool_t)(next != i_NEXT_DEAD);
 }
 
+/*---------------------------------------------------------------------------*/
+
+bool_t _nfa_accept(const NFACtx *ctx)
+{
+    cassert_no_null(ctx);
+    if (ctx->dstate == i_NEXT_DEAD)
+        return FALSE;
+    else if (ctx->dstate == i_NEXT_NFA)
+        return (bool_t)(i_accepts(ctx->nfa, arrst_all_const(ctx->current, uint32_t), arrst_size(ctx->current, uint32_t), NULL, 0) > 0);
+    else
+        return (bool_t)(i_dstate(ctx->nfa, ctx->dstate)->nids > 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t _nfa_accepts(const NFACtx *ctx, uint32_t *ids, const uint32_t max)
+{
+    cassert_no_null(ctx);
+    if (ctx->dstate == i_NEXT_DEAD)
+    {
+        return 0;
+    }
+    else if (ctx->dstate == i_NEXT_NFA)
+    {
+        return i_accepts(ctx->nfa, arrst_all_const(ctx->current, uint32_t), arrst_size(ctx->current, uint32_t), ids, max);
+    }
+    else
+    {
+        const DState *dstate = i_dstate(ctx->nfa, ctx->dstate);
+        if (ids != NULL && dstate->nids > 0)
+            bmem_copy_n(ids, dstate->ids, dstate->nids < max ? dstate->nids : max, uint32_t);
+        return dstate->nids;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void _nfa_end(NFACtx *ctx)
+{
+    cassert_no_null(ctx);
+    if (ctx->current != NULL)
+    {
+        arrst_destroy(&ctx->current, NULL, uint32_t);
+        arrst_destroy(&ctx->temp, NULL, uint32_t);
+        heap_delete_n(&ctx->marks, arrst_size(ctx->nfa->ttable, Trans), uint32_t);
+    }
+}
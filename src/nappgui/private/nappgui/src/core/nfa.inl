@@ -18,13 +18,21 @@ NFA *_nfa_string(const char_t *str);
 
 NFA *_nfa_regex(const char_t *regex, const bool_t verbose);
 
+NFA *_nfa_set(const char_t **regex, const uint32_t n);
+
+const NFA *_nfa_reverse(const NFA *nfa);
+
 void _nfa_destroy(NFA **nfa);
 
-void _nfa_start(NFA *nfa);
+void _nfa_start(const NFA *nfa, const bool_t floating, NFACtx *ctx);
+
+bool_t _nfa_next(NFACtx *ctx, const uint32_t codepoint);
+
+bool_t _nfa_accept(const NFACtx *ctx);
 
-bool_t _nfa_next(NFA *nfa, const uint32_t codepoint);
+uint32_t _nfa_accepts(const NFACtx *ctx, uint32_t *ids, const uint32_t max);
 
-bool_t _nfa_accept(NFA *nfa);
+void _nfa_end(NFACtx *ctx);
 
 __END_C
 
@@ -12,8 +12,16 @@
 
 #include "regex.h"
 #include "nfa.inl"
+#include "arrst.h"
+#include "cassert.h"
+#include "event.h"
+#include "heap.h"
+#include "stream.h"
+#include "strings.h"
 #include "unicode.h"
 
+#define i_LOCAL_BOUNDS  256
+
 /*
 RegEx *regex = regex_create("000_OCR_OK_01_.*\\.png");
 bool_t ok1 = regex_match(regex, "000_OCR_OK_01_001.png");
@@ -52,17 +60,294 @@ void regex_destroy(RegEx **regex)
 
 bool_t regex_match(const RegEx *regex, const char_t *str)
 {
-    uint32_t codepoint;
-    _nfa_start((NFA*)regex);
-    codepoint = unicode_to_u32(str, ekUTF8);
-    while(codepoint != 0)
+    NFACtx ctx;
+    bool_t ok = TRUE;
+    cassert_no_null(str);
+    _nfa_start((const NFA*)regex, FALSE, &ctx);
+    while (*str != '\0')
+    {
+        uint32_t codepoint;
+
+        /* ASCII doesn't need decoding */
+        if ((byte_t)*str < 0x80)
+        {
+            codepoint = (uint32_t)*str;
+            str += 1;
+        }
+        else
+        {
+            codepoint = unicode_to_u32(str, ekUTF8);
+            str = unicode_next(str, ekUTF8);
+        }
+
+        if (_nfa_next(&ctx, codepoint) == FALSE)
+        {
+            ok = FALSE;
+            break;
+        }
+    }
+
+    if (ok == TRUE)
+        ok = _nfa_accept(&ctx);
+
+    _nfa_end(&ctx);
+    return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Bounded UTF-8 decoding. Truncated sequences are taken byte by byte */
+static __INLINE uint32_t i_decode(const char_t *str, const uint32_t size, uint32_t *codepoint)
+{
+    byte_t c = (byte_t)str[0];
+    uint32_t n = c < 0x80 ? 1 : (c < 0xE0 ? 2 : (c < 0xF0 ? 3 : 4));
+    if (n == 1 || n > size)
+    {
+        *codepoint = (uint32_t)c;
+        return 1;
+    }
+    else
+    {
+        *codepoint = unicode_to_u32(str, ekUTF8);
+        return n;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Offset of each codepoint, plus the final one ('size'). 'bounds' has room for 'size + 1' */
+static uint32_t i_bounds(const char_t *str, const uint32_t size, uint32_t *bounds)
+{
+    uint32_t pos = 0, n = 0;
+    while (pos < size)
+    {
+        uint32_t codepoint;
+        bounds[n++] = pos;
+        pos += i_decode(str + pos, size - pos, &codepoint);
+    }
+
+    bounds[n++] = size;
+    return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * The floating reverse automaton, run back from the end of the text,
+ * accepts at each codepoint where a match begins. Returns the first one
+ * (leftmost start) or UINT32_MAX. 'st' (optional, 'nb' items) gets all of them.
+ */
+static uint32_t i_starts(const NFA *nfa, const char_t *str, const uint32_t *b, const uint32_t nb, bool_t *st)
+{
+    NFACtx ctx;
+    uint32_t i = nb - 1, first = UINT32_MAX;
+    cassert(nb > 0);
+    _nfa_start(_nfa_reverse(nfa), TRUE, &ctx);
+    for (;;)
+    {
+        bool_t accept = _nfa_accept(&ctx);
+        if (accept == TRUE)
+            first = i;
+
+        if (st != NULL)
+            st[i] = accept;
+
+        if (i == 0)
+            break;
+
+        {
+            uint32_t codepoint;
+            i -= 1;
+            i_decode(str + b[i], b[i + 1] - b[i], &codepoint);
+            _nfa_next(&ctx, codepoint);
+        }
+    }
+
+    _nfa_end(&ctx);
+    return first;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* End of the longest match beginning at 'start' (anchored automaton) */
+static uint32_t i_longest(const NFA *nfa, const char_t *str, const uint32_t size, const uint32_t start)
+{
+    NFACtx ctx;
+    uint32_t pos = start, end = UINT32_MAX;
+    _nfa_start(nfa, FALSE, &ctx);
+    if (_nfa_accept(&ctx) == TRUE)
+        end = pos;
+
+    while (pos < size)
+    {
+        uint32_t codepoint;
+        pos += i_decode(str + pos, size - pos, &codepoint);
+        if (_nfa_next(&ctx, codepoint) == FALSE)
+            break;
+
+        if (_nfa_accept(&ctx) == TRUE)
+            end = pos;
+    }
+
+    _nfa_end(&ctx);
+    cassert_msg(end != UINT32_MAX, "Regex search inconsistency");
+    return end;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Leftmost-longest match: one reverse pass for the start, one forward for the end */
+static bool_t i_search(const NFA *nfa, const char_t *str, const uint32_t size, uint32_t *start, uint32_t *end)
+{
+    /* Usual texts don't touch the heap */
+    uint32_t local[i_LOCAL_BOUNDS];
+    uint32_t *bounds = local;
+    uint32_t nb, first;
+    bool_t found = FALSE;
+    cassert_no_null(start);
+    cassert_no_null(end);
+    if (size >= i_LOCAL_BOUNDS)
+        bounds = heap_new_n(size + 1, uint32_t);
+
+    nb = i_bounds(str, size, bounds);
+    first = i_starts(nfa, str, bounds, nb, NULL);
+    if (first != UINT32_MAX)
+    {
+        *start = bounds[first];
+        *end = i_longest(nfa, str, size, *start);
+        found = TRUE;
+    }
+
+    if (bounds != local)
+        heap_delete_n(&bounds, size + 1, uint32_t);
+
+    return found;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t regex_search(const RegEx *regex, const char_t *str, uint32_t *start, uint32_t *end)
+{
+    cassert_no_null(regex);
+    return i_search((const NFA*)regex, str, str_len_c(str), start, end);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t regex_search_n(const RegEx *regex, const char_t *str, const uint32_t size, uint32_t *start, uint32_t *end)
+{
+    cassert_no_null(regex);
+    cassert(str != NULL || size == 0);
+    return i_search((const NFA*)regex, str, size, start, end);
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t regex_search_stm(const RegEx *regex, Stream *stm, Listener *listener)
+{
+    ArrSt(uint32_t) *bounds = arrst_create(uint32_t);
+    ArrSt(bool_t) *starts = arrst_create(bool_t);
+    uint32_t n = 0, row = 0;
+    bool_t more = TRUE;
+    const char_t *line = NULL;
+    cassert_no_null(regex);
+    line = stm_read_line(stm);
+    while (line != NULL && more == TRUE)
     {
-        if (_nfa_next((NFA*)regex, codepoint) == FALSE)
-            return FALSE;
+        uint32_t size = str_len_c(line);
+        uint32_t *b = NULL;
+        bool_t *st = NULL;
+        uint32_t i = 0, nb = 0;
+        row += 1;
 
-        str = unicode_next(str, ekUTF8);
-        codepoint = unicode_to_u32(str, ekUTF8);
+        /* Match starts are found once per line, buffers are reused between lines */
+        arrst_clear(bounds, NULL, uint32_t);
+        arrst_grow(bounds, size + 1, uint32_t);
+        b = arrst_all(bounds, uint32_t);
+        nb = i_bounds(line, size, b);
+        arrst_clear(starts, NULL, bool_t);
+        arrst_grow(starts, nb, bool_t);
+        st = arrst_all(starts, bool_t);
+        i_starts((const NFA*)regex, line, b, nb, st);
+        while (more == TRUE)
+        {
+            uint32_t end;
+            while (i < nb && st[i] == FALSE)
+                i += 1;
+
+            if (i == nb)
+                break;
+
+            end = i_longest((const NFA*)regex, line, size, b[i]);
+            n += 1;
+            if (listener != NULL)
+            {
+                EvRegEx params;
+                params.line = line;
+                params.row = row;
+                params.start = b[i];
+                params.end = end;
+                listener_event(listener, ekEREGEX, NULL, &params, &more, void, EvRegEx, bool_t);
+            }
+
+            /* Empty matches move one character forward */
+            if (end > b[i])
+            {
+                while (b[i] < end)
+                    i += 1;
+            }
+            else
+            {
+                i += 1;
+            }
+        }
+
+        if (more == TRUE)
+            line = stm_read_line(stm);
+    }
+
+    arrst_destroy(&bounds, NULL, uint32_t);
+    arrst_destroy(&starts, NULL, bool_t);
+    if (listener != NULL)
+        listener_destroy(&listener);
+
+    return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+RegExSet *regex_set_create(const char_t **patterns, const uint32_t n)
+{
+    return (RegExSet*)_nfa_set(patterns, n);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void regex_set_destroy(RegExSet **set)
+{
+    _nfa_destroy((NFA**)set);
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t regex_set_match(const RegExSet *set, const char_t *str, uint32_t *matches, const uint32_t max)
+{
+    NFACtx ctx;
+    uint32_t n = 0;
+    uint32_t size = str_len_c(str), pos = 0;
+    cassert_no_null(set);
+    _nfa_start((const NFA*)set, FALSE, &ctx);
+    while (pos < size)
+    {
+        uint32_t codepoint;
+        pos += i_decode(str + pos, size - pos, &codepoint);
+        if (_nfa_next(&ctx, codepoint) == FALSE)
+            break;
     }
 
-    return _nfa_accept((NFA*)regex);
+    if (pos == size)
+        n = _nfa_accepts(&ctx, matches, max);
+
+    _nfa_end(&ctx);
+    return n;
 }
@@ -21,4 +21,16 @@ _core_api void regex_destroy(RegEx **regex);
 
 _core_api bool_t regex_match(const RegEx *regex, const char_t *str);
 
+_core_api bool_t regex_search(const RegEx *regex, const char_t *str, uint32_t *start, uint32_t *end);
+
+_core_api bool_t regex_search_n(const RegEx *regex, const char_t *str, const uint32_t size, uint32_t *start, uint32_t *end);
+
+_core_api uint32_t regex_search_stm(const RegEx *regex, Stream *stm, Listener *listener);
+
+_core_api RegExSet *regex_set_create(const char_t **patterns, const uint32_t n);
+
+_core_api void regex_set_destroy(RegExSet **set);
+
+_core_api uint32_t regex_set_match(const RegExSet *set, const char_t *str, uint32_t *matches, const uint32_t max);
+
 __END_C
@@ -15,7 +15,6 @@
 #include "arrpt.h"
 #include "arrst.h"
 #include "bfile.h"
-#include "buffer.h"
 #include "cassert.h"
 #include "heap.h"
 #include "hfile.h"
@@ -44,7 +43,8 @@ struct _respack
 {
     enum i_type_t type;
     String *name;
-    Buffer *buffer;
+    const byte_t *data;
+    uint64_t size;
     ArrSt(i_Resource) *resources;
 };
 
@@ -81,12 +81,13 @@ static void i_remove_resource(i_Resource *resource)
 
 /*---------------------------------------------------------------------------*/
 
-static ResPack *i_create_respack(const enum i_type_t type, String **name, Buffer **buffer, ArrSt(i_Resource) **resources)
+static ResPack *i_create_respack(const enum i_type_t type, String **name, const byte_t *data, const uint64_t size, ArrSt(i_Resource) **resources)
 {
     ResPack *pack = heap_new(ResPack);
     pack->type = type;
     pack->name = ptr_dget_no_null(name, String);
-    pack->buffer = ptr_dget(buffer, Buffer);
+    pack->data = data;
+    pack->size = size;
     pack->resources = ptr_dget_no_null(resources, ArrSt(i_Resource));
     return pack;
 }
@@ -100,9 +101,14 @@ void respack_destroy(ResPack **pack)
     str_destroy(&(*pack)->name);
     arrst_destroy(&(*pack)->resources, i_remove_resource, i_Resource);
     if ((*pack)->type == i_ekTYPE_PACKED)
-        buffer_destroy(&(*pack)->buffer);
+    {
+        if ((*pack)->data != NULL)
+            hfile_munmap(&(*pack)->data, (*pack)->size);
+    }
     else
-        cassert((*pack)->buffer == NULL);
+    {
+        cassert((*pack)->data == NULL);
+    }
     heap_delete(pack, ResPack);
 }
 
@@ -111,9 +117,8 @@ void respack_destroy(ResPack **pack)
 ResPack *respack_embedded(const char_t *name)
 {
     String *lname = str_c(name);
-    Buffer *buffer = NULL;
     ArrSt(i_Resource) *resources = arrst_create(i_Resource);
-    return i_create_respack(i_ekTYPE_EMBEDDED, &lname, &buffer, &resources);
+    return i_create_respack(i_ekTYPE_EMBEDDED, &lname, NULL, 0, &resources);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -169,10 +174,10 @@ static void i_load_resource(Stream *stream, const uint32_t locale_code, i_Resour
 
 /*---------------------------------------------------------------------------*/
 
-static Buffer *i_load_pack(ArrSt(i_Resource) *resources, const char_t *name, const char_t *locale)
+static const byte_t *i_load_pack(ArrSt(i_Resource) *resources, const char_t *name, const char_t *locale, uint64_t *size)
 {
     String *resfile = NULL;
-    Buffer *buffer = NULL;
+    const byte_t *data = NULL;
 
     {
         String *path;
@@ -192,11 +197,12 @@ static Buffer *i_load_pack(ArrSt(i_Resource) *resources, const char_t *name, con
         str_destroy(&path);
     }
 
-    buffer = hfile_buffer(tc(resfile), NULL);
-    if (buffer != NULL)
+    /* Resources point directly into the mapped file, no copy is made */
+    data = hfile_mmap(tc(resfile), size, NULL);
+    if (data != NULL && *size <= 0xFFFFFFFF)
     {
         uint32_t locale_code = UINT32_MAX;
-        Stream *stream = stm_from_block(buffer_data(buffer), buffer_size(buffer));
+        Stream *stream = stm_from_block(data, (uint32_t)*size);
         register uint32_t num_resources;
         register uint32_t i, num_locales = stm_read_u32(stream);
         for (i = 0; i < num_locales; ++i)
@@ -227,7 +233,7 @@ static Buffer *i_load_pack(ArrSt(i_Resource) *resources, const char_t *name, con
     }
 
     str_destroy(&resfile);
-    return buffer;
+    return data;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -236,8 +242,9 @@ ResPack *respack_packed(const char_t *name, const char_t *locale)
 {
     String *lname = str_c(name);
     ArrSt(i_Resource) *resources = arrst_create(i_Resource);
-    Buffer *buffer = i_load_pack(resources, name, locale);
-    return i_create_respack(i_ekTYPE_PACKED, &lname, &buffer, &resources);
+    uint64_t size = 0;
+    const byte_t *data = i_load_pack(resources, name, locale, &size);
+    return i_create_respack(i_ekTYPE_PACKED, &lname, data, size, &resources);
 }
 
 /*---------------------------------------------------------------------------*/
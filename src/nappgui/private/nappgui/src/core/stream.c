@@ -19,6 +19,8 @@
 #include "bsocket.h"
 #include "cassert.h"
 #include "heap.h"
+#include "hfile.h"
+#include "heap.inl"
 #include "log.h"
 #include "osbs.h"
 #include "ptr.h"
@@ -41,10 +43,14 @@
 #define IS_OK(state)        !(BIT_TEST(state, END_BIT) || BIT_TEST(state, CORRUPTION_BIT) || BIT_TEST(state, BROKEN_BIT))
 #define IS_EMPTY(str)       ((str)[0] == '\0')
 #define DISK_CACHE          2048
+#define DISK_CACHE_MAX      (256 * 1024)
 #define MEM_CACHE           2048
-#define SOCK_WRITE_CACHE	512
+#define SOCK_WRITE_CACHE	16384
+#define SOCK_READ_CACHE     4096
+#define SOCK_RECV_MAX       (4 * 1024 * 1024)
 #define STD_CACHE           2048
 #define PIPE_CACHE          2048
+#define CHUNK64             0x40000000
 Stream *kSTDIN = NULL;
 Stream *kSTDOUT = NULL;
 Stream *kSTDERR = NULL;
@@ -66,14 +72,15 @@ typedef enum i_type_t
 
 typedef struct i_file_t i_File;
 typedef struct i_socket_t i_Socket;
+typedef struct i_map_t i_Map;
 typedef struct i_buffer_t i_Buffer;
 
 struct i_buffer_t
 {
     byte_t *data;
-    uint32_t size;
-    uint32_t woffset;
-    uint32_t roffset;
+    uint64_t size;
+    uint64_t woffset;
+    uint64_t roffset;
     bool_t dynamic_alloc;
 };
 
@@ -87,12 +94,21 @@ struct i_socket_t
 {
     Socket *socket;
     serror_t sock_err;
+    bool_t async;
+    bool_t closed;
+};
+
+struct i_map_t
+{
+    const byte_t *data;
+    uint64_t size;
 };
 
 typedef union i_channel_t
 {
     i_File file;
     i_Socket sock;
+    i_Map map;
 } i_Channel;
 
 struct _stream_t
@@ -112,6 +128,7 @@ struct _stream_t
     uint32_t state;
     uint64_t read_offset;
     uint64_t write_offset;
+    bool_t adaptive;
     bool_t escapes;
     bool_t spaces;
     bool_t newlines;
@@ -169,7 +186,7 @@ static void i_init_buffer(i_Buffer *buffer, const uint32_t size, const char_t *n
 
 /*---------------------------------------------------------------------------*/
 
-static void i_init_const_buffer(i_Buffer *buffer, const byte_t *data, const uint32_t size)
+static void i_init_const_buffer(i_Buffer *buffer, const byte_t *data, const uint64_t size)
 {
     cassert_no_null(buffer);
     cassert(size > 0);
@@ -188,7 +205,7 @@ static void i_remove_buffer(i_Buffer *buffer, const char_t *name)
     if (buffer->data != NULL)
     {
         if (buffer->dynamic_alloc == TRUE)
-            heap_free(&buffer->data, buffer->size, name);
+            heap_free(&buffer->data, (uint32_t)buffer->size, name);
         buffer->size = 0;
         buffer->roffset = 0;
         buffer->woffset = 0;
@@ -203,6 +220,53 @@ static void i_remove_buffer(i_Buffer *buffer, const char_t *name)
 
 /*---------------------------------------------------------------------------*/
 
+static void i_resize_buffer(i_Buffer *buffer, const uint32_t size, const char_t *name)
+{
+    uint32_t pending = 0;
+    cassert_no_null(buffer);
+    cassert(buffer->dynamic_alloc == TRUE);
+    cassert(buffer->woffset >= buffer->roffset);
+    pending = (uint32_t)(buffer->woffset - buffer->roffset);
+    cassert(size >= pending);
+    if (size != buffer->size)
+    {
+        byte_t *data = heap_malloc(size, name);
+        if (pending > 0)
+            bmem_copy(data, buffer->data + buffer->roffset, pending);
+
+        if (buffer->data != NULL)
+            heap_free(&buffer->data, (uint32_t)buffer->size, name);
+
+        buffer->data = data;
+        buffer->size = size;
+    }
+    else if (buffer->roffset > 0)
+    {
+        bmem_move(buffer->data, buffer->data + buffer->roffset, pending);
+    }
+
+    buffer->roffset = 0;
+    buffer->woffset = pending;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Sequential access detected. Grow the channel cache to reduce syscalls */
+static void i_adapt_cache(Stream *stm, i_Buffer *buffer)
+{
+    cassert_no_null(stm);
+    cassert_no_null(buffer);
+    if (stm->adaptive == TRUE && buffer->size < DISK_CACHE_MAX)
+    {
+        uint32_t size = (uint32_t)buffer->size * 2;
+        if (size > DISK_CACHE_MAX)
+            size = DISK_CACHE_MAX;
+        i_resize_buffer(buffer, size, "StreamBuffer1");
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
 static Stream *i_create_stream(const type_t type)
 {
     Stream *stm = heap_new0(Stream);
@@ -251,6 +315,11 @@ static void i_close_channel(i_Channel *channel, const type_t type)
             break;
 
         case i_ekFROMMEMORY:
+            /* Memory mapped file (stm_from_mmap) */
+            if (channel->map.data != NULL)
+                hfile_munmap(&channel->map.data, channel->map.size);
+            break;
+
         case i_ekTOMEMORY:
         case i_ekTOSTDOUT:
         case i_ekTOSTDERR:
@@ -330,6 +399,38 @@ Stream *stm_from_file(const char_t *pathname, ferror_t *error)
         stm->input = &stm->buffer1;
         stm->channel.file.file = file;
         stm->channel.file.file_err = ekFOK;
+        stm->adaptive = TRUE;
+        return stm;
+    }
+    else
+    {
+        return NULL;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+Stream *stm_from_mmap(const char_t *pathname, ferror_t *error)
+{
+    ferror_t lerror;
+    uint64_t size = 0;
+    const byte_t *data = hfile_mmap(pathname, &size, &lerror);
+    ptr_assign(error, lerror);
+    if (data != NULL)
+    {
+        Stream *stm = i_create_stream(i_ekFROMMEMORY);
+        i_init_const_buffer(&stm->buffer1, data, size);
+        stm->input = &stm->buffer1;
+        stm->input->woffset = size;
+        stm->channel.map.data = data;
+        stm->channel.map.size = size;
+        return stm;
+    }
+    else if (lerror == ekFOK)
+    {
+        /* Empty file */
+        Stream *stm = i_create_stream(i_ekFROMMEMORY);
+        stm->input = &stm->buffer1;
         return stm;
     }
     else
@@ -350,6 +451,7 @@ static Stream *i_to_file(File *file, const ferror_t lerror, ferror_t *error)
         stm->output = &stm->buffer1;
         stm->channel.file.file = file;
         stm->channel.file.file_err = ekFOK;
+        stm->adaptive = TRUE;
         return stm;
     }
     else
@@ -389,6 +491,8 @@ Stream *stm_socket(Socket *socket)
         stm->input = NULL;
         stm->channel.sock.socket = socket;
         stm->channel.sock.sock_err = ekSOK;
+        stm->channel.sock.async = FALSE;
+        stm->channel.sock.closed = FALSE;
         return stm;
     }
     else
@@ -399,6 +503,21 @@ Stream *stm_socket(Socket *socket)
 
 /*---------------------------------------------------------------------------*/
 
+Stream *stm_socket_async(Socket *socket)
+{
+    Stream *stm = stm_socket(socket);
+    if (stm != NULL)
+    {
+        /* buffer2 holds the received data (stm_sock_recv) */
+        bsocket_nonblock(socket, TRUE);
+        stm->channel.sock.async = TRUE;
+    }
+
+    return stm;
+}
+
+/*---------------------------------------------------------------------------*/
+
 static Stream *i_stdout(void)
 {
     Stream *stm = i_create_stream(i_ekTOSTDOUT);
@@ -723,7 +842,45 @@ uint32_t stm_buffer_size(const Stream *stm)
     cassert_no_null(stm);
     cassert(stm->type == i_ekTOMEMORY);
     cassert(stm->buffer1.woffset >= stm->buffer1.roffset);
-    return stm->buffer1.woffset - stm->buffer1.roffset;
+    return (uint32_t)(stm->buffer1.woffset - stm->buffer1.roffset);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void stm_cache_size(Stream *stm, const uint32_t size)
+{
+    cassert_no_null(stm);
+    switch (stm->type)
+    {
+        case i_ekTOFILE:
+        case i_ekFROMFILE:
+        case i_ekSOCKET:
+        case i_ekTOSTDOUT:
+        case i_ekTOSTDERR:
+        case i_ekFROMSTDIN:
+        {
+            i_Buffer *buffer = stm->output != NULL ? stm->output : stm->input;
+            cassert_no_null(buffer);
+            /* size = 0 --> Adaptive cache (grows on sequential access) */
+            stm->adaptive = (bool_t)(size == 0);
+            if (size > 0)
+            {
+                uint32_t lsize = size;
+                stm_flush(stm);
+                if (lsize < buffer->woffset - buffer->roffset)
+                    lsize = (uint32_t)(buffer->woffset - buffer->roffset);
+                i_resize_buffer(buffer, lsize, "StreamBuffer1");
+            }
+            break;
+        }
+
+        case i_ekTOMEMORY:
+        case i_ekFROMMEMORY:
+        case i_ekDEVNULL:
+            break;
+
+        cassert_default();
+    }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -764,6 +921,62 @@ static void i_sock_write(Stream *stm, const byte_t *data, const uint32_t size)
 
 /*---------------------------------------------------------------------------*/
 
+/* Cached frame header and big payload in one system call */
+static void i_sock_write2(Stream *stm, const byte_t *data1, const uint32_t size1, const byte_t *data2, const uint32_t size2)
+{
+    SockBuf bufs[2];
+    uint32_t num_written = 0;
+    cassert_no_null(stm);
+    cassert(stm->type == i_ekSOCKET);
+    bufs[0].data = (byte_t*)data1;
+    bufs[0].size = size1;
+    bufs[1].data = (byte_t*)data2;
+    bufs[1].size = size2;
+    if (bsocket_writev(stm->channel.sock.socket, bufs, 2, &num_written, &stm->channel.sock.sock_err) == TRUE)
+    {
+        if (num_written != size1 + size2)
+            BIT_SET(stm->state, BROKEN_BIT);
+    }
+    else
+    {
+        BIT_SET(stm->state, BROKEN_BIT);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Non-blocking send. The data not accepted by the socket remains in cache */
+static void i_sock_send(Stream *stm)
+{
+    i_Buffer *output = NULL;
+    uint32_t pending = 0;
+    cassert_no_null(stm);
+    cassert(stm->type == i_ekSOCKET);
+    output = stm->output;
+    cassert(output->roffset == 0);
+    pending = (uint32_t)output->woffset;
+
+    if (pending > 0)
+    {
+        uint32_t num_written = 0;
+        serror_t error = ekSOK;
+        bsocket_write(stm->channel.sock.socket, output->data, pending, &num_written, &error);
+        if (error == ekSOK || error == ekSAGAIN)
+        {
+            if (num_written > 0 && num_written < pending)
+                bmem_move(output->data, output->data + num_written, pending - num_written);
+            output->woffset = pending - num_written;
+        }
+        else
+        {
+            stm->channel.sock.sock_err = error;
+            BIT_SET(stm->state, BROKEN_BIT);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void i_stdout_write(Stream *stm, const byte_t *data, const uint32_t size)
 {
     uint32_t num_written = 0;
@@ -807,14 +1020,16 @@ static void i_grow_buffer(i_Buffer *output, const uint32_t size, const uint32_t
     cassert(size > 0);
     cassert(output->woffset + size > output->size);
 
-    current_datasize = output->woffset - output->roffset;
+    current_datasize = (uint32_t)(output->woffset - output->roffset);
     reqsize = current_datasize + size;
 
     /* Not enough buffer size */
     if (reqsize > output->size)
     {
-        register uint32_t new_size = output->size > 0 ? 2 * output->size : grow_size;
+        register uint32_t new_size = output->size > 0 ? 2 * (uint32_t)output->size : grow_size;
         byte_t *data = NULL;
+        /* Stream buffers never live in a HeapArena region */
+        HeapArena *region = _heap_arena_pause();
 
         while (reqsize > new_size)
             new_size *= 2;
@@ -830,7 +1045,7 @@ static void i_grow_buffer(i_Buffer *output, const uint32_t size, const uint32_t
             for (i = 0; i < current_datasize; ++i, ++sdata, ++ddata)
                 *ddata = *sdata;
 
-            heap_free(&output->data, output->size, memname);
+            heap_free(&output->data, (uint32_t)output->size, memname);
         }
         else
         {
@@ -840,6 +1055,7 @@ static void i_grow_buffer(i_Buffer *output, const uint32_t size, const uint32_t
 
         output->data = data;
         output->size = new_size;
+        _heap_arena_resume(region);
     }
     /* We can reuse the existing buffer move data in. */
     else
@@ -867,16 +1083,27 @@ static void i_need_buffer_space(Stream *stm, i_Buffer *output, const uint32_t si
     }
     else if (stm->type == i_ekSOCKET)
     {
-        /* Sockets all allways write cache-flushed */
-        cassert(output->woffset == 0);
+        /* Async sockets keep the unsent data until stm_flush */
+        if (stm->channel.sock.async == TRUE)
+        {
+            i_grow_buffer(output, size, SOCK_WRITE_CACHE, "StreamBuffer1");
+        }
+        /* Frames bigger than cache are sent together with the cached data (i_write) */
+        else if (size <= output->size)
+        {
+            cassert(output->roffset == 0);
+            i_sock_write(stm, output->data, (uint32_t)output->woffset);
+            output->woffset = 0;
+        }
     }
     else
     {
         /* For channel buffers --> flush to free space in cache */
         cassert_no_nullf(i_FUNC_WRITE[stm->type]);
         cassert(output->roffset == 0);
-        i_FUNC_WRITE[stm->type](stm, output->data, output->woffset);
+        i_FUNC_WRITE[stm->type](stm, output->data, (uint32_t)output->woffset);
         output->woffset = 0;
+        i_adapt_cache(stm, output);
     }
 }
 
@@ -905,8 +1132,16 @@ static void i_write(Stream *stm, const byte_t *data, const uint32_t size, const
             cassert(reverse == FALSE);      /* So big for endianness */
             cassert_no_nullf(i_FUNC_WRITE[stm->type]);
             cassert(output->roffset == 0);
-            cassert(output->woffset == 0);  /* Has been flushed */
-            i_FUNC_WRITE[stm->type](stm, data, size);
+            if (stm->type == i_ekSOCKET && output->woffset > 0)
+            {
+                i_sock_write2(stm, output->data, (uint32_t)output->woffset, data, size);
+                output->woffset = 0;
+            }
+            else
+            {
+                cassert(output->woffset == 0);  /* Has been flushed */
+                i_FUNC_WRITE[stm->type](stm, data, size);
+            }
         }
         /* Write in cache */
         else
@@ -935,15 +1170,6 @@ static void i_write(Stream *stm, const byte_t *data, const uint32_t size, const
                     bmem_rev(dest, size);
                 }
             }
-
-            /* For sockets --> flush cache allways */
-            if (stm->type == i_ekSOCKET)
-            {
-                cassert_no_nullf(i_FUNC_WRITE[stm->type]);
-                cassert(output->roffset == 0);
-                i_FUNC_WRITE[stm->type](stm, output->data, output->woffset);
-                output->woffset = 0;
-            }
         }
 
         stm->write_offset += size;
@@ -969,6 +1195,21 @@ void stm_write(Stream *stm, const byte_t *data, const uint32_t size)
 
 /*---------------------------------------------------------------------------*/
 
+void stm_write64(Stream *stm, const byte_t *data, const uint64_t size)
+{
+    uint64_t written = 0;
+    cassert_no_null(stm);
+    while (written < size && IS_OK(stm->state))
+    {
+        uint64_t remain = size - written;
+        uint32_t chunk = remain < CHUNK64 ? (uint32_t)remain : CHUNK64;
+        stm_write(stm, data + written, chunk);
+        written += chunk;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void i_write_utf16(Stream *stm, const char_t *str)
 {
     uint32_t codepoint = unicode_to_u32(str, ekUTF8);
@@ -1277,7 +1518,12 @@ static void i_file_fill_cache(Stream *stm, const uint32_t size)
     cassert_no_null(input);
     cassert(input->woffset == input->roffset);
     unref(size);
-    if (bfile_read(stm->channel.file.file, input->data, input->size, &nreaded, &stm->channel.file.file_err) == TRUE)
+
+    /* The previous cache has been fully consumed */
+    if (input->woffset > 0)
+        i_adapt_cache(stm, input);
+
+    if (bfile_read(stm->channel.file.file, input->data, (uint32_t)input->size, &nreaded, &stm->channel.file.file_err) == TRUE)
     {
         input->woffset = nreaded;
         input->roffset = 0;
@@ -1294,13 +1540,75 @@ static void i_file_fill_cache(Stream *stm, const uint32_t size)
 
 /*---------------------------------------------------------------------------*/
 
-static void i_read_from_socket(Stream *stm, byte_t *data, const uint32_t size)
+/* Big reads bypass the cache, straight into the caller's memory */
+static uint32_t i_file_read_direct(Stream *stm, byte_t *data, const uint32_t size)
 {
-    uint32_t nreaded;
+    uint32_t nreaded = 0;
+    cassert_no_null(stm);
+    cassert(stm->type == i_ekFROMFILE);
+    cassert(stm->input->woffset == stm->input->roffset);
+    if (bfile_read(stm->channel.file.file, data, size, &nreaded, &stm->channel.file.file_err) == TRUE)
+    {
+        if (nreaded == 0)
+            BIT_SET(stm->state, END_BIT);
+    }
+    else
+    {
+        nreaded = 0;
+        BIT_SET(stm->state, BROKEN_BIT);
+    }
+
+    return nreaded;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_read_from_socket(Stream *stm, byte_t *data, const uint32_t size)
+{
+    uint32_t nreaded = 0;
     cassert_no_null(stm);
     cassert(stm->type == i_ekSOCKET);
     cassert(stm->input == NULL);
 
+    /* Async sockets only read the data previously received.
+       A value is never split: if it has not arrived yet, nothing is consumed
+       and ekSAGAIN is reported, so the read can be retried after 'stm_sock_recv' */
+    if (stm->channel.sock.async == TRUE)
+    {
+        i_Buffer *recv = &stm->buffer2;
+        if (recv->woffset - recv->roffset >= size)
+        {
+            bmem_copy(data, recv->data + recv->roffset, size);
+            recv->roffset += size;
+            if (recv->roffset == recv->woffset)
+            {
+                recv->roffset = 0;
+                recv->woffset = 0;
+            }
+
+            stm->channel.sock.sock_err = ekSOK;
+            return size;
+        }
+        else if (stm->channel.sock.closed == TRUE)
+        {
+            BIT_SET(stm->state, END_BIT);
+        }
+        else
+        {
+            stm->channel.sock.sock_err = ekSAGAIN;
+        }
+
+        return 0;
+    }
+
+    /* Request-response: the peer must receive the pending frames before we wait */
+    if (stm->output->woffset > 0)
+    {
+        stm_flush(stm);
+        if (!IS_OK(stm->state))
+            return 0;
+    }
+
     if (bsocket_read(stm->channel.sock.socket, data, size, &nreaded, &stm->channel.sock.sock_err) == TRUE)
     {
         if (nreaded == 0)
@@ -1310,6 +1618,88 @@ static void i_read_from_socket(Stream *stm, byte_t *data, const uint32_t size)
     {
         BIT_SET(stm->state, BROKEN_BIT);
     }
+
+    return nreaded;
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t stm_sock_recv(Stream *stm)
+{
+    i_Buffer *recv = NULL;
+    uint32_t total = 0;
+    cassert_no_null(stm);
+    cassert(stm->type == i_ekSOCKET);
+    cassert(stm->channel.sock.async == TRUE);
+    recv = &stm->buffer2;
+
+    while (stm->channel.sock.closed == FALSE)
+    {
+        uint32_t avail = 0, rsize = 0;
+        serror_t error = ekSOK;
+
+        if (recv->woffset + SOCK_READ_CACHE > recv->size)
+        {
+            /* The rest waits in the kernel until the application consumes */
+            if (recv->woffset - recv->roffset + SOCK_READ_CACHE > SOCK_RECV_MAX)
+                break;
+
+            i_grow_buffer(recv, SOCK_READ_CACHE, SOCK_READ_CACHE, "StreamBuffer2");
+        }
+
+        avail = (uint32_t)(recv->size - recv->woffset);
+        bsocket_read(stm->channel.sock.socket, recv->data + recv->woffset, avail, &rsize, &error);
+        recv->woffset += rsize;
+        total += rsize;
+
+        if (error == ekSOK)
+        {
+            /* Peer has closed the connection */
+            if (rsize < avail)
+                stm->channel.sock.closed = TRUE;
+        }
+        else
+        {
+            /* ekSAGAIN --> No more data for now */
+            if (error != ekSAGAIN)
+            {
+                stm->channel.sock.sock_err = error;
+                stm->channel.sock.closed = TRUE;
+                BIT_SET(stm->state, BROKEN_BIT);
+            }
+
+            break;
+        }
+    }
+
+    return total;
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t stm_sock_available(const Stream *stm)
+{
+    cassert_no_null(stm);
+    cassert(stm->type == i_ekSOCKET);
+    return (uint32_t)(stm->buffer2.woffset - stm->buffer2.roffset);
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t stm_sock_pending(const Stream *stm)
+{
+    cassert_no_null(stm);
+    cassert(stm->type == i_ekSOCKET);
+    return (uint32_t)(stm->buffer1.woffset - stm->buffer1.roffset);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t stm_sock_closed(const Stream *stm)
+{
+    cassert_no_null(stm);
+    cassert(stm->type == i_ekSOCKET);
+    return stm->channel.sock.closed;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -1325,7 +1715,7 @@ static void i_stdin_fill_cache(Stream *stm, const uint32_t size)
     cassert_no_null(input);
     cassert(input->woffset == input->roffset);
     if (input->size < rsize)
-        rsize = input->size;
+        rsize = (uint32_t)input->size;
 
     if (bstd_read(input->data, rsize, &nreaded) == TRUE)
     {
@@ -1356,7 +1746,7 @@ static uint32_t i_read(Stream *stm, byte_t *data, const uint32_t size, const boo
     /* Read first from restore cache */
     if (stm->restore.woffset > stm->restore.roffset)
     {
-        register uint32_t read_restore = stm->restore.woffset - stm->restore.roffset;
+        register uint32_t read_restore = (uint32_t)(stm->restore.woffset - stm->restore.roffset);
         register byte_t *src = stm->restore.data + stm->restore.roffset;
         if (read_restore > size)
             read_restore = size;
@@ -1376,23 +1766,23 @@ static uint32_t i_read(Stream *stm, byte_t *data, const uint32_t size, const boo
 
         if (data != NULL)
         {
-            i_read_from_socket(stm, data + readed, remain);
+            readed += i_read_from_socket(stm, data + readed, remain);
         }
         /* Jump socket data */
         else
         {
             byte_t waste[512];
-            uint32_t i, n = remain / sizeof(waste);
-            uint32_t last = remain % sizeof(waste);
 
-            for (i = 0; i < n; ++i)
-                i_read_from_socket(stm, waste, sizeof(waste));
-
-            if (last > 0)
-                i_read_from_socket(stm, waste, last);
+            while (remain > 0)
+            {
+                uint32_t n = remain < sizeof32(waste) ? remain : sizeof32(waste);
+                uint32_t r = i_read_from_socket(stm, waste, n);
+                readed += r;
+                remain -= r;
+                if (r < n)
+                    break;
+            }
         }
-
-        readed += remain;
     }
     else
     {
@@ -1409,11 +1799,20 @@ static uint32_t i_read(Stream *stm, byte_t *data, const uint32_t size, const boo
         for (; readed < size; )
         {
             register uint32_t remain = size - readed;
-            uint32_t available = input->woffset - input->roffset;
+            uint64_t available = input->woffset - input->roffset;
 
             /* Fill the read cache */
             if (available == 0)
             {
+                if (data != NULL && stm->type == i_ekFROMFILE && remain >= input->size)
+                {
+                    uint32_t direct = i_file_read_direct(stm, data + readed, remain);
+                    if (direct == 0)
+                        break;
+                    readed += direct;
+                    continue;
+                }
+
                 cassert_no_nullf(i_FUNC_FILL[stm->type]);
                 i_FUNC_FILL[stm->type](stm, remain);
                 available = input->woffset - input->roffset;
@@ -1426,10 +1825,10 @@ static uint32_t i_read(Stream *stm, byte_t *data, const uint32_t size, const boo
 
             /* data = NULL for jump */
             if (data != NULL)
-                bmem_copy(data + readed, input->data + input->roffset, available);
+                bmem_copy(data + readed, input->data + input->roffset, (uint32_t)available);
 
             input->roffset += available;
-            readed += available;
+            readed += (uint32_t)available;
         }
     }
 
@@ -1468,6 +1867,25 @@ uint32_t stm_read(Stream *stm, byte_t *data, const uint32_t size)
 
 /*---------------------------------------------------------------------------*/
 
+uint64_t stm_read64(Stream *stm, byte_t *data, const uint64_t size)
+{
+    uint64_t readed = 0;
+    cassert_no_null(stm);
+    while (readed < size)
+    {
+        uint64_t remain = size - readed;
+        uint32_t chunk = remain < CHUNK64 ? (uint32_t)remain : CHUNK64;
+        uint32_t r = i_read(stm, data != NULL ? data + readed : NULL, chunk, FALSE);
+        readed += r;
+        if (r < chunk)
+            break;
+    }
+
+    return readed;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void stm_skip(Stream *stm, const uint32_t size)
 {
     i_read(stm, NULL, size, FALSE);
@@ -1475,6 +1893,71 @@ void stm_skip(Stream *stm, const uint32_t size)
 
 /*---------------------------------------------------------------------------*/
 
+void stm_skip64(Stream *stm, const uint64_t size)
+{
+    stm_read64(stm, NULL, size);
+}
+
+/*---------------------------------------------------------------------------*/
+
+const byte_t *stm_peek(Stream *stm, uint32_t *size)
+{
+    i_Buffer *input = NULL;
+    cassert_no_null(stm);
+    cassert_no_null(size);
+    cassert(stm->type != i_ekDEVNULL);
+    *size = 0;
+
+    if (!IS_OK(stm->state))
+        return NULL;
+
+    /* Pending restore data goes first */
+    if (stm->restore.woffset > stm->restore.roffset)
+    {
+        *size = (uint32_t)(stm->restore.woffset - stm->restore.roffset);
+        return stm->restore.data + stm->restore.roffset;
+    }
+
+    stm->restore.roffset = 0;
+    stm->restore.woffset = 0;
+
+    /* Sockets doesn't use cache. Only one byte can be read without blocking */
+    if (stm->type == i_ekSOCKET)
+    {
+        byte_t byte;
+        i_read_from_socket(stm, &byte, 1);
+        if (!IS_OK(stm->state))
+            return NULL;
+        _stm_restore(stm, &byte, 1);
+        *size = 1;
+        return stm->restore.data;
+    }
+
+    input = stm->input;
+    if (input == NULL)
+    {
+        log_printf("Trying to read in a write-only stream.");
+        BIT_SET(stm->state, CORRUPTION_BIT);
+        return NULL;
+    }
+
+    if (input->woffset == input->roffset)
+    {
+        cassert_no_nullf(i_FUNC_FILL[stm->type]);
+        i_FUNC_FILL[stm->type](stm, (uint32_t)input->size);
+    }
+
+    /* Memory mapped files can exceed 4GB */
+    {
+        uint64_t available = input->woffset - input->roffset;
+        *size = available < 0xFFFFFFFF ? (uint32_t)available : 0xFFFFFFFF;
+    }
+
+    return *size > 0 ? input->data + input->roffset : NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void stm_skip_bom(Stream *stm)
 {
     uint32_t pcol = stm_col(stm);
@@ -1598,6 +2081,7 @@ static void i_char_to_cache(Stream *stm, const uint32_t code)
     line = &stm->textline;
     if (line->roffset + 4 > line->size)
     {
+        HeapArena *region = _heap_arena_pause();
         if (line->size == 0)
         {
             line->data = heap_malloc(256, "StreamTextLine");
@@ -1605,9 +2089,10 @@ static void i_char_to_cache(Stream *stm, const uint32_t code)
         }
         else
         {
-            line->data = heap_realloc(line->data, line->size, line->size * 2, "StreamTextLine");
+            line->data = heap_realloc(line->data, (uint32_t)line->size, (uint32_t)line->size * 2, "StreamTextLine");
             line->size *= 2;
         }
+        _heap_arena_resume(region);
     }
 
     line->roffset += unicode_to_char(code, (char_t*)(line->data + line->roffset), ekUTF8);
@@ -1750,7 +2235,11 @@ const char_t *stm_read_trim(Stream *stm)
 
 ltoken_t stm_read_token(Stream *stm)
 {
+    HeapArena *region = NULL;
+    ltoken_t token = ekTUNDEF;
     cassert_no_null(stm);
+    /* The lexer state belongs to the stream, not to the active region */
+    region = _heap_arena_pause();
     if (stm->lex == NULL)
     {
         stm->lex = _lexscn_create();
@@ -1759,7 +2248,9 @@ ltoken_t stm_read_token(Stream *stm)
         _lexscn_comments(stm->lex, stm->comments);
     }
 
-    return _lexscn_token(stm->lex, stm);
+    token = _lexscn_token(stm->lex, stm);
+    _heap_arena_resume(region);
+    return token;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -2043,6 +2534,12 @@ void stm_flush(Stream *stm)
     if (stm->type == i_ekDEVNULL)
         return;
 
+    if (stm->type == i_ekSOCKET && stm->channel.sock.async == TRUE)
+    {
+        i_sock_send(stm);
+        return;
+    }
+
     if (i_FUNC_WRITE[stm->type] != NULL)
     {
         i_Buffer *output = stm->output;
@@ -2050,7 +2547,7 @@ void stm_flush(Stream *stm)
         cassert(output->roffset == 0);
         if (output->woffset > 0)
         {
-            i_FUNC_WRITE[stm->type](stm, output->data, output->woffset);
+            i_FUNC_WRITE[stm->type](stm, output->data, (uint32_t)output->woffset);
             output->woffset = 0;
         }
     }
@@ -2058,31 +2555,59 @@ void stm_flush(Stream *stm)
 
 /*---------------------------------------------------------------------------*/
 
-void stm_pipe(Stream *from, Stream *to, const uint32_t n)
+static void i_pipe(Stream *from, Stream *to, const uint64_t n)
 {
-    byte_t cache[PIPE_CACHE];
-    uint32_t i = 0, ln, r;
-    ln = n / PIPE_CACHE;
-    r = n % PIPE_CACHE;
-
+    uint64_t remain = n;
     cassert_no_null(from);
     cassert_no_null(to);
 
-    for (i = 0; i < ln; ++i)
+    /* Write straight from the source read cache, no intermediate copy */
+    if (from != to && from->type != i_ekSOCKET)
     {
-        i_read(from, cache, PIPE_CACHE, FALSE);
-        i_write(to, cache, PIPE_CACHE, FALSE);
-    }
+        while (remain > 0)
+        {
+            uint32_t size = 0;
+            const byte_t *data = stm_peek(from, &size);
+            if (data == NULL)
+                break;
+
+            if (size > remain)
+                size = (uint32_t)remain;
 
-    if (r > 0)
+            i_write(to, data, size, FALSE);
+            i_read(from, NULL, size, FALSE);
+            remain -= size;
+        }
+    }
+    else
     {
-        i_read(from, cache, r, FALSE);
-        i_write(to, cache, r, FALSE);
+        byte_t cache[PIPE_CACHE];
+        while (remain > 0)
+        {
+            uint32_t size = remain < PIPE_CACHE ? (uint32_t)remain : PIPE_CACHE;
+            i_read(from, cache, size, FALSE);
+            i_write(to, cache, size, FALSE);
+            remain -= size;
+        }
     }
 }
 
 /*---------------------------------------------------------------------------*/
 
+void stm_pipe(Stream *from, Stream *to, const uint32_t n)
+{
+    i_pipe(from, to, (uint64_t)n);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void stm_pipe64(Stream *from, Stream *to, const uint64_t n)
+{
+    i_pipe(from, to, n);
+}
+
+/*---------------------------------------------------------------------------*/
+
 void _stm_start(void)
 {
     cassert(kSTDIN == NULL);
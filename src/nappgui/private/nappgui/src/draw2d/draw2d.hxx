@@ -38,6 +38,14 @@ typedef enum _codec_t
     ekGIF
 } codec_t;
 
+typedef enum _pixfilter_t
+{
+    ekPIXNEAREST = 1,
+    ekPIXBILINEAR,
+    ekPIXBICUBIC,
+    ekPIXLANCZOS
+} pixfilter_t;
+
 typedef enum _fstyle_t
 {
     ekFNORMAL       = 0,
@@ -13,6 +13,7 @@
 #include "image.inl"
 #include "osimage.inl"
 #include "imgutil.inl"
+#include "pixconv.inl"
 #include "dctxh.h"
 #include "bmem.h"
 #include "buffer.h"
@@ -108,7 +109,7 @@ OSImage *osimage_create_from_pixels(const uint32_t width, const uint32_t height,
 
     case ekRGB24:
     {
-        register uint32_t i, j;
+        register uint32_t j;
         guchar *dest = NULL;
         colorspace = GDK_COLORSPACE_RGB;
         has_alpha = FALSE;
@@ -118,18 +119,20 @@ OSImage *osimage_create_from_pixels(const uint32_t width, const uint32_t height,
         size = rowstride * height;
         data = heap_new_n(size, guchar);
         dest = data;
-        bmem_copy(data, pixel_data, size);
-        for (j = 0; j < height; ++j)
+
+        /* Rows are 4-byte aligned in GdkPixbuf */
+        if (offset == 0)
+        {
+            bmem_copy(data, pixel_data, size);
+        }
+        else
         {
-            for (i = 0; i < width; ++i, dest += 3)
+            for (j = 0; j < height; ++j)
             {
-                dest[0] = pixel_data[0];
-                dest[1] = pixel_data[1];
-                dest[2] = pixel_data[2];
-                pixel_data += 3;
+                bmem_copy(dest, pixel_data, width * 3);
+                pixel_data += width * 3;
+                dest += rowstride;
             }
-
-            dest += offset;
         }
 
         break;
@@ -137,7 +140,7 @@ OSImage *osimage_create_from_pixels(const uint32_t width, const uint32_t height,
 
     case ekGRAY8:
     {
-        register uint32_t i, j;
+        register uint32_t j;
         guchar *dest = NULL;
         colorspace = GDK_COLORSPACE_RGB;
         has_alpha = FALSE;
@@ -149,15 +152,9 @@ OSImage *osimage_create_from_pixels(const uint32_t width, const uint32_t height,
         dest = data;
         for (j = 0; j < height; ++j)
         {
-            for (i = 0; i < width; ++i, dest += 3)
-            {
-                dest[0] = *pixel_data;
-                dest[1] = *pixel_data;
-                dest[2] = *pixel_data;
-                pixel_data += 1;
-            }
-
-            dest += offset;
+            pixconv_gray_to_rgb(pixel_data, dest, width);
+            pixel_data += width;
+            dest += rowstride;
         }
         break;
     }
@@ -300,7 +297,7 @@ static OSImage *i_multiple_osimage_from_data(const byte_t *data, const uint32_t
 
 /*---------------------------------------------------------------------------*/
 
-OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size)
+OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size, const uint32_t num_frames)
 {
     OSImage *image = NULL;
 
@@ -311,13 +308,17 @@ OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size)
     {
         image = i_single_osimage_from_data(data, size);
     }
+    /* 'num_frames' already known by caller, avoid parse the stream again */
     else
     {
-        uint32_t num_frames = imgutil_num_frames(data, size);
-        if (num_frames == 1)
+        uint32_t lnum_frames = num_frames;
+        if (lnum_frames == 0)
+            lnum_frames = imgutil_num_frames(data, size);
+
+        if (lnum_frames == 1)
             image = i_single_osimage_from_data(data, size);
         else
-            image = i_multiple_osimage_from_data(data, size, num_frames);
+            image = i_multiple_osimage_from_data(data, size, lnum_frames);
     }
 
     return image;
@@ -325,6 +326,51 @@ OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size)
 
 /*---------------------------------------------------------------------------*/
 
+static void i_OnSizePrepared(GdkPixbufLoader *loader, gint width, gint height, gpointer data)
+{
+    const uint32_t *max_size = (const uint32_t*)data;
+    uint32_t nwidth, nheight;
+    cassert_no_null(max_size);
+    imgutil_fit((uint32_t)width, (uint32_t)height, max_size[0], max_size[1], &nwidth, &nheight);
+    /* The loader decodes at reduced size (JPEG DCT scaling) */
+    if (nwidth != (uint32_t)width || nheight != (uint32_t)height)
+        gdk_pixbuf_loader_set_size(loader, (int)nwidth, (int)nheight);
+}
+
+/*---------------------------------------------------------------------------*/
+
+OSImage *osimage_create_from_data_scaled(const byte_t *data, const uint32_t size, const uint32_t max_width, const uint32_t max_height)
+{
+    GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
+    GdkPixbuf *pixbuf = NULL;
+    uint32_t max_size[2];
+    gboolean ok = FALSE;
+
+    cassert_no_null(data);
+    cassert(size > 0);
+    max_size[0] = max_width;
+    max_size[1] = max_height;
+    g_signal_connect(G_OBJECT(loader), "size-prepared", G_CALLBACK(i_OnSizePrepared), (gpointer)max_size);
+    ok = gdk_pixbuf_loader_write(loader, (const guchar*)data, (gsize)size, NULL);
+
+    /* The loader must always be closed, even on error */
+    if (gdk_pixbuf_loader_close(loader, NULL) == TRUE && ok == TRUE)
+    {
+        pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+        if (pixbuf != NULL)
+            g_object_ref(pixbuf);
+    }
+
+    g_object_unref(loader);
+
+    if (pixbuf != NULL)
+        return i_osimage(pixbuf);
+
+    return i_single_osimage_from_data(data, size);
+}
+
+/*---------------------------------------------------------------------------*/
+
 OSImage *osimage_create_from_type(const char_t *file_type)
 {
     /* TODO */
@@ -249,14 +249,14 @@ Image *image_from_file(const char_t *pathname, ferror_t *error)
 
 /*---------------------------------------------------------------------------*/
 
-Image *image_from_data(const byte_t *data, const uint32_t size)
+static Image *i_from_data(const byte_t *data, const uint32_t size, const uint32_t num_frames)
 {
     codec_t codec = i_codec(data[0]);
     if (codec != ENUM_MAX(codec_t))
     {
         OSImage *osimage = NULL;
         real32_t *frame_length = NULL;
-        osimage = osimage_create_from_data(data, size);
+        osimage = osimage_create_from_data(data, size, num_frames);
         return i_create_image(1, PARAM(num_frames, 0), &frame_length, codec, &osimage);
     }
 
@@ -265,6 +265,64 @@ Image *image_from_data(const byte_t *data, const uint32_t size)
 
 /*---------------------------------------------------------------------------*/
 
+Image *image_from_data(const byte_t *data, const uint32_t size)
+{
+    return i_from_data(data, size, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+Image *image_from_data_scaled(const byte_t *data, const uint32_t size, const uint32_t max_width, const uint32_t max_height)
+{
+    codec_t codec = i_codec(data[0]);
+    if (codec != ENUM_MAX(codec_t))
+    {
+        uint32_t num_frames = imgutil_num_frames(data, size);
+
+        /* At the moment, animations are not scaled */
+        if (num_frames == 1 && (max_width != UINT32_MAX || max_height != UINT32_MAX))
+        {
+            OSImage *osimage = NULL;
+            real32_t *frame_length = NULL;
+            uint32_t width, height, nwidth, nheight;
+
+            /* Native decoder reduces the image as much as it can at decoding time */
+            osimage = osimage_create_from_data_scaled(data, size, max_width, max_height);
+            osimage_info(osimage, &width, &height, NULL, NULL);
+            imgutil_fit(width, height, max_width, max_height, &nwidth, &nheight);
+
+            /* Generic fallback, finish the fitting over the pixels */
+            if (nwidth != width || nheight != height)
+            {
+                Pixbuf *pixels = NULL;
+                Pixbuf *spixels = NULL;
+                osimage_info(osimage, NULL, NULL, NULL, &pixels);
+                cassert_no_null(pixels);
+                spixels = pixbuf_scale(pixels, nwidth, nheight, ekPIXBILINEAR);
+                osimage_destroy(&osimage);
+                osimage = osimage_create_from_pixels(nwidth, nheight, pixbuf_format(spixels), pixbuf_cdata(spixels));
+                pixbuf_destroy(&spixels);
+                pixbuf_destroy(&pixels);
+            }
+
+            return i_create_image(1, PARAM(num_frames, 0), &frame_length, codec, &osimage);
+        }
+
+        return i_from_data(data, size, num_frames);
+    }
+
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t image_probe(const byte_t *data, const uint32_t size, codec_t *codec, uint32_t *width, uint32_t *height, pixformat_t *format, uint32_t *num_frames)
+{
+    return imgutil_probe(data, size, codec, width, height, format, num_frames);
+}
+
+/*---------------------------------------------------------------------------*/
+
 const Image *image_from_resource(const ResPack *pack, const ResId id)
 {
     return respack_object(pack, id, image_from_data, image_destroy, Image);
@@ -293,80 +351,19 @@ Image *image_trim(const Image *image, const uint32_t x, const uint32_t y, const
 
 /*---------------------------------------------------------------------------*/
 
-static void i_rotated_image_size(const T2Df *t2d, const uint32_t width, const uint32_t height, real32_t *fx, real32_t *fy, uint32_t *fwidth, uint32_t *fheight)
-{
-    real32_t minx = 1e8f;
-    real32_t maxx = -1e8f;
-    real32_t miny = 1e8f;
-    real32_t maxy = -1e8f;
-    uint32_t i = 0;
-    V2Df corners[4];
-    corners[0].x = 0;
-    corners[0].y = 0;
-    corners[1].x = (real32_t)width;
-    corners[1].y = 0;
-    corners[2].x = (real32_t)width;
-    corners[2].y = (real32_t)height;
-    corners[3].x = 0;
-    corners[3].y = (real32_t)height;
-    for (i = 0; i < 4; ++i)
-    {
-        t2d_vmultf(corners + i, t2d, corners + i);
-        if (corners[i].x < minx) minx = corners[i].x;
-        if (corners[i].x > maxx) maxx = corners[i].x;
-        if (corners[i].y < miny) miny = corners[i].y;
-        if (corners[i].y > maxy) maxy = corners[i].y;
-    }
-
-    *fx = minx;
-    *fy = miny;
-    *fwidth = (uint32_t)(maxx - minx) + 1;
-    *fheight  = (uint32_t)(maxy - miny) + 1;
-}
-
-/*---------------------------------------------------------------------------*/
-
 Image *image_rotate(const Image *image, const real32_t angle, const bool_t nsize, const color_t background, T2Df *t2dc)
 {
-    uint32_t width, height;
-    uint32_t fwidth, fheight;
-    real32_t cx, cy;
-    real32_t fx, fy;
-    T2Df t2d;
-    DCtx *ctx = NULL;
-
+    Pixbuf *pixels = NULL;
+    Pixbuf *rpixels = NULL;
+    Image *rimage = NULL;
     cassert_no_null(image);
-    osimage_info(image->osimage, &width, &height, NULL, NULL);
-    cx = width / 2.f;
-    cy = height / 2.f;
-    t2d_movef(&t2d, kT2D_IDENTf, cx, cy);
-    t2d_rotatef(&t2d, &t2d, angle);
-    t2d_movef(&t2d, &t2d, -cx, -cy);
-
-    if (nsize == TRUE)
-    {
-        i_rotated_image_size(&t2d, width, height, &fx, &fy, &fwidth, &fheight);
-    }
-    else
-    {
-        fx = 0;
-        fy = 0;
-        fwidth = width;
-        fheight = height;
-    }
-
-    ctx = dctx_bitmap(fwidth, fheight, ekRGB24);
-    draw_clear(ctx, background);
-    t2d_movef(&t2d, kT2D_IDENTf, - fx + cx, - fy + cy);
-    t2d_rotatef(&t2d, &t2d, angle);
-    t2d_movef(&t2d, &t2d, -cx, -cy);
-    draw_matrixf(ctx, &t2d);
-
-    if (t2dc != NULL)
-        *t2dc = t2d;
-
-    draw_image(ctx, image, 0, 0);
-    return dctx_image(&ctx);
+    pixels = image_pixels(image, ekFIMAGE);
+    cassert_no_null(pixels);
+    rpixels = pixbuf_rotate(pixels, angle, nsize, background, ekPIXBILINEAR, t2dc);
+    rimage = image_from_pixbuf(rpixels, NULL);
+    pixbuf_destroy(&rpixels);
+    pixbuf_destroy(&pixels);
+    return rimage;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -397,7 +394,21 @@ Image *image_scale(const Image *image, const uint32_t nwidth, const uint32_t nhe
         OSImage *osimage = NULL;
         real32_t *frame_length = NULL;
         cassert_no_null(image);
-        osimage = osimage_create_scaled(image->osimage, width, height);
+        if (image_num_frames(image) == 1)
+        {
+            Pixbuf *pixels = image_pixels(image, ekFIMAGE);
+            Pixbuf *spixels = NULL;
+            cassert_no_null(pixels);
+            spixels = pixbuf_scale(pixels, width, height, ekPIXBILINEAR);
+            osimage = osimage_create_from_pixels(width, height, pixbuf_format(spixels), pixbuf_cdata(spixels));
+            pixbuf_destroy(&spixels);
+            pixbuf_destroy(&pixels);
+        }
+        else
+        {
+            osimage = osimage_create_scaled(image->osimage, width, height);
+        }
+
         return i_create_image(1, PARAM(num_frames, 0), &frame_length, image->codec, &osimage);
     }
     else
@@ -416,10 +427,12 @@ Image *image_read(Stream *stm)
         const byte_t *data = stm_buffer(stm);
         uint64_t st = stm_bytes_readed(stm);
 
-        if (imgutil_parse(stm, NULL) == TRUE)
+        uint32_t num_frames = 0;
+
+        if (imgutil_parse(stm, NULL, &num_frames) == TRUE)
         {
             uint64_t ed = stm_bytes_readed(stm);
-            return image_from_data(data, (uint32_t)(ed - st));
+            return i_from_data(data, (uint32_t)(ed - st), num_frames);
         }
         else
         {
@@ -430,11 +443,12 @@ Image *image_read(Stream *stm)
     {
         Image *image = NULL;
         Stream *stm_out = stm_memory(4096);
-        if (imgutil_parse(stm, stm_out) == TRUE)
+        uint32_t num_frames = 0;
+        if (imgutil_parse(stm, stm_out, &num_frames) == TRUE)
         {
             const byte_t *data = stm_buffer(stm_out);
             uint32_t size = stm_buffer_size(stm_out);
-            image = image_from_data(data, size);
+            image = i_from_data(data, size, num_frames);
         }
 
         stm_close(&stm_out);
@@ -522,7 +536,7 @@ Pixbuf *image_pixels(const Image *image, const pixformat_t format)
            {
                Pixbuf *npixels = NULL;
                cassert(palette == NULL || *palette == NULL);
-               npixels = imgutil_to_indexed(pixbuf_width(*pixels), pixbuf_height(*pixels), pixbuf_data(*pixels), rformat == ekRGB24 ? 3 : 4, palette);
+               npixels = imgutil_to_indexed(pixbuf_width(*pixels), pixbuf_height(*pixels), pixbuf_data(*pixels), rformat == ekRGB24 ? 3 : 4, FALSE, palette);
                if (npixels != NULL)
                {
                    pixbuf_destroy(pixels);
@@ -20,7 +20,9 @@ void osimage_dealloc_globals(void);
 
 OSImage *osimage_create_from_pixels(const uint32_t width, const uint32_t height, const pixformat_t format, const byte_t *pixel_data);
 
-OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size);
+OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size, const uint32_t num_frames);
+
+OSImage *osimage_create_from_data_scaled(const byte_t *data, const uint32_t size, const uint32_t max_width, const uint32_t max_height);
 
 OSImage *osimage_create_from_type(const char_t *file_type);
 
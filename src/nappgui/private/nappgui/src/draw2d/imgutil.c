@@ -11,12 +11,16 @@
 /* Image utilities */
 
 #include "imgutil.inl"
+#include "blib.h"
 #include "bmem.h"
 #include "buffer.h"
 #include "cassert.h"
 #include "color.h"
+#include "heap.h"
 #include "palette.h"
 #include "pixbuf.h"
+#include "pixconv.inl"
+#include "ptr.h"
 #include "strings.h"
 #include "stream.h"
 
@@ -409,7 +413,8 @@ static bool_t i_parse_gif(Stream *stm_in, Stream *stm_out, uint32_t *num_frames)
     /* GIF Blocks */
     for(;;)
     {
-        byte_t type;
+        /* Truncated stream leaves 'type' as unknown block */
+        byte_t type = 0;
         stm_read(stm_in, &type, 1);
 
         if (stm_out)
@@ -650,10 +655,12 @@ static bool_t i_parse_img(Stream *stm_in, Stream *stm_out, uint32_t *num_frames)
 
 /*---------------------------------------------------------------------------*/
 
-bool_t imgutil_parse(Stream *stm_in, Stream *stm_out)
+bool_t imgutil_parse(Stream *stm_in, Stream *stm_out, uint32_t *num_frames)
 {
-    uint32_t num_frames = 0;
-    return i_parse_img(stm_in, stm_out, &num_frames);
+    uint32_t lnum_frames = 0;
+    bool_t ok = i_parse_img(stm_in, stm_out, &lnum_frames);
+    ptr_assign(num_frames, lnum_frames);
+    return ok;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -662,13 +669,329 @@ uint32_t imgutil_num_frames(const byte_t *data, const uint32_t size)
 {
     Stream *stm = stm_from_block(data, size);
     uint32_t num_frames = 0;
-    i_parse_img(stm, NULL, &num_frames);
+
+    /* Only GIF can hold several frames, the rest are known from the header */
+    switch (i_header(stm, NULL)) {
+    case ekPNG:
+    case ekJPG:
+    case ekBMP:
+        num_frames = 1;
+        break;
+    case ekGIF:
+        i_parse_gif(stm, NULL, &num_frames);
+        break;
+    default:
+        break;
+    }
+
     stm_close(&stm);
     return num_frames;
 }
 
 /*---------------------------------------------------------------------------*/
 
+static pixformat_t i_index_bpp_format(const uint32_t bpp)
+{
+    if (bpp <= 1)
+        return ekINDEX1;
+    if (bpp == 2)
+        return ekINDEX2;
+    if (bpp <= 4)
+        return ekINDEX4;
+    return ekINDEX8;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_probe_png(Stream *stm, uint32_t *width, uint32_t *height, pixformat_t *format)
+{
+    byte_t type[4];
+    byte_t depth, ctype;
+    bool_t trns = FALSE;
+
+    stm_set_read_endian(stm, ekBIGEND);
+
+    /* IHDR is always the first chunk */
+    if (stm_read_u32(stm) != 13)
+        return FALSE;
+
+    stm_read(stm, type, 4);
+    if (str_equ_cn((const char_t*)type, "IHDR", 4) == FALSE)
+        return FALSE;
+
+    *width = stm_read_u32(stm);
+    *height = stm_read_u32(stm);
+    depth = stm_read_u8(stm);
+    ctype = stm_read_u8(stm);
+    stm_skip(stm, 3 + 4);
+
+    if (stm_state(stm) != ekSTOK)
+        return FALSE;
+
+    /* Transparency chunk (tRNS) must appear before image data */
+    if (ctype == 0 || ctype == 2 || ctype == 3)
+    {
+        while (stm_state(stm) == ekSTOK)
+        {
+            uint32_t size = stm_read_u32(stm);
+            stm_read(stm, type, 4);
+
+            if (str_equ_cn((const char_t*)type, "tRNS", 4) == TRUE)
+            {
+                trns = TRUE;
+                break;
+            }
+
+            if (str_equ_cn((const char_t*)type, "IDAT", 4) == TRUE)
+                break;
+
+            if (str_equ_cn((const char_t*)type, "IEND", 4) == TRUE)
+                break;
+
+            stm_skip(stm, size + 4);
+        }
+    }
+
+    switch (ctype) {
+    case 0:
+        *format = trns ? ekRGBA32 : ekGRAY8;
+        break;
+    case 2:
+        *format = trns ? ekRGBA32 : ekRGB24;
+        break;
+    case 3:
+        *format = i_index_bpp_format((uint32_t)depth);
+        break;
+    case 4:
+    case 6:
+        *format = ekRGBA32;
+        break;
+    default:
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_probe_jpg(Stream *stm, uint32_t *width, uint32_t *height, pixformat_t *format)
+{
+    stm_set_read_endian(stm, ekBIGEND);
+
+    /* Walk the segments until Start Of Frame */
+    while (stm_state(stm) == ekSTOK)
+    {
+        byte_t marker[2] = {0, 0};
+        stm_read(stm, marker, 2);
+
+        if (marker[0] != 0xFF)
+            return FALSE;
+
+        /* Fill bytes */
+        while (marker[1] == 0xFF && stm_state(stm) == ekSTOK)
+            stm_read(stm, marker + 1, 1);
+
+        /* Stand-alone marker */
+        if (marker[1] == 0x01 || (marker[1] >= 0xD0 && marker[1] <= 0xD7))
+            continue;
+
+        /* End Of Image or Start Of Scan before any frame */
+        if (marker[1] == 0xD9 || marker[1] == 0xDA)
+            return FALSE;
+
+        {
+            uint16_t size = stm_read_u16(stm);
+            if (size < 2)
+                return FALSE;
+
+            /* SOF0-SOF15, except DHT (C4), JPG (C8) and DAC (CC) */
+            if (marker[1] >= 0xC0 && marker[1] <= 0xCF && marker[1] != 0xC4 && marker[1] != 0xC8 && marker[1] != 0xCC)
+            {
+                byte_t ncomps;
+                stm_skip(stm, 1);
+                *height = (uint32_t)stm_read_u16(stm);
+                *width = (uint32_t)stm_read_u16(stm);
+                ncomps = stm_read_u8(stm);
+                *format = ncomps == 1 ? ekGRAY8 : ekRGB24;
+                return (bool_t)(stm_state(stm) == ekSTOK);
+            }
+
+            stm_skip(stm, (uint32_t)(size - 2));
+        }
+    }
+
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_probe_gif(Stream *stm, uint32_t *width, uint32_t *height, pixformat_t *format)
+{
+    GifDesc desc;
+    stm_set_read_endian(stm, ekLITEND);
+    i_read_gif_desc(&desc, stm);
+    *width = (uint32_t)desc.width;
+    *height = (uint32_t)desc.height;
+
+    /* Global color table size, 8 bits otherwise */
+    if (BIT_TEST(desc.flags, 7) == TRUE)
+        *format = i_index_bpp_format((uint32_t)(desc.flags & 0x07) + 1);
+    else
+        *format = ekINDEX8;
+
+    return (bool_t)(stm_state(stm) == ekSTOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_probe_bmp(Stream *stm, uint32_t *width, uint32_t *height, pixformat_t *format)
+{
+    uint32_t dibsize;
+    uint16_t bpp;
+
+    stm_set_read_endian(stm, ekLITEND);
+
+    /* File size, reserved and pixel data offset */
+    stm_skip(stm, 12);
+    dibsize = stm_read_u32(stm);
+
+    /* BITMAPCOREHEADER (OS/2) */
+    if (dibsize == 12)
+    {
+        *width = (uint32_t)stm_read_u16(stm);
+        *height = (uint32_t)stm_read_u16(stm);
+        stm_skip(stm, 2);
+        bpp = stm_read_u16(stm);
+    }
+    /* BITMAPINFOHEADER and later */
+    else if (dibsize >= 40)
+    {
+        int32_t w = stm_read_i32(stm);
+        int32_t h = stm_read_i32(stm);
+        /* Negative height means top-down rows */
+        *width = (uint32_t)(w < 0 ? -w : w);
+        *height = (uint32_t)(h < 0 ? -h : h);
+        stm_skip(stm, 2);
+        bpp = stm_read_u16(stm);
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    if (bpp <= 8)
+    {
+        *format = i_index_bpp_format((uint32_t)bpp);
+    }
+    else if (bpp == 32 && dibsize >= 56)
+    {
+        uint32_t amask;
+        /* Compression, sizes, resolution, colors and RGB masks */
+        stm_skip(stm, 4 + 4 + 8 + 8 + 12);
+        amask = stm_read_u32(stm);
+        *format = amask != 0 ? ekRGBA32 : ekRGB24;
+    }
+    else
+    {
+        *format = ekRGB24;
+    }
+
+    return (bool_t)(stm_state(stm) == ekSTOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t imgutil_probe(const byte_t *data, const uint32_t size, codec_t *codec, uint32_t *width, uint32_t *height, pixformat_t *format, uint32_t *num_frames)
+{
+    Stream *stm = NULL;
+    codec_t lcodec = ENUM_MAX(codec_t);
+    uint32_t lwidth = 0, lheight = 0;
+    pixformat_t lformat = ENUM_MAX(pixformat_t);
+    bool_t ok = FALSE;
+
+    cassert_no_null(data);
+
+    /* Avoid the 'Unknown image encoding' assert of 'i_header' */
+    if (size < 8)
+        return FALSE;
+
+    if (data[0] != 0x89 && data[0] != 0xFF && data[0] != 'G' && data[0] != 'B' && data[0] != 'C' && data[0] != 'I' && data[0] != 'P')
+        return FALSE;
+
+    /* BMP arrays ('BA') have no single image header */
+    if (data[0] == 'B' && data[1] == 'A')
+        return FALSE;
+
+    stm = stm_from_block(data, size);
+    lcodec = i_header(stm, NULL);
+
+    switch (lcodec) {
+    case ekPNG:
+        ok = i_probe_png(stm, &lwidth, &lheight, &lformat);
+        break;
+    case ekJPG:
+        ok = i_probe_jpg(stm, &lwidth, &lheight, &lformat);
+        break;
+    case ekGIF:
+        ok = i_probe_gif(stm, &lwidth, &lheight, &lformat);
+        break;
+    case ekBMP:
+        ok = i_probe_bmp(stm, &lwidth, &lheight, &lformat);
+        break;
+    default:
+        break;
+    }
+
+    stm_close(&stm);
+
+    if (ok == TRUE)
+    {
+        ptr_assign(codec, lcodec);
+        ptr_assign(width, lwidth);
+        ptr_assign(height, lheight);
+        ptr_assign(format, lformat);
+
+        /* Only GIF walks the stream, just when frames are requested */
+        if (num_frames != NULL)
+            *num_frames = imgutil_num_frames(data, size);
+    }
+
+    return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void imgutil_fit(const uint32_t width, const uint32_t height, const uint32_t max_width, const uint32_t max_height, uint32_t *nwidth, uint32_t *nheight)
+{
+    cassert_no_null(nwidth);
+    cassert_no_null(nheight);
+    if (width <= max_width && height <= max_height)
+    {
+        *nwidth = width;
+        *nheight = height;
+    }
+    /* Width is the limiting side */
+    else if ((uint64_t)width * (uint64_t)max_height > (uint64_t)height * (uint64_t)max_width)
+    {
+        *nwidth = max_width;
+        *nheight = (uint32_t)(((uint64_t)height * (uint64_t)max_width + width / 2) / width);
+    }
+    else
+    {
+        *nwidth = (uint32_t)(((uint64_t)width * (uint64_t)max_height + height / 2) / height);
+        *nheight = max_height;
+    }
+
+    if (*nwidth == 0)
+        *nwidth = 1;
+
+    if (*nheight == 0)
+        *nheight = 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
 Palette *imgutil_def_palette(const pixformat_t format)
 {
     switch(format) {
@@ -698,16 +1021,8 @@ Palette *imgutil_def_palette(const pixformat_t format)
 
 Pixbuf *imgutil_rgba_to_rgb(const byte_t *data, const uint32_t width, const uint32_t height)
 {
-    register uint32_t i, n = width * height;
     Pixbuf *pixbuf = pixbuf_create(width, height, ekRGB24);
-    byte_t *dest = pixbuf_data(pixbuf);
-    for (i = 0; i < n; ++i, data += 4, dest += 3)
-    {
-        dest[0] = data[0];
-        dest[1] = data[1];
-        dest[2] = data[2];
-    }
-
+    pixconv_rgba_to_rgb(data, pixbuf_data(pixbuf), width * height);
     return pixbuf;
 }
 
@@ -715,17 +1030,8 @@ Pixbuf *imgutil_rgba_to_rgb(const byte_t *data, const uint32_t width, const uint
 
 Pixbuf *imgutil_rgb_to_rgba(const byte_t *data, const uint32_t width, const uint32_t height)
 {
-    register uint32_t i, n = width * height;
     Pixbuf *pixbuf = pixbuf_create(width, height, ekRGBA32);
-    byte_t *dest = pixbuf_data(pixbuf);
-    for (i = 0; i < n; ++i, data += 3, dest += 4)
-    {
-        dest[0] = data[0];
-        dest[1] = data[1];
-        dest[2] = data[2];
-        dest[3] = 255;
-    }
-
+    pixconv_rgb_to_rgba(data, pixbuf_data(pixbuf), width * height);
     return pixbuf;
 }
 
@@ -733,11 +1039,8 @@ Pixbuf *imgutil_rgb_to_rgba(const byte_t *data, const uint32_t width, const uint
 
 Pixbuf *imgutil_rgba_to_gray(const byte_t *data, const uint32_t width, const uint32_t height)
 {
-    register uint32_t i, n = width * height;
     Pixbuf *pixbuf = pixbuf_create(width, height, ekGRAY8);
-    byte_t *dest = pixbuf_data(pixbuf);
-    for (i = 0; i < n; ++i, data += 4, dest += 1)
-        *dest = (byte_t)((77 * (uint32_t)data[0] + 148 * (uint32_t)data[1] + 30 * (uint32_t)data[2]) / 255);
+    pixconv_rgba_to_gray(data, pixbuf_data(pixbuf), width * height);
     return pixbuf;
 }
 
@@ -745,11 +1048,8 @@ Pixbuf *imgutil_rgba_to_gray(const byte_t *data, const uint32_t width, const uin
 
 Pixbuf *imgutil_rgb_to_gray(const byte_t *data, const uint32_t width, const uint32_t height)
 {
-    register uint32_t i, n = width * height;
     Pixbuf *pixbuf = pixbuf_create(width, height, ekGRAY8);
-    byte_t *dest = pixbuf_data(pixbuf);
-    for (i = 0; i < n; ++i, data += 3, dest += 1)
-        *dest = (byte_t)((77 * (uint32_t)data[0] + 148 * (uint32_t)data[1] + 30 * (uint32_t)data[2]) / 255);
+    pixconv_rgb_to_gray(data, pixbuf_data(pixbuf), width * height);
     return pixbuf;
 }
 
@@ -757,17 +1057,8 @@ Pixbuf *imgutil_rgb_to_gray(const byte_t *data, const uint32_t width, const uint
 
 Buffer *imgutil_gray_to_rgba(const byte_t *data, const uint32_t width, const uint32_t height)
 {
-    register uint32_t i, n = width * height;
-    Buffer *buffer = buffer_create(n * 4);
-    byte_t *dest = buffer_data(buffer);
-    for (i = 0; i < n; ++i, data += 1, dest += 4)
-    {
-        dest[0] = data[0];
-        dest[1] = data[0];
-        dest[2] = data[0];
-        dest[3] = 255;
-    }
-
+    Buffer *buffer = buffer_create(width * height * 4);
+    pixconv_gray_to_rgba(data, buffer_data(buffer), width * height);
     return buffer;
 }
 
@@ -775,16 +1066,8 @@ Buffer *imgutil_gray_to_rgba(const byte_t *data, const uint32_t width, const uin
 
 Buffer *imgutil_gray_to_rgb(const byte_t *data, const uint32_t width, const uint32_t height)
 {
-    register uint32_t i, n = width * height;
-    Buffer *buffer = buffer_create(n * 3);
-    byte_t *dest = buffer_data(buffer);
-    for (i = 0; i < n; ++i, data += 1, dest += 3)
-    {
-        dest[0] = data[0];
-        dest[1] = data[0];
-        dest[2] = data[0];
-    }
-
+    Buffer *buffer = buffer_create(width * height * 3);
+    pixconv_gray_to_rgb(data, buffer_data(buffer), width * height);
     return buffer;
 }
 
@@ -823,14 +1106,6 @@ Pixbuf *imgutil_indexed_to_gray(const uint32_t width, const uint32_t height, con
 {
     Pixbuf *buffer = NULL;
     byte_t *data = NULL;
-    register byte_t ibyte;
-    register byte_t ipos;
-    register byte_t value;
-    register color_t c;
-
-    /* mask = 1, 3, 15, 255 */
-    register byte_t imask = (byte_t)(1 << ibpp) - 1;
-    register uint32_t j, i;
 
     cassert(ibpp == 1 || ibpp == 2 || ibpp == 4 || ibpp == 8);
     cassert_no_null(palette);
@@ -838,48 +1113,19 @@ Pixbuf *imgutil_indexed_to_gray(const uint32_t width, const uint32_t height, con
     buffer = pixbuf_create(width, height, ekGRAY8);
     data = pixbuf_data(buffer);
 
+    /* Packed pixels, low bits first */
     if (stride == 0)
     {
-        uint32_t n = width * height;
-
-        for (i = 0; i < n; ++i)
-        {
-            /* 1) Get the pixel value */
-            ibyte = pixdata[i / (8 / ibpp)];
-            ipos = (byte_t)(i % (8 / ibpp));
-            value = (byte_t)((ibyte & (imask << (ipos * ibpp))) >> (ipos * ibpp));
-            c = palette[value];
-
-            /* Its a gray palette */
-            cassert((byte_t)c == (byte_t)(c >> 8));
-            cassert((byte_t)c == (byte_t)(c >> 16));
-
-            /* 2) Write the pixel value */
-            *data = (byte_t)c;
-            data += 1;
-        }
+        pixconv_index_to_gray(pixdata, data, width * height, ibpp, FALSE, palette);
     }
+    /* Row by row, high bits first */
     else
     {
+        register uint32_t j;
         for (j = 0; j < height; ++j)
         {
-            for (i = 0; i < width; ++i)
-            {
-                /* 1) Get the pixel value */
-                ibyte = pixdata[i / (8 / ibpp)];
-                ipos = (byte_t)((8 / (uint8_t)ibpp) - 1 - (i % (8 / (uint8_t)ibpp)));
-                value = (byte_t)((ibyte & (imask << (ipos * ibpp))) >> (ipos * ibpp));
-                c = palette[value];
-
-                /* Its a gray palette */
-                cassert((byte_t)c == (byte_t)(c >> 8));
-                cassert((byte_t)c == (byte_t)(c >> 16));
-
-                /* 2) Write the pixel value */
-                *data = (byte_t)c;
-                data += 1;
-            }
-
+            pixconv_index_to_gray(pixdata, data, width, ibpp, TRUE, palette);
+            data += width;
             pixdata += stride;
         }
     }
@@ -928,56 +1174,27 @@ static Pixbuf *i_index_to_rgba(const byte_t *data, const uint32_t width, const u
 Pixbuf *imgutil_indexed_to_rgba(const uint32_t width, const uint32_t height, const byte_t *pixdata, const uint32_t stride, const uint32_t ibpp, const color_t *palette)
 {
     Pixbuf *buffer = NULL;
-    uint32_t *data = NULL;
-    register byte_t ibyte;
-    register byte_t ipos;
-    register byte_t value;
-    register color_t c;
-
-    /* mask = 1, 3, 15, 255 */
-    register byte_t imask = (byte_t)(1 << ibpp) - 1;
-    register uint32_t j, i;
+    byte_t *data = NULL;
 
     cassert(ibpp == 1 || ibpp == 2 || ibpp == 4 || ibpp == 8);
     cassert_no_null(palette);
 
     buffer = pixbuf_create(width, height, ekRGBA32);
-    data = (uint32_t*)pixbuf_data(buffer);
+    data = pixbuf_data(buffer);
 
+    /* Packed pixels, low bits first */
     if (stride == 0)
     {
-        uint32_t n = width * height;
-
-        for (i = 0; i < n; ++i)
-        {
-            /* 1) Get the pixel value */
-            ibyte = pixdata[i / (8 / ibpp)];
-            ipos = (byte_t)(i % (8 / ibpp));
-            value = (byte_t)((ibyte & (imask << (ipos * ibpp))) >> (ipos * ibpp));
-            c = palette[value];
-
-            /* 2) Write the pixel value */
-            *data = (uint32_t)c;
-            data += 1;
-        }
+        pixconv_index_to_rgba(pixdata, data, width * height, ibpp, FALSE, palette);
     }
+    /* Row by row, high bits first */
     else
     {
+        register uint32_t j;
         for (j = 0; j < height; ++j)
         {
-            for (i = 0; i < width; ++i)
-            {
-                /* 1) Get the pixel value */
-                ibyte = pixdata[i / (8 / ibpp)];
-                ipos = (byte_t)((8 / (uint8_t)ibpp) - 1 - (i % (8 / (uint8_t)ibpp)));
-                value = (byte_t)((ibyte & (imask << (ipos * ibpp))) >> (ipos * ibpp));
-                c = palette[value];
-
-                /* 2) Write the pixel value */
-                *data = (uint32_t)c;
-                data += 1;
-            }
-
+            pixconv_index_to_rgba(pixdata, data, width, ibpp, TRUE, palette);
+            data += width * 4;
             pixdata += stride;
         }
     }
@@ -1030,14 +1247,6 @@ Pixbuf *imgutil_indexed_to_rgb(const uint32_t width, const uint32_t height, cons
 {
     Pixbuf *buffer = NULL;
     byte_t *data = NULL;
-    register byte_t ibyte;
-    register byte_t ipos;
-    register byte_t value;
-    register color_t c;
-
-    /* mask = 1, 3, 15, 255 */
-    register byte_t imask = (byte_t)(1 << ibpp) - 1;
-    register uint32_t j, i;
 
     cassert(ibpp == 1 || ibpp == 2 || ibpp == 4 || ibpp == 8);
     cassert_no_null(palette);
@@ -1045,44 +1254,19 @@ Pixbuf *imgutil_indexed_to_rgb(const uint32_t width, const uint32_t height, cons
     buffer = pixbuf_create(width, height, ekRGB24);
     data = pixbuf_data(buffer);
 
+    /* Packed pixels, low bits first */
     if (stride == 0)
     {
-        uint32_t n = width * height;
-
-        for (i = 0; i < n; ++i)
-        {
-            /* 1) Get the pixel value */
-            ibyte = pixdata[i / (8 / ibpp)];
-            ipos = (byte_t)(i % (8 / ibpp));
-            value = (byte_t)((ibyte & (imask << (ipos * ibpp))) >> (ipos * ibpp));
-            c = palette[value];
-
-            /* 2) Write the pixel value */
-            data[0] = (byte_t)c;
-            data[1] = (byte_t)(c >> 8);
-            data[2] = (byte_t)(c >> 16);
-            data += 3;
-        }
+        pixconv_index_to_rgb(pixdata, data, width * height, ibpp, FALSE, palette);
     }
+    /* Row by row, high bits first */
     else
     {
+        register uint32_t j;
         for (j = 0; j < height; ++j)
         {
-            for (i = 0; i < width; ++i)
-            {
-                /* 1) Get the pixel value */
-                ibyte = pixdata[i / (8 / ibpp)];
-                ipos = (byte_t)((8 / (uint8_t)ibpp) - 1 - (i % (8 / (uint8_t)ibpp)));
-                value = (byte_t)((ibyte & (imask << (ipos * ibpp))) >> (ipos * ibpp));
-                c = palette[value];
-
-                /* 2) Write the pixel value */
-                data[0] = (byte_t)c;
-                data[1] = (byte_t)(c >> 8);
-                data[2] = (byte_t)(c >> 16);
-                data += 3;
-            }
-
+            pixconv_index_to_rgb(pixdata, data, width, ibpp, TRUE, palette);
+            data += width * 3;
             pixdata += stride;
         }
     }
@@ -1190,125 +1374,494 @@ static __INLINE bool_t i_is_gray_palette(const color_t *palette, const uint32_t
 /*---------------------------------------------------------------------------*/
 
 #define i_color(r, g, b, a)\
-    (color_t)(((a) << 24) | ((b) << 16) | ((g) << 8) | (r))
+    (color_t)(((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(r))
+
+#define i_TABLE_BITS    10
+#define i_TABLE_SIZE    (1 << i_TABLE_BITS)
+#define i_TABLE_MASK    (i_TABLE_SIZE - 1)
+
+/* Quantization bins: 5 bits per RGB channel, 3 bits for alpha */
+#define i_QKEYS         (1 << 18)
+#define i_QCOLORS       256
+
+typedef struct _ctable_t i_ColorTable;
+typedef struct _qcolor_t i_QColor;
+typedef struct _qbox_t i_QBox;
+
+/* Open addressed color --> palette index (+1) table. 0 = empty slot */
+struct _ctable_t
+{
+    color_t color[i_TABLE_SIZE];
+    uint16_t index[i_TABLE_SIZE];
+};
+
+struct _qcolor_t
+{
+    byte_t c[4];
+    uint32_t key;
+    uint32_t count;
+};
+
+struct _qbox_t
+{
+    uint32_t first;
+    uint32_t size;
+    uint32_t count;
+    uint32_t channel;
+    uint32_t range;
+};
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE color_t i_pixel(const byte_t *pixdata, const uint32_t bytespp)
+{
+    if (bytespp == 3)
+        return i_color(pixdata[0], pixdata[1], pixdata[2], 255);
+    else
+        return i_color(pixdata[0], pixdata[1], pixdata[2], pixdata[3]);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Returns the slot of 'color' or the empty slot where it has to be inserted */
+static __INLINE uint32_t i_table_slot(const i_ColorTable *table, const color_t color)
+{
+    register uint32_t slot = (uint32_t)(color * 2654435761u) >> (32 - i_TABLE_BITS);
+
+    while (table->index[slot] != 0 && table->color[slot] != color)
+        slot = (slot + 1) & i_TABLE_MASK;
+
+    return slot;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static pixformat_t i_index_format(const uint32_t ncolors, uint32_t *bpp)
+{
+    cassert_no_null(bpp);
+    cassert(ncolors <= 256);
+
+    if (ncolors <= 2)
+    {
+        *bpp = 1;
+        return ekINDEX1;
+    }
+    else if (ncolors <= 4)
+    {
+        *bpp = 2;
+        return ekINDEX2;
+    }
+    else if (ncolors <= 16)
+    {
+        *bpp = 4;
+        return ekINDEX4;
+    }
+    else
+    {
+        *bpp = 8;
+        return ekINDEX8;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE void i_set_index(byte_t *destdata, const uint32_t i, const uint32_t bpp, const uint32_t index)
+{
+    /* Write the pixel value leaving intact the other bits */
+    register uint32_t ppb = 8 / bpp;
+    register byte_t *obyte = destdata + i / ppb;
+    register uint32_t shift = (i % ppb) * bpp;
+    *obyte &= (byte_t)~(((1u << bpp) - 1) << shift);
+    *obyte |= (byte_t)(index << shift);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_palette(const color_t *palrgb, const uint32_t pn, Palette **palette)
+{
+    if (palette != NULL)
+    {
+        *palette = palette_create(pn);
+        bmem_copy_n(palette_colors(*palette), palrgb, pn, color_t);
+    }
+}
 
 /*---------------------------------------------------------------------------*/
 
-static Pixbuf *i_rgb_to_indexed(const byte_t *pixdata, const uint32_t width, const uint32_t height, const uint32_t bytespp, const color_t *palrgb, const uint32_t pn, Palette **palette)
+static Pixbuf *i_rgb_to_indexed(const byte_t *pixdata, const uint32_t width, const uint32_t height, const uint32_t bytespp, const color_t *palrgb, const uint32_t pn, const i_ColorTable *table, Palette **palette)
 {
     uint32_t bpp = 0;
-    pixformat_t format = ENUM_MAX(pixformat_t);
-    Pixbuf *pixels = NULL;
+    pixformat_t format = i_index_format(pn, &bpp);
+    Pixbuf *pixels = pixbuf_create(width, height, format);
     register uint32_t n = width * height;
-    register byte_t omask = 0;
-    register byte_t *destdata = NULL;
-    register uint32_t i, j;
+    register byte_t *destdata = pixbuf_data(pixels);
+    register color_t last = pn > 0 ? palrgb[0] : 0;
+    register uint32_t lindex = 0;
+    register uint32_t i;
 
     cassert(pn <= 256);
+    cassert_no_null(table);
 
-    if (pn <= 2)
+    for (i = 0; i < n; ++i)
     {
-        format = ekINDEX1;
-        bpp = 1;
+        register color_t c = i_pixel(pixdata, bytespp);
+
+        /* Consecutive pixels usually share color */
+        if (c != last)
+        {
+            register uint32_t slot = i_table_slot(table, c);
+            /* RGB must exists in palette */
+            cassert(table->index[slot] != 0);
+            lindex = (uint32_t)table->index[slot] - 1;
+            last = c;
+        }
+
+        i_set_index(destdata, i, bpp, lindex);
+        pixdata += bytespp;
     }
-    else if (pn <= 4)
+
+    i_palette(palrgb, pn, palette);
+    return pixels;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint32_t i_qkey(const byte_t *pixdata, const uint32_t bytespp)
+{
+    register uint32_t a = bytespp == 3 ? 255 : (uint32_t)pixdata[3];
+    return ((uint32_t)(pixdata[0] >> 3) << 13) | ((uint32_t)(pixdata[1] >> 3) << 8) | ((uint32_t)(pixdata[2] >> 3) << 3) | (a >> 5);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Center of the bin, expanding the channel bits to [0, 255] */
+static void i_qcolor(const uint32_t key, byte_t *c)
+{
+    register uint32_t r = (key >> 13) & 31;
+    register uint32_t g = (key >> 8) & 31;
+    register uint32_t b = (key >> 3) & 31;
+    register uint32_t a = key & 7;
+    c[0] = (byte_t)((r << 3) | (r >> 2));
+    c[1] = (byte_t)((g << 3) | (g >> 2));
+    c[2] = (byte_t)((b << 3) | (b >> 2));
+    c[3] = (byte_t)((a << 5) | (a << 2) | (a >> 1));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_box_bounds(const i_QColor *colors, i_QBox *box)
+{
+    byte_t cmin[4] = {255, 255, 255, 255};
+    byte_t cmax[4] = {0, 0, 0, 0};
+    register uint32_t i, k;
+
+    box->count = 0;
+    for (i = box->first; i < box->first + box->size; ++i)
     {
-        format = ekINDEX2;
-        bpp = 2;
+        for (k = 0; k < 4; ++k)
+        {
+            if (colors[i].c[k] < cmin[k])
+                cmin[k] = colors[i].c[k];
+            if (colors[i].c[k] > cmax[k])
+                cmax[k] = colors[i].c[k];
+        }
+
+        box->count += colors[i].count;
     }
-    else if (pn <= 16)
+
+    box->channel = 0;
+    box->range = 0;
+    for (k = 0; k < 4; ++k)
     {
-        format = ekINDEX4;
-        bpp = 4;
+        if ((uint32_t)(cmax[k] - cmin[k]) > box->range)
+        {
+            box->channel = k;
+            box->range = (uint32_t)(cmax[k] - cmin[k]);
+        }
     }
-    else
+}
+
+/*---------------------------------------------------------------------------*/
+
+static int i_cmp_channel(const i_QColor *c1, const i_QColor *c2, const uint32_t *channel)
+{
+    return (int)c1->c[*channel] - (int)c2->c[*channel];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Splits the box at the population median of its widest channel */
+static void i_box_split(i_QColor *colors, i_QBox *box, i_QBox *nbox)
+{
+    register uint32_t i, acc = 0;
+
+    cassert(box->size > 1);
+    blib_qsort_ex((const byte_t*)(colors + box->first), box->size, sizeof(i_QColor), (FPtr_compare_ex)i_cmp_channel, (const byte_t*)&box->channel);
+
+    for (i = 0; i < box->size - 1; ++i)
     {
-        format = ekINDEX8;
-        bpp = 8;
+        acc += colors[box->first + i].count;
+        if (acc >= box->count / 2)
+            break;
     }
 
-    omask = (byte_t)(1 << bpp) - 1;
-    pixels = pixbuf_create(width, height, format);
-    destdata = pixbuf_data(pixels);
+    nbox->first = box->first + i + 1;
+    nbox->size = box->size - i - 1;
+    box->size = i + 1;
+    i_box_bounds(colors, box);
+    i_box_bounds(colors, nbox);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static color_t i_box_color(const i_QColor *colors, const i_QBox *box)
+{
+    uint64_t sum[4] = {0, 0, 0, 0};
+    uint64_t half = box->count / 2;
+    register uint32_t i, k;
+
+    for (i = box->first; i < box->first + box->size; ++i)
+    {
+        for (k = 0; k < 4; ++k)
+            sum[k] += (uint64_t)colors[i].c[k] * colors[i].count;
+    }
+
+    return i_color((uint32_t)((sum[0] + half) / box->count), (uint32_t)((sum[1] + half) / box->count), (uint32_t)((sum[2] + half) / box->count), (uint32_t)((sum[3] + half) / box->count));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_nearest(const color_t *palrgb, const uint32_t pn, const uint32_t key)
+{
+    byte_t c[4];
+    uint32_t best = 0, bdist = UINT32_MAX;
+    register uint32_t i;
+
+    i_qcolor(key, c);
+    for (i = 0; i < pn; ++i)
+    {
+        register int32_t dr = (int32_t)(palrgb[i] & 0xFF) - c[0];
+        register int32_t dg = (int32_t)((palrgb[i] >> 8) & 0xFF) - c[1];
+        register int32_t db = (int32_t)((palrgb[i] >> 16) & 0xFF) - c[2];
+        register int32_t da = (int32_t)(palrgb[i] >> 24) - c[3];
+        register uint32_t dist = (uint32_t)(dr * dr + dg * dg + db * db + da * da);
+        if (dist < bdist)
+        {
+            best = i;
+            bdist = dist;
+        }
+    }
+
+    return best;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE byte_t i_clamp(const int32_t v)
+{
+    if (v < 0)
+        return 0;
+    if (v > 255)
+        return 255;
+    return (byte_t)v;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Floyd-Steinberg error diffusion over RGB. Alpha is not dithered */
+static void i_dither(const byte_t *pixdata, const uint32_t width, const uint32_t height, const uint32_t bytespp, const color_t *palrgb, const uint32_t pn, const uint32_t bpp, byte_t *destdata)
+{
+    uint32_t rsize = (width + 2) * 3;
+    uint16_t *nearest = heap_new_n0(i_QKEYS, uint16_t);
+    int32_t *error = heap_new_n0(2 * rsize, int32_t);
+    register uint32_t i, j, k, p = 0;
+
+    for (j = 0; j < height; ++j)
+    {
+        /* Rows with one guard pixel at each side */
+        int32_t *cerr = error + (j % 2) * rsize + 3;
+        int32_t *nerr = error + ((j + 1) % 2) * rsize + 3;
+        bmem_zero_n(nerr - 3, rsize, int32_t);
+
+        for (i = 0; i < width; ++i, ++p)
+        {
+            byte_t v[4];
+            uint32_t key, index;
+            color_t c;
+
+            for (k = 0; k < 3; ++k)
+                v[k] = i_clamp((int32_t)pixdata[k] + cerr[i * 3 + k] / 16);
+
+            v[3] = bytespp == 3 ? 255 : pixdata[3];
+            key = i_qkey(v, 4);
+            if (nearest[key] == 0)
+                nearest[key] = (uint16_t)(i_nearest(palrgb, pn, key) + 1);
+
+            index = (uint32_t)nearest[key] - 1;
+            i_set_index(destdata, p, bpp, index);
+            c = palrgb[index];
+
+            for (k = 0; k < 3; ++k)
+            {
+                int32_t e = (int32_t)v[k] - (int32_t)((c >> (k * 8)) & 0xFF);
+                int32_t *ce = cerr + i * 3 + k;
+                int32_t *ne = nerr + i * 3 + k;
+                ce[3] += e * 7;
+                ne[-3] += e * 3;
+                ne[0] += e * 5;
+                ne[3] += e;
+            }
+
+            pixdata += bytespp;
+        }
+    }
+
+    heap_delete_n(&error, 2 * rsize, int32_t);
+    heap_delete_n(&nearest, i_QKEYS, uint16_t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Median cut quantization over a 5:5:5:3 color histogram */
+static Pixbuf *i_quantize(const byte_t *pixdata, const uint32_t width, const uint32_t height, const uint32_t bytespp, const bool_t dither, Palette **palette)
+{
+    uint32_t *bins = heap_new_n0(i_QKEYS, uint32_t);
+    i_QColor *colors = NULL;
+    i_QBox boxes[i_QCOLORS];
+    color_t pal[i_QCOLORS];
+    uint32_t ncolors = 0, nboxes = 1, bpp = 0;
+    pixformat_t format = ENUM_MAX(pixformat_t);
+    Pixbuf *pixels = NULL;
+    byte_t *destdata = NULL;
+    register const byte_t *datai = pixdata;
+    register uint32_t i, j, n = width * height;
 
     for (i = 0; i < n; ++i)
     {
-        register color_t c;
+        bins[i_qkey(datai, bytespp)] += 1;
+        datai += bytespp;
+    }
 
-        if (bytespp == 3)
-            c = i_color(pixdata[0], pixdata[1], pixdata[2], 255);
-        else
-            c = i_color(pixdata[0], pixdata[1], pixdata[2], pixdata[3]);
+    for (i = 0; i < i_QKEYS; ++i)
+    {
+        if (bins[i] > 0)
+            ncolors += 1;
+    }
+
+    cassert(ncolors > 0);
+    colors = heap_new_n(ncolors, i_QColor);
+    ncolors = 0;
+    for (i = 0; i < i_QKEYS; ++i)
+    {
+        if (bins[i] > 0)
+        {
+            i_qcolor(i, colors[ncolors].c);
+            colors[ncolors].key = i;
+            colors[ncolors].count = bins[i];
+            ncolors += 1;
+        }
+    }
+
+    boxes[0].first = 0;
+    boxes[0].size = ncolors;
+    i_box_bounds(colors, &boxes[0]);
+
+    /* Split the box with the biggest error estimation: range * population */
+    while (nboxes < i_QCOLORS)
+    {
+        uint32_t best = UINT32_MAX;
+        uint64_t bscore = 0;
 
-        for (j = 0; j < pn; ++j)
+        for (i = 0; i < nboxes; ++i)
         {
-            if (palrgb[j] == c)
+            if (boxes[i].size > 1)
             {
-                /* Write the pixel value leaving intact the other bits */
-                register byte_t *obyte = destdata + i / (8 / bpp);
-                register byte_t opos = (byte_t)(i % (8 / (uint8_t)bpp));
-                *obyte &= ~(omask << (opos * bpp));
-                *obyte |= (j << (opos * bpp));
-                break;
+                uint64_t score = (uint64_t)boxes[i].range * boxes[i].count;
+                if (best == UINT32_MAX || score > bscore)
+                {
+                    best = i;
+                    bscore = score;
+                }
             }
         }
 
-        /* RGB must exists in palette */
-        cassert(j < pn);
-        pixdata += bytespp;
+        if (best == UINT32_MAX)
+            break;
+
+        i_box_split(colors, &boxes[best], &boxes[nboxes]);
+        nboxes += 1;
     }
 
-    if (palette != NULL)
+    /* Histogram becomes the bin --> palette index map */
+    for (i = 0; i < nboxes; ++i)
     {
-        *palette = palette_create(pn);
-        bmem_copy_n(palette_colors(*palette), palrgb, pn, color_t);
+        pal[i] = i_box_color(colors, &boxes[i]);
+        for (j = boxes[i].first; j < boxes[i].first + boxes[i].size; ++j)
+            bins[colors[j].key] = i;
+    }
+
+    format = i_index_format(nboxes, &bpp);
+    pixels = pixbuf_create(width, height, format);
+    destdata = pixbuf_data(pixels);
+
+    if (dither == TRUE)
+    {
+        i_dither(pixdata, width, height, bytespp, pal, nboxes, bpp, destdata);
+    }
+    else
+    {
+        datai = pixdata;
+        for (i = 0; i < n; ++i)
+        {
+            i_set_index(destdata, i, bpp, bins[i_qkey(datai, bytespp)]);
+            datai += bytespp;
+        }
     }
 
+    i_palette(pal, nboxes, palette);
+    heap_delete_n(&colors, ncolors, i_QColor);
+    heap_delete_n(&bins, i_QKEYS, uint32_t);
     return pixels;
 }
 
 /*---------------------------------------------------------------------------*/
 
-Pixbuf *imgutil_to_indexed(const uint32_t width, const uint32_t height, const byte_t *pixdata, const uint32_t bytespp, Palette **palette)
+Pixbuf *imgutil_to_indexed(const uint32_t width, const uint32_t height, const byte_t *pixdata, const uint32_t bytespp, const bool_t dither, Palette **palette)
 {
     register uint32_t i, n = width * height;
-    register uint32_t j, pn = 0;
+    register uint32_t pn = 0;
     register const byte_t *datai = pixdata;
+    register color_t last = 0;
     color_t pal[256];
+    i_ColorTable table;
+
+    bmem_zero_n(table.index, i_TABLE_SIZE, uint16_t);
 
     for (i = 0; i < n; ++i)
     {
-        register color_t c;
+        register color_t c = i_pixel(datai, bytespp);
 
-        if (bytespp == 3)
-            c = i_color(datai[0], datai[1], datai[2], 255);
-        else
-            c = i_color(datai[0], datai[1], datai[2], datai[3]);
-
-        for (j = 0; j < pn; ++j)
+        if (pn == 0 || c != last)
         {
-            if (pal[j] == c)
-                break;
-        }
+            register uint32_t slot = i_table_slot(&table, c);
 
-        if (j == pn)
-        {
-            if (pn < 256)
+            if (table.index[slot] == 0)
             {
+                /* More than 256 colors */
+                if (pn == 256)
+                    return i_quantize(pixdata, width, height, bytespp, dither, palette);
+
+                table.color[slot] = c;
+                table.index[slot] = (uint16_t)(pn + 1);
                 pal[pn] = c;
                 pn += 1;
             }
-            else
-            {
-                if (palette != NULL)
-                    *palette = NULL;
 
-                return NULL;
-            }
+            last = c;
         }
 
         datai += bytespp;
     }
 
-    return i_rgb_to_indexed(pixdata, width, height, bytespp, pal, pn, palette);
+    return i_rgb_to_indexed(pixdata, width, height, bytespp, pal, pn, &table, palette);
 }
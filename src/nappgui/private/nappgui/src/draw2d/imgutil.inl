@@ -14,10 +14,14 @@
 
 __EXTERN_C
 
-bool_t imgutil_parse(Stream *stm_in, Stream *stm_out);
+bool_t imgutil_parse(Stream *stm_in, Stream *stm_out, uint32_t *num_frames);
 
 uint32_t imgutil_num_frames(const byte_t *data, const uint32_t size);
 
+bool_t imgutil_probe(const byte_t *data, const uint32_t size, codec_t *codec, uint32_t *width, uint32_t *height, pixformat_t *format, uint32_t *num_frames);
+
+void imgutil_fit(const uint32_t width, const uint32_t height, const uint32_t max_width, const uint32_t max_height, uint32_t *nwidth, uint32_t *nheight);
+
 Palette *imgutil_def_palette(const pixformat_t format);
 
 Pixbuf *imgutil_rgba_to_rgb(const byte_t *data, const uint32_t width, const uint32_t height);
@@ -42,6 +46,6 @@ uint32_t imgutil_effective_palette(const uint32_t *ipalette, const uint32_t isiz
 
 Pixbuf *imgutil_indexed_to_indexed(const uint32_t width, const uint32_t height, const byte_t *pixdata, const uint32_t stride, const uint32_t ibpp, const pixformat_t oformat, const uint8_t *palette_index);
 
-Pixbuf *imgutil_to_indexed(const uint32_t width, const uint32_t height, const byte_t *pixdata, const uint32_t bytespp, Palette **palette);
+Pixbuf *imgutil_to_indexed(const uint32_t width, const uint32_t height, const byte_t *pixdata, const uint32_t bytespp, const bool_t dither, Palette **palette);
 
 __END_C
@@ -12,9 +12,11 @@
 
 #include "nowarn.hxx"
 #include <Cocoa/Cocoa.h>
+#include <ImageIO/ImageIO.h>
 #include "warn.hxx"
 
 #include "image.inl"
+#include "imgutil.inl"
 #include "dctxh.h"
 #include "bmem.h"
 #include "buffer.h"
@@ -116,10 +118,11 @@ OSImage *osimage_create_from_pixels(const uint32_t width, const uint32_t height,
 
 /*---------------------------------------------------------------------------*/
 
-OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size_in_bytes)
+OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size_in_bytes, const uint32_t num_frames)
 {
     NSData *ldata = NULL;
     NSImage *image = NULL;
+    unref(num_frames);
     ldata = [NSData dataWithBytes/*NoCopy*/:(void*)data length:(NSUInteger)size_in_bytes];
     cassert_no_null(ldata);
     image = [[NSImage alloc] initWithData:ldata];
@@ -140,6 +143,61 @@ OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size_in_byt
 
 /*---------------------------------------------------------------------------*/
 
+OSImage *osimage_create_from_data_scaled(const byte_t *data, const uint32_t size_in_bytes, const uint32_t max_width, const uint32_t max_height)
+{
+    CFDataRef cfdata = CFDataCreateWithBytesNoCopy(kCFAllocatorDefault, (const UInt8*)data, (CFIndex)size_in_bytes, kCFAllocatorNull);
+    CGImageSourceRef source = CGImageSourceCreateWithData(cfdata, NULL);
+    CGImageRef cgimage = NULL;
+
+    if (source != NULL)
+    {
+        /* Pixel size from image header, without decoding */
+        CFDictionaryRef props = CGImageSourceCopyPropertiesAtIndex(source, 0, NULL);
+        if (props != NULL)
+        {
+            NSNumber *width = (NSNumber*)CFDictionaryGetValue(props, kCGImagePropertyPixelWidth);
+            NSNumber *height = (NSNumber*)CFDictionaryGetValue(props, kCGImagePropertyPixelHeight);
+            if (width != nil && height != nil)
+            {
+                uint32_t nwidth, nheight;
+                imgutil_fit((uint32_t)[width unsignedIntValue], (uint32_t)[height unsignedIntValue], max_width, max_height, &nwidth, &nheight);
+
+                /* ImageIO decodes JPEG at reduced size (DCT scaling) when building the thumbnail */
+                if (nwidth != (uint32_t)[width unsignedIntValue] || nheight != (uint32_t)[height unsignedIntValue])
+                {
+                    uint32_t max_size = nwidth > nheight ? nwidth : nheight;
+                    NSDictionary *options = [NSDictionary dictionaryWithObjectsAndKeys:
+                                                (id)kCFBooleanTrue, (id)kCGImageSourceCreateThumbnailFromImageAlways,
+                                                [NSNumber numberWithUnsignedInt:max_size], (id)kCGImageSourceThumbnailMaxPixelSize,
+                                                nil];
+                    cgimage = CGImageSourceCreateThumbnailAtIndex(source, 0, (CFDictionaryRef)options);
+                }
+            }
+
+            CFRelease(props);
+        }
+
+        CFRelease(source);
+    }
+
+    CFRelease(cfdata);
+
+    if (cgimage != NULL)
+    {
+        NSBitmapImageRep *bitmap = [[NSBitmapImageRep alloc] initWithCGImage:cgimage];
+        NSImage *image = [[NSImage alloc] initWithSize:NSMakeSize((CGFloat)[bitmap pixelsWide], (CGFloat)[bitmap pixelsHigh])];
+        [image addRepresentation:bitmap];
+        [bitmap release];
+        CGImageRelease(cgimage);
+        return (OSImage*)image;
+    }
+
+    /* Image fits in the limits or ImageIO can't handle it */
+    return osimage_create_from_data(data, size_in_bytes, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
 OSImage *osimage_create_from_type(const char_t *file_type)
 {
     NSString *nsfile_type = nil;
@@ -15,7 +15,11 @@
 #include "bmath.h"
 #include "bmem.h"
 #include "cassert.h"
+#include "color.h"
 #include "heap.h"
+#include "palette.h"
+#include "pixconv.inl"
+#include "pixscale.inl"
 #include "ptr.h"
 #include "t2d.h"
 
@@ -131,7 +135,7 @@ static uint32_t i_get4(const byte_t *data, const uint32_t x, const uint32_t y, c
 {
     register byte_t b = data[(y * width + x) / 2];
     register byte_t pos = (byte_t)((y * width + x) % 2);
-    return (uint32_t)((b >> (pos * 4)) & 7);
+    return (uint32_t)((b >> (pos * 4)) & 15);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -267,10 +271,93 @@ Pixbuf *pixbuf_trim(const Pixbuf *pixbuf, const uint32_t x, const uint32_t y, co
 
 /*---------------------------------------------------------------------------*/
 
+static Pixbuf *i_from_gray(const Pixbuf *pixbuf, const pixformat_t oformat)
+{
+    Pixbuf *npixbuf = pixbuf_create(pixbuf->width, pixbuf->height, oformat);
+    uint32_t n = pixbuf->width * pixbuf->height;
+    switch (oformat) {
+    case ekRGB24:
+        pixconv_gray_to_rgb(i_DATA(pixbuf), i_DATA(npixbuf), n);
+        break;
+    case ekRGBA32:
+        pixconv_gray_to_rgba(i_DATA(pixbuf), i_DATA(npixbuf), n);
+        break;
+    case ekINDEX1:
+    case ekINDEX2:
+    case ekINDEX4:
+    case ekINDEX8:
+    case ekGRAY8:
+    case ekFIMAGE:
+    cassert_default();
+    }
+
+    return npixbuf;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Pixbuf *i_from_indexed(const Pixbuf *pixbuf, const Palette *palette, const pixformat_t oformat)
+{
+    Palette *dpalette = NULL;
+    const color_t *colors = NULL;
+    uint32_t ncolors = 0;
+    uint32_t bpp = pixbuf_format_bpp(pixbuf->format);
+    Pixbuf *npixbuf = NULL;
+
+    if (palette != NULL)
+    {
+        colors = palette_colors((Palette*)palette);
+        ncolors = palette_size(palette);
+    }
+    else
+    {
+        dpalette = imgutil_def_palette(pixbuf->format);
+        colors = palette_colors(dpalette);
+        ncolors = palette_size(dpalette);
+    }
+
+    switch (oformat) {
+    case ekGRAY8:
+    {
+        /* Any palette: luminance of each entry */
+        color_t gray[256];
+        uint32_t i;
+        bmem_zero_n(gray, 256, color_t);
+        for (i = 0; i < ncolors && i < 256; ++i)
+        {
+            uint32_t g = (77 * (colors[i] & 0xFF) + 148 * ((colors[i] >> 8) & 0xFF) + 30 * ((colors[i] >> 16) & 0xFF)) / 255;
+            gray[i] = (color_t)(g | (g << 8) | (g << 16) | 0xFF000000);
+        }
+
+        npixbuf = imgutil_indexed_to_gray(pixbuf->width, pixbuf->height, i_DATA(pixbuf), 0, bpp, gray);
+        break;
+    }
+
+    case ekRGB24:
+        npixbuf = imgutil_indexed_to_rgb(pixbuf->width, pixbuf->height, i_DATA(pixbuf), 0, bpp, colors);
+        break;
+
+    case ekRGBA32:
+        npixbuf = imgutil_indexed_to_rgba(pixbuf->width, pixbuf->height, i_DATA(pixbuf), 0, bpp, colors);
+        break;
+
+    case ekINDEX1:
+    case ekINDEX2:
+    case ekINDEX4:
+    case ekINDEX8:
+    case ekFIMAGE:
+    cassert_default();
+    }
+
+    ptr_destopt(palette_destroy, &dpalette, Palette);
+    return npixbuf;
+}
+
+/*---------------------------------------------------------------------------*/
+
 Pixbuf *pixbuf_convert(const Pixbuf *pixbuf, const Palette *palette, const pixformat_t oformat)
 {
     cassert_no_null(pixbuf);
-    unref(palette);
     if (pixbuf->format != oformat)
     {
         switch(pixbuf->format) {
@@ -311,12 +398,15 @@ Pixbuf *pixbuf_convert(const Pixbuf *pixbuf, const Palette *palette, const pixfo
             }
             break;
 
+        case ekGRAY8:
+            return i_from_gray(pixbuf, oformat);
 
         case ekINDEX1:
         case ekINDEX2:
         case ekINDEX4:
         case ekINDEX8:
-        case ekGRAY8:
+            return i_from_indexed(pixbuf, palette, oformat);
+
         case ekFIMAGE:
         cassert_default();
         }
@@ -333,6 +423,207 @@ Pixbuf *pixbuf_convert(const Pixbuf *pixbuf, const Palette *palette, const pixfo
 
 /*---------------------------------------------------------------------------*/
 
+Pixbuf *pixbuf_quantize(const Pixbuf *pixbuf, const bool_t dither, Palette **palette)
+{
+    cassert_no_null(pixbuf);
+    cassert_no_null(palette);
+    cassert(pixbuf->format == ekRGB24 || pixbuf->format == ekRGBA32);
+    return imgutil_to_indexed(pixbuf->width, pixbuf->height, i_DATA(pixbuf), pixbuf->format == ekRGB24 ? 3 : 4, dither, palette);
+}
+/*---------------------------------------------------------------------------*/
+
+/* Indices can't be interpolated: always nearest neighbor */
+static void i_scale_indexed(const Pixbuf *pixbuf, Pixbuf *npixbuf)
+{
+    const byte_t *sdata = i_DATA(pixbuf);
+    byte_t *data = i_DATA(npixbuf);
+    FPtr_get func_get = i_GET[pixbuf->format];
+    FPtr_set func_set = i_SET[pixbuf->format];
+    register uint32_t i, j;
+    for (j = 0; j < npixbuf->height; ++j)
+    {
+        uint32_t y = (uint32_t)(((2 * (uint64_t)j + 1) * pixbuf->height) / (2 * (uint64_t)npixbuf->height));
+        for (i = 0; i < npixbuf->width; ++i)
+        {
+            uint32_t x = (uint32_t)(((2 * (uint64_t)i + 1) * pixbuf->width) / (2 * (uint64_t)npixbuf->width));
+            func_set(data, i, j, npixbuf->width, func_get(sdata, x, y, pixbuf->width));
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+Pixbuf *pixbuf_scale(const Pixbuf *pixbuf, const uint32_t width, const uint32_t height, const pixfilter_t filter)
+{
+    Pixbuf *npixbuf = NULL;
+    uint32_t bytespp = 0;
+    cassert_no_null(pixbuf);
+    cassert(width > 0 && height > 0);
+    if (width == pixbuf->width && height == pixbuf->height)
+        return pixbuf_copy(pixbuf);
+
+    npixbuf = pixbuf_create(width, height, pixbuf->format);
+    switch (pixbuf->format) {
+    case ekINDEX1:
+    case ekINDEX2:
+    case ekINDEX4:
+        i_scale_indexed(pixbuf, npixbuf);
+        return npixbuf;
+
+    case ekINDEX8:
+        pixscale_nearest(i_DATA(pixbuf), pixbuf->width, pixbuf->height, i_DATA(npixbuf), width, height, 1);
+        return npixbuf;
+
+    case ekGRAY8:
+        bytespp = 1;
+        break;
+    case ekRGB24:
+        bytespp = 3;
+        break;
+    case ekRGBA32:
+        bytespp = 4;
+        break;
+
+    case ekFIMAGE:
+    cassert_default();
+    }
+
+    if (filter == ekPIXNEAREST)
+        pixscale_nearest(i_DATA(pixbuf), pixbuf->width, pixbuf->height, i_DATA(npixbuf), width, height, bytespp);
+    else
+        pixscale_resample(i_DATA(pixbuf), pixbuf->width, pixbuf->height, i_DATA(npixbuf), width, height, bytespp, filter);
+
+    return npixbuf;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rotated_size(const T2Df *t2d, const uint32_t width, const uint32_t height, real32_t *fx, real32_t *fy, uint32_t *fwidth, uint32_t *fheight)
+{
+    real32_t minx = 1e8f;
+    real32_t maxx = -1e8f;
+    real32_t miny = 1e8f;
+    real32_t maxy = -1e8f;
+    uint32_t i = 0;
+    V2Df corners[4];
+    corners[0].x = 0;
+    corners[0].y = 0;
+    corners[1].x = (real32_t)width;
+    corners[1].y = 0;
+    corners[2].x = (real32_t)width;
+    corners[2].y = (real32_t)height;
+    corners[3].x = 0;
+    corners[3].y = (real32_t)height;
+    for (i = 0; i < 4; ++i)
+    {
+        t2d_vmultf(corners + i, t2d, corners + i);
+        if (corners[i].x < minx) minx = corners[i].x;
+        if (corners[i].x > maxx) maxx = corners[i].x;
+        if (corners[i].y < miny) miny = corners[i].y;
+        if (corners[i].y > maxy) maxy = corners[i].y;
+    }
+
+    *fx = minx;
+    *fy = miny;
+    *fwidth = (uint32_t)(maxx - minx) + 1;
+    *fheight  = (uint32_t)(maxy - miny) + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rotate_indexed(const Pixbuf *pixbuf, Pixbuf *npixbuf, const T2Df *inv)
+{
+    const byte_t *sdata = i_DATA(pixbuf);
+    byte_t *data = i_DATA(npixbuf);
+    FPtr_get func_get = i_GET[pixbuf->format];
+    FPtr_set func_set = i_SET[pixbuf->format];
+    register uint32_t i, j;
+    for (j = 0; j < npixbuf->height; ++j)
+    for (i = 0; i < npixbuf->width; ++i)
+    {
+        V2Df p;
+        uint32_t value = 0;
+        p.x = (real32_t)i + .5f;
+        p.y = (real32_t)j + .5f;
+        t2d_vmultf(&p, inv, &p);
+        if (p.x >= 0 && p.y >= 0 && p.x < (real32_t)pixbuf->width && p.y < (real32_t)pixbuf->height)
+            value = func_get(sdata, (uint32_t)p.x, (uint32_t)p.y, pixbuf->width);
+        func_set(data, i, j, npixbuf->width, value);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+Pixbuf *pixbuf_rotate(const Pixbuf *pixbuf, const real32_t angle, const bool_t nsize, const color_t background, const pixfilter_t filter, T2Df *t2d)
+{
+    Pixbuf *npixbuf = NULL;
+    uint32_t fwidth, fheight;
+    real32_t cx, cy, fx, fy;
+    byte_t bg[4];
+    T2Df tr, inv;
+
+    cassert_no_null(pixbuf);
+    cx = pixbuf->width / 2.f;
+    cy = pixbuf->height / 2.f;
+
+    if (nsize == TRUE)
+    {
+        t2d_movef(&tr, kT2D_IDENTf, cx, cy);
+        t2d_rotatef(&tr, &tr, angle);
+        t2d_movef(&tr, &tr, -cx, -cy);
+        i_rotated_size(&tr, pixbuf->width, pixbuf->height, &fx, &fy, &fwidth, &fheight);
+    }
+    else
+    {
+        fx = 0;
+        fy = 0;
+        fwidth = pixbuf->width;
+        fheight = pixbuf->height;
+    }
+
+    t2d_movef(&tr, kT2D_IDENTf, - fx + cx, - fy + cy);
+    t2d_rotatef(&tr, &tr, angle);
+    t2d_movef(&tr, &tr, -cx, -cy);
+    t2d_invfastf(&inv, &tr);
+    ptr_assign(t2d, tr);
+
+    npixbuf = pixbuf_create(fwidth, fheight, pixbuf->format);
+    color_get_rgba(background, bg, bg + 1, bg + 2, bg + 3);
+
+    switch (pixbuf->format) {
+    case ekINDEX1:
+    case ekINDEX2:
+    case ekINDEX4:
+        i_rotate_indexed(pixbuf, npixbuf, &inv);
+        break;
+
+    case ekINDEX8:
+        bg[0] = 0;
+        pixscale_affine(i_DATA(pixbuf), pixbuf->width, pixbuf->height, i_DATA(npixbuf), fwidth, fheight, 1, &inv, bg, ekPIXNEAREST);
+        break;
+
+    case ekGRAY8:
+        bg[0] = (byte_t)((77 * (uint32_t)bg[0] + 148 * (uint32_t)bg[1] + 30 * (uint32_t)bg[2]) / 255);
+        pixscale_affine(i_DATA(pixbuf), pixbuf->width, pixbuf->height, i_DATA(npixbuf), fwidth, fheight, 1, &inv, bg, filter);
+        break;
+
+    case ekRGB24:
+        pixscale_affine(i_DATA(pixbuf), pixbuf->width, pixbuf->height, i_DATA(npixbuf), fwidth, fheight, 3, &inv, bg, filter);
+        break;
+
+    case ekRGBA32:
+        pixscale_affine(i_DATA(pixbuf), pixbuf->width, pixbuf->height, i_DATA(npixbuf), fwidth, fheight, 4, &inv, bg, filter);
+        break;
+
+    case ekFIMAGE:
+    cassert_default();
+    }
+
+    return npixbuf;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void pixbuf_destroy(Pixbuf **pixbuf)
 {
     uint32_t n;
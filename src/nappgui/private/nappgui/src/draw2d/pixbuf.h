@@ -26,6 +26,12 @@ _draw2d_api Pixbuf *pixbuf_trim(const Pixbuf *pixbuf, const uint32_t x, const ui
 
 _draw2d_api Pixbuf *pixbuf_convert(const Pixbuf *pixbuf, const Palette *palette, const pixformat_t oformat);
 
+_draw2d_api Pixbuf *pixbuf_quantize(const Pixbuf *pixbuf, const bool_t dither, Palette **palette);
+
+_draw2d_api Pixbuf *pixbuf_scale(const Pixbuf *pixbuf, const uint32_t width, const uint32_t height, const pixfilter_t filter);
+
+_draw2d_api Pixbuf *pixbuf_rotate(const Pixbuf *pixbuf, const real32_t angle, const bool_t nsize, const color_t background, const pixfilter_t filter, T2Df *t2d);
+
 _draw2d_api void pixbuf_destroy(Pixbuf **pixbuf);
 
 _draw2d_api pixformat_t pixbuf_format(const Pixbuf *pixbuf);
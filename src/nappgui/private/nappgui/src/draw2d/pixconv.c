@@ -0,0 +1,1424 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: pixconv.c
+ *
+ */
+
+/* Pixel format conversion kernels */
+
+#include "pixconv.inl"
+#include "cassert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXCONV_SSE2
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#include <immintrin.h>
+#define PIXCONV_AVX2
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PIXCONV_NEON
+#endif
+
+#if defined(_MSC_VER) && defined(PIXCONV_AVX2)
+#include <intrin.h>
+#endif
+
+/* AVX2 kernels are compiled for the target regardless of the global flags
+   and only called after checking the CPU at runtime */
+#if defined(PIXCONV_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#define i_AVX2 __attribute__((target("avx2")))
+#else
+#define i_AVX2
+#endif
+
+typedef enum _isa_t
+{
+    i_ekSCALAR,
+    i_ekSSE2,
+    i_ekAVX2,
+    i_ekNEON
+} isa_t;
+
+/* Pixels unpacked per block in indexed conversions (multiple of 8) */
+#define i_BLOCK     1024
+
+static bool_t i_SIMD = TRUE;
+static isa_t i_ISA = ENUM_MAX(isa_t);
+
+/*---------------------------------------------------------------------------*/
+
+static isa_t i_cpu_isa(void)
+{
+#if defined(PIXCONV_AVX2) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return i_ekAVX2;
+    return i_ekSSE2;
+
+#elif defined(PIXCONV_AVX2) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+        /* OSXSAVE + AVX, and the OS saves the YMM registers */
+        __cpuid(info, 1);
+        if ((info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(info, 7, 0);
+            if ((info[1] & (1 << 5)) != 0)
+                return i_ekAVX2;
+        }
+    }
+    return i_ekSSE2;
+
+#elif defined(PIXCONV_SSE2)
+    return i_ekSSE2;
+
+#elif defined(PIXCONV_NEON)
+    return i_ekNEON;
+
+#else
+    return i_ekSCALAR;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE isa_t i_isa(void)
+{
+    /* Concurrent first calls compute the same value */
+    if (i_ISA == ENUM_MAX(isa_t))
+        i_ISA = i_cpu_isa();
+
+    if (i_SIMD == TRUE)
+        return i_ISA;
+
+    return i_ekSCALAR;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE byte_t i_gray(const byte_t *rgb)
+{
+    return (byte_t)((77 * (uint32_t)rgb[0] + 148 * (uint32_t)rgb[1] + 30 * (uint32_t)rgb[2]) / 255);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgba_to_rgb(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i;
+    for (i = 0; i < n; ++i, src += 4, dest += 3)
+    {
+        dest[0] = src[0];
+        dest[1] = src[1];
+        dest[2] = src[2];
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgb_to_rgba(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i;
+    for (i = 0; i < n; ++i, src += 3, dest += 4)
+    {
+        dest[0] = src[0];
+        dest[1] = src[1];
+        dest[2] = src[2];
+        dest[3] = 255;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgba_to_gray(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i;
+    for (i = 0; i < n; ++i, src += 4, dest += 1)
+        *dest = i_gray(src);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgb_to_gray(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i;
+    for (i = 0; i < n; ++i, src += 3, dest += 1)
+        *dest = i_gray(src);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_gray_to_rgba(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i;
+    for (i = 0; i < n; ++i, src += 1, dest += 4)
+    {
+        dest[0] = src[0];
+        dest[1] = src[0];
+        dest[2] = src[0];
+        dest[3] = 255;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_gray_to_rgb(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i;
+    for (i = 0; i < n; ++i, src += 1, dest += 3)
+    {
+        dest[0] = src[0];
+        dest[1] = src[0];
+        dest[2] = src[0];
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* 'msb' --> The first pixel is in the high bits of each byte */
+static void i_unpack(const byte_t *src, byte_t *dest, const uint32_t n, const uint32_t bpp, const bool_t msb)
+{
+    register uint32_t i;
+    register uint32_t ppb = 8 / bpp;
+    register byte_t mask = (byte_t)((1 << bpp) - 1);
+    for (i = 0; i < n; ++i)
+    {
+        register uint32_t pos = i % ppb;
+        register uint32_t shift = msb ? (ppb - 1 - pos) * bpp : pos * bpp;
+        dest[i] = (byte_t)((src[i / ppb] >> shift) & mask);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_lookup_gray(const byte_t *index, byte_t *dest, const uint32_t n, const color_t *palette)
+{
+    register uint32_t i;
+    for (i = 0; i < n; ++i)
+    {
+        register color_t c = palette[index[i]];
+
+        /* Its a gray palette */
+        cassert((byte_t)c == (byte_t)(c >> 8));
+        cassert((byte_t)c == (byte_t)(c >> 16));
+
+        dest[i] = (byte_t)c;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_lookup_rgb(const byte_t *index, byte_t *dest, const uint32_t n, const color_t *palette)
+{
+    register uint32_t i;
+    for (i = 0; i < n; ++i, dest += 3)
+    {
+        register color_t c = palette[index[i]];
+        dest[0] = (byte_t)c;
+        dest[1] = (byte_t)(c >> 8);
+        dest[2] = (byte_t)(c >> 16);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_lookup_rgba(const byte_t *index, byte_t *dest, const uint32_t n, const color_t *palette)
+{
+    register uint32_t i;
+    register uint32_t *data = (uint32_t*)dest;
+    for (i = 0; i < n; ++i)
+        data[i] = (uint32_t)palette[index[i]];
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* RGBA is premultiplied by alpha, keeping the [0, 255] range */
+static void i_to_float(const byte_t *src, real32_t *dest, const uint32_t n, const uint32_t channels)
+{
+    register uint32_t i;
+    if (channels == 4)
+    {
+        for (i = 0; i < n; ++i, src += 4, dest += 4)
+        {
+            real32_t a = (real32_t)src[3] * (1.f / 255.f);
+            dest[0] = (real32_t)src[0] * a;
+            dest[1] = (real32_t)src[1] * a;
+            dest[2] = (real32_t)src[2] * a;
+            dest[3] = (real32_t)src[3];
+        }
+    }
+    else
+    {
+        for (i = 0; i < n * channels; ++i)
+            dest[i] = (real32_t)src[i];
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE byte_t i_fbyte(const real32_t v)
+{
+    if (v <= 0.f)
+        return 0;
+    if (v >= 255.f)
+        return 255;
+    return (byte_t)(v + .5f);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Almost transparent pixels (alpha < .5) lose their color */
+static __INLINE real32_t i_unpremul(const real32_t a)
+{
+    return a >= .5f ? 255.f / a : 0.f;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_from_float(const real32_t *src, byte_t *dest, const uint32_t n, const uint32_t channels)
+{
+    register uint32_t i;
+    if (channels == 4)
+    {
+        for (i = 0; i < n; ++i, src += 4, dest += 4)
+        {
+            real32_t f = i_unpremul(src[3]);
+            dest[0] = i_fbyte(src[0] * f);
+            dest[1] = i_fbyte(src[1] * f);
+            dest[2] = i_fbyte(src[2] * f);
+            dest[3] = i_fbyte(src[3]);
+        }
+    }
+    else
+    {
+        for (i = 0; i < n * channels; ++i)
+            dest[i] = i_fbyte(src[i]);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_hfilter(const real32_t *src, real32_t *dest, const uint32_t n, const uint32_t channels, const uint32_t *first, const uint32_t ntaps, const real32_t *weights)
+{
+    register uint32_t i, k, c;
+    for (i = 0; i < n; ++i, weights += ntaps, dest += channels)
+    {
+        const real32_t *s = src + first[i] * channels;
+        for (c = 0; c < channels; ++c)
+        {
+            real32_t acc = 0.f;
+            for (k = 0; k < ntaps; ++k)
+                acc += weights[k] * s[k * channels + c];
+            dest[c] = acc;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_vfilter(const real32_t **rows, const real32_t *weights, const uint32_t ntaps, real32_t *dest, const uint32_t st, const uint32_t n)
+{
+    register uint32_t i, k;
+    for (i = st; i < n; ++i)
+    {
+        real32_t acc = 0.f;
+        for (k = 0; k < ntaps; ++k)
+            acc += weights[k] * rows[k][i];
+        dest[i] = acc;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(PIXCONV_SSE2)
+
+/* Four RGBx pixels (32 bits lanes) to gray, one value per lane.
+   'x / 255' is computed as '(x + 1 + (x >> 8)) >> 8', exact for x < 65535 */
+static __INLINE __m128i i_gray4_sse2(const __m128i v)
+{
+    __m128i rb = _mm_and_si128(v, _mm_set1_epi32(0x00FF00FF));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), _mm_set1_epi32(0xFF));
+    __m128i x = _mm_add_epi32(_mm_madd_epi16(rb, _mm_set1_epi32((30 << 16) | 77)), _mm_madd_epi16(g, _mm_set1_epi32(148)));
+    x = _mm_add_epi32(_mm_add_epi32(x, _mm_set1_epi32(1)), _mm_srli_epi32(x, 8));
+    return _mm_srli_epi32(x, 8);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgba_to_gray_sse2(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 64, dest += 16)
+    {
+        __m128i a = i_gray4_sse2(_mm_loadu_si128((const __m128i*)src));
+        __m128i b = i_gray4_sse2(_mm_loadu_si128((const __m128i*)(src + 16)));
+        __m128i c = i_gray4_sse2(_mm_loadu_si128((const __m128i*)(src + 32)));
+        __m128i d = i_gray4_sse2(_mm_loadu_si128((const __m128i*)(src + 48)));
+        __m128i g = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128((__m128i*)dest, g);
+    }
+
+    i_rgba_to_gray(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_gray_to_rgba_sse2(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    __m128i alpha = _mm_set1_epi8((char)0xFF);
+    for (; i + 16 <= n; i += 16, src += 16, dest += 64)
+    {
+        __m128i g = _mm_loadu_si128((const __m128i*)src);
+        __m128i gg0 = _mm_unpacklo_epi8(g, g);
+        __m128i gg1 = _mm_unpackhi_epi8(g, g);
+        __m128i ga0 = _mm_unpacklo_epi8(g, alpha);
+        __m128i ga1 = _mm_unpackhi_epi8(g, alpha);
+        _mm_storeu_si128((__m128i*)dest, _mm_unpacklo_epi16(gg0, ga0));
+        _mm_storeu_si128((__m128i*)(dest + 16), _mm_unpackhi_epi16(gg0, ga0));
+        _mm_storeu_si128((__m128i*)(dest + 32), _mm_unpacklo_epi16(gg1, ga1));
+        _mm_storeu_si128((__m128i*)(dest + 48), _mm_unpackhi_epi16(gg1, ga1));
+    }
+
+    i_gray_to_rgba(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Bits [shift, shift + bpp) of each byte */
+static __INLINE __m128i i_plane_sse2(const __m128i v, const uint32_t shift, const __m128i mask)
+{
+    return _mm_and_si128(_mm_srl_epi16(v, _mm_cvtsi32_si128((int)shift)), mask);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* 16 bytes --> 16 * (8 / bpp) indices */
+static void i_unpack16_sse2(const byte_t *src, byte_t *dest, const uint32_t bpp, const bool_t msb)
+{
+    __m128i v = _mm_loadu_si128((const __m128i*)src);
+    __m128i mask = _mm_set1_epi8((char)((1 << bpp) - 1));
+    __m128i p[8];
+    uint32_t i, ppb = 8 / bpp;
+    __m128i *out = (__m128i*)dest;
+
+    for (i = 0; i < ppb; ++i)
+        p[i] = i_plane_sse2(v, msb ? (ppb - 1 - i) * bpp : i * bpp, mask);
+
+    if (bpp == 4)
+    {
+        _mm_storeu_si128(out, _mm_unpacklo_epi8(p[0], p[1]));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(p[0], p[1]));
+    }
+    else if (bpp == 2)
+    {
+        __m128i a0 = _mm_unpacklo_epi8(p[0], p[1]);
+        __m128i a1 = _mm_unpackhi_epi8(p[0], p[1]);
+        __m128i b0 = _mm_unpacklo_epi8(p[2], p[3]);
+        __m128i b1 = _mm_unpackhi_epi8(p[2], p[3]);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(a0, b0));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(a0, b0));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(a1, b1));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(a1, b1));
+    }
+    else
+    {
+        __m128i a[2], b[2], c[2], d[2];
+        uint32_t j, k = 0;
+        cassert(bpp == 1);
+        a[0] = _mm_unpacklo_epi8(p[0], p[1]);
+        a[1] = _mm_unpackhi_epi8(p[0], p[1]);
+        b[0] = _mm_unpacklo_epi8(p[2], p[3]);
+        b[1] = _mm_unpackhi_epi8(p[2], p[3]);
+        c[0] = _mm_unpacklo_epi8(p[4], p[5]);
+        c[1] = _mm_unpackhi_epi8(p[4], p[5]);
+        d[0] = _mm_unpacklo_epi8(p[6], p[7]);
+        d[1] = _mm_unpackhi_epi8(p[6], p[7]);
+        for (j = 0; j < 2; ++j)
+        {
+            __m128i ab0 = _mm_unpacklo_epi16(a[j], b[j]);
+            __m128i ab1 = _mm_unpackhi_epi16(a[j], b[j]);
+            __m128i cd0 = _mm_unpacklo_epi16(c[j], d[j]);
+            __m128i cd1 = _mm_unpackhi_epi16(c[j], d[j]);
+            _mm_storeu_si128(out + k++, _mm_unpacklo_epi32(ab0, cd0));
+            _mm_storeu_si128(out + k++, _mm_unpackhi_epi32(ab0, cd0));
+            _mm_storeu_si128(out + k++, _mm_unpacklo_epi32(ab1, cd1));
+            _mm_storeu_si128(out + k++, _mm_unpackhi_epi32(ab1, cd1));
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_to_float_sse2(const byte_t *src, real32_t *dest, const uint32_t n, const uint32_t channels)
+{
+    register uint32_t i = 0;
+    __m128i zero = _mm_setzero_si128();
+    if (channels == 4)
+    {
+        __m128 inv = _mm_set1_ps(1.f / 255.f);
+        __m128 rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        __m128 one = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
+        for (; i + 2 <= n; i += 2, src += 8, dest += 8)
+        {
+            __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)src), zero);
+            __m128 p0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+            __m128 p1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+            __m128 a0 = _mm_mul_ps(_mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3, 3, 3, 3)), inv);
+            __m128 a1 = _mm_mul_ps(_mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3, 3, 3, 3)), inv);
+            _mm_storeu_ps(dest, _mm_mul_ps(p0, _mm_or_ps(_mm_and_ps(a0, rgb), one)));
+            _mm_storeu_ps(dest + 4, _mm_mul_ps(p1, _mm_or_ps(_mm_and_ps(a1, rgb), one)));
+        }
+
+        i_to_float(src, dest, n - i, 4);
+    }
+    else
+    {
+        uint32_t m = n * channels;
+        for (; i + 16 <= m; i += 16, src += 16, dest += 16)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)src);
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            _mm_storeu_ps(dest, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+            _mm_storeu_ps(dest + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+            _mm_storeu_ps(dest + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+            _mm_storeu_ps(dest + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+        }
+
+        i_to_float(src, dest, m - i, 1);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Clamp to [0, 255] and round */
+static __INLINE __m128i i_fbyte4_sse2(const __m128 v)
+{
+    __m128 c = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.f));
+    return _mm_cvttps_epi32(_mm_add_ps(c, _mm_set1_ps(.5f)));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE __m128 i_unpremul_sse2(const __m128 v)
+{
+    __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 f = _mm_and_ps(_mm_div_ps(_mm_set1_ps(255.f), a), _mm_cmpge_ps(a, _mm_set1_ps(.5f)));
+    __m128 rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    return _mm_mul_ps(v, _mm_or_ps(_mm_and_ps(f, rgb), _mm_set_ps(1.f, 0.f, 0.f, 0.f)));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_from_float_sse2(const real32_t *src, byte_t *dest, const uint32_t n, const uint32_t channels)
+{
+    register uint32_t i = 0;
+    if (channels == 4)
+    {
+        for (; i + 4 <= n; i += 4, src += 16, dest += 16)
+        {
+            __m128i a = i_fbyte4_sse2(i_unpremul_sse2(_mm_loadu_ps(src)));
+            __m128i b = i_fbyte4_sse2(i_unpremul_sse2(_mm_loadu_ps(src + 4)));
+            __m128i c = i_fbyte4_sse2(i_unpremul_sse2(_mm_loadu_ps(src + 8)));
+            __m128i d = i_fbyte4_sse2(i_unpremul_sse2(_mm_loadu_ps(src + 12)));
+            _mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        }
+
+        i_from_float(src, dest, n - i, 4);
+    }
+    else
+    {
+        uint32_t m = n * channels;
+        for (; i + 16 <= m; i += 16, src += 16, dest += 16)
+        {
+            __m128i a = i_fbyte4_sse2(_mm_loadu_ps(src));
+            __m128i b = i_fbyte4_sse2(_mm_loadu_ps(src + 4));
+            __m128i c = i_fbyte4_sse2(_mm_loadu_ps(src + 8));
+            __m128i d = i_fbyte4_sse2(_mm_loadu_ps(src + 12));
+            _mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        }
+
+        i_from_float(src, dest, m - i, 1);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* One pixel per vector. Three channels read one float past the pixel */
+static void i_hfilter_sse2(const real32_t *src, real32_t *dest, const uint32_t n, const uint32_t channels, const uint32_t *first, const uint32_t ntaps, const real32_t *weights)
+{
+    register uint32_t i, k;
+    cassert(channels == 3 || channels == 4);
+    for (i = 0; i < n; ++i, weights += ntaps, dest += channels)
+    {
+        const real32_t *s = src + first[i] * channels;
+        __m128 acc = _mm_setzero_ps();
+        for (k = 0; k < ntaps; ++k, s += channels)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(s)));
+
+        if (channels == 4)
+        {
+            _mm_storeu_ps(dest, acc);
+        }
+        else
+        {
+            _mm_storel_pi((__m64*)dest, acc);
+            _mm_store_ss(dest + 2, _mm_movehl_ps(acc, acc));
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_vfilter_sse2(const real32_t **rows, const real32_t *weights, const uint32_t ntaps, real32_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0, k;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 acc = _mm_setzero_ps();
+        for (k = 0; k < ntaps; ++k)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows[k] + i)));
+        _mm_storeu_ps(dest + i, acc);
+    }
+
+    i_vfilter(rows, weights, ntaps, dest, i, n);
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(PIXCONV_AVX2)
+
+/* Eight RGBx pixels (32 bits lanes) to gray, one value per lane */
+static __INLINE i_AVX2 __m256i i_gray8_avx2(const __m256i v)
+{
+    __m256i rb = _mm256_and_si256(v, _mm256_set1_epi32(0x00FF00FF));
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(v, 8), _mm256_set1_epi32(0xFF));
+    __m256i x = _mm256_add_epi32(_mm256_madd_epi16(rb, _mm256_set1_epi32((30 << 16) | 77)), _mm256_madd_epi16(g, _mm256_set1_epi32(148)));
+    x = _mm256_add_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(1)), _mm256_srli_epi32(x, 8));
+    return _mm256_srli_epi32(x, 8);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Two vectors of eight gray values (32 bits lanes) --> 16 bytes */
+static __INLINE i_AVX2 void i_store_gray16_avx2(byte_t *dest, const __m256i a, const __m256i b)
+{
+    /* packus works per 128 bits lane: restore the pixel order */
+    __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+    p = _mm256_packus_epi16(p, _mm256_setzero_si256());
+    _mm_storel_epi64((__m128i*)dest, _mm256_castsi256_si128(p));
+    _mm_storel_epi64((__m128i*)(dest + 8), _mm256_extracti128_si256(p, 1));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Eight RGB pixels --> RGBx. Reads 28 bytes */
+static __INLINE i_AVX2 __m256i i_load_rgb8_avx2(const byte_t *src, const __m256i shuf)
+{
+    __m128i lo = _mm_loadu_si128((const __m128i*)src);
+    __m128i hi = _mm_loadu_si128((const __m128i*)(src + 12));
+    return _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), shuf);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Two 12-byte results (one per 128 bits lane). Writes 28 bytes */
+static __INLINE i_AVX2 void i_store_rgb8_avx2(byte_t *dest, const __m256i v)
+{
+    _mm_storeu_si128((__m128i*)dest, _mm256_castsi256_si128(v));
+    _mm_storeu_si128((__m128i*)(dest + 12), _mm256_extracti128_si256(v, 1));
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* The 16-byte loads/stores of 24-byte RGB groups touch 4 bytes more.
+   The loops stop 2 pixels before the end to stay inside the buffers */
+static i_AVX2 void i_rgba_to_rgb_avx2(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    __m256i shuf = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    for (; i + 10 <= n; i += 8, src += 32, dest += 24)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)src);
+        i_store_rgb8_avx2(dest, _mm256_shuffle_epi8(v, shuf));
+    }
+
+    i_rgba_to_rgb(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_AVX2 void i_rgb_to_rgba_avx2(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    __m256i shuf = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+    for (; i + 10 <= n; i += 8, src += 24, dest += 32)
+    {
+        __m256i v = i_load_rgb8_avx2(src, shuf);
+        _mm256_storeu_si256((__m256i*)dest, _mm256_or_si256(v, alpha));
+    }
+
+    i_rgb_to_rgba(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_AVX2 void i_rgba_to_gray_avx2(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 64, dest += 16)
+    {
+        __m256i a = i_gray8_avx2(_mm256_loadu_si256((const __m256i*)src));
+        __m256i b = i_gray8_avx2(_mm256_loadu_si256((const __m256i*)(src + 32)));
+        i_store_gray16_avx2(dest, a, b);
+    }
+
+    i_rgba_to_gray(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_AVX2 void i_rgb_to_gray_avx2(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    __m256i shuf = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    for (; i + 18 <= n; i += 16, src += 48, dest += 16)
+    {
+        __m256i a = i_gray8_avx2(i_load_rgb8_avx2(src, shuf));
+        __m256i b = i_gray8_avx2(i_load_rgb8_avx2(src + 24, shuf));
+        i_store_gray16_avx2(dest, a, b);
+    }
+
+    i_rgb_to_gray(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_AVX2 void i_gray_to_rgb_avx2(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    __m256i shuf = _mm256_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, -1, -1, -1, -1, 4, 4, 4, 5, 5, 5, 6, 6, 6, 7, 7, 7, -1, -1, -1, -1);
+    for (; i + 10 <= n; i += 8, src += 8, dest += 24)
+    {
+        __m256i v = _mm256_broadcastsi128_si256(_mm_loadl_epi64((const __m128i*)src));
+        i_store_rgb8_avx2(dest, _mm256_shuffle_epi8(v, shuf));
+    }
+
+    i_gray_to_rgb(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_AVX2 void i_lookup_rgba_avx2(const byte_t *index, byte_t *dest, const uint32_t n, const color_t *palette)
+{
+    register uint32_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(index + i)));
+        __m256i c = _mm256_i32gather_epi32((const int*)palette, idx, 4);
+        _mm256_storeu_si256((__m256i*)(dest + i * 4), c);
+    }
+
+    i_lookup_rgba(index + i, dest + i * 4, n - i, palette);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_AVX2 void i_vfilter_avx2(const real32_t **rows, const real32_t *weights, const uint32_t ntaps, real32_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0, k;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 acc = _mm256_setzero_ps();
+        for (k = 0; k < ntaps; ++k)
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows[k] + i)));
+        _mm256_storeu_ps(dest + i, acc);
+    }
+
+    i_vfilter(rows, weights, ntaps, dest, i, n);
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(PIXCONV_NEON)
+
+/* 'x / 255' for x < 65535 */
+static __INLINE uint8x8_t i_div255_neon(const uint16x8_t x)
+{
+    return vshrn_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint8x16_t i_gray16_neon(const uint8x16_t r, const uint8x16_t g, const uint8x16_t b)
+{
+    uint16x8_t lo = vmull_u8(vget_low_u8(r), vdup_n_u8(77));
+    uint16x8_t hi = vmull_u8(vget_high_u8(r), vdup_n_u8(77));
+    lo = vmlal_u8(lo, vget_low_u8(g), vdup_n_u8(148));
+    hi = vmlal_u8(hi, vget_high_u8(g), vdup_n_u8(148));
+    lo = vmlal_u8(lo, vget_low_u8(b), vdup_n_u8(30));
+    hi = vmlal_u8(hi, vget_high_u8(b), vdup_n_u8(30));
+    return vcombine_u8(i_div255_neon(lo), i_div255_neon(hi));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgba_to_rgb_neon(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 64, dest += 48)
+    {
+        uint8x16x4_t v = vld4q_u8(src);
+        uint8x16x3_t o;
+        o.val[0] = v.val[0];
+        o.val[1] = v.val[1];
+        o.val[2] = v.val[2];
+        vst3q_u8(dest, o);
+    }
+
+    i_rgba_to_rgb(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgb_to_rgba_neon(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 48, dest += 64)
+    {
+        uint8x16x3_t v = vld3q_u8(src);
+        uint8x16x4_t o;
+        o.val[0] = v.val[0];
+        o.val[1] = v.val[1];
+        o.val[2] = v.val[2];
+        o.val[3] = vdupq_n_u8(255);
+        vst4q_u8(dest, o);
+    }
+
+    i_rgb_to_rgba(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgba_to_gray_neon(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 64, dest += 16)
+    {
+        uint8x16x4_t v = vld4q_u8(src);
+        vst1q_u8(dest, i_gray16_neon(v.val[0], v.val[1], v.val[2]));
+    }
+
+    i_rgba_to_gray(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_rgb_to_gray_neon(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 48, dest += 16)
+    {
+        uint8x16x3_t v = vld3q_u8(src);
+        vst1q_u8(dest, i_gray16_neon(v.val[0], v.val[1], v.val[2]));
+    }
+
+    i_rgb_to_gray(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_gray_to_rgba_neon(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 16, dest += 64)
+    {
+        uint8x16x4_t o;
+        o.val[0] = vld1q_u8(src);
+        o.val[1] = o.val[0];
+        o.val[2] = o.val[0];
+        o.val[3] = vdupq_n_u8(255);
+        vst4q_u8(dest, o);
+    }
+
+    i_gray_to_rgba(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_gray_to_rgb_neon(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0;
+    for (; i + 16 <= n; i += 16, src += 16, dest += 48)
+    {
+        uint8x16x3_t o;
+        o.val[0] = vld1q_u8(src);
+        o.val[1] = o.val[0];
+        o.val[2] = o.val[0];
+        vst3q_u8(dest, o);
+    }
+
+    i_gray_to_rgb(src, dest, n - i);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* 16 bytes --> 16 * (8 / bpp) indices */
+static void i_unpack16_neon(const byte_t *src, byte_t *dest, const uint32_t bpp, const bool_t msb)
+{
+    uint8x16_t v = vld1q_u8(src);
+    uint8x16_t mask = vdupq_n_u8((uint8_t)((1 << bpp) - 1));
+    uint8x16_t p[8];
+    uint32_t i, ppb = 8 / bpp;
+
+    for (i = 0; i < ppb; ++i)
+    {
+        int32_t shift = (int32_t)(msb ? (ppb - 1 - i) * bpp : i * bpp);
+        p[i] = vandq_u8(vshlq_u8(v, vdupq_n_s8((int8_t)-shift)), mask);
+    }
+
+    if (bpp == 4)
+    {
+        uint8x16x2_t a = vzipq_u8(p[0], p[1]);
+        vst1q_u8(dest, a.val[0]);
+        vst1q_u8(dest + 16, a.val[1]);
+    }
+    else if (bpp == 2)
+    {
+        uint8x16x2_t a = vzipq_u8(p[0], p[1]);
+        uint8x16x2_t b = vzipq_u8(p[2], p[3]);
+        uint16x8x2_t ab0 = vzipq_u16(vreinterpretq_u16_u8(a.val[0]), vreinterpretq_u16_u8(b.val[0]));
+        uint16x8x2_t ab1 = vzipq_u16(vreinterpretq_u16_u8(a.val[1]), vreinterpretq_u16_u8(b.val[1]));
+        vst1q_u8(dest, vreinterpretq_u8_u16(ab0.val[0]));
+        vst1q_u8(dest + 16, vreinterpretq_u8_u16(ab0.val[1]));
+        vst1q_u8(dest + 32, vreinterpretq_u8_u16(ab1.val[0]));
+        vst1q_u8(dest + 48, vreinterpretq_u8_u16(ab1.val[1]));
+    }
+    else
+    {
+        uint8x16x2_t a = vzipq_u8(p[0], p[1]);
+        uint8x16x2_t b = vzipq_u8(p[2], p[3]);
+        uint8x16x2_t c = vzipq_u8(p[4], p[5]);
+        uint8x16x2_t d = vzipq_u8(p[6], p[7]);
+        uint32_t j;
+        cassert(bpp == 1);
+        for (j = 0; j < 2; ++j)
+        {
+            uint16x8x2_t ab = vzipq_u16(vreinterpretq_u16_u8(a.val[j]), vreinterpretq_u16_u8(b.val[j]));
+            uint16x8x2_t cd = vzipq_u16(vreinterpretq_u16_u8(c.val[j]), vreinterpretq_u16_u8(d.val[j]));
+            uint32x4x2_t o0 = vzipq_u32(vreinterpretq_u32_u16(ab.val[0]), vreinterpretq_u32_u16(cd.val[0]));
+            uint32x4x2_t o1 = vzipq_u32(vreinterpretq_u32_u16(ab.val[1]), vreinterpretq_u32_u16(cd.val[1]));
+            vst1q_u8(dest, vreinterpretq_u8_u32(o0.val[0]));
+            vst1q_u8(dest + 16, vreinterpretq_u8_u32(o0.val[1]));
+            vst1q_u8(dest + 32, vreinterpretq_u8_u32(o1.val[0]));
+            vst1q_u8(dest + 48, vreinterpretq_u8_u32(o1.val[1]));
+            dest += 64;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_to_float_neon(const byte_t *src, real32_t *dest, const uint32_t n, const uint32_t channels)
+{
+    register uint32_t i = 0;
+    if (channels == 4)
+    {
+        for (; i + 2 <= n; i += 2, src += 8, dest += 8)
+        {
+            uint16x8_t v = vmovl_u8(vld1_u8(src));
+            float32x4_t p0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+            float32x4_t p1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v)));
+            float32x4_t a0 = vsetq_lane_f32(1.f, vmulq_n_f32(vdupq_laneq_f32(p0, 3), 1.f / 255.f), 3);
+            float32x4_t a1 = vsetq_lane_f32(1.f, vmulq_n_f32(vdupq_laneq_f32(p1, 3), 1.f / 255.f), 3);
+            vst1q_f32(dest, vmulq_f32(p0, a0));
+            vst1q_f32(dest + 4, vmulq_f32(p1, a1));
+        }
+
+        i_to_float(src, dest, n - i, 4);
+    }
+    else
+    {
+        uint32_t m = n * channels;
+        for (; i + 8 <= m; i += 8, src += 8, dest += 8)
+        {
+            uint16x8_t v = vmovl_u8(vld1_u8(src));
+            vst1q_f32(dest, vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))));
+            vst1q_f32(dest + 4, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))));
+        }
+
+        i_to_float(src, dest, m - i, 1);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Clamp to [0, 255] and round */
+static __INLINE uint16x4_t i_fbyte4_neon(const float32x4_t v)
+{
+    float32x4_t c = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0.f)), vdupq_n_f32(255.f));
+    return vmovn_u32(vcvtq_u32_f32(vaddq_f32(c, vdupq_n_f32(.5f))));
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE float32x4_t i_unpremul_neon(const float32x4_t v)
+{
+    float32x4_t f = vsetq_lane_f32(1.f, vdupq_n_f32(i_unpremul(vgetq_lane_f32(v, 3))), 3);
+    return vmulq_f32(v, f);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_from_float_neon(const real32_t *src, byte_t *dest, const uint32_t n, const uint32_t channels)
+{
+    register uint32_t i = 0;
+    if (channels == 4)
+    {
+        for (; i + 2 <= n; i += 2, src += 8, dest += 8)
+        {
+            uint16x4_t a = i_fbyte4_neon(i_unpremul_neon(vld1q_f32(src)));
+            uint16x4_t b = i_fbyte4_neon(i_unpremul_neon(vld1q_f32(src + 4)));
+            vst1_u8(dest, vmovn_u16(vcombine_u16(a, b)));
+        }
+
+        i_from_float(src, dest, n - i, 4);
+    }
+    else
+    {
+        uint32_t m = n * channels;
+        for (; i + 8 <= m; i += 8, src += 8, dest += 8)
+        {
+            uint16x4_t a = i_fbyte4_neon(vld1q_f32(src));
+            uint16x4_t b = i_fbyte4_neon(vld1q_f32(src + 4));
+            vst1_u8(dest, vmovn_u16(vcombine_u16(a, b)));
+        }
+
+        i_from_float(src, dest, m - i, 1);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* One pixel per vector. Three channels read one float past the pixel */
+static void i_hfilter_neon(const real32_t *src, real32_t *dest, const uint32_t n, const uint32_t channels, const uint32_t *first, const uint32_t ntaps, const real32_t *weights)
+{
+    register uint32_t i, k;
+    cassert(channels == 3 || channels == 4);
+    for (i = 0; i < n; ++i, weights += ntaps, dest += channels)
+    {
+        const real32_t *s = src + first[i] * channels;
+        float32x4_t acc = vdupq_n_f32(0.f);
+        for (k = 0; k < ntaps; ++k, s += channels)
+            acc = vaddq_f32(acc, vmulq_n_f32(vld1q_f32(s), weights[k]));
+
+        if (channels == 4)
+        {
+            vst1q_f32(dest, acc);
+        }
+        else
+        {
+            vst1_f32(dest, vget_low_f32(acc));
+            vst1q_lane_f32(dest + 2, acc, 2);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_vfilter_neon(const real32_t **rows, const real32_t *weights, const uint32_t ntaps, real32_t *dest, const uint32_t n)
+{
+    register uint32_t i = 0, k;
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t acc = vdupq_n_f32(0.f);
+        for (k = 0; k < ntaps; ++k)
+            acc = vaddq_f32(acc, vmulq_n_f32(vld1q_f32(rows[k] + i), weights[k]));
+        vst1q_f32(dest + i, acc);
+    }
+
+    i_vfilter(rows, weights, ntaps, dest, i, n);
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_rgba_to_rgb(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_AVX2)
+    case i_ekAVX2:
+        i_rgba_to_rgb_avx2(src, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_rgba_to_rgb_neon(src, dest, n);
+        return;
+#endif
+    default:
+        i_rgba_to_rgb(src, dest, n);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_rgb_to_rgba(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_AVX2)
+    case i_ekAVX2:
+        i_rgb_to_rgba_avx2(src, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_rgb_to_rgba_neon(src, dest, n);
+        return;
+#endif
+    default:
+        i_rgb_to_rgba(src, dest, n);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_rgba_to_gray(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_AVX2)
+    case i_ekAVX2:
+        i_rgba_to_gray_avx2(src, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_SSE2)
+    case i_ekSSE2:
+        i_rgba_to_gray_sse2(src, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_rgba_to_gray_neon(src, dest, n);
+        return;
+#endif
+    default:
+        i_rgba_to_gray(src, dest, n);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_rgb_to_gray(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_AVX2)
+    case i_ekAVX2:
+        i_rgb_to_gray_avx2(src, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_rgb_to_gray_neon(src, dest, n);
+        return;
+#endif
+    default:
+        i_rgb_to_gray(src, dest, n);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_gray_to_rgba(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_SSE2)
+    case i_ekAVX2:
+    case i_ekSSE2:
+        i_gray_to_rgba_sse2(src, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_gray_to_rgba_neon(src, dest, n);
+        return;
+#endif
+    default:
+        i_gray_to_rgba(src, dest, n);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_gray_to_rgb(const byte_t *src, byte_t *dest, const uint32_t n)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_AVX2)
+    case i_ekAVX2:
+        i_gray_to_rgb_avx2(src, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_gray_to_rgb_neon(src, dest, n);
+        return;
+#endif
+    default:
+        i_gray_to_rgb(src, dest, n);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Returns the 8 bits indices of 'n' pixels (n <= i_BLOCK) */
+static const byte_t *i_indices(const byte_t *src, byte_t *index, const uint32_t n, const uint32_t bpp, const bool_t msb, const isa_t isa)
+{
+    uint32_t i = 0;
+    cassert(bpp == 1 || bpp == 2 || bpp == 4 || bpp == 8);
+    cassert(n <= i_BLOCK);
+
+    if (bpp == 8)
+        return src;
+
+    /* Each 16 bytes block holds 16 * (8 / bpp) pixels */
+    {
+        uint32_t step = 16 * (8 / bpp);
+        switch (isa) {
+#if defined(PIXCONV_SSE2)
+        case i_ekAVX2:
+        case i_ekSSE2:
+            for (; i + step <= n; i += step, src += 16)
+                i_unpack16_sse2(src, index + i, bpp, msb);
+            break;
+#endif
+#if defined(PIXCONV_NEON)
+        case i_ekNEON:
+            for (; i + step <= n; i += step, src += 16)
+                i_unpack16_neon(src, index + i, bpp, msb);
+            break;
+#endif
+        default:
+            unref(step);
+            break;
+        }
+    }
+
+    i_unpack(src, index + i, n - i, bpp, msb);
+    return index;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_index_to_gray(const byte_t *src, byte_t *dest, const uint32_t n, const uint32_t bpp, const bool_t msb, const color_t *palette)
+{
+    byte_t index[i_BLOCK];
+    isa_t isa = i_isa();
+    uint32_t i;
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    cassert_no_null(palette);
+    for (i = 0; i < n; i += i_BLOCK)
+    {
+        uint32_t m = n - i < i_BLOCK ? n - i : i_BLOCK;
+        const byte_t *idx = i_indices(src + i / (8 / bpp), index, m, bpp, msb, isa);
+        i_lookup_gray(idx, dest + i, m, palette);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_index_to_rgb(const byte_t *src, byte_t *dest, const uint32_t n, const uint32_t bpp, const bool_t msb, const color_t *palette)
+{
+    byte_t index[i_BLOCK];
+    isa_t isa = i_isa();
+    uint32_t i;
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    cassert_no_null(palette);
+    for (i = 0; i < n; i += i_BLOCK)
+    {
+        uint32_t m = n - i < i_BLOCK ? n - i : i_BLOCK;
+        const byte_t *idx = i_indices(src + i / (8 / bpp), index, m, bpp, msb, isa);
+        i_lookup_rgb(idx, dest + i * 3, m, palette);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_index_to_rgba(const byte_t *src, byte_t *dest, const uint32_t n, const uint32_t bpp, const bool_t msb, const color_t *palette)
+{
+    byte_t index[i_BLOCK];
+    isa_t isa = i_isa();
+    uint32_t i;
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    cassert_no_null(palette);
+    for (i = 0; i < n; i += i_BLOCK)
+    {
+        uint32_t m = n - i < i_BLOCK ? n - i : i_BLOCK;
+        const byte_t *idx = i_indices(src + i / (8 / bpp), index, m, bpp, msb, isa);
+#if defined(PIXCONV_AVX2)
+        if (isa == i_ekAVX2)
+        {
+            i_lookup_rgba_avx2(idx, dest + i * 4, m, palette);
+            continue;
+        }
+#endif
+        i_lookup_rgba(idx, dest + i * 4, m, palette);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_to_float(const byte_t *src, real32_t *dest, const uint32_t n, const uint32_t channels)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_SSE2)
+    case i_ekAVX2:
+    case i_ekSSE2:
+        i_to_float_sse2(src, dest, n, channels);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_to_float_neon(src, dest, n, channels);
+        return;
+#endif
+    default:
+        i_to_float(src, dest, n, channels);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_from_float(const real32_t *src, byte_t *dest, const uint32_t n, const uint32_t channels)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_SSE2)
+    case i_ekAVX2:
+    case i_ekSSE2:
+        i_from_float_sse2(src, dest, n, channels);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_from_float_neon(src, dest, n, channels);
+        return;
+#endif
+    default:
+        i_from_float(src, dest, n, channels);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_hfilter(const real32_t *src, real32_t *dest, const uint32_t n, const uint32_t channels, const uint32_t *first, const uint32_t ntaps, const real32_t *weights)
+{
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    cassert_no_null(first);
+    cassert_no_null(weights);
+    if (channels >= 3)
+    {
+        switch (i_isa()) {
+#if defined(PIXCONV_SSE2)
+        case i_ekAVX2:
+        case i_ekSSE2:
+            i_hfilter_sse2(src, dest, n, channels, first, ntaps, weights);
+            return;
+#endif
+#if defined(PIXCONV_NEON)
+        case i_ekNEON:
+            i_hfilter_neon(src, dest, n, channels, first, ntaps, weights);
+            return;
+#endif
+        default:
+            break;
+        }
+    }
+
+    i_hfilter(src, dest, n, channels, first, ntaps, weights);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixconv_vfilter(const real32_t **rows, const real32_t *weights, const uint32_t ntaps, real32_t *dest, const uint32_t n)
+{
+    cassert_no_null(rows);
+    cassert_no_null(weights);
+    cassert_no_null(dest);
+    switch (i_isa()) {
+#if defined(PIXCONV_AVX2)
+    case i_ekAVX2:
+        i_vfilter_avx2(rows, weights, ntaps, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_SSE2)
+    case i_ekSSE2:
+        i_vfilter_sse2(rows, weights, ntaps, dest, n);
+        return;
+#endif
+#if defined(PIXCONV_NEON)
+    case i_ekNEON:
+        i_vfilter_neon(rows, weights, ntaps, dest, n);
+        return;
+#endif
+    default:
+        i_vfilter(rows, weights, ntaps, dest, 0, n);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+void pixconv_simd(const bool_t enable)
+{
+    i_SIMD = enable;
+}
+
+/*---------------------------------------------------------------------------*/
+
+const char_t *pixconv_isa(void)
+{
+    switch (i_isa()) {
+    case i_ekSCALAR:
+        return "scalar";
+    case i_ekSSE2:
+        return "sse2";
+    case i_ekAVX2:
+        return "avx2";
+    case i_ekNEON:
+        return "neon";
+    cassert_default();
+    }
+
+    return "";
+}
@@ -0,0 +1,47 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: pixconv.inl
+ *
+ */
+
+/* Pixel format conversion kernels */
+
+#include "draw2d.ixx"
+
+__EXTERN_C
+
+void pixconv_rgba_to_rgb(const byte_t *src, byte_t *dest, const uint32_t n);
+
+void pixconv_rgb_to_rgba(const byte_t *src, byte_t *dest, const uint32_t n);
+
+void pixconv_rgba_to_gray(const byte_t *src, byte_t *dest, const uint32_t n);
+
+void pixconv_rgb_to_gray(const byte_t *src, byte_t *dest, const uint32_t n);
+
+void pixconv_gray_to_rgba(const byte_t *src, byte_t *dest, const uint32_t n);
+
+void pixconv_gray_to_rgb(const byte_t *src, byte_t *dest, const uint32_t n);
+
+void pixconv_index_to_gray(const byte_t *src, byte_t *dest, const uint32_t n, const uint32_t bpp, const bool_t msb, const color_t *palette);
+
+void pixconv_index_to_rgb(const byte_t *src, byte_t *dest, const uint32_t n, const uint32_t bpp, const bool_t msb, const color_t *palette);
+
+void pixconv_index_to_rgba(const byte_t *src, byte_t *dest, const uint32_t n, const uint32_t bpp, const bool_t msb, const color_t *palette);
+
+void pixconv_to_float(const byte_t *src, real32_t *dest, const uint32_t n, const uint32_t channels);
+
+void pixconv_from_float(const real32_t *src, byte_t *dest, const uint32_t n, const uint32_t channels);
+
+void pixconv_hfilter(const real32_t *src, real32_t *dest, const uint32_t n, const uint32_t channels, const uint32_t *first, const uint32_t ntaps, const real32_t *weights);
+
+void pixconv_vfilter(const real32_t **rows, const real32_t *weights, const uint32_t ntaps, real32_t *dest, const uint32_t n);
+
+void pixconv_simd(const bool_t enable);
+
+const char_t *pixconv_isa(void);
+
+__END_C
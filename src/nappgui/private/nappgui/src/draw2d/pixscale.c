@@ -0,0 +1,639 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: pixscale.c
+ *
+ */
+
+/* Pixel resampling */
+
+#include "pixscale.inl"
+#include "pixconv.inl"
+#include "bmath.h"
+#include "bmem.h"
+#include "bthread.h"
+#include "cassert.h"
+#include "heap.h"
+
+/* Rows are split in bands of, at least, 'i_BAND_WORK' multiply-adds */
+#define i_THREADS       8
+#define i_BAND_WORK     (1 << 22)
+
+/* Subpixel positions of the affine sampling kernel */
+#define i_PHASES        64
+#define i_MAX_TAPS      6
+
+typedef enum _pass_t
+{
+    i_ekHPASS,
+    i_ekVPASS,
+    i_ekAFFINE
+} pass_t;
+
+typedef struct _contrib_t i_Contrib;
+typedef struct _resample_t i_Resample;
+typedef struct _band_t i_Band;
+
+/* Source window and weights of each destination pixel along one axis */
+struct _contrib_t
+{
+    uint32_t ntaps;
+    uint32_t *first;
+    real32_t *weights;
+};
+
+struct _resample_t
+{
+    const byte_t *src;
+    byte_t *dest;
+    uint32_t swidth;
+    uint32_t sheight;
+    uint32_t dwidth;
+    uint32_t dheight;
+    uint32_t channels;
+    pixfilter_t filter;
+    i_Contrib hcontrib;
+    i_Contrib vcontrib;
+    real32_t *inter;
+    const T2Df *inv;
+    real32_t background[4];
+    const byte_t *bbackground;
+    real32_t kernel[i_PHASES + 1][i_MAX_TAPS];
+    uint32_t ntaps;
+};
+
+struct _band_t
+{
+    i_Resample *resample;
+    pass_t pass;
+    uint32_t y0;
+    uint32_t y1;
+    real32_t *row;
+    const real32_t **rows;
+};
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE uint32_t i_nearest(const uint32_t i, const uint32_t ssize, const uint32_t dsize)
+{
+    return (uint32_t)(((2 * (uint64_t)i + 1) * ssize) / (2 * (uint64_t)dsize));
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixscale_nearest(const byte_t *src, const uint32_t swidth, const uint32_t sheight, byte_t *dest, const uint32_t dwidth, const uint32_t dheight, const uint32_t bytespp)
+{
+    uint32_t *xmap = heap_new_n(dwidth, uint32_t);
+    register uint32_t i, j;
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    cassert(bytespp == 1 || bytespp == 3 || bytespp == 4);
+
+    for (i = 0; i < dwidth; ++i)
+        xmap[i] = i_nearest(i, swidth, dwidth) * bytespp;
+
+    for (j = 0; j < dheight; ++j)
+    {
+        const byte_t *srow = src + (size_t)i_nearest(j, sheight, dheight) * swidth * bytespp;
+        switch (bytespp) {
+        case 1:
+            for (i = 0; i < dwidth; ++i)
+                dest[i] = srow[xmap[i]];
+            break;
+        case 3:
+            for (i = 0; i < dwidth; ++i)
+            {
+                dest[i * 3] = srow[xmap[i]];
+                dest[i * 3 + 1] = srow[xmap[i] + 1];
+                dest[i * 3 + 2] = srow[xmap[i] + 2];
+            }
+            break;
+        case 4:
+            for (i = 0; i < dwidth; ++i)
+                bmem_copy(dest + i * 4, srow + xmap[i], 4);
+            break;
+        }
+
+        dest += dwidth * bytespp;
+    }
+
+    heap_delete_n(&xmap, dwidth, uint32_t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static real32_t i_radius(const pixfilter_t filter)
+{
+    switch (filter) {
+    case ekPIXNEAREST:
+        return .5f;
+    case ekPIXBILINEAR:
+        return 1.f;
+    case ekPIXBICUBIC:
+        return 2.f;
+    case ekPIXLANCZOS:
+        return 3.f;
+    cassert_default();
+    }
+
+    return 1.f;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static real32_t i_kernel(const pixfilter_t filter, const real32_t x)
+{
+    real32_t ax = x < 0.f ? -x : x;
+    switch (filter) {
+    case ekPIXNEAREST:
+        return ax <= .5f ? 1.f : 0.f;
+
+    case ekPIXBILINEAR:
+        return ax < 1.f ? 1.f - ax : 0.f;
+
+    /* Catmull-Rom (a = -0.5) */
+    case ekPIXBICUBIC:
+        if (ax < 1.f)
+            return (1.5f * ax - 2.5f) * ax * ax + 1.f;
+        if (ax < 2.f)
+            return ((-.5f * ax + 2.5f) * ax - 4.f) * ax + 2.f;
+        return 0.f;
+
+    /* Lanczos3 */
+    case ekPIXLANCZOS:
+        if (ax < 1e-5f)
+            return 1.f;
+        if (ax < 3.f)
+        {
+            real32_t px = kBMATH_PIf * ax;
+            return 3.f * bmath_sinf(px) * bmath_sinf(px / 3.f) / (px * px);
+        }
+        return 0.f;
+
+    cassert_default();
+    }
+
+    return 0.f;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* When downscaling, the filter is stretched to cover all the source pixels */
+static void i_contrib(i_Contrib *contrib, const uint32_t ssize, const uint32_t dsize, const pixfilter_t filter)
+{
+    real32_t scale = (real32_t)ssize / (real32_t)dsize;
+    real32_t fscale = scale > 1.f ? scale : 1.f;
+    real32_t support = i_radius(filter) * fscale;
+    uint32_t ntaps = (uint32_t)bmath_ceilf(2.f * support) + 1;
+    register uint32_t i, k;
+
+    cassert_no_null(contrib);
+    if (ntaps > ssize)
+        ntaps = ssize;
+
+    contrib->ntaps = ntaps;
+    contrib->first = heap_new_n(dsize, uint32_t);
+    contrib->weights = heap_new_n(dsize * ntaps, real32_t);
+
+    for (i = 0; i < dsize; ++i)
+    {
+        real32_t center = ((real32_t)i + .5f) * scale - .5f;
+        real32_t *w = contrib->weights + i * ntaps;
+        real32_t sum = 0.f;
+        int32_t first = (int32_t)bmath_floorf(center - support) + 1;
+
+        /* The window is kept inside the image. Out of support taps weigh 0 */
+        if (first > (int32_t)(ssize - ntaps))
+            first = (int32_t)(ssize - ntaps);
+        if (first < 0)
+            first = 0;
+
+        contrib->first[i] = (uint32_t)first;
+        for (k = 0; k < ntaps; ++k)
+        {
+            w[k] = i_kernel(filter, ((real32_t)(first + (int32_t)k) - center) / fscale);
+            sum += w[k];
+        }
+
+        if (sum != 0.f)
+        {
+            for (k = 0; k < ntaps; ++k)
+                w[k] /= sum;
+        }
+        else
+        {
+            int32_t c = (int32_t)bmath_floorf(center + .5f) - first;
+            bmem_zero_n(w, ntaps, real32_t);
+            w[c < 0 ? 0 : (c >= (int32_t)ntaps ? ntaps - 1 : (uint32_t)c)] = 1.f;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_contrib_free(i_Contrib *contrib, const uint32_t dsize)
+{
+    cassert_no_null(contrib);
+    heap_delete_n(&contrib->weights, dsize * contrib->ntaps, real32_t);
+    heap_delete_n(&contrib->first, dsize, uint32_t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_hpass(const i_Band *band)
+{
+    const i_Resample *res = band->resample;
+    uint32_t sstride = res->swidth * res->channels;
+    uint32_t dstride = res->dwidth * res->channels;
+    register uint32_t j;
+
+    for (j = band->y0; j < band->y1; ++j)
+    {
+        pixconv_to_float(res->src + (size_t)j * sstride, band->row, res->swidth, res->channels);
+        pixconv_hfilter(band->row, res->inter + (size_t)j * dstride, res->dwidth, res->channels, res->hcontrib.first, res->hcontrib.ntaps, res->hcontrib.weights);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_vpass(const i_Band *band)
+{
+    const i_Resample *res = band->resample;
+    uint32_t ntaps = res->vcontrib.ntaps;
+    uint32_t dstride = res->dwidth * res->channels;
+    register uint32_t j, k;
+
+    for (j = band->y0; j < band->y1; ++j)
+    {
+        const real32_t *row = res->inter + (size_t)res->vcontrib.first[j] * dstride;
+        for (k = 0; k < ntaps; ++k)
+            band->rows[k] = row + (size_t)k * dstride;
+
+        pixconv_vfilter(band->rows, res->vcontrib.weights + j * ntaps, ntaps, band->row, dstride);
+        pixconv_from_float(band->row, res->dest + (size_t)j * dstride, res->dwidth, res->channels);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE void i_sample(const i_Resample *res, const int32_t x, const int32_t y, const real32_t w, real32_t *acc)
+{
+    register uint32_t c;
+    if (x >= 0 && y >= 0 && x < (int32_t)res->swidth && y < (int32_t)res->sheight)
+    {
+        const byte_t *p = res->src + ((size_t)y * res->swidth + (uint32_t)x) * res->channels;
+        if (res->channels == 4)
+        {
+            real32_t a = w * (real32_t)p[3] * (1.f / 255.f);
+            acc[0] += a * (real32_t)p[0];
+            acc[1] += a * (real32_t)p[1];
+            acc[2] += a * (real32_t)p[2];
+            acc[3] += w * (real32_t)p[3];
+        }
+        else
+        {
+            for (c = 0; c < res->channels; ++c)
+                acc[c] += w * (real32_t)p[c];
+        }
+    }
+    else
+    {
+        for (c = 0; c < res->channels; ++c)
+            acc[c] += w * res->background[c];
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE int32_t i_floor(const real32_t v)
+{
+    int32_t i = (int32_t)v;
+    return (real32_t)i > v ? i - 1 : i;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Sampling window fully inside the source image */
+static __INLINE void i_window(const i_Resample *res, const int32_t x, const int32_t y, const real32_t *wx, const real32_t *wy, real32_t *acc)
+{
+    uint32_t ntaps = res->ntaps;
+    size_t stride = (size_t)res->swidth * res->channels;
+    const byte_t *p = res->src + (size_t)y * stride + (size_t)x * res->channels;
+    register uint32_t k, l;
+
+    for (l = 0; l < ntaps; ++l, p += stride)
+    {
+        real32_t r[4] = {0.f, 0.f, 0.f, 0.f};
+        switch (res->channels) {
+        case 1:
+            for (k = 0; k < ntaps; ++k)
+                r[0] += wx[k] * (real32_t)p[k];
+            break;
+        case 3:
+            for (k = 0; k < ntaps; ++k)
+            {
+                r[0] += wx[k] * (real32_t)p[k * 3];
+                r[1] += wx[k] * (real32_t)p[k * 3 + 1];
+                r[2] += wx[k] * (real32_t)p[k * 3 + 2];
+            }
+            break;
+        case 4:
+            for (k = 0; k < ntaps; ++k)
+            {
+                real32_t a = wx[k] * (real32_t)p[k * 4 + 3];
+                real32_t pa = a * (1.f / 255.f);
+                r[0] += pa * (real32_t)p[k * 4];
+                r[1] += pa * (real32_t)p[k * 4 + 1];
+                r[2] += pa * (real32_t)p[k * 4 + 2];
+                r[3] += a;
+            }
+            break;
+        }
+
+        acc[0] += wy[l] * r[0];
+        acc[1] += wy[l] * r[1];
+        acc[2] += wy[l] * r[2];
+        acc[3] += wy[l] * r[3];
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_affine_nearest(const i_Band *band)
+{
+    const i_Resample *res = band->resample;
+    const T2Df *inv = res->inv;
+    uint32_t ch = res->channels;
+    register uint32_t i, j;
+
+    for (j = band->y0; j < band->y1; ++j)
+    {
+        byte_t *dest = res->dest + (size_t)j * res->dwidth * ch;
+        real32_t sx = inv->i.x * .5f + inv->j.x * ((real32_t)j + .5f) + inv->p.x;
+        real32_t sy = inv->i.y * .5f + inv->j.y * ((real32_t)j + .5f) + inv->p.y;
+        for (i = 0; i < res->dwidth; ++i, dest += ch)
+        {
+            int32_t x = i_floor(sx + (real32_t)i * inv->i.x);
+            int32_t y = i_floor(sy + (real32_t)i * inv->i.y);
+            if (x >= 0 && y >= 0 && x < (int32_t)res->swidth && y < (int32_t)res->sheight)
+                bmem_copy(dest, res->src + ((size_t)y * res->swidth + (uint32_t)x) * ch, ch);
+            else
+                bmem_copy(dest, res->bbackground, ch);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_affine(const i_Band *band)
+{
+    const i_Resample *res = band->resample;
+    const T2Df *inv = res->inv;
+    uint32_t ch = res->channels;
+    int32_t ntaps = (int32_t)res->ntaps;
+    int32_t offset = ntaps / 2 - 1;
+    int32_t xmax = (int32_t)res->swidth - ntaps;
+    int32_t ymax = (int32_t)res->sheight - ntaps;
+    register uint32_t i, j, k;
+    register int32_t l;
+
+    for (j = band->y0; j < band->y1; ++j)
+    {
+        real32_t *row = band->row;
+        real32_t sx = inv->i.x * .5f + inv->j.x * ((real32_t)j + .5f) + inv->p.x - .5f;
+        real32_t sy = inv->i.y * .5f + inv->j.y * ((real32_t)j + .5f) + inv->p.y - .5f;
+        for (i = 0; i < res->dwidth; ++i, row += ch)
+        {
+            real32_t px = sx + (real32_t)i * inv->i.x;
+            real32_t py = sy + (real32_t)i * inv->i.y;
+            int32_t fx = i_floor(px);
+            int32_t fy = i_floor(py);
+            int32_t x = fx - offset;
+            int32_t y = fy - offset;
+            const real32_t *wx = res->kernel[(uint32_t)((px - (real32_t)fx) * i_PHASES + .5f)];
+            const real32_t *wy = res->kernel[(uint32_t)((py - (real32_t)fy) * i_PHASES + .5f)];
+            real32_t acc[4] = {0.f, 0.f, 0.f, 0.f};
+
+            if (x >= 0 && y >= 0 && x <= xmax && y <= ymax)
+            {
+                i_window(res, x, y, wx, wy, acc);
+            }
+            else if (x + ntaps <= 0 || y + ntaps <= 0 || x >= (int32_t)res->swidth || y >= (int32_t)res->sheight)
+            {
+                bmem_copy_n(acc, res->background, 4, real32_t);
+            }
+            else
+            {
+                /* Image border: outer pixels take the background */
+                for (l = 0; l < ntaps; ++l)
+                {
+                    for (k = 0; k < (uint32_t)ntaps; ++k)
+                        i_sample(res, x + (int32_t)k, y + l, wx[k] * wy[l], acc);
+                }
+            }
+
+            for (k = 0; k < ch; ++k)
+                row[k] = acc[k];
+        }
+
+        pixconv_from_float(band->row, res->dest + (size_t)j * res->dwidth * ch, res->dwidth, ch);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_band_main(i_Band *band)
+{
+    cassert_no_null(band);
+    switch (band->pass) {
+    case i_ekHPASS:
+        i_hpass(band);
+        break;
+    case i_ekVPASS:
+        i_vpass(band);
+        break;
+    case i_ekAFFINE:
+        if (band->resample->filter == ekPIXNEAREST)
+            i_affine_nearest(band);
+        else
+            i_affine(band);
+        break;
+    cassert_default();
+    }
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_num_bands(const uint64_t work, const uint32_t rows)
+{
+    uint64_t n = work / i_BAND_WORK + 1;
+    if (n > i_THREADS)
+        n = i_THREADS;
+    if (n > rows)
+        n = rows;
+    return n > 0 ? (uint32_t)n : 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Band 0 runs in the calling thread */
+static void i_run(i_Band *bands, const uint32_t nbands, const pass_t pass, const uint32_t rows)
+{
+    Thread *threads[i_THREADS];
+    register uint32_t i;
+
+    cassert(nbands > 0 && nbands <= i_THREADS);
+    for (i = 0; i < nbands; ++i)
+    {
+        bands[i].pass = pass;
+        bands[i].y0 = (uint32_t)(((uint64_t)rows * i) / nbands);
+        bands[i].y1 = (uint32_t)(((uint64_t)rows * (i + 1)) / nbands);
+    }
+
+    for (i = 1; i < nbands; ++i)
+        threads[i] = bthread_create(i_band_main, &bands[i], i_Band);
+
+    i_band_main(bands);
+
+    for (i = 1; i < nbands; ++i)
+    {
+        bthread_wait(threads[i]);
+        bthread_close(&threads[i]);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_bands(i_Band *bands, const uint32_t nbands, i_Resample *res, const uint32_t rowsize, const uint32_t ntaps)
+{
+    register uint32_t i;
+    for (i = 0; i < nbands; ++i)
+    {
+        bands[i].resample = res;
+        bands[i].row = heap_new_n(rowsize, real32_t);
+        bands[i].rows = ntaps > 0 ? (const real32_t**)heap_new_n(ntaps, real32_t*) : NULL;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_bands_free(i_Band *bands, const uint32_t nbands, const uint32_t rowsize, const uint32_t ntaps)
+{
+    register uint32_t i;
+    for (i = 0; i < nbands; ++i)
+    {
+        heap_delete_n(&bands[i].row, rowsize, real32_t);
+        if (bands[i].rows != NULL)
+            heap_delete_n((real32_t***)&bands[i].rows, ntaps, real32_t*);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixscale_resample(const byte_t *src, const uint32_t swidth, const uint32_t sheight, byte_t *dest, const uint32_t dwidth, const uint32_t dheight, const uint32_t channels, const pixfilter_t filter)
+{
+    i_Resample res;
+    i_Band bands[i_THREADS];
+    uint32_t hbands, vbands, nbands, rowsize;
+    uint64_t isize;
+
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    cassert(channels == 1 || channels == 3 || channels == 4);
+    cassert(filter != ekPIXNEAREST);
+    bmem_zero(&res, i_Resample);
+    res.src = src;
+    res.dest = dest;
+    res.swidth = swidth;
+    res.sheight = sheight;
+    res.dwidth = dwidth;
+    res.dheight = dheight;
+    res.channels = channels;
+    res.filter = filter;
+    i_contrib(&res.hcontrib, swidth, dwidth, filter);
+    i_contrib(&res.vcontrib, sheight, dheight, filter);
+
+    /* Horizontal pass output: 'sheight' rows of 'dwidth' pixels */
+    isize = (uint64_t)sheight * dwidth * channels * sizeof(real32_t);
+    res.inter = (real32_t*)heap_malloc64(isize, "PixScaleRows");
+
+    /* One extra float, as 3-channel SIMD kernels read 4 floats per pixel */
+    rowsize = (swidth > dwidth ? swidth : dwidth) * channels + 1;
+    hbands = i_num_bands((uint64_t)sheight * dwidth * res.hcontrib.ntaps * channels, sheight);
+    vbands = i_num_bands((uint64_t)dheight * dwidth * res.vcontrib.ntaps * channels, dheight);
+    nbands = hbands > vbands ? hbands : vbands;
+    i_bands(bands, nbands, &res, rowsize, res.vcontrib.ntaps);
+    i_run(bands, hbands, i_ekHPASS, sheight);
+    i_run(bands, vbands, i_ekVPASS, dheight);
+    i_bands_free(bands, nbands, rowsize, res.vcontrib.ntaps);
+    heap_free64((byte_t**)&res.inter, isize, "PixScaleRows");
+    i_contrib_free(&res.vcontrib, dheight);
+    i_contrib_free(&res.hcontrib, dwidth);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_affine_kernel(i_Resample *res)
+{
+    register uint32_t i, k;
+    int32_t offset;
+    res->ntaps = 2 * (uint32_t)i_radius(res->filter);
+    offset = (int32_t)res->ntaps / 2 - 1;
+    cassert(res->ntaps <= i_MAX_TAPS);
+    for (i = 0; i <= i_PHASES; ++i)
+    {
+        real32_t f = (real32_t)i / (real32_t)i_PHASES;
+        real32_t sum = 0.f;
+        for (k = 0; k < res->ntaps; ++k)
+        {
+            res->kernel[i][k] = i_kernel(res->filter, (real32_t)((int32_t)k - offset) - f);
+            sum += res->kernel[i][k];
+        }
+
+        for (k = 0; k < res->ntaps; ++k)
+            res->kernel[i][k] /= sum;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void pixscale_affine(const byte_t *src, const uint32_t swidth, const uint32_t sheight, byte_t *dest, const uint32_t dwidth, const uint32_t dheight, const uint32_t channels, const T2Df *inv, const byte_t *background, const pixfilter_t filter)
+{
+    i_Resample res;
+    i_Band bands[i_THREADS];
+    uint32_t nbands, rowsize;
+
+    cassert_no_null(src);
+    cassert_no_null(dest);
+    cassert_no_null(inv);
+    cassert_no_null(background);
+    cassert(channels == 1 || channels == 3 || channels == 4);
+    bmem_zero(&res, i_Resample);
+    res.src = src;
+    res.dest = dest;
+    res.swidth = swidth;
+    res.sheight = sheight;
+    res.dwidth = dwidth;
+    res.dheight = dheight;
+    res.channels = channels;
+    res.filter = filter;
+    res.inv = inv;
+    res.bbackground = background;
+    pixconv_to_float(background, res.background, 1, channels);
+
+    if (filter != ekPIXNEAREST)
+        i_affine_kernel(&res);
+    else
+        res.ntaps = 1;
+
+    rowsize = dwidth * channels;
+    nbands = i_num_bands((uint64_t)dwidth * dheight * res.ntaps * res.ntaps * channels, dheight);
+    i_bands(bands, nbands, &res, rowsize, 0);
+    i_run(bands, nbands, i_ekAFFINE, dheight);
+    i_bands_free(bands, nbands, rowsize, 0);
+}
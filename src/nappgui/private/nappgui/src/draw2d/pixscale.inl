@@ -0,0 +1,23 @@
+/*
+ * NAppGUI Cross-platform C SDK
+ * 2015-2023 Francisco Garcia Collado
+ * MIT Licence
+ * https://nappgui.com/en/legal/license.html
+ *
+ * File: pixscale.inl
+ *
+ */
+
+/* Pixel resampling */
+
+#include "draw2d.ixx"
+
+__EXTERN_C
+
+void pixscale_nearest(const byte_t *src, const uint32_t swidth, const uint32_t sheight, byte_t *dest, const uint32_t dwidth, const uint32_t dheight, const uint32_t bytespp);
+
+void pixscale_resample(const byte_t *src, const uint32_t swidth, const uint32_t sheight, byte_t *dest, const uint32_t dwidth, const uint32_t dheight, const uint32_t channels, const pixfilter_t filter);
+
+void pixscale_affine(const byte_t *src, const uint32_t swidth, const uint32_t sheight, byte_t *dest, const uint32_t dwidth, const uint32_t dheight, const uint32_t channels, const T2Df *inv, const byte_t *background, const pixfilter_t filter);
+
+__END_C
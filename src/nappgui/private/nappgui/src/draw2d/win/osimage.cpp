@@ -179,12 +179,13 @@ OSImage *osimage_create_from_pixels(const uint32_t width, const uint32_t height,
 
 /*---------------------------------------------------------------------------*/
 
-OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size_in_bytes)
+OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size_in_bytes, const uint32_t num_frames)
 {
     IStream *stream = NULL;
     Gdiplus::Bitmap *bitmap = NULL;
 	cassert_no_null(data);
     cassert(size_in_bytes > 0);
+    unref(num_frames);
     stream = i_kSHCreateMemStream((const BYTE*)data, (UINT)size_in_bytes);
     bitmap = Gdiplus::Bitmap::FromStream(stream, TRUE);
     stream->Release();
@@ -198,6 +199,16 @@ OSImage *osimage_create_from_data(const byte_t *data, const uint32_t size_in_byt
 
 /*---------------------------------------------------------------------------*/
 
+OSImage *osimage_create_from_data_scaled(const byte_t *data, const uint32_t size_in_bytes, const uint32_t max_width, const uint32_t max_height)
+{
+    /* GDI+ has no reduced-size decoding. The caller scales the full image */
+    unref(max_width);
+    unref(max_height);
+    return osimage_create_from_data(data, size_in_bytes, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
 OSImage *osimage_create_from_type(const char_t *file_type)
 {
     WCHAR wextension[64];
@@ -19,6 +19,7 @@
 #include "bmem.h"
 #include "cassert.h"
 #include "heap.h"
+#include "log.h"
 
 /*---------------------------------------------------------------------------*/
 
@@ -829,37 +830,16 @@ bool_t col2d_obb_boxd(const OBB2Dd *obb, const Box2Dd *box, Col2Dd *col)
 }
 
 /*---------------------------------------------------------------------------*/
-//#include "bstd.h"
-//template<typename real>
-//static void i_dump(const SATPoly<real> *poly)
-//{
-//    register uint32_t i = 0;
-//    bstd_printf("Vertices: ");
-//    for (i = 0; i < poly->num_vertices; ++i)
-//    {
-//        bstd_printf("(%.2f,%2.f)", poly->vertex[i].x, poly->vertex[i].y);
-//        if (i < poly->num_vertices - 1)
-//            bstd_printf(", ");
-//    }
-//
-//    bstd_printf("\n");
-//    bstd_printf("Axis: ");
-//    for (i = 0; i < poly->num_axis; ++i)
-//    {
-//        bstd_printf("(%.2f,%2.f)", poly->axis[i].x, poly->axis[i].y);
-//        if (i < poly->num_axis - 1)
-//            bstd_printf(", ");
-//    }
-//
-//    bstd_printf("\n");
-//    bstd_printf("Limits: ");
-//    for (i = 0; i < poly->num_axis; ++i)
-//    {
-//        bstd_printf("Min: %.2f Max:%2.f\n", poly->min[i], poly->max[i]);
-//    }
-//
-//    bstd_printf("\n");
-//}
+template<typename real>
+static void i_dump(const SATPoly<real> *poly)
+{
+    uint32_t i = 0;
+    for (i = 0; i < poly->num_vertices; ++i)
+        log_trace("col2d", "Vertex %u: (%.2f,%.2f)", i, (real64_t)poly->vertex[i].x, (real64_t)poly->vertex[i].y);
+
+    for (i = 0; i < poly->num_axis; ++i)
+        log_trace("col2d", "Axis %u: (%.2f,%.2f) Min: %.2f Max: %.2f", i, (real64_t)poly->axis[i].x, (real64_t)poly->axis[i].y, (real64_t)poly->min[i], (real64_t)poly->max[i]);
+}
 
 /*---------------------------------------------------------------------------*/
 
@@ -870,6 +850,12 @@ static bool_t i_sat_sat(const SATPoly<real> *sat1, const SATPoly<real> *sat2, Co
     cassert_no_null(sat2);
     unref(col);
 
+    if (log_enabled(ekLOG_TRACE, "col2d") == TRUE)
+    {
+        i_dump<real>(sat1);
+        i_dump<real>(sat2);
+    }
+
     if (i_sat_overlaps<real>(sat1->axis, sat1->min, sat1->max, sat1->num_axis, sat2->vertex, sat2->num_vertices) == FALSE)
         return FALSE;
 
@@ -19,6 +19,7 @@
 #include "t2d.hpp"
 #include "cassert.h"
 #include "heap.h"
+#include "log.h"
 
 /*---------------------------------------------------------------------------*/
 
@@ -149,7 +150,7 @@ static __INLINE bool_t i_angle_equal(const real a1, const real a2)
 }
 
 /*---------------------------------------------------------------------------*/
-//#include "bstd.h"
+
 template<typename real>
 static OBB2D<real>* i_from_points(const V2D<real> *p, const uint32_t n)
 {
@@ -281,7 +282,7 @@ static OBB2D<real>* i_from_points(const V2D<real> *p, const uint32_t n)
             //else
             //    deviation1 = 0;
 
-            //bstd_printf("sigma0: %.2f, sigma1: %.2f", deviation0, deviation1);
+            log_trace("obb2d", "varianze0: %.2f, varianze1: %.2f", (real64_t)varianze0, (real64_t)varianze1);
             //if (deviation0 > deviation1)
             if (varianze0 > varianze1)
             {
@@ -343,7 +344,7 @@ static OBB2D<real>* i_from_points(const V2D<real> *p, const uint32_t n)
 
         height = BMath<real>::sqrt(max_sqdist);
         width = BMath<real>::max(BMath<real>::abs(min_proj), BMath<real>::abs(max_proj));
-        //bstd_printf(" width: %.2f, height: %.2f\n", width, height);
+        log_trace("obb2d", "width: %.2f, height: %.2f", (real64_t)width, (real64_t)height);
         width *= 2;
         height *= 2;
     }
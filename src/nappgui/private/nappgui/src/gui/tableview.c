@@ -27,6 +27,7 @@
 #include "font.h"
 #include "gui.h"
 #include "heap.h"
+#include "log.h"
 #include "s2d.h"
 #include "strings.h"
 #include "types.h"
@@ -344,14 +345,11 @@ static void i_OnDraw(TableView *view, Event *e)
         edrow = min_u32(nr, strow + vrows);
         i_visible_cols(data->columns, freeze_width, data->freeze_col_id, stx, (uint32_t)p->width, &stcol, &edcol, &xmin);
 
-        /*
-        #include "bstd.h"
-        bstd_printf("X: %d Y: %d W: %d H: %d\n", (uint32_t)p->x, (uint32_t)p->y, (uint32_t)p->width, (uint32_t)p->height);
-        bstd_printf("CX: %d CY: %d\n", data->control_width, data->control_height);
-        bstd_printf("AX: %d AY: %d\n", data->content_width, data->content_height);
-        bstd_printf("StRow: %d EdRow: %d\n", strow, edrow);
-        bstd_printf("StCol: %d EdCol: %d X:%d\n", stcol, edcol, xmin);
-        */
+        log_trace("tableview", "X: %d Y: %d W: %d H: %d", (int32_t)p->x, (int32_t)p->y, (int32_t)p->width, (int32_t)p->height);
+        log_trace("tableview", "CX: %u CY: %u", data->control_width, data->control_height);
+        log_trace("tableview", "AX: %u AY: %u", data->content_width, data->content_height);
+        log_trace("tableview", "StRow: %u EdRow: %u", strow, edrow);
+        log_trace("tableview", "StCol: %u EdCol: %u X:%u", stcol, edcol, xmin);
 
         y = head_height + (strow * data->row_height);
 
@@ -13,7 +13,9 @@
 #include "httpreq.h"
 #include "oshttpreq.inl"
 #include "url.h"
+#include "arrpt.h"
 #include "arrst.h"
+#include "bmem.h"
 #include "bsocket.h"
 #include "cassert.h"
 #include "heap.h"
@@ -28,6 +30,7 @@ struct _http_t
     String *host_name;
     uint32_t host_ip;
     uint16_t host_port;
+    bool_t secure;
     ierror_t error;
     uint32_t rcode;
     String *rprotocol;
@@ -35,6 +38,37 @@ struct _http_t
     ArrSt(Field) *headers;
 };
 
+typedef struct _poolreq_t i_PoolReq;
+
+struct _poolreq_t
+{
+    String *host;
+    uint16_t port;
+    bool_t secure;
+    bool_t use_get;
+    String *path;
+    byte_t *content;
+    uint32_t size;
+    Stream *body;
+    void *data;
+    FPtr_http_done func_done;
+    Http *http;
+};
+
+DeclPt(i_PoolReq);
+DeclPt(Http);
+
+struct _httppool_t
+{
+    OSHttpMulti *multi;
+    uint32_t max_active;
+    uint32_t qhead;
+    ArrPt(i_PoolReq) *queue;
+    ArrPt(i_PoolReq) *active;
+    ArrPt(Http) *idle;
+    ArrSt(Field) *headers;
+};
+
 /*---------------------------------------------------------------------------*/
 
 static void i_remove_field(Field *field)
@@ -66,6 +100,7 @@ static Http *i_create(const char_t *host, const uint16_t port, const bool_t secu
     http->oshttp = oshttp_create(host, port, secure);
     http->host_name = str_c(host);
     http->host_port = port;
+    http->secure = secure;
     http->error = ENUM_MAX(ierror_t);
     http->rcode = UINT32_MAX;
     http->rmsg = NULL;
@@ -151,6 +186,25 @@ bool_t http_post(Http *http, const char_t *path, const byte_t *data, const uint3
 
 /*---------------------------------------------------------------------------*/
 
+bool_t http_post_stream(Http *http, const char_t *path, Stream *body, ierror_t *error)
+{
+    cassert_no_null(http);
+    i_clear_response(http);
+    oshttp_post_stream(http->oshttp, path, body, TRUE, &http->error);
+    ptr_assign(error, http->error);
+    return http->error == ekIOK ? TRUE : FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void http_response_chunks_imp(Http *http, void *data, FPtr_http_chunk func_chunk)
+{
+    cassert_no_null(http);
+    oshttp_body_chunks(http->oshttp, data, func_chunk);
+}
+
+/*---------------------------------------------------------------------------*/
+
 static bool_t i_response(Http *http)
 {
     cassert_no_null(http);
@@ -355,14 +409,17 @@ Stream *http_dget(const char_t *url, uint32_t *result, ierror_t *error)
     if (http != NULL)
     {
         String *res = url_resource(uurl);
+        /* The body is received directly in the result stream */
+        stm = stm_memory(2048);
+        oshttp_body(http->oshttp, stm);
         if (http_get(http, tc(res), NULL, 0, error) == TRUE)
         {
             if (result != NULL)
                 *result = http_response_status(http);
-
-            stm = stm_memory(2048);
-            if (http_response_body(http, stm, error) == FALSE)
-                stm_close(&stm);
+        }
+        else
+        {
+            stm_close(&stm);
         }
 
         http_destroy(&http);
@@ -412,3 +469,245 @@ bool_t http_exists(const char_t *url)
     url_destroy(&uurl);
     return exists;
 }
+
+/*---------------------------------------------------------------------------*/
+
+HttpPool *http_pool_create(const uint32_t max_active, const uint32_t max_host_conns)
+{
+    HttpPool *pool = heap_new(HttpPool);
+    cassert(max_active > 0);
+    pool->multi = oshttp_multi_create(max_host_conns);
+    pool->max_active = max_active;
+    pool->qhead = 0;
+    pool->queue = arrpt_create(i_PoolReq);
+    pool->active = arrpt_create(i_PoolReq);
+    pool->idle = arrpt_create(Http);
+    pool->headers = arrst_create(Field);
+    return pool;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_destroy_req(i_PoolReq **req)
+{
+    cassert_no_null(req);
+    cassert_no_null(*req);
+    str_destroy(&(*req)->host);
+    str_destroy(&(*req)->path);
+    if ((*req)->content != NULL)
+        heap_free(&(*req)->content, (*req)->size, "HttpPoolContent");
+    heap_delete(req, i_PoolReq);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void http_pool_destroy(HttpPool **pool)
+{
+    cassert_no_null(pool);
+    cassert_no_null(*pool);
+
+    /* Unfinished requests are cancelled without notification */
+    arrpt_foreach(req, (*pool)->active, i_PoolReq)
+        oshttp_multi_remove((*pool)->multi, req->http->oshttp);
+        http_destroy(&req->http);
+    arrpt_end();
+
+    {
+        uint32_t i, n = arrpt_size((*pool)->queue, i_PoolReq);
+        for (i = (*pool)->qhead; i < n; ++i)
+        {
+            i_PoolReq *req = arrpt_get((*pool)->queue, i, i_PoolReq);
+            i_destroy_req(&req);
+        }
+    }
+
+    arrpt_destroy(&(*pool)->queue, NULL, i_PoolReq);
+    arrpt_destroy(&(*pool)->active, i_destroy_req, i_PoolReq);
+    arrpt_destroy(&(*pool)->idle, http_destroy, Http);
+    arrst_destroy(&(*pool)->headers, i_remove_field, Field);
+    oshttp_multi_destroy(&(*pool)->multi);
+    heap_delete(pool, HttpPool);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void http_pool_add_header(HttpPool *pool, const char_t *name, const char_t *value)
+{
+    Field *field = NULL;
+    cassert_no_null(pool);
+    field = arrst_new(pool->headers, Field);
+    field->name = str_c(name);
+    field->value = str_c(value);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_pool_request(HttpPool *pool, const char_t *url, const bool_t use_get, const byte_t *content, const uint32_t size, Stream *body, void *data, FPtr_http_done func_done)
+{
+    Url *uurl = url_parse(url);
+    const char_t *sh = url_scheme(uurl);
+    bool_t secure = FALSE;
+    i_PoolReq *req = NULL;
+    cassert_no_null(pool);
+    cassert_no_nullf(func_done);
+
+    if (str_equ_nocase(sh, "https") == TRUE)
+    {
+        secure = TRUE;
+    }
+    else if (str_equ_nocase(sh, "http") == FALSE)
+    {
+        url_destroy(&uurl);
+        return FALSE;
+    }
+
+    req = heap_new0(i_PoolReq);
+    req->host = str_c(url_host(uurl));
+    req->port = url_port(uurl);
+    if (req->port == UINT16_MAX)
+        req->port = secure == TRUE ? 443 : 80;
+    req->secure = secure;
+    req->use_get = use_get;
+    req->path = url_resource(uurl);
+    if (size > 0)
+    {
+        cassert_no_null(content);
+        req->content = heap_malloc(size, "HttpPoolContent");
+        req->size = size;
+        bmem_copy(req->content, content, size);
+    }
+
+    req->body = body;
+    req->data = data;
+    req->func_done = func_done;
+    arrpt_append(pool->queue, req, i_PoolReq);
+    url_destroy(&uurl);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t http_pool_get_imp(HttpPool *pool, const char_t *url, Stream *body, void *data, FPtr_http_done func_done)
+{
+    return i_pool_request(pool, url, TRUE, NULL, 0, body, data, func_done);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t http_pool_post_imp(HttpPool *pool, const char_t *url, const byte_t *content, const uint32_t size, Stream *body, void *data, FPtr_http_done func_done)
+{
+    return i_pool_request(pool, url, FALSE, content, size, body, data, func_done);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Reuse an idle handle (and its connection) to the same host */
+static Http *i_pool_http(HttpPool *pool, const i_PoolReq *req)
+{
+    Http *http = NULL;
+    cassert_no_null(pool);
+    cassert_no_null(req);
+    arrpt_foreach(ihttp, pool->idle, Http)
+        if (ihttp->host_port == req->port
+            && ihttp->secure == req->secure
+            && str_equ(ihttp->host_name, tc(req->host)) == TRUE)
+        {
+            http = ihttp;
+            arrpt_delete(pool->idle, ihttp_i, NULL, Http);
+            break;
+        }
+    arrpt_end();
+
+    if (http == NULL)
+        http = i_create(tc(req->host), req->port, req->secure);
+
+    oshttp_clear_headers(http->oshttp);
+    arrst_foreach(field, pool->headers, Field)
+        oshttp_add_header(http->oshttp, tc(field->name), tc(field->value));
+    arrst_end();
+    return http;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_pool_start(HttpPool *pool)
+{
+    cassert_no_null(pool);
+    while (pool->qhead < arrpt_size(pool->queue, i_PoolReq)
+        && arrpt_size(pool->active, i_PoolReq) < pool->max_active)
+    {
+        /* Queue positions before 'qhead' are already in 'active' */
+        i_PoolReq *req = arrpt_get(pool->queue, pool->qhead, i_PoolReq);
+        pool->qhead += 1;
+        req->http = i_pool_http(pool, req);
+        i_clear_response(req->http);
+        arrpt_append(pool->active, req, i_PoolReq);
+
+        if (req->body != NULL)
+            oshttp_body(req->http->oshttp, req->body);
+
+        oshttp_multi_add(pool->multi, req->http->oshttp, req->use_get, tc(req->path), req->content, req->size, TRUE);
+    }
+
+    /* All queued requests started */
+    if (pool->qhead == arrpt_size(pool->queue, i_PoolReq))
+    {
+        arrpt_clear(pool->queue, NULL, i_PoolReq);
+        pool->qhead = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_pool_done(HttpPool *pool, OSHttp *oshttp, const ierror_t error)
+{
+    i_PoolReq *req = NULL;
+    cassert_no_null(pool);
+    arrpt_foreach(areq, pool->active, i_PoolReq)
+        if (areq->http->oshttp == oshttp)
+        {
+            req = areq;
+            arrpt_delete(pool->active, areq_i, NULL, i_PoolReq);
+            break;
+        }
+    arrpt_end();
+
+    cassert_no_null(req);
+    req->http->error = error;
+    req->func_done(req->data, req->http, error);
+
+    /* The handle keeps its connection alive for the next request */
+    arrpt_append(pool->idle, req->http, Http);
+    if (arrpt_size(pool->idle, Http) > pool->max_active)
+        arrpt_delete(pool->idle, 0, http_destroy, Http);
+
+    req->http = NULL;
+    i_destroy_req(&req);
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t http_pool_run(HttpPool *pool, const uint32_t timeout_ms)
+{
+    OSHttp *oshttp = NULL;
+    ierror_t error = ekIOK;
+    cassert_no_null(pool);
+    i_pool_start(pool);
+
+    if (arrpt_size(pool->active, i_PoolReq) > 0)
+        oshttp_multi_perform(pool->multi, timeout_ms);
+
+    /* Callbacks can submit new requests */
+    while ((oshttp = oshttp_multi_done(pool->multi, &error)) != NULL)
+        i_pool_done(pool, oshttp, error);
+
+    i_pool_start(pool);
+    return arrpt_size(pool->active, i_PoolReq) + arrpt_size(pool->queue, i_PoolReq) - pool->qhead;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void http_pool_wait(HttpPool *pool)
+{
+    while (http_pool_run(pool, 100) > 0) {}
+}
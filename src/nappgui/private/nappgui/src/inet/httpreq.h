@@ -29,6 +29,12 @@ _inet_api bool_t http_get(Http *http, const char_t *path, const byte_t *data, co
 
 _inet_api bool_t http_post(Http *http, const char_t *path, const byte_t *data, const uint32_t size, ierror_t *error);
 
+/* macOS: the body stream is read into memory before sending the request */
+_inet_api bool_t http_post_stream(Http *http, const char_t *path, Stream *body, ierror_t *error);
+
+/* macOS: the whole body is delivered in a single call once the response completes */
+_inet_api void http_response_chunks_imp(Http *http, void *data, FPtr_http_chunk func_chunk);
+
 _inet_api uint32_t http_response_status(const Http *http);
 
 _inet_api const char_t *http_response_protocol(const Http *http);
@@ -49,4 +55,39 @@ _inet_api Stream *http_dget(const char_t *url, uint32_t *result, ierror_t *error
 
 _inet_api bool_t http_exists(const char_t *url);
 
+_inet_api HttpPool *http_pool_create(const uint32_t max_active, const uint32_t max_host_conns);
+
+_inet_api void http_pool_destroy(HttpPool **pool);
+
+_inet_api void http_pool_add_header(HttpPool *pool, const char_t *name, const char_t *value);
+
+_inet_api bool_t http_pool_get_imp(HttpPool *pool, const char_t *url, Stream *body, void *data, FPtr_http_done func_done);
+
+_inet_api bool_t http_pool_post_imp(HttpPool *pool, const char_t *url, const byte_t *content, const uint32_t size, Stream *body, void *data, FPtr_http_done func_done);
+
+_inet_api uint32_t http_pool_run(HttpPool *pool, const uint32_t timeout_ms);
+
+_inet_api void http_pool_wait(HttpPool *pool);
+
 __END_C
+
+#define http_response_chunks(http, data, func_chunk, type)\
+    (\
+        (void)(data == (type*)data),\
+        FUNC_CHECK_HTTP_CHUNK(func_chunk, type),\
+        http_response_chunks_imp(http, (void*)data, (FPtr_http_chunk)func_chunk)\
+    )
+
+#define http_pool_get(pool, url, body, data, func_done, type)\
+    (\
+        (void)(data == (type*)data),\
+        FUNC_CHECK_HTTP_DONE(func_done, type),\
+        http_pool_get_imp(pool, url, body, (void*)data, (FPtr_http_done)func_done)\
+    )
+
+#define http_pool_post(pool, url, content, size, body, data, func_done, type)\
+    (\
+        (void)(data == (type*)data),\
+        FUNC_CHECK_HTTP_DONE(func_done, type),\
+        http_pool_post_imp(pool, url, content, size, body, (void*)data, (FPtr_http_done)func_done)\
+    )
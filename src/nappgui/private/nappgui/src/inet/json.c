@@ -14,17 +14,32 @@
 #include "dbind.h"
 #include "dbindh.h"
 #include "arrpt.h"
+#include "arrst.h"
 #include "bmath.h"
 #include "bmem.h"
 #include "bstd.h"
 #include "base64.h"
 #include "cassert.h"
+#include "event.h"
 #include "heap.h"
 #include "log.h"
+#include "ptr.h"
 #include "stream.h"
 #include "strings.h"
 #include "unicode.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JSON_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define JSON_NEON
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 typedef enum _jtoken_t
 {
     i_ekTRUE,
@@ -41,18 +56,58 @@ typedef enum _jtoken_t
     i_ekUNKNOWN
 } jtoken_t;
 
+typedef enum _rstate_t
+{
+    i_ekSTATE_VALUE,
+    i_ekSTATE_VALUE_OR_END,
+    i_ekSTATE_KEY,
+    i_ekSTATE_KEY_OR_END,
+    i_ekSTATE_COLON,
+    i_ekSTATE_AFTER_VALUE,
+    i_ekSTATE_ERROR
+} rstate_t;
+
 typedef struct i_parser_t i_Parser;
 
+/* Scanner over the stream read buffer (window) */
 struct i_parser_t
 {
     Stream *stm;
     jtoken_t token;
-    bool_t minus;
     uint32_t col;
     uint32_t row;
     uint32_t lexsize;
     const char_t *lexeme;
     char_t number[128];
+    bool_t integer;
+    bool_t negative;
+    bool_t inrange;
+    uint64_t uvalue;
+    real64_t rvalue;
+    const byte_t *wstart;
+    const byte_t *cur;
+    const byte_t *end;
+    uint64_t wpos;
+    uint64_t lpos;
+    char_t *text;
+    uint32_t textsize;
+    const DBind *each;
+    Listener *listener;
+};
+
+struct _jsonreader_t
+{
+    i_Parser parser;
+    rstate_t state;
+    jevent_t event;
+    ArrSt(bool_t) *stack;
+};
+
+struct _jsonwriter_t
+{
+    Stream *stm;
+    bool_t key;
+    ArrSt(uint32_t) *stack;
 };
 
 /*---------------------------------------------------------------------------*/
@@ -88,120 +143,719 @@ static bool_t i_error(const bool_t cond, const bool_t fatal, i_Parser *parser, c
 
 /*---------------------------------------------------------------------------*/
 
-static void i_new_token(i_Parser *parser)
+static __INLINE uint32_t i_ctz(const uint32_t mask)
+{
+    cassert(mask != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return (uint32_t)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+    {
+        unsigned long i;
+        _BitScanForward(&i, mask);
+        return (uint32_t)i;
+    }
+#else
+    {
+        uint32_t i = 0;
+        while ((mask & (1u << i)) == 0)
+            i += 1;
+        return i;
+    }
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(JSON_NEON)
+static __INLINE uint32_t i_neon_mask(const uint8x16_t v)
+{
+    static const uint8_t i_BITS[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t m = vandq_u8(v, vld1q_u8(i_BITS));
+    uint8x8_t r = vpadd_u8(vget_low_u8(m), vget_high_u8(m));
+    r = vpadd_u8(r, r);
+    r = vpadd_u8(r, r);
+    return (uint32_t)vget_lane_u16(vreinterpret_u16_u8(r), 0);
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+/* 16 bits mask: 1 for bytes that are not JSON whitespace. 'nl' for '\n' */
+#if defined(JSON_SSE2) || defined(JSON_NEON)
+static __INLINE uint32_t i_space_mask(const byte_t *data, uint32_t *nl)
+{
+#if defined(JSON_SSE2)
+    __m128i v = _mm_loadu_si128((const __m128i*)data);
+    __m128i n = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+    __m128i w = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))), _mm_or_si128(n, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    *nl = (uint32_t)_mm_movemask_epi8(n);
+    return (uint32_t)(~_mm_movemask_epi8(w)) & 0xFFFF;
+#else
+    uint8x16_t v = vld1q_u8(data);
+    uint8x16_t n = vceqq_u8(v, vdupq_n_u8('\n'));
+    uint8x16_t w = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))), vorrq_u8(n, vceqq_u8(v, vdupq_n_u8('\r'))));
+    *nl = i_neon_mask(n);
+    return (~i_neon_mask(w)) & 0xFFFF;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* 16 bits mask: 1 for string terminators '"' or escapes '\\' */
+static __INLINE uint32_t i_string_mask(const byte_t *data)
+{
+#if defined(JSON_SSE2)
+    __m128i v = _mm_loadu_si128((const __m128i*)data);
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+    return (uint32_t)_mm_movemask_epi8(m);
+#else
+    uint8x16_t v = vld1q_u8(data);
+    uint8x16_t m = vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\')));
+    return i_neon_mask(m);
+#endif
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+/* The whole window is consumed and the next one requested */
+static bool_t i_fill(i_Parser *parser)
+{
+    uint32_t size = 0;
+    cassert_no_null(parser);
+    if (parser->end != parser->wstart)
+    {
+        stm_skip(parser->stm, (uint32_t)(parser->end - parser->wstart));
+        parser->wpos += (uint64_t)(parser->end - parser->wstart);
+    }
+
+    parser->wstart = stm_peek(parser->stm, &size);
+    parser->cur = parser->wstart;
+    parser->end = parser->wstart + size;
+    return (bool_t)(size > 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Stream position after the last scanned token */
+static void i_sync(i_Parser *parser)
+{
+    cassert_no_null(parser);
+    if (parser->cur != parser->wstart)
+    {
+        stm_skip(parser->stm, (uint32_t)(parser->cur - parser->wstart));
+        parser->wpos += (uint64_t)(parser->cur - parser->wstart);
+        parser->wstart = parser->cur;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE int i_peek_byte(i_Parser *parser)
+{
+    if (parser->cur == parser->end && i_fill(parser) == FALSE)
+        return -1;
+    return (int)*parser->cur;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_text_append(i_Parser *parser, const byte_t *data, const uint32_t size)
 {
-    ltoken_t token;
     cassert_no_null(parser);
-    token = stm_read_token(parser->stm);
-    parser->row = stm_token_col(parser->stm);
-    parser->col = stm_token_row(parser->stm);
-    parser->lexeme = stm_token_lexeme(parser->stm, &parser->lexsize);
-    switch (token) {
-    case ekTIDENT:
-        if (str_equ_c(parser->lexeme, "true") == TRUE)
-            parser->token = i_ekTRUE;
-        else if (str_equ_c(parser->lexeme, "false") == TRUE)
-            parser->token = i_ekFALSE;
-        else if (str_equ_c(parser->lexeme, "null") == TRUE)
-            parser->token = i_ekNULL;
+    if (parser->lexsize + size + 1 > parser->textsize)
+    {
+        uint32_t nsize = parser->textsize * 2;
+        while (parser->lexsize + size + 1 > nsize)
+            nsize *= 2;
+        parser->text = (char_t*)heap_realloc((byte_t*)parser->text, parser->textsize, nsize, "JsonText");
+        parser->textsize = nsize;
+    }
+
+    bmem_copy((byte_t*)parser->text + parser->lexsize, data, size);
+    parser->lexsize += size;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_skip_spaces(i_Parser *parser)
+{
+    for (;;)
+    {
+        register const byte_t *c = parser->cur;
+        const byte_t *e = parser->end;
+
+#if defined(JSON_SSE2) || defined(JSON_NEON)
+        while (e - c >= 16)
+        {
+            uint32_t nl;
+            uint32_t mask = i_space_mask(c, &nl);
+            uint32_t n = mask != 0 ? i_ctz(mask) : 16;
+            if (n < 16)
+                nl &= (1u << n) - 1;
+
+            while (nl != 0)
+            {
+                uint32_t i = i_ctz(nl);
+                parser->row += 1;
+                parser->lpos = parser->wpos + (uint64_t)(c - parser->wstart) + i + 1;
+                nl &= nl - 1;
+            }
+
+            c += n;
+            if (n < 16)
+            {
+                parser->cur = c;
+                return;
+            }
+        }
+#endif
+
+        while (c < e)
+        {
+            if (*c == ' ' || *c == '\t' || *c == '\r')
+            {
+                c += 1;
+            }
+            else if (*c == '\n')
+            {
+                c += 1;
+                parser->row += 1;
+                parser->lpos = parser->wpos + (uint64_t)(c - parser->wstart);
+            }
+            else
+            {
+                parser->cur = c;
+                return;
+            }
+        }
+
+        parser->cur = c;
+        if (i_fill(parser) == FALSE)
+            return;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_scan_hex(i_Parser *parser, uint32_t *cp)
+{
+    uint32_t i;
+    *cp = 0;
+    for (i = 0; i < 4; ++i)
+    {
+        int c = i_peek_byte(parser);
+        if (c >= '0' && c <= '9')
+            *cp = (*cp << 4) | (uint32_t)(c - '0');
+        else if (c >= 'a' && c <= 'f')
+            *cp = (*cp << 4) | (uint32_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')
+            *cp = (*cp << 4) | (uint32_t)(c - 'A' + 10);
         else
-            parser->token = i_ekUNKNOWN;
+            return FALSE;
+        parser->cur += 1;
+    }
+
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_scan_escape(i_Parser *parser)
+{
+    int c = i_peek_byte(parser);
+    byte_t out[8];
+    uint32_t n = 1;
+    if (c < 0)
+        return FALSE;
+
+    parser->cur += 1;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+        out[0] = (byte_t)c;
+        break;
+    case 'b':
+        out[0] = '\b';
+        break;
+    case 'f':
+        out[0] = '\f';
+        break;
+    case 'n':
+        out[0] = '\n';
+        break;
+    case 'r':
+        out[0] = '\r';
         break;
+    case 't':
+        out[0] = '\t';
+        break;
+    case 'u':
+    {
+        uint32_t cp;
+        if (i_scan_hex(parser, &cp) == FALSE)
+            return FALSE;
 
-    case ekTINTEGER:
-    case ekTREAL:
-        parser->token = i_ekNUMBER;
-        if (parser->minus == TRUE)
+        /* UTF-16 surrogate pair */
+        if (cp >= 0xD800 && cp <= 0xDBFF)
         {
-            bstd_sprintf(parser->number, sizeof(parser->number), "-%s", parser->lexeme);
-            parser->minus = FALSE;
+            uint32_t lo;
+            if (i_peek_byte(parser) != '\\')
+                return FALSE;
+            parser->cur += 1;
+            if (i_peek_byte(parser) != 'u')
+                return FALSE;
+            parser->cur += 1;
+            if (i_scan_hex(parser, &lo) == FALSE || lo < 0xDC00 || lo > 0xDFFF)
+                return FALSE;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
         }
+
+        if (cp == 0 || unicode_valid(cp) == FALSE)
+            return FALSE;
+
+        n = unicode_to_char(cp, (char_t*)out, ekUTF8);
+        break;
+    }
+    default:
+        return FALSE;
+    }
+
+    i_text_append(parser, out, n);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Opening '"' already consumed. Lexeme is unescaped in parser->text */
+static bool_t i_scan_string(i_Parser *parser)
+{
+    parser->lexsize = 0;
+    for (;;)
+    {
+        register const byte_t *c = parser->cur;
+        const byte_t *e = parser->end;
+
+#if defined(JSON_SSE2) || defined(JSON_NEON)
+        while (e - c >= 16)
+        {
+            uint32_t mask = i_string_mask(c);
+            if (mask != 0)
+            {
+                c += i_ctz(mask);
+                break;
+            }
+            c += 16;
+        }
+#endif
+
+        while (c < e && *c != '"' && *c != '\\')
+            c += 1;
+
+        if (c != parser->cur)
+            i_text_append(parser, parser->cur, (uint32_t)(c - parser->cur));
+        parser->cur = c;
+
+        if (c == e)
+        {
+            if (i_fill(parser) == FALSE)
+                return FALSE;
+        }
+        else if (*c == '"')
+        {
+            parser->cur += 1;
+            parser->text[parser->lexsize] = '\0';
+            return TRUE;
+        }
+        else
+        {
+            parser->cur += 1;
+            if (i_scan_escape(parser) == FALSE)
+                return FALSE;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static const real64_t i_POW10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+/* Short numbers stay in 'number', long ones spill into the 'text' buffer */
+static void i_number_push(i_Parser *parser, uint32_t *n, const char_t c)
+{
+    cassert_no_null(n);
+    if (*n < sizeof32(parser->number) - 1)
+    {
+        parser->number[*n] = c;
+    }
+    else
+    {
+        if (*n == sizeof32(parser->number) - 1)
+        {
+            parser->lexsize = 0;
+            i_text_append(parser, (const byte_t*)parser->number, *n);
+        }
+
+        i_text_append(parser, (const byte_t*)&c, 1);
+    }
+
+    *n += 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_number_lexeme(i_Parser *parser, const uint32_t n)
+{
+    if (n < sizeof32(parser->number))
+    {
+        parser->number[n] = '\0';
+        parser->lexeme = parser->number;
+        parser->lexsize = n;
+    }
+    else
+    {
+        parser->text[parser->lexsize] = '\0';
+        parser->lexeme = parser->text;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Numbers are converted here, text is kept for error messages and filters */
+static bool_t i_scan_number_imp(i_Parser *parser, uint32_t *n)
+{
+    uint32_t ndigits = 0, nfrac = 0;
+    int32_t exp10 = 0, expv = 0;
+    bool_t expneg = FALSE;
+    uint64_t mant = 0;
+    int c = i_peek_byte(parser);
+
+    parser->integer = TRUE;
+    parser->negative = FALSE;
+    parser->inrange = TRUE;
+
+    if (c == '-')
+    {
+        parser->negative = TRUE;
+        i_number_push(parser, n, '-');
+        parser->cur += 1;
+        c = i_peek_byte(parser);
+    }
+
+    /* Integer part */
+    while (c >= '0' && c <= '9')
+    {
+        i_number_push(parser, n, (char_t)c);
+        if (ndigits < 19)
+            mant = mant * 10 + (uint64_t)(c - '0');
+        else if (ndigits == 19 && mant <= (UINT64_MAX - (uint64_t)(c - '0')) / 10)
+            mant = mant * 10 + (uint64_t)(c - '0');
         else
+            exp10 += 1, parser->inrange = FALSE;
+        ndigits += 1;
+        parser->cur += 1;
+        c = i_peek_byte(parser);
+    }
+
+    if (ndigits == 0)
+        return FALSE;
+
+    /* Fraction */
+    if (c == '.')
+    {
+        parser->integer = FALSE;
+        i_number_push(parser, n, '.');
+        parser->cur += 1;
+        c = i_peek_byte(parser);
+        while (c >= '0' && c <= '9')
+        {
+            i_number_push(parser, n, (char_t)c);
+            if (mant < (UINT64_MAX - 9) / 10)
+            {
+                mant = mant * 10 + (uint64_t)(c - '0');
+                exp10 -= 1;
+            }
+            nfrac += 1;
+            parser->cur += 1;
+            c = i_peek_byte(parser);
+        }
+
+        if (nfrac == 0)
+            return FALSE;
+    }
+
+    /* Exponent */
+    if (c == 'e' || c == 'E')
+    {
+        uint32_t nexp = 0;
+        parser->integer = FALSE;
+        i_number_push(parser, n, (char_t)c);
+        parser->cur += 1;
+        c = i_peek_byte(parser);
+        if (c == '-' || c == '+')
         {
-            str_copy_c(parser->number, sizeof(parser->number), parser->lexeme);
+            expneg = (bool_t)(c == '-');
+            i_number_push(parser, n, (char_t)c);
+            parser->cur += 1;
+            c = i_peek_byte(parser);
         }
+
+        while (c >= '0' && c <= '9')
+        {
+            i_number_push(parser, n, (char_t)c);
+            if (expv < 100000)
+                expv = expv * 10 + (c - '0');
+            nexp += 1;
+            parser->cur += 1;
+            c = i_peek_byte(parser);
+        }
+
+        if (nexp == 0)
+            return FALSE;
+
+        exp10 += expneg ? -expv : expv;
+    }
+
+    i_number_lexeme(parser, *n);
+    parser->uvalue = mant;
+
+    /* Exact conversion (mantissa < 2^53 and exact power of 10), else libc */
+    if (parser->inrange == TRUE && mant < ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22)
+    {
+        real64_t v = (real64_t)mant;
+        if (exp10 < 0)
+            v /= i_POW10[-exp10];
+        else
+            v *= i_POW10[exp10];
+        parser->rvalue = parser->negative ? -v : v;
+    }
+    else
+    {
+        parser->rvalue = str_to_r64(parser->lexeme, NULL);
+    }
+
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_scan_number(i_Parser *parser)
+{
+    uint32_t n = 0;
+    bool_t ok = i_scan_number_imp(parser, &n);
+    i_number_lexeme(parser, n);
+    return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_scan_literal(i_Parser *parser, const char_t *literal)
+{
+    int c;
+    while (*literal != '\0')
+    {
+        if (i_peek_byte(parser) != (int)(byte_t)*literal)
+            return FALSE;
+        parser->cur += 1;
+        literal += 1;
+    }
+
+    /* 'truex' is not 'true' */
+    c = i_peek_byte(parser);
+    return (bool_t)!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_');
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE void i_punct(i_Parser *parser, const jtoken_t token, const char_t *lexeme)
+{
+    parser->cur += 1;
+    parser->token = token;
+    parser->lexeme = lexeme;
+    parser->lexsize = 1;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_new_token(i_Parser *parser)
+{
+    int c;
+    cassert_no_null(parser);
+    i_skip_spaces(parser);
+    parser->col = (uint32_t)(parser->wpos + (uint64_t)(parser->cur - parser->wstart) - parser->lpos) + 1;
+    c = i_peek_byte(parser);
+    switch (c) {
+    case '{':
+        i_punct(parser, i_ekOPEN_OBJECT, "{");
         break;
 
-    case ekTSTRING:
-        cassert(parser->lexeme[0] == '\"');
-        cassert(parser->lexeme[parser->lexsize - 1] == '\"');
-        ((char_t*)parser->lexeme)[parser->lexsize - 1] = '\0';
-        parser->lexeme += 1;
-        parser->lexsize -= 2;
-        parser->token = i_ekSTRING;
+    case '}':
+        i_punct(parser, i_ekCLOSE_OBJECT, "}");
         break;
 
-    case ekTOPENBRAC:
-        parser->token = i_ekOPEN_ARRAY;
+    case '[':
+        i_punct(parser, i_ekOPEN_ARRAY, "[");
         break;
 
-    case ekTCLOSBRAC:
-        parser->token = i_ekCLOSE_ARRAY;
+    case ']':
+        i_punct(parser, i_ekCLOSE_ARRAY, "]");
         break;
 
-    case ekTOPENCURL:
-        parser->token = i_ekOPEN_OBJECT;
+    case ',':
+        i_punct(parser, i_ekCOMMA, ",");
         break;
 
-    case ekTCLOSCURL:
-        parser->token = i_ekCLOSE_OBJECT;
+    case ':':
+        i_punct(parser, i_ekCOLON, ":");
         break;
 
-    case ekTCOMMA:
-        parser->token = i_ekCOMMA;
+    case '"':
+        parser->cur += 1;
+        parser->token = i_scan_string(parser) == TRUE ? i_ekSTRING : i_ekUNKNOWN;
+        parser->text[parser->lexsize] = '\0';
+        parser->lexeme = parser->text;
         break;
 
-    case ekTCOLON:
-        parser->token = i_ekCOLON;
+    case 't':
+        parser->token = i_scan_literal(parser, "true") == TRUE ? i_ekTRUE : i_ekUNKNOWN;
+        parser->lexeme = "true";
+        parser->lexsize = 4;
         break;
 
-    case ekTMINUS:
-        cassert(parser->minus == FALSE);
-        parser->minus = TRUE;
-        i_new_token(parser);
+    case 'f':
+        parser->token = i_scan_literal(parser, "false") == TRUE ? i_ekFALSE : i_ekUNKNOWN;
+        parser->lexeme = "false";
+        parser->lexsize = 5;
+        break;
+
+    case 'n':
+        parser->token = i_scan_literal(parser, "null") == TRUE ? i_ekNULL : i_ekUNKNOWN;
+        parser->lexeme = "null";
+        parser->lexsize = 4;
+        break;
+
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        parser->token = i_scan_number(parser) == TRUE ? i_ekNUMBER : i_ekUNKNOWN;
         break;
 
-    case ekTSLCOM:
-    case ekTMLCOM:
-    case ekTSPACE:
-    case ekTEOL:
-    case ekTLESS:
-    case ekTGREAT:
-    case ekTPERIOD:
-    case ekTSCOLON:
-    case ekTOPENPAR:
-    case ekTCLOSPAR:
-    case ekTPLUS:
-    case ekTASTERK:
-    case ekTEQUALS:
-    case ekTDOLLAR:
-    case ekTPERCENT:
-    case ekTPOUND:
-    case ekTAMPER:
-    case ekTAPOST:
-    case ekTQUOTE:
-    case ekTCIRCUM:
-    case ekTTILDE:
-    case ekTEXCLA:
-    case ekTQUEST:
-    case ekTVLINE:
-    case ekTSLASH:
-    case ekTBSLASH:
-    case ekTAT:
-    case ekTOCTAL:
-    case ekTHEX:
-    case ekTUNDEF:
-    case ekTCORRUP:
-    case ekTEOF:
-    case ekTRESERVED:
     default:
         parser->token = i_ekUNKNOWN;
+        parser->lexeme = "";
+        parser->lexsize = 0;
         break;
     }
 }
 
 /*---------------------------------------------------------------------------*/
 
+static void i_parser_init(i_Parser *parser, Stream *stm)
+{
+    cassert_no_null(parser);
+    parser->stm = stm;
+    stm_skip_bom(parser->stm);
+    parser->token = i_ekUNKNOWN;
+    parser->col = 0;
+    parser->row = 1;
+    parser->lexeme = NULL;
+    parser->lexsize = 0;
+    parser->number[0] = '\0';
+    parser->integer = FALSE;
+    parser->negative = FALSE;
+    parser->inrange = FALSE;
+    parser->uvalue = 0;
+    parser->rvalue = 0;
+    parser->wstart = NULL;
+    parser->cur = NULL;
+    parser->end = NULL;
+    parser->wpos = 0;
+    parser->lpos = 0;
+    parser->textsize = 256;
+    parser->text = (char_t*)heap_malloc(parser->textsize, "JsonText");
+    parser->each = NULL;
+    parser->listener = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_parser_finish(i_Parser *parser)
+{
+    cassert_no_null(parser);
+    i_sync(parser);
+    heap_free((byte_t**)&parser->text, parser->textsize, "JsonText");
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Out of range or non-integer numbers are clamped (non-fatal error) */
+static bool_t i_number_int(const i_Parser *parser, const int64_t min, const int64_t max, int64_t *value)
+{
+    /* -min without overflow */
+    uint64_t umin = (uint64_t)(-(min + 1)) + 1;
+    cassert_no_null(parser);
+    cassert_no_null(value);
+    if (parser->integer == TRUE && parser->inrange == TRUE)
+    {
+        if (parser->negative == TRUE)
+        {
+            if (parser->uvalue <= umin)
+            {
+                *value = (int64_t)(0 - parser->uvalue);
+                return TRUE;
+            }
+        }
+        else if (parser->uvalue <= (uint64_t)max)
+        {
+            *value = (int64_t)parser->uvalue;
+            return TRUE;
+        }
+    }
+
+    if (parser->rvalue <= (real64_t)min)
+        *value = min;
+    else if (parser->rvalue >= (real64_t)max)
+        *value = max;
+    else
+        *value = (int64_t)parser->rvalue;
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_number_uint(const i_Parser *parser, const uint64_t max, uint64_t *value)
+{
+    cassert_no_null(parser);
+    cassert_no_null(value);
+    if (parser->integer == TRUE && parser->inrange == TRUE && parser->uvalue <= max)
+    {
+        if (parser->negative == FALSE || parser->uvalue == 0)
+        {
+            *value = parser->uvalue;
+            return TRUE;
+        }
+    }
+
+    if (parser->rvalue <= 0)
+        *value = 0;
+    else if (parser->rvalue >= (real64_t)max)
+        *value = max;
+    else
+        *value = (uint64_t)parser->rvalue;
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
 static bool_t i_jump_array(i_Parser *parser)
 {
     bool_t ok = i_jump_value(parser);
@@ -305,7 +959,6 @@ static bool_t i_jump_value(i_Parser *parser)
     cassert_default();
     }
 
-    parser->minus = FALSE;
     return i_error(FALSE, TRUE, parser, "Fatal Json parsing error");
 }
 
@@ -357,6 +1010,57 @@ static bool_t i_parse_array(i_Parser *parser, dtype_t type, const char_t *subtyp
 
 /*---------------------------------------------------------------------------*/
 
+/* ArrSt elements are parsed in a single reused buffer and sent to listener */
+static bool_t i_parse_each(i_Parser *parser, const DBind *dbind, dtype_t type, const char_t *subtype, const uint16_t esize)
+{
+    byte_t *obj = heap_malloc((uint32_t)esize, "JsonEachElem");
+    bool_t more = TRUE;
+    bool_t ok = TRUE;
+    EvJsonElem params;
+    cassert_no_null(parser);
+    params.type = dbind_stbind_type(dbind_get_stbind(dbind));
+    params.mname = dbind_name(dbind);
+    params.etype = subtype;
+    params.index = 0;
+    params.elem = obj;
+
+    for (;;)
+    {
+        bool_t parsed;
+        dbind_init_imp(obj, subtype);
+        parsed = i_parse_value(parser, NULL, type, subtype, obj);
+        if (parsed == TRUE && more == TRUE)
+            listener_event(parser->listener, ekEJSONELEM, NULL, &params, &more, void, EvJsonElem, bool_t);
+        dbind_remove_imp(obj, subtype);
+
+        if (parsed == FALSE)
+        {
+            /* Empty array */
+            if (params.index == 0 && parser->token == i_ekCLOSE_ARRAY)
+                ok = TRUE;
+            else
+                ok = i_error(FALSE, TRUE, parser, "Unexpected token in ArrSt");
+            break;
+        }
+
+        params.index += 1;
+        i_new_token(parser);
+        if (parser->token == i_ekCLOSE_ARRAY)
+            break;
+
+        if (parser->token != i_ekCOMMA)
+        {
+            ok = i_error(FALSE, TRUE, parser, "Comma expected in ArrSt");
+            break;
+        }
+    }
+
+    heap_free(&obj, (uint32_t)esize, "JsonEachElem");
+    return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+
 static bool_t i_parse_arrptr(i_Parser *parser, const char_t *subtype, Array *array)
 {
     void *obj = i_create_type(parser, subtype);
@@ -453,93 +1157,101 @@ static bool_t i_parse_value(i_Parser *parser, const DBind *dbind, dtype_t type,
         switch (type) {
         case ekDTYPE_INT8:
         {
-            bool_t err;
-            *((int8_t*)object) = str_to_i8(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to int8_t");
+            int64_t v;
+            bool_t ok = i_number_int(parser, INT8_MIN, INT8_MAX, &v);
+            *((int8_t*)object) = (int8_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to int8_t");
         }
 
         case ekDTYPE_INT16:
         {
-            bool_t err;
-            *((int16_t*)object) = str_to_i16(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to int16_t");
+            int64_t v;
+            bool_t ok = i_number_int(parser, INT16_MIN, INT16_MAX, &v);
+            *((int16_t*)object) = (int16_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to int16_t");
         }
 
         case ekDTYPE_INT32:
         {
-            bool_t err;
-            *((int32_t*)object) = str_to_i32(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to int32_t");
+            int64_t v;
+            bool_t ok = i_number_int(parser, INT32_MIN, INT32_MAX, &v);
+            *((int32_t*)object) = (int32_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to int32_t");
         }
 
         case ekDTYPE_INT64:
         {
-            bool_t err;
-            *((int64_t*)object) = str_to_i64(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to int64_t");
+            int64_t v;
+            bool_t ok = i_number_int(parser, INT64_MIN, INT64_MAX, &v);
+            *((int64_t*)object) = (int64_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to int64_t");
         }
 
         case ekDTYPE_UINT8:
         {
-            bool_t err;
-            *((uint8_t*)object) = str_to_u8(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to uint8_t");
+            uint64_t v;
+            bool_t ok = i_number_uint(parser, UINT8_MAX, &v);
+            *((uint8_t*)object) = (uint8_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to uint8_t");
         }
 
         case ekDTYPE_UINT16:
         {
-            bool_t err;
-            *((uint16_t*)object) = str_to_u16(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to uint16_t");
+            uint64_t v;
+            bool_t ok = i_number_uint(parser, UINT16_MAX, &v);
+            *((uint16_t*)object) = (uint16_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to uint16_t");
         }
 
         case ekDTYPE_UINT32:
         {
-            bool_t err;
-            *((uint32_t*)object) = str_to_u32(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to uint32_t");
+            uint64_t v;
+            bool_t ok = i_number_uint(parser, UINT32_MAX, &v);
+            *((uint32_t*)object) = (uint32_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to uint32_t");
         }
 
         case ekDTYPE_UINT64:
         {
-            bool_t err;
-            *((uint64_t*)object) = str_to_u64(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to uint64_t");
+            uint64_t v;
+            bool_t ok = i_number_uint(parser, UINT64_MAX, &v);
+            *((uint64_t*)object) = (uint64_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to uint64_t");
         }
 
+        /* Keep the scanner value, re-parsing the lexeme drops exponents */
         case ekDTYPE_REAL32:
             if (dbind != NULL)
             {
-                *((real32_t*)object) = dbind_string_to_real32(dbind, *((real32_t*)object), parser->number);
+                *((real32_t*)object) = dbind_real32(dbind, (real32_t)parser->rvalue);
                 return TRUE;
             }
             else
             {
-                bool_t err;
-                *((real32_t*)object) = str_to_r32(parser->number, &err);
-                return i_error(!err, FALSE, parser, "Cannot cast to real32_t");
+                *((real32_t*)object) = (real32_t)parser->rvalue;
+                return TRUE;
             }
             break;
 
         case ekDTYPE_REAL64:
             if (dbind != NULL)
             {
-                *((real64_t*)object) = dbind_string_to_real64(dbind, *((real64_t*)object), parser->number);
+                *((real64_t*)object) = dbind_real64(dbind, parser->rvalue);
                 return TRUE;
             }
             else
             {
-                bool_t err;
-                *((real64_t*)object) = str_to_r64(parser->number, &err);
-                return i_error(!err, FALSE, parser, "Cannot cast to real64_t");
+                *((real64_t*)object) = parser->rvalue;
+                return TRUE;
             }
             break;
 
         case ekDTYPE_ENUM:
         {
-            bool_t err;
-            *((int32_t*)object) = str_to_i32(parser->number, 10, &err);
-            return i_error(!err, FALSE, parser, "Cannot cast to enum");
+            int64_t v;
+            bool_t ok = i_number_int(parser, INT32_MIN, INT32_MAX, &v);
+            *((int32_t*)object) = (int32_t)v;
+            return i_error(ok, FALSE, parser, "Cannot cast to enum");
         }
 
         case ekDTYPE_BOOL:
@@ -667,6 +1379,8 @@ static bool_t i_parse_value(i_Parser *parser, const DBind *dbind, dtype_t type,
             cassert(array_size(*(Array**)object) == 0);
             dtype = dbind_data_type(subtype, NULL, &size);
             cassert(size == array_esize(*(Array**)object));
+            if (dbind != NULL && dbind == parser->each)
+                return i_parse_each(parser, dbind, dtype, subtype, size);
             return i_parse_array(parser, dtype, subtype, *((Array**)object));
         }
         else if (type == ekDTYPE_ARRPTR)
@@ -686,10 +1400,11 @@ static bool_t i_parse_value(i_Parser *parser, const DBind *dbind, dtype_t type,
         }
         else if (type == ekDTYPE_OBJECT_PTR)
         {
-            if (dbind_stbind(subtype) != NULL)
+            const StBind *stbind = dbind_stbind(subtype);
+            if (stbind != NULL)
             {
                 cassert(*(void**)object == NULL);
-                *(void**)object = dbind_create_imp(subtype);
+                *(void**)object = dbind_stbind_create(stbind);
                 return i_parse_object(parser, subtype, *(void**)object);
             }
         }
@@ -717,10 +1432,10 @@ static bool_t i_parse_value(i_Parser *parser, const DBind *dbind, dtype_t type,
 static bool_t i_parse_object(i_Parser *parser, const char_t *subtype, void *object)
 {
     bool_t comma_state = FALSE;
+    const StBind *mstbind = dbind_stbind(subtype);
     /* For all object members */
     for (;;)
     {
-        const StBind *mstbind = NULL;
         const DBind *mbind = NULL;
 
         /* '}' */
@@ -750,7 +1465,6 @@ static bool_t i_parse_object(i_Parser *parser, const char_t *subtype, void *obje
         if (parser->token != i_ekSTRING)
             return i_error(FALSE, TRUE, parser, "Expected Json 'string' (member name)");
 
-        mstbind = dbind_stbind(subtype);
         mbind = dbind_stbind_find(mstbind, parser->lexeme);
         /*if (_dbind_member(subtype, parser->lexeme, &moffset, &mtype, &msubtype) == FALSE)
         {
@@ -950,26 +1664,30 @@ void *json_read_imp(Stream *stm, const JsonOpts *opts, const char_t *type)
 {
     i_Parser parser;
     void *obj = NULL;
-    unref(opts);
-    parser.stm = stm;
-    stm_token_escapes(parser.stm, TRUE);
-    stm_skip_bom(parser.stm);
-    parser.col = 0;
-    parser.row = 0;
-    parser.lexeme = NULL;
-    parser.lexsize = 0;
-    parser.minus = FALSE;
-    obj = i_create_type(&parser, type);
+    i_parser_init(&parser, stm);
+
+    /* The whole object graph is allocated in the region */
+    if (opts != NULL && opts->arena != NULL)
+    {
+        heap_arena_push(opts->arena);
+        obj = i_create_type(&parser, type);
+        heap_arena_pop(opts->arena);
+    }
+    else
+    {
+        obj = i_create_type(&parser, type);
+    }
+
+    i_parser_finish(&parser);
     return obj;
 }
 
 /*---------------------------------------------------------------------------*/
 
-static void i_write_string(Stream *stm, const String *str)
+static void i_write_cstr(Stream *stm, const char_t *cstr)
 {
-    if (str != NULL)
+    if (cstr != NULL)
     {
-        const char_t *cstr = tc(str);
         uint32_t cp = unicode_to_u32(cstr, ekUTF8);
         stm_writef(stm, "\"");
         while (cp != 0)
@@ -1005,6 +1723,13 @@ static void i_write_string(Stream *stm, const String *str)
 
 /*---------------------------------------------------------------------------*/
 
+static void i_write_string(Stream *stm, const String *str)
+{
+    i_write_cstr(stm, str != NULL ? tc(str) : NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
 static void i_write_array(Stream *stm, const Array *array, const char_t *type)
 {
     if (array != NULL)
@@ -1202,11 +1927,11 @@ static void i_write_type(Stream *stm, dtype_t type, const char_t *subtype, const
             break;
 
         case ekDTYPE_REAL32:
-            stm_printf(stm, "%f", *(real32_t*)data);
+            stm_printf(stm, "%.9g", (real64_t)*(real32_t*)data);
             break;
 
         case ekDTYPE_REAL64:
-            stm_printf(stm, "%f", *(real64_t*)data);
+            stm_printf(stm, "%.17g", *(real64_t*)data);
             break;
 
         case ekDTYPE_ENUM:
@@ -1283,3 +2008,528 @@ void json_destopt_imp(void **data, const char_t *type)
     dbind_destopt_imp((byte_t**)data, type);
 }
 
+
+/*---------------------------------------------------------------------------*/
+
+void *json_read_each_imp(Stream *stm, const JsonOpts *opts, const char_t *type, const char_t *mname, Listener *listener)
+{
+    i_Parser parser;
+    void *obj = NULL;
+    const StBind *stbind = dbind_stbind(type);
+    cassert_msg(stbind != NULL, "Json: Unknown struct type.");
+    i_parser_init(&parser, stm);
+    parser.each = dbind_stbind_find(stbind, mname);
+    parser.listener = listener;
+    cassert_msg(parser.each != NULL, "Json: Unknown struct member.");
+    cassert_msg(dbind_type(parser.each) == ekDTYPE_ARRAY, "Json: Member is not an ArrSt.");
+
+    if (opts != NULL && opts->arena != NULL)
+    {
+        heap_arena_push(opts->arena);
+        obj = i_create_type(&parser, type);
+        heap_arena_pop(opts->arena);
+    }
+    else
+    {
+        obj = i_create_type(&parser, type);
+    }
+
+    i_parser_finish(&parser);
+    listener_destroy(&listener);
+    return obj;
+}
+
+/*---------------------------------------------------------------------------*/
+
+JsonReader *json_reader_create(Stream *stm)
+{
+    JsonReader *reader = heap_new0(JsonReader);
+    i_parser_init(&reader->parser, stm);
+    reader->state = i_ekSTATE_VALUE;
+    reader->event = ekJSON_EOF;
+    reader->stack = arrst_create(bool_t);
+    return reader;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_reader_destroy(JsonReader **reader)
+{
+    cassert_no_null(reader);
+    cassert_no_null(*reader);
+    i_parser_finish(&(*reader)->parser);
+    arrst_destroy(&(*reader)->stack, NULL, bool_t);
+    heap_delete(reader, JsonReader);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static jevent_t i_reader_error(JsonReader *reader, const char_t *errmsg)
+{
+    cassert_no_null(reader);
+    i_error(FALSE, TRUE, &reader->parser, errmsg);
+    reader->state = i_ekSTATE_ERROR;
+    return ekJSON_ERROR;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Stack elements: TRUE for objects, FALSE for arrays */
+static jevent_t i_reader_close(JsonReader *reader, const bool_t object)
+{
+    uint32_t n = arrst_size(reader->stack, bool_t);
+    if (n == 0 || *arrst_get_const(reader->stack, n - 1, bool_t) != object)
+        return i_reader_error(reader, "Unexpected Json closing token");
+
+    arrst_pop(reader->stack, NULL, bool_t);
+    reader->state = i_ekSTATE_AFTER_VALUE;
+    return object == TRUE ? ekJSON_END_OBJECT : ekJSON_END_ARRAY;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static jevent_t i_reader_value(JsonReader *reader)
+{
+    switch (reader->parser.token) {
+    case i_ekTRUE:
+        reader->state = i_ekSTATE_AFTER_VALUE;
+        return ekJSON_TRUE;
+    case i_ekFALSE:
+        reader->state = i_ekSTATE_AFTER_VALUE;
+        return ekJSON_FALSE;
+    case i_ekNULL:
+        reader->state = i_ekSTATE_AFTER_VALUE;
+        return ekJSON_NULL;
+    case i_ekNUMBER:
+        reader->state = i_ekSTATE_AFTER_VALUE;
+        return ekJSON_NUMBER;
+    case i_ekSTRING:
+        reader->state = i_ekSTATE_AFTER_VALUE;
+        return ekJSON_STRING;
+    case i_ekOPEN_OBJECT:
+        arrst_append(reader->stack, TRUE, bool_t);
+        reader->state = i_ekSTATE_KEY_OR_END;
+        return ekJSON_BEGIN_OBJECT;
+    case i_ekOPEN_ARRAY:
+        arrst_append(reader->stack, FALSE, bool_t);
+        reader->state = i_ekSTATE_VALUE_OR_END;
+        return ekJSON_BEGIN_ARRAY;
+    case i_ekCLOSE_ARRAY:
+    case i_ekCLOSE_OBJECT:
+    case i_ekCOMMA:
+    case i_ekCOLON:
+    case i_ekUNKNOWN:
+        return i_reader_error(reader, "Unexpected Json token (value expected)");
+    cassert_default();
+    }
+
+    return i_reader_error(reader, "Fatal Json parsing error");
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* After a value: ',' or the container end. FALSE if no more tokens are expected */
+static bool_t i_reader_sep(JsonReader *reader, jevent_t *event)
+{
+    uint32_t n = arrst_size(reader->stack, bool_t);
+    cassert_no_null(event);
+    if (n == 0)
+    {
+        *event = ekJSON_EOF;
+        return FALSE;
+    }
+
+    i_new_token(&reader->parser);
+    if (reader->parser.token == i_ekCOMMA)
+    {
+        bool_t object = *arrst_get_const(reader->stack, n - 1, bool_t);
+        reader->state = object == TRUE ? i_ekSTATE_KEY : i_ekSTATE_VALUE;
+        return TRUE;
+    }
+
+    if (reader->parser.token == i_ekCLOSE_OBJECT)
+        *event = i_reader_close(reader, TRUE);
+    else if (reader->parser.token == i_ekCLOSE_ARRAY)
+        *event = i_reader_close(reader, FALSE);
+    else
+        *event = i_reader_error(reader, "Comma expected");
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_reader_colon(JsonReader *reader)
+{
+    cassert(reader->state == i_ekSTATE_COLON);
+    i_new_token(&reader->parser);
+    if (reader->parser.token != i_ekCOLON)
+    {
+        i_reader_error(reader, "Expected Json ':' (object member)");
+        return FALSE;
+    }
+
+    reader->state = i_ekSTATE_VALUE;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static jevent_t i_reader_next(JsonReader *reader)
+{
+    jevent_t event = ekJSON_ERROR;
+    cassert_no_null(reader);
+
+    if (reader->state == i_ekSTATE_AFTER_VALUE)
+    {
+        if (i_reader_sep(reader, &event) == FALSE)
+            return event;
+    }
+
+    switch (reader->state) {
+    case i_ekSTATE_VALUE:
+        i_new_token(&reader->parser);
+        return i_reader_value(reader);
+
+    case i_ekSTATE_VALUE_OR_END:
+        i_new_token(&reader->parser);
+        if (reader->parser.token == i_ekCLOSE_ARRAY)
+            return i_reader_close(reader, FALSE);
+        return i_reader_value(reader);
+
+    case i_ekSTATE_KEY:
+    case i_ekSTATE_KEY_OR_END:
+        i_new_token(&reader->parser);
+        if (reader->parser.token == i_ekCLOSE_OBJECT && reader->state == i_ekSTATE_KEY_OR_END)
+            return i_reader_close(reader, TRUE);
+
+        if (reader->parser.token != i_ekSTRING)
+            return i_reader_error(reader, "Expected Json 'string' (member name)");
+
+        /* ':' is read later, the key lexeme lives in the stream token buffer */
+        reader->state = i_ekSTATE_COLON;
+        return ekJSON_KEY;
+
+    case i_ekSTATE_COLON:
+        if (i_reader_colon(reader) == FALSE)
+            return ekJSON_ERROR;
+        i_new_token(&reader->parser);
+        return i_reader_value(reader);
+
+    case i_ekSTATE_ERROR:
+        return ekJSON_ERROR;
+
+    case i_ekSTATE_AFTER_VALUE:
+    cassert_default();
+    }
+
+    return i_reader_error(reader, "Fatal Json parsing error");
+}
+
+/*---------------------------------------------------------------------------*/
+
+jevent_t json_reader_next(JsonReader *reader)
+{
+    cassert_no_null(reader);
+    reader->event = i_reader_next(reader);
+    return reader->event;
+}
+
+/*---------------------------------------------------------------------------*/
+
+jevent_t json_reader_event(const JsonReader *reader)
+{
+    cassert_no_null(reader);
+    return reader->event;
+}
+
+/*---------------------------------------------------------------------------*/
+
+const char_t *json_reader_lexeme(const JsonReader *reader, uint32_t *size)
+{
+    cassert_no_null(reader);
+    switch (reader->event) {
+    case ekJSON_KEY:
+    case ekJSON_STRING:
+    case ekJSON_NUMBER:
+        ptr_assign(size, reader->parser.lexsize);
+        return reader->parser.lexeme;
+    case ekJSON_TRUE:
+        ptr_assign(size, 4);
+        return "true";
+    case ekJSON_FALSE:
+        ptr_assign(size, 5);
+        return "false";
+    case ekJSON_NULL:
+        ptr_assign(size, 4);
+        return "null";
+    case ekJSON_BEGIN_OBJECT:
+    case ekJSON_END_OBJECT:
+    case ekJSON_BEGIN_ARRAY:
+    case ekJSON_END_ARRAY:
+    case ekJSON_VALUE:
+    case ekJSON_EOF:
+    case ekJSON_ERROR:
+        break;
+    cassert_default();
+    }
+
+    ptr_assign(size, 0);
+    return "";
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t json_reader_depth(const JsonReader *reader)
+{
+    cassert_no_null(reader);
+    return arrst_size(reader->stack, bool_t);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t json_reader_skip(JsonReader *reader)
+{
+    bool_t ok = TRUE;
+    cassert_no_null(reader);
+    if (reader->state == i_ekSTATE_COLON)
+        json_reader_next(reader);
+
+    if (reader->event == ekJSON_BEGIN_OBJECT)
+    {
+        cassert(reader->state == i_ekSTATE_KEY_OR_END);
+        ok = i_jump_object(&reader->parser);
+        if (ok == TRUE)
+            reader->event = i_reader_close(reader, TRUE);
+    }
+    else if (reader->event == ekJSON_BEGIN_ARRAY)
+    {
+        cassert(reader->state == i_ekSTATE_VALUE_OR_END);
+        ok = i_jump_array(&reader->parser);
+        if (ok == TRUE)
+            reader->event = i_reader_close(reader, FALSE);
+    }
+
+    if (ok == FALSE)
+        reader->event = i_reader_error(reader, "Error skipping Json value");
+
+    return (bool_t)(reader->event != ekJSON_ERROR);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void *json_reader_value_imp(JsonReader *reader, const JsonOpts *opts, const char_t *type)
+{
+    void *obj = NULL;
+    cassert_no_null(reader);
+
+    /* Next array element */
+    if (reader->state == i_ekSTATE_AFTER_VALUE)
+    {
+        uint32_t n = arrst_size(reader->stack, bool_t);
+        if (n == 0 || *arrst_get_const(reader->stack, n - 1, bool_t) == TRUE)
+        {
+            reader->event = i_reader_error(reader, "Unexpected Json value");
+            return NULL;
+        }
+
+        if (i_reader_sep(reader, &reader->event) == FALSE)
+            return NULL;
+    }
+
+    /* Member value */
+    if (reader->state == i_ekSTATE_COLON)
+    {
+        if (i_reader_colon(reader) == FALSE)
+        {
+            reader->event = ekJSON_ERROR;
+            return NULL;
+        }
+    }
+
+    if (reader->state != i_ekSTATE_VALUE && reader->state != i_ekSTATE_VALUE_OR_END)
+    {
+        reader->event = i_reader_error(reader, "Unexpected Json value");
+        return NULL;
+    }
+
+    if (opts != NULL && opts->arena != NULL)
+    {
+        heap_arena_push(opts->arena);
+        obj = i_create_type(&reader->parser, type);
+        heap_arena_pop(opts->arena);
+    }
+    else
+    {
+        obj = i_create_type(&reader->parser, type);
+    }
+
+    if (obj != NULL)
+    {
+        reader->state = i_ekSTATE_AFTER_VALUE;
+        reader->event = ekJSON_VALUE;
+    }
+    else if (reader->state == i_ekSTATE_VALUE_OR_END && reader->parser.token == i_ekCLOSE_ARRAY)
+    {
+        reader->event = i_reader_close(reader, FALSE);
+    }
+    else
+    {
+        reader->event = i_reader_error(reader, "Json value can't be created");
+    }
+
+    return obj;
+}
+
+/*---------------------------------------------------------------------------*/
+
+JsonWriter *json_writer_create(Stream *stm)
+{
+    JsonWriter *writer = heap_new0(JsonWriter);
+    writer->stm = stm;
+    writer->key = FALSE;
+    writer->stack = arrst_create(uint32_t);
+    return writer;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_destroy(JsonWriter **writer)
+{
+    cassert_no_null(writer);
+    cassert_no_null(*writer);
+    cassert(arrst_size((*writer)->stack, uint32_t) == 0);
+    arrst_destroy(&(*writer)->stack, NULL, uint32_t);
+    heap_delete(writer, JsonWriter);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Stack elements: number of items written in each open container */
+static void i_writer_item(JsonWriter *writer)
+{
+    uint32_t n;
+    cassert_no_null(writer);
+    n = arrst_size(writer->stack, uint32_t);
+    if (writer->key == TRUE)
+    {
+        writer->key = FALSE;
+    }
+    else if (n > 0)
+    {
+        uint32_t *items = arrst_get(writer->stack, n - 1, uint32_t);
+        if (*items > 0)
+            stm_writef(writer->stm, ", ");
+        *items += 1;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_writer_close(JsonWriter *writer, const char_t *close)
+{
+    cassert_no_null(writer);
+    cassert(writer->key == FALSE);
+    cassert(arrst_size(writer->stack, uint32_t) > 0);
+    arrst_pop(writer->stack, NULL, uint32_t);
+    stm_writef(writer->stm, close);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_begin_object(JsonWriter *writer)
+{
+    i_writer_item(writer);
+    arrst_append(writer->stack, 0, uint32_t);
+    stm_writef(writer->stm, "{");
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_end_object(JsonWriter *writer)
+{
+    i_writer_close(writer, " }");
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_begin_array(JsonWriter *writer)
+{
+    i_writer_item(writer);
+    arrst_append(writer->stack, 0, uint32_t);
+    stm_writef(writer->stm, "[ ");
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_end_array(JsonWriter *writer)
+{
+    i_writer_close(writer, " ]");
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_key(JsonWriter *writer, const char_t *name)
+{
+    cassert_no_null(name);
+    cassert(writer->key == FALSE);
+    i_writer_item(writer);
+    i_write_cstr(writer->stm, name);
+    stm_writef(writer->stm, " : ");
+    writer->key = TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_str(JsonWriter *writer, const char_t *value)
+{
+    i_writer_item(writer);
+    i_write_cstr(writer->stm, value);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_int(JsonWriter *writer, const int64_t value)
+{
+    i_writer_item(writer);
+    stm_printf(writer->stm, "%" PRId64, value);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_uint(JsonWriter *writer, const uint64_t value)
+{
+    i_writer_item(writer);
+    stm_printf(writer->stm, "%" PRIu64, value);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_real(JsonWriter *writer, const real64_t value)
+{
+    i_writer_item(writer);
+    stm_printf(writer->stm, "%.17g", value);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_bool(JsonWriter *writer, const bool_t value)
+{
+    i_writer_item(writer);
+    stm_writef(writer->stm, value == TRUE ? "true" : "false");
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_null(JsonWriter *writer)
+{
+    i_writer_item(writer);
+    stm_writef(writer->stm, "null");
+}
+
+/*---------------------------------------------------------------------------*/
+
+void json_writer_value_imp(JsonWriter *writer, const void *data, const char_t *type)
+{
+    i_writer_item(writer);
+    json_write_imp(writer->stm, data, NULL, type);
+}
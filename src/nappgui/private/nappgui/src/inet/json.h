@@ -23,6 +23,52 @@ _inet_api void json_destroy_imp(void **data, const char_t *type);
 
 _inet_api void json_destopt_imp(void **data, const char_t *type);
 
+_inet_api void *json_read_each_imp(Stream *stm, const JsonOpts *opts, const char_t *type, const char_t *mname, Listener *listener);
+
+_inet_api JsonReader *json_reader_create(Stream *stm);
+
+_inet_api void json_reader_destroy(JsonReader **reader);
+
+_inet_api jevent_t json_reader_next(JsonReader *reader);
+
+_inet_api jevent_t json_reader_event(const JsonReader *reader);
+
+_inet_api const char_t *json_reader_lexeme(const JsonReader *reader, uint32_t *size);
+
+_inet_api uint32_t json_reader_depth(const JsonReader *reader);
+
+_inet_api bool_t json_reader_skip(JsonReader *reader);
+
+_inet_api void *json_reader_value_imp(JsonReader *reader, const JsonOpts *opts, const char_t *type);
+
+_inet_api JsonWriter *json_writer_create(Stream *stm);
+
+_inet_api void json_writer_destroy(JsonWriter **writer);
+
+_inet_api void json_writer_begin_object(JsonWriter *writer);
+
+_inet_api void json_writer_end_object(JsonWriter *writer);
+
+_inet_api void json_writer_begin_array(JsonWriter *writer);
+
+_inet_api void json_writer_end_array(JsonWriter *writer);
+
+_inet_api void json_writer_key(JsonWriter *writer, const char_t *name);
+
+_inet_api void json_writer_str(JsonWriter *writer, const char_t *value);
+
+_inet_api void json_writer_int(JsonWriter *writer, const int64_t value);
+
+_inet_api void json_writer_uint(JsonWriter *writer, const uint64_t value);
+
+_inet_api void json_writer_real(JsonWriter *writer, const real64_t value);
+
+_inet_api void json_writer_bool(JsonWriter *writer, const bool_t value);
+
+_inet_api void json_writer_null(JsonWriter *writer);
+
+_inet_api void json_writer_value_imp(JsonWriter *writer, const void *data, const char_t *type);
+
 __END_C
 
 #define json_read(stm, opts, type)\
@@ -39,3 +85,13 @@ __END_C
 #define json_destopt(data, type)\
     ((void)((type**)data == data),\
     json_destopt_imp((void**)data, (const char_t*)#type))
+
+#define json_read_each(stm, opts, type, mname, listener)\
+    (type*)json_read_each_imp(stm, opts, (const char_t*)#type, (const char_t*)#mname, listener)
+
+#define json_reader_value(reader, opts, type)\
+    (type*)json_reader_value_imp(reader, opts, (const char_t*)#type)
+
+#define json_writer_value(writer, data, type)\
+    ((void)((const type*)data == data),\
+    json_writer_value_imp(writer, (const void*)data, (const char_t*)#type))
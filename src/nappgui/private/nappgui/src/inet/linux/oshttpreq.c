@@ -31,9 +31,18 @@ struct _oshttp_t
     bool_t secure;
     Stream *resp_headers;
     Stream *resp_data;
+    Stream *body;
+    void *chunk_data;
+    FPtr_http_chunk func_chunk;
     ierror_t error;
 };
 
+/* Concurrent transfers (HttpPool). Connections are cached and shared */
+struct _oshttpmulti_t
+{
+    CURLM *multi;
+};
+
 /*---------------------------------------------------------------------------*/
 
 void oshttp_init(void)
@@ -59,6 +68,9 @@ OSHttp *oshttp_create(const char_t *host, const uint16_t port, const bool_t secu
     http->headers = NULL;
     http->resp_headers = NULL;
     http->resp_data = NULL;
+    http->body = NULL;
+    http->chunk_data = NULL;
+    http->func_chunk = NULL;
 
     if (secure == TRUE)
         http->host_url = str_printf("https://%s", host);
@@ -69,6 +81,9 @@ OSHttp *oshttp_create(const char_t *host, const uint16_t port, const bool_t secu
     {
         int res = curl_easy_setopt(http->curl, CURLOPT_PORT, port);
         cassert_unref(res == CURLE_OK, res);
+        /* Idle connections of reused handles stay alive */
+        res = curl_easy_setopt(http->curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        cassert_unref(res == CURLE_OK, res);
     }
     else
     {
@@ -139,16 +154,59 @@ static size_t i_write_response(char *buffer, size_t size, size_t nitems, void *u
 
 /*---------------------------------------------------------------------------*/
 
-static void i_request(OSHttp *http, const bool_t use_get, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
+static size_t i_write_chunk(char *buffer, size_t size, size_t nitems, void *userdata)
 {
-    int res = 0;
+    OSHttp *http = (OSHttp*)userdata;
     cassert_no_null(http);
+    cassert_no_nullf(http->func_chunk);
+    http->func_chunk(http->chunk_data, (const byte_t*)buffer, (uint32_t)(size * nitems));
+    return nitems * size;
+}
 
-    if (http->error != ekIOK)
+/*---------------------------------------------------------------------------*/
+
+static size_t i_read_request(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    /* 0 --> End of the request body. A failed source never looks like the end */
+    Stream *stm = (Stream*)userdata;
+    uint32_t rsize = stm_read(stm, (byte_t*)buffer, (uint32_t)(size * nitems));
+    sstate_t state = stm_state(stm);
+    if (state != ekSTOK && state != ekSTEND)
+        return CURL_READFUNC_ABORT;
+    return (size_t)rsize;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static ierror_t i_error(const CURLcode code)
+{
+    switch (code)
     {
-        ptr_assign(error, http->error);
-        return;
+        case CURLE_OK:
+            return ekIOK;
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+            return ekINOHOST;
+        case CURLE_OPERATION_TIMEDOUT:
+            return ekITIMEOUT;
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_WRITE_ERROR:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_ABORTED_BY_CALLBACK:
+            return ekISTREAM;
+        default:
+            return ekISERVER;
     }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_setup(OSHttp *http, const bool_t use_get, const char_t *path, const byte_t *data, const uint32_t size, Stream *upload, const bool_t auto_redirect)
+{
+    int res = 0;
+    cassert_no_null(http);
+    cassert(http->error == ekIOK);
 
     /* Seems that CURLOPT_FOLLOWLOCATION fails */
     res = curl_easy_setopt(http->curl, CURLOPT_FOLLOWLOCATION, auto_redirect ? 1L : 0L);
@@ -167,13 +225,33 @@ static void i_request(OSHttp *http, const bool_t use_get, const char_t *path, co
         cassert_unref(res == CURLE_OK, res);
     }
 
-    if (data != NULL)
+    /* Unknown size --> Chunked transfer, read on demand from the stream */
+    if (upload != NULL)
+    {
+        res = curl_easy_setopt(http->curl, CURLOPT_POSTFIELDS, NULL);
+        cassert_unref(res == CURLE_OK, res);
+        res = curl_easy_setopt(http->curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)-1);
+        cassert_unref(res == CURLE_OK, res);
+        res = curl_easy_setopt(http->curl, CURLOPT_READFUNCTION, i_read_request);
+        cassert_unref(res == CURLE_OK, res);
+        res = curl_easy_setopt(http->curl, CURLOPT_READDATA, upload);
+        cassert_unref(res == CURLE_OK, res);
+    }
+    else if (data != NULL)
     {
         res = curl_easy_setopt(http->curl, CURLOPT_POSTFIELDSIZE, size);
         cassert_unref(res == CURLE_OK, res);
         res = curl_easy_setopt(http->curl, CURLOPT_POSTFIELDS, (char*)data);
         cassert_unref(res == CURLE_OK, res);
     }
+    /* Reused handle: don't send the previous request body */
+    else if (use_get == FALSE)
+    {
+        res = curl_easy_setopt(http->curl, CURLOPT_POSTFIELDSIZE, 0L);
+        cassert_unref(res == CURLE_OK, res);
+        res = curl_easy_setopt(http->curl, CURLOPT_POSTFIELDS, "");
+        cassert_unref(res == CURLE_OK, res);
+    }
 
     if (use_get == TRUE)
     {
@@ -193,42 +271,77 @@ static void i_request(OSHttp *http, const bool_t use_get, const char_t *path, co
         stm_close(&http->resp_data);
 
     http->resp_headers = stm_memory(100 * 1024);
-    http->resp_data = stm_memory(1024 * 1024);
 
     res = curl_easy_setopt(http->curl, CURLOPT_HEADERFUNCTION, i_write_response);
     cassert(res == CURLE_OK);
     res = curl_easy_setopt(http->curl, CURLOPT_HEADERDATA, http->resp_headers);
     cassert(res == CURLE_OK);
 
-    res = curl_easy_setopt(http->curl, CURLOPT_WRITEFUNCTION, i_write_response);
-    cassert(res == CURLE_OK);
-    res = curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, http->resp_data);
-    cassert(res == CURLE_OK);
-
-    res = curl_easy_perform(http->curl);
-	if (res == CURLE_OK)
+    /* The body goes straight to the caller stream (oshttp_body) */
+    if (http->body != NULL)
+    {
+        res = curl_easy_setopt(http->curl, CURLOPT_WRITEFUNCTION, i_write_response);
+        cassert(res == CURLE_OK);
+        res = curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, http->body);
+        cassert(res == CURLE_OK);
+        http->body = NULL;
+    }
+    /* Or to the caller, chunk by chunk (oshttp_body_chunks) */
+    else if (http->func_chunk != NULL)
     {
-        ptr_assign(error, ekIOK);
+        res = curl_easy_setopt(http->curl, CURLOPT_WRITEFUNCTION, i_write_chunk);
+        cassert(res == CURLE_OK);
+        res = curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, http);
+        cassert(res == CURLE_OK);
     }
     else
     {
-        /* TODO: Error codes */
-        ptr_assign(error, ekISERVER);
+        http->resp_data = stm_memory(1024 * 1024);
+        res = curl_easy_setopt(http->curl, CURLOPT_WRITEFUNCTION, i_write_response);
+        cassert(res == CURLE_OK);
+        res = curl_easy_setopt(http->curl, CURLOPT_WRITEDATA, http->resp_data);
+        cassert(res == CURLE_OK);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_request(OSHttp *http, const bool_t use_get, const char_t *path, const byte_t *data, const uint32_t size, Stream *upload, const bool_t auto_redirect, ierror_t *error)
+{
+    CURLcode res = CURLE_OK;
+    cassert_no_null(http);
+
+    if (http->error != ekIOK)
+    {
+        ptr_assign(error, http->error);
+        return;
     }
+
+    i_setup(http, use_get, path, data, size, upload, auto_redirect);
+    res = curl_easy_perform(http->curl);
+    ptr_assign(error, i_error(res));
 }
 
 /*---------------------------------------------------------------------------*/
 
 void oshttp_get(OSHttp *http, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
 {
-    i_request(http, TRUE, path, data, size, auto_redirect, error);
+    i_request(http, TRUE, path, data, size, NULL, auto_redirect, error);
 }
 
 /*---------------------------------------------------------------------------*/
 
 void oshttp_post(OSHttp *http, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
 {
-    i_request(http, FALSE, path, data, size, auto_redirect, error);
+    i_request(http, FALSE, path, data, size, NULL, auto_redirect, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_post_stream(OSHttp *http, const char_t *path, Stream *body, const bool_t auto_redirect, ierror_t *error)
+{
+    cassert_no_null(body);
+    i_request(http, FALSE, path, NULL, 0, body, auto_redirect, error);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -246,13 +359,137 @@ Stream *oshttp_response(OSHttp *http)
 
 void oshttp_response_body(OSHttp *http, Stream *body, ierror_t *error)
 {
-    const byte_t *data = NULL;
-    uint32_t size = 0;
     cassert_no_null(http);
-    data = stm_buffer(http->resp_data);
-    size = stm_buffer_size(http->resp_data);
-    stm_write(body, data, size);
-    stm_close(&http->resp_data);
+    /* resp_data = NULL --> The body was written in the oshttp_body stream */
+    if (http->resp_data != NULL)
+    {
+        const byte_t *data = stm_buffer(http->resp_data);
+        uint32_t size = stm_buffer_size(http->resp_data);
+        stm_write(body, data, size);
+        stm_close(&http->resp_data);
+    }
+
     ptr_assign(error, ekIOK);
 }
 
+/*---------------------------------------------------------------------------*/
+
+void oshttp_body(OSHttp *http, Stream *body)
+{
+    cassert_no_null(http);
+    http->body = body;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_body_chunks(OSHttp *http, void *data, FPtr_http_chunk func_chunk)
+{
+    cassert_no_null(http);
+    http->chunk_data = data;
+    http->func_chunk = func_chunk;
+}
+
+/*---------------------------------------------------------------------------*/
+
+OSHttpMulti *oshttp_multi_create(const uint32_t max_host_conns)
+{
+    OSHttpMulti *multi = heap_new(OSHttpMulti);
+    CURLMcode res = CURLM_OK;
+    multi->multi = curl_multi_init();
+    cassert_no_null(multi->multi);
+    /* HTTP/2 requests to the same host share one connection */
+    res = curl_multi_setopt(multi->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    cassert_unref(res == CURLM_OK, res);
+    if (max_host_conns > 0)
+    {
+        res = curl_multi_setopt(multi->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)max_host_conns);
+        cassert_unref(res == CURLM_OK, res);
+    }
+
+    return multi;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_destroy(OSHttpMulti **multi)
+{
+    cassert_no_null(multi);
+    cassert_no_null(*multi);
+    curl_multi_cleanup((*multi)->multi);
+    heap_delete(multi, OSHttpMulti);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_add(OSHttpMulti *multi, OSHttp *http, const bool_t use_get, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect)
+{
+    CURLMcode res = CURLM_OK;
+    cassert_no_null(multi);
+    cassert_no_null(http);
+    cassert(http->error == ekIOK);
+    i_setup(http, use_get, path, data, size, NULL, auto_redirect);
+    /* Wait for a multiplexed connection instead of opening a new one.
+       Plain HTTP/1.1 servers will use persistent (keep-alive) connections */
+    curl_easy_setopt(http->curl, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(http->curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(http->curl, CURLOPT_PRIVATE, (void*)http);
+    res = curl_multi_add_handle(multi->multi, http->curl);
+    cassert_unref(res == CURLM_OK, res);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_remove(OSHttpMulti *multi, OSHttp *http)
+{
+    CURLMcode res = CURLM_OK;
+    cassert_no_null(multi);
+    cassert_no_null(http);
+    res = curl_multi_remove_handle(multi->multi, http->curl);
+    cassert_unref(res == CURLM_OK, res);
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t oshttp_multi_perform(OSHttpMulti *multi, const uint32_t timeout_ms)
+{
+    int running = 0;
+    CURLMcode res = CURLM_OK;
+    cassert_no_null(multi);
+    res = curl_multi_perform(multi->multi, &running);
+    if (res == CURLM_OK && running > 0 && timeout_ms > 0)
+    {
+        res = curl_multi_poll(multi->multi, NULL, 0, (int)timeout_ms, NULL);
+        if (res == CURLM_OK)
+            res = curl_multi_perform(multi->multi, &running);
+    }
+
+    cassert(res == CURLM_OK);
+    return (uint32_t)running;
+}
+
+/*---------------------------------------------------------------------------*/
+
+OSHttp *oshttp_multi_done(OSHttpMulti *multi, ierror_t *error)
+{
+    CURLMsg *msg = NULL;
+    int queued = 0;
+    cassert_no_null(multi);
+    while ((msg = curl_multi_info_read(multi->multi, &queued)) != NULL)
+    {
+        if (msg->msg == CURLMSG_DONE)
+        {
+            OSHttp *http = NULL;
+            CURL *curl = msg->easy_handle;
+            CURLcode result = msg->data.result;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&http);
+            cassert_no_null(http);
+            cassert(http->curl == curl);
+            curl_multi_remove_handle(multi->multi, curl);
+            ptr_assign(error, i_error(result));
+            return http;
+        }
+    }
+
+    return NULL;
+}
+
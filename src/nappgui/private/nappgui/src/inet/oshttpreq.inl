@@ -34,5 +34,23 @@ Stream *oshttp_response(OSHttp *http);
 
 void oshttp_response_body(OSHttp *http, Stream *body, ierror_t *error);
 
+void oshttp_body(OSHttp *http, Stream *body);
+
+void oshttp_body_chunks(OSHttp *http, void *data, FPtr_http_chunk func_chunk);
+
+void oshttp_post_stream(OSHttp *http, const char_t *path, Stream *body, const bool_t auto_redirect, ierror_t *error);
+
+OSHttpMulti *oshttp_multi_create(const uint32_t max_host_conns);
+
+void oshttp_multi_destroy(OSHttpMulti **multi);
+
+void oshttp_multi_add(OSHttpMulti *multi, OSHttp *http, const bool_t use_get, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect);
+
+void oshttp_multi_remove(OSHttpMulti *multi, OSHttp *http);
+
+uint32_t oshttp_multi_perform(OSHttpMulti *multi, const uint32_t timeout_ms);
+
+OSHttp *oshttp_multi_done(OSHttpMulti *multi, ierror_t *error);
+
 __END_C
 
@@ -62,6 +62,26 @@ struct _oshttp_t
     String *protocol;
     Stream *headers;
     Stream *body;
+    Stream *target;
+    void *chunk_data;
+    FPtr_http_chunk func_chunk;
+};
+
+typedef struct _done_t i_Done;
+
+struct _done_t
+{
+    OSHttp *http;
+    ierror_t error;
+};
+
+DeclSt(i_Done);
+
+/* Requests are synchronous. Multi transfers are performed one after the
+   other. NSURLSession keeps the connections of each handle alive */
+struct _oshttpmulti_t
+{
+    ArrSt(i_Done) *done;
 };
 
 /*---------------------------------------------------------------------------*/
@@ -152,6 +172,9 @@ OSHttp *oshttp_create(const char_t *host, const uint16_t port, const bool_t secu
     http->protocol = NULL;
     http->headers = NULL;
     http->body = NULL;
+    http->target = NULL;
+    http->chunk_data = NULL;
+    http->func_chunk = NULL;
     return http;
 }
 
@@ -349,7 +372,25 @@ static void i_response(NSData *data, NSURLResponse *response, NSError *error, OS
 
 /*---------------------------------------------------------------------------*/
 
-static void i_request(OSHttp *http, NSString *verb, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
+static NSData *i_stream_data(Stream *upload)
+{
+    NSMutableData *nsdata = [NSMutableData dataWithCapacity:16384];
+    byte_t buffer[16384];
+    uint32_t rsize = 0;
+
+    do
+    {
+        rsize = stm_read(upload, buffer, sizeof(buffer));
+        if (rsize > 0)
+            [nsdata appendBytes:(const void*)buffer length:(NSUInteger)rsize];
+    } while (rsize > 0);
+
+    return nsdata;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_request(OSHttp *http, NSString *verb, const char_t *path, const byte_t *data, const uint32_t size, Stream *upload, const bool_t auto_redirect, ierror_t *error)
 {
     cassert_no_null(http);
     http->response = FALSE;
@@ -368,7 +409,13 @@ static void i_request(OSHttp *http, NSString *verb, const char_t *path, const by
     
     [http->request setHTTPMethod:verb];
     
-    if (data != NULL)
+    /* NSURLSession has no pull-based body source for plain C streams.
+       The upload stream is collected before sending the request */
+    if (upload != NULL)
+    {
+        [http->request setHTTPBody:i_stream_data(upload)];
+    }
+    else if (data != NULL)
     {
         NSData *nsdata = [NSData dataWithBytes:(const void*)data length:(NSUInteger)size];
         [http->request setHTTPBody:nsdata];
@@ -376,6 +423,7 @@ static void i_request(OSHttp *http, NSString *verb, const char_t *path, const by
     else
     {
         cassert(size == 0);
+        [http->request setHTTPBody:nil];
     }
 
 #if defined (MAC_OS_X_VERSION_10_9) && MAC_OS_X_VERSION_MIN_REQUIRED >= MAC_OS_X_VERSION_10_9
@@ -408,6 +456,30 @@ static void i_request(OSHttp *http, NSString *verb, const char_t *path, const by
     }
 #endif
 
+    /* The body goes straight to the caller stream (oshttp_body) */
+    if (http->target != NULL)
+    {
+        if (http->error == ekIOK)
+        {
+            uint32_t bsize = stm_buffer_size(http->body);
+            stm_pipe(http->body, http->target, bsize);
+            stm_close(&http->body);
+        }
+
+        http->target = NULL;
+    }
+    /* Or to the caller (oshttp_body_chunks). The whole body arrives at once */
+    else if (http->func_chunk != NULL)
+    {
+        if (http->error == ekIOK)
+        {
+            uint32_t bsize = stm_buffer_size(http->body);
+            if (bsize > 0)
+                http->func_chunk(http->chunk_data, stm_buffer(http->body), bsize);
+            stm_close(&http->body);
+        }
+    }
+
     ptr_assign(error, http->error);
 }
 
@@ -415,14 +487,22 @@ static void i_request(OSHttp *http, NSString *verb, const char_t *path, const by
 
 void oshttp_get(OSHttp *http, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
 {
-    i_request(http, @"GET", path, data, size, auto_redirect, error);
+    i_request(http, @"GET", path, data, size, NULL, auto_redirect, error);
 }
 
 /*---------------------------------------------------------------------------*/
 
 void oshttp_post(OSHttp *http, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
 {
-    i_request(http, @"POST", path, data, size, auto_redirect, error);
+    i_request(http, @"POST", path, data, size, NULL, auto_redirect, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_post_stream(OSHttp *http, const char_t *path, Stream *body, const bool_t auto_redirect, ierror_t *error)
+{
+    cassert_no_null(body);
+    i_request(http, @"POST", path, NULL, 0, body, auto_redirect, error);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -448,7 +528,8 @@ void oshttp_response_body(OSHttp *http, Stream *body, ierror_t *error)
     cassert_no_null(http);
 	cassert(http->response == TRUE);
 
-    if (http->error == ekIOK)
+    /* body = NULL --> Written in the oshttp_body stream */
+    if (http->error == ekIOK && http->body != NULL)
     {
         uint32_t size = stm_buffer_size(http->body);
         stm_pipe(http->body, body, size);
@@ -457,3 +538,91 @@ void oshttp_response_body(OSHttp *http, Stream *body, ierror_t *error)
 	ptr_assign(error, http->error);
 }
 
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_body(OSHttp *http, Stream *body)
+{
+    cassert_no_null(http);
+    http->target = body;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_body_chunks(OSHttp *http, void *data, FPtr_http_chunk func_chunk)
+{
+    cassert_no_null(http);
+    http->chunk_data = data;
+    http->func_chunk = func_chunk;
+}
+
+/*---------------------------------------------------------------------------*/
+
+OSHttpMulti *oshttp_multi_create(const uint32_t max_host_conns)
+{
+    OSHttpMulti *multi = heap_new(OSHttpMulti);
+    multi->done = arrst_create(i_Done);
+    unref(max_host_conns);
+    return multi;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_destroy(OSHttpMulti **multi)
+{
+    cassert_no_null(multi);
+    cassert_no_null(*multi);
+    arrst_destroy(&(*multi)->done, NULL, i_Done);
+    heap_delete(multi, OSHttpMulti);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_add(OSHttpMulti *multi, OSHttp *http, const bool_t use_get, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect)
+{
+    i_Done *done = NULL;
+    cassert_no_null(multi);
+    done = arrst_new(multi->done, i_Done);
+    done->http = http;
+    i_request(http, use_get == TRUE ? @"GET" : @"POST", path, data, size, NULL, auto_redirect, &done->error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_remove(OSHttpMulti *multi, OSHttp *http)
+{
+    cassert_no_null(multi);
+    arrst_foreach(done, multi->done, i_Done)
+        if (done->http == http)
+        {
+            arrst_delete(multi->done, done_i, NULL, i_Done);
+            break;
+        }
+    arrst_end();
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t oshttp_multi_perform(OSHttpMulti *multi, const uint32_t timeout_ms)
+{
+    cassert_no_null(multi);
+    unref(timeout_ms);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+OSHttp *oshttp_multi_done(OSHttpMulti *multi, ierror_t *error)
+{
+    cassert_no_null(multi);
+    if (arrst_size(multi->done, i_Done) > 0)
+    {
+        const i_Done *done = arrst_get_const(multi->done, 0, i_Done);
+        OSHttp *http = done->http;
+        ptr_assign(error, done->error);
+        arrst_delete(multi->done, 0, NULL, i_Done);
+        return http;
+    }
+
+    return NULL;
+}
@@ -38,6 +38,26 @@ struct _oshttp_t
     ierror_t error;
     bool_t secure;
     Stream *headers;
+    Stream *body;
+    void *chunk_data;
+    FPtr_http_chunk func_chunk;
+};
+
+typedef struct _done_t i_Done;
+
+struct _done_t
+{
+    OSHttp *http;
+    ierror_t error;
+};
+
+DeclSt(i_Done);
+
+/* WinINet requests are synchronous. Multi transfers are performed one
+   after the other, reusing the persistent connection of each handle */
+struct _oshttpmulti_t
+{
+    ArrSt(i_Done) *done;
 };
 
 /*---------------------------------------------------------------------------*/
@@ -128,14 +148,108 @@ void oshttp_add_header(OSHttp *http, const char_t *name, const char_t *value)
 
 /*---------------------------------------------------------------------------*/
 
-static void i_request(OSHttp *http, const WCHAR *verb, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
+static BOOL i_write_all(HINTERNET hRequest, const byte_t *data, const uint32_t size)
+{
+    uint32_t written = 0;
+    while (written < size)
+    {
+        DWORD dwWritten = 0;
+        if (InternetWriteFile(hRequest, (LPCVOID)(data + written), (DWORD)(size - written), &dwWritten) == FALSE || dwWritten == 0)
+            return FALSE;
+        written += (uint32_t)dwWritten;
+    }
+
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static __INLINE bool_t i_upload_failed(const Stream *upload)
+{
+    sstate_t state = stm_state(upload);
+    return (bool_t)(state != ekSTOK && state != ekSTEND);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* WinINet doesn't frame chunked uploads, we do it by hand */
+static BOOL i_send_stream(OSHttp *http, const WCHAR *headers, const DWORD hlen, Stream *upload)
+{
+    static const WCHAR *i_CHUNKED = L"Transfer-Encoding: chunked";
+    byte_t buffer[16384];
+    uint32_t rsize = 0;
+
+    if (HttpAddRequestHeaders(http->hRequest, i_CHUNKED, (DWORD)-1, HTTP_ADDREQ_FLAG_ADD | HTTP_ADDREQ_FLAG_REPLACE) == FALSE)
+        return FALSE;
+
+    if (headers != NULL)
+    {
+        if (HttpAddRequestHeaders(http->hRequest, headers, hlen, HTTP_ADDREQ_FLAG_ADD | HTTP_ADDREQ_FLAG_REPLACE) == FALSE)
+            return FALSE;
+    }
+
+    if (HttpSendRequestEx(http->hRequest, NULL, NULL, 0, 0) == FALSE)
+        return FALSE;
+
+    do
+    {
+        rsize = stm_read(upload, buffer, sizeof(buffer));
+
+        /* Never send the last chunk of a failed body: the server would take it as complete */
+        if (i_upload_failed(upload) == TRUE)
+            return FALSE;
+
+        if (rsize > 0)
+        {
+            char_t head[16];
+            uint32_t hsize = bstd_sprintf(head, sizeof(head), "%X\r\n", rsize);
+            if (i_write_all(http->hRequest, (const byte_t*)head, hsize) == FALSE
+                || i_write_all(http->hRequest, buffer, rsize) == FALSE
+                || i_write_all(http->hRequest, (const byte_t*)"\r\n", 2) == FALSE)
+                return FALSE;
+        }
+    } while (rsize > 0);
+
+    if (i_write_all(http->hRequest, (const byte_t*)"0\r\n\r\n", 5) == FALSE)
+        return FALSE;
+
+    return HttpEndRequest(http->hRequest, NULL, 0, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_response_chunks(OSHttp *http, ierror_t *error)
+{
+    byte_t buffer[16384];
+    DWORD dwByteRead = 0;
+
+    do
+    {
+        if (InternetReadFile(http->hRequest, buffer, sizeof(buffer), &dwByteRead) == FALSE)
+        {
+            ptr_assign(error, ekISTREAM);
+            return;
+        }
+
+        if (dwByteRead > 0)
+            http->func_chunk(http->chunk_data, buffer, (uint32_t)dwByteRead);
+
+    } while (dwByteRead);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_request(OSHttp *http, const WCHAR *verb, const char_t *path, const byte_t *data, const uint32_t size, Stream *upload, const bool_t auto_redirect, ierror_t *error)
 {
     WCHAR wpath[1024];
     uint64_t hsize = 0;
     BOOL status = FALSE;
     DWORD flags = 0;
+    Stream *body = NULL;
 
     cassert_no_null(http);
+    body = http->body;
+    http->body = NULL;
 
     if (http->error != ekIOK)
     {
@@ -161,7 +275,12 @@ static void i_request(OSHttp *http, const WCHAR *verb, const char_t *path, const
     }
 
     hsize = stm_bytes_written(http->headers);
-    if (hsize > 0)
+    if (upload != NULL)
+    {
+        WCHAR *lpszHeaders = hsize > 0 ? (WCHAR*)stm_buffer(http->headers) : NULL;
+        status = i_send_stream(http, lpszHeaders, (DWORD)hsize / sizeof(WCHAR), upload);
+    }
+    else if (hsize > 0)
     {
         WCHAR *lpszHeaders = (WCHAR*)stm_buffer(http->headers);
 	    status = HttpSendRequest(http->hRequest, lpszHeaders, (DWORD)hsize / sizeof(WCHAR), (LPVOID)data, (DWORD)size);
@@ -174,10 +293,17 @@ static void i_request(OSHttp *http, const WCHAR *verb, const char_t *path, const
 	if (status == TRUE)
     {
         ptr_assign(error, ekIOK);
+
+        /* The body goes straight to the caller stream (oshttp_body) */
+        if (body != NULL)
+            oshttp_response_body(http, body, error);
+        /* Or to the caller, chunk by chunk (oshttp_body_chunks) */
+        else if (http->func_chunk != NULL)
+            i_response_chunks(http, error);
     }
     else
     {
-        ptr_assign(error, ekISERVER);
+        ptr_assign(error, upload != NULL && i_upload_failed(upload) == TRUE ? ekISTREAM : ekISERVER);
 	    InternetCloseHandle(http->hRequest);
         http->hRequest = NULL;
     }
@@ -187,14 +313,22 @@ static void i_request(OSHttp *http, const WCHAR *verb, const char_t *path, const
 
 void oshttp_get(OSHttp *http, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
 {
-    i_request(http, L"GET", path, data, size, auto_redirect, error);
+    i_request(http, L"GET", path, data, size, NULL, auto_redirect, error);
 }
 
 /*---------------------------------------------------------------------------*/
 
 void oshttp_post(OSHttp *http, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect, ierror_t *error)
 {
-    i_request(http, L"POST", path, data, size, auto_redirect, error);
+    i_request(http, L"POST", path, data, size, NULL, auto_redirect, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_post_stream(OSHttp *http, const char_t *path, Stream *body, const bool_t auto_redirect, ierror_t *error)
+{
+    cassert_no_null(body);
+    i_request(http, L"POST", path, NULL, 0, body, auto_redirect, error);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -275,3 +409,91 @@ void oshttp_response_body(OSHttp *http, Stream *body, ierror_t *error)
     ptr_assign(error, ekIOK);
 }
 
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_body(OSHttp *http, Stream *body)
+{
+    cassert_no_null(http);
+    http->body = body;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_body_chunks(OSHttp *http, void *data, FPtr_http_chunk func_chunk)
+{
+    cassert_no_null(http);
+    http->chunk_data = data;
+    http->func_chunk = func_chunk;
+}
+
+/*---------------------------------------------------------------------------*/
+
+OSHttpMulti *oshttp_multi_create(const uint32_t max_host_conns)
+{
+    OSHttpMulti *multi = heap_new(OSHttpMulti);
+    multi->done = arrst_create(i_Done);
+    unref(max_host_conns);
+    return multi;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_destroy(OSHttpMulti **multi)
+{
+    cassert_no_null(multi);
+    cassert_no_null(*multi);
+    arrst_destroy(&(*multi)->done, NULL, i_Done);
+    heap_delete(multi, OSHttpMulti);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_add(OSHttpMulti *multi, OSHttp *http, const bool_t use_get, const char_t *path, const byte_t *data, const uint32_t size, const bool_t auto_redirect)
+{
+    i_Done *done = NULL;
+    cassert_no_null(multi);
+    done = arrst_new(multi->done, i_Done);
+    done->http = http;
+    i_request(http, use_get == TRUE ? L"GET" : L"POST", path, data, size, NULL, auto_redirect, &done->error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void oshttp_multi_remove(OSHttpMulti *multi, OSHttp *http)
+{
+    cassert_no_null(multi);
+    arrst_foreach(done, multi->done, i_Done)
+        if (done->http == http)
+        {
+            arrst_delete(multi->done, done_i, NULL, i_Done);
+            break;
+        }
+    arrst_end();
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t oshttp_multi_perform(OSHttpMulti *multi, const uint32_t timeout_ms)
+{
+    cassert_no_null(multi);
+    unref(timeout_ms);
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+OSHttp *oshttp_multi_done(OSHttpMulti *multi, ierror_t *error)
+{
+    cassert_no_null(multi);
+    if (arrst_size(multi->done, i_Done) > 0)
+    {
+        const i_Done *done = arrst_get_const(multi->done, 0, i_Done);
+        OSHttp *http = done->http;
+        ptr_assign(error, done->error);
+        arrst_delete(multi->done, 0, NULL, i_Done);
+        return http;
+    }
+
+    return NULL;
+}
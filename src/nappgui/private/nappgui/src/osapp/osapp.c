@@ -165,6 +165,7 @@ static uint32_t i_dispatch_task(i_Task *task)
     rvalue = task->func_main(task->data);
     task->state = i_ekSTATE_FINISH;
     osapp_end_thread(task->osapp, data);
+    heap_thread_end();
     return rvalue;
 }
 
@@ -49,11 +49,23 @@ _osbs_api bool_t bfile_read(File *file, byte_t *data, const uint32_t size, uint3
 
 _osbs_api bool_t bfile_write(File *file, const byte_t *data, const uint32_t size, uint32_t *wsize, ferror_t *error);
 
+_osbs_api bool_t bfile_read64(File *file, byte_t *data, const uint64_t size, uint64_t *rsize, ferror_t *error);
+
+_osbs_api bool_t bfile_write64(File *file, const byte_t *data, const uint64_t size, uint64_t *wsize, ferror_t *error);
+
+_osbs_api bool_t bfile_copy(File *from, File *to, const uint64_t size, uint64_t *csize, ferror_t *error);
+
 _osbs_api bool_t bfile_seek(File *file, const int64_t offset, const file_seek_t whence, ferror_t *error);
 
 _osbs_api uint64_t bfile_pos(const File *file);
 
+_osbs_api const byte_t *bfile_mmap(File *file, const uint64_t offset, const uint64_t size, ferror_t *error);
+
+_osbs_api void bfile_munmap(const byte_t **data, const uint64_t size);
+
 _osbs_api bool_t bfile_delete(const char_t *pathname, ferror_t *error);
 
+_osbs_api bool_t bfile_rename(const char_t *from, const char_t *to, ferror_t *error);
+
 __END_C
 
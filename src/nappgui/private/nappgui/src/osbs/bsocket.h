@@ -19,6 +19,10 @@ _osbs_api Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const
 
 _osbs_api Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t *error);
 
+_osbs_api Socket *bsocket_connect_host(const char_t *host, const uint16_t port, const uint32_t timeout_ms, serror_t *error);
+
+_osbs_api Socket *bsocket_server_host(const char_t *host, const uint16_t port, const uint32_t max_connect, serror_t *error);
+
 _osbs_api Socket *bsocket_accept(Socket *socket, const uint32_t timeout_ms, serror_t *error);
 
 _osbs_api void bsocket_close(Socket **socket);
@@ -27,14 +31,44 @@ _osbs_api void bsocket_local_ip(Socket *socket, uint32_t *ip, uint16_t *port);
 
 _osbs_api void bsocket_remote_ip(Socket *socket, uint32_t *ip, uint16_t *port);
 
+_osbs_api bool_t bsocket_local_addr(Socket *socket, char_t *addr, const uint32_t size, uint16_t *port);
+
+_osbs_api bool_t bsocket_remote_addr(Socket *socket, char_t *addr, const uint32_t size, uint16_t *port);
+
 _osbs_api void bsocket_read_timeout(Socket *socket, const uint32_t timeout_ms);
 
 _osbs_api void bsocket_write_timeout(Socket *socket, const uint32_t timeout_ms);
 
+_osbs_api void bsocket_nodelay(Socket *socket, const bool_t nodelay);
+
+_osbs_api void bsocket_keepalive(Socket *socket, const bool_t keepalive, const uint32_t idle_s);
+
+_osbs_api void bsocket_read_bufsize(Socket *socket, const uint32_t size);
+
+_osbs_api void bsocket_write_bufsize(Socket *socket, const uint32_t size);
+
 _osbs_api bool_t bsocket_read(Socket *socket, byte_t *data, const uint32_t size, uint32_t *rsize, serror_t *error);
 
 _osbs_api bool_t bsocket_write(Socket *socket, const byte_t *data, const uint32_t size, uint32_t *wsize, serror_t *error);
 
+_osbs_api bool_t bsocket_readv(Socket *socket, const SockBuf *bufs, const uint32_t n, uint32_t *rsize, serror_t *error);
+
+_osbs_api bool_t bsocket_writev(Socket *socket, const SockBuf *bufs, const uint32_t n, uint32_t *wsize, serror_t *error);
+
+_osbs_api void bsocket_nonblock(Socket *socket, const bool_t nonblock);
+
+_osbs_api SockPoll *bsocket_poll_create(void);
+
+_osbs_api void bsocket_poll_destroy(SockPoll **poll);
+
+_osbs_api bool_t bsocket_poll_add_imp(SockPoll *poll, Socket *socket, const uint32_t events, void *data, FPtr_sock_event func_event);
+
+_osbs_api bool_t bsocket_poll_mod(SockPoll *poll, Socket *socket, const uint32_t events);
+
+_osbs_api void bsocket_poll_remove(SockPoll *poll, Socket *socket);
+
+_osbs_api uint32_t bsocket_poll_wait(SockPoll *poll, const uint32_t timeout_ms);
+
 
 _osbs_api uint32_t bsocket_url_ip(const char_t *url, serror_t *error);
 
@@ -59,3 +93,10 @@ _osbs_api void bsocket_ntoh4(byte_t *dest, const byte_t *src);
 _osbs_api void bsocket_ntoh8(byte_t *dest, const byte_t *src);
 
 __END_C
+
+#define bsocket_poll_add(poll, socket, events, data, func_event, type)\
+    (\
+        (void)(data == (type*)data),\
+        FUNC_CHECK_SOCK_EVENT(func_event, type),\
+        bsocket_poll_add_imp(poll, socket, events, (void*)data, (FPtr_sock_event)func_event)\
+    )
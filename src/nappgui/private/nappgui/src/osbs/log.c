@@ -13,18 +13,151 @@
 #include "log.h"
 #include "log.inl"
 #include "blib.h"
+#include "bmem.h"
 #include "cassert.h"
 #include "bfile.h"
 #include "bmutex.h"
 #include "bstd.h"
+#include "bthread.h"
 #include "btime.h"
+#include "ptr.h"
+#include <signal.h>
+
+#if defined(__UNIX__)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* Compile-time filters don't apply to the implementation */
+#undef log_trace
+#undef log_debug
+#undef log_info
+#undef log_warn
+
+#if defined(__GNUC__)
+    #define i_load_acquire(ptr)         __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+    #define i_store_release(ptr, v)     __atomic_store_n(ptr, v, __ATOMIC_RELEASE)
+    #define i_cas32(ptr, expected, v)   __atomic_compare_exchange_n(ptr, expected, v, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+    #define i_add_seq(ptr, v)           __atomic_add_fetch(ptr, v, __ATOMIC_SEQ_CST)
+    #define i_load_seq(ptr)             __atomic_load_n(ptr, __ATOMIC_SEQ_CST)
+    #define i_store_seq(ptr, v)         __atomic_store_n(ptr, v, __ATOMIC_SEQ_CST)
+#elif defined(_MSC_VER)
+    #if defined(_M_ARM64)
+    #define i_load_acquire(ptr)         (uint32_t)__ldar32((unsigned __int32 volatile*)(ptr))
+    #define i_store_release(ptr, v)     __stlr32((unsigned __int32 volatile*)(ptr), (unsigned __int32)(v))
+    #else
+    #define i_load_acquire(ptr)         (*(volatile uint32_t*)(ptr))
+    #define i_store_release(ptr, v)     _InterlockedExchange((volatile long*)(ptr), (long)(v))
+    #endif
+    #define i_cas32(ptr, expected, v)   i_msvc_cas32((volatile long*)(ptr), expected, v)
+    #define i_add_seq(ptr, v)           (uint32_t)(_InterlockedExchangeAdd((volatile long*)(ptr), (long)(v)) + (long)(v))
+    #define i_load_seq(ptr)             (uint32_t)_InterlockedOr((volatile long*)(ptr), 0)
+    #define i_store_seq(ptr, v)         _InterlockedExchange((volatile long*)(ptr), (long)(v))
+    static __INLINE bool_t i_msvc_cas32(volatile long *ptr, uint32_t *expected, const uint32_t value)
+    {
+        long prev = _InterlockedCompareExchange(ptr, (long)value, (long)*expected);
+        if ((uint32_t)prev == *expected)
+            return TRUE;
+        *expected = (uint32_t)prev;
+        return FALSE;
+    }
+#endif
+
+#define i_MSG_SIZE          1024
+#define i_RING_SLOTS        1024
+#define i_SLOT_DATA         240
+#define i_BATCH_SIZE        (32 * 1024)
+#define i_IDLE_MS           5
+#define i_MAX_CATEGORIES    32
+#define i_CATEGORY_SIZE     32
+#define i_MAX_FIELDS        255
+#define i_BIN_MAGIC         "NLOG"
+#define i_BIN_VERSION       1
+
+typedef struct _slot_t i_Slot;
+typedef struct _msg_t i_Msg;
+typedef struct _category_t i_Category;
+
+/*
+ * Message payload: [text][2 bytes line ending][binary record]
+ * Payloads longer than i_SLOT_DATA are moved to the heap ('big')
+ */
+struct _slot_t
+{
+    uint32_t seq;
+    uint32_t size;
+    uint32_t rsize;
+    char_t *big;
+    char_t data[i_SLOT_DATA];
+};
+
+struct _msg_t
+{
+    char_t *data;
+    uint32_t size;
+    uint32_t alloc;
+    char_t buffer[i_MSG_SIZE];
+};
+
+struct _category_t
+{
+    char_t name[i_CATEGORY_SIZE];
+    uint32_t level;
+};
 
 /*---------------------------------------------------------------------------*/
 
 static Mutex *i_LOG_MUTEX = NULL;
 static bool_t i_LOG_STDOUT = TRUE;
 static bool_t i_LOG_STDERR = FALSE;
+static bool_t i_LOG_BINARY = FALSE;
 static char_t i_LOG_FILEPATH[512] = "";
+static File *i_LOG_FILE = NULL;
+static uint64_t i_LOG_FILE_SIZE = 0;
+static uint64_t i_LOG_FILE_TIME = 0;
+static uint64_t i_ROTATE_SIZE = 0;
+static uint32_t i_ROTATE_SECONDS = 0;
+static uint32_t i_ROTATE_FILES = 0;
+
+/* Runtime filter. 'i_LOG_MIN' is the lowest level of all thresholds (fast reject) */
+static uint32_t i_LOG_LEVEL = ekLOG_INFO;
+static uint32_t i_LOG_MIN = ekLOG_INFO;
+static i_Category i_CATEGORIES[i_MAX_CATEGORIES];
+static uint32_t i_NUM_CATEGORIES = 0;
+static const char_t *i_LEVELS[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+
+/* Async mode. Lock-free MPSC ring, the background thread is the only consumer.
+   'i_LOG_PRODUCERS' counts threads inside i_push, the ring outlives them */
+static i_Slot *i_RING = NULL;
+static uint32_t i_RING_TAIL = 0;
+static uint32_t i_RING_HEAD = 0;
+static uint32_t i_LOG_RUNNING = 0;
+static uint32_t i_LOG_PRODUCERS = 0;
+static Thread *i_LOG_THREAD = NULL;
+static char_t *i_BATCH_STD = NULL;
+static char_t *i_BATCH_FILE = NULL;
+static uint32_t i_BATCH_STD_SIZE = 0;
+static uint32_t i_BATCH_FILE_SIZE = 0;
+
+/* Crash handlers replaced by the log (restored and chained) */
+static const int i_SIGNALS[] = {
+    SIGSEGV, SIGABRT, SIGFPE, SIGILL
+    #if defined(SIGBUS)
+    , SIGBUS
+    #endif
+};
+#define i_NUM_SIGNALS   (sizeof(i_SIGNALS) / sizeof(i_SIGNALS[0]))
+#if defined(__UNIX__)
+static struct sigaction i_PREV_ACTIONS[i_NUM_SIGNALS];
+#else
+static void(*i_PREV_ACTIONS[i_NUM_SIGNALS])(int);
+#endif
+static bool_t i_CRASH_HOOK = FALSE;
 
 /*---------------------------------------------------------------------------*/
 
@@ -39,6 +172,11 @@ void _log_start(void)
 void _log_finish(void)
 {
     cassert(i_LOG_MUTEX != NULL);
+    log_async(FALSE);
+    bmutex_lock(i_LOG_MUTEX);
+    if (i_LOG_FILE != NULL)
+        bfile_close(&i_LOG_FILE);
+    bmutex_unlock(i_LOG_MUTEX);
     bmutex_close(&i_LOG_MUTEX);
 }
 
@@ -60,88 +198,1260 @@ static void i_unlock(void)
 
 /*---------------------------------------------------------------------------*/
 
-uint32_t log_printf(const char_t *format, ...)
+static void i_msg_init(i_Msg *msg)
+{
+    msg->data = msg->buffer;
+    msg->size = 0;
+    msg->alloc = i_MSG_SIZE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_msg_remove(i_Msg *msg)
 {
-    char_t time_buffer[32];
-    char_t msg_buffer[1024];
-    uint32_t time_size = 0;
-    uint32_t msg_size = 0;
-    uint32_t total_size = 0;
+    if (msg->data != msg->buffer)
+        bmem_free((byte_t*)msg->data);
+}
+
+/*---------------------------------------------------------------------------*/
 
+static void i_msg_reserve(i_Msg *msg, const uint32_t size)
+{
+    if (msg->size + size > msg->alloc)
     {
-        Date date;
-        btime_date(&date);
-        time_size = bstd_sprintf(time_buffer, 32, "[%02d:%02d:%02d] ", date.hour, date.minute, date.second);
+        uint32_t alloc = msg->alloc;
+        char_t *data = NULL;
+        while (msg->size + size > alloc)
+            alloc *= 2;
+
+        data = (char_t*)bmem_malloc(alloc);
+        bmem_copy((byte_t*)data, (const byte_t*)msg->data, msg->size);
+        i_msg_remove(msg);
+        msg->data = data;
+        msg->alloc = alloc;
     }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_msg_append(i_Msg *msg, const void *data, const uint32_t size)
+{
+    if (size == 0)
+        return;
+
+    i_msg_reserve(msg, size);
+    bmem_copy((byte_t*)msg->data + msg->size, (const byte_t*)data, size);
+    msg->size += size;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Appends a previous fragment of the message */
+static void i_msg_copy(i_Msg *msg, const uint32_t offset, const uint32_t size)
+{
+    if (size == 0)
+        return;
+
+    i_msg_reserve(msg, size);
+    bmem_copy((byte_t*)msg->data + msg->size, (const byte_t*)msg->data + offset, size);
+    msg->size += size;
+}
+
+/*---------------------------------------------------------------------------*/
 
+/* If the text doesn't fit, the buffer grows and FALSE is returned (format again) */
+static bool_t i_msg_vprintf(i_Msg *msg, const char_t *format, va_list args)
+{
+    uint32_t free = msg->alloc - msg->size;
+    uint32_t n = bstd_vsprintf(msg->data + msg->size, free, format, args);
+    if (n < free)
     {
-        va_list args;
-        va_start(args, format);
-        msg_size = bstd_vsprintf(msg_buffer, 1024, format, args);
-        cassert(msg_size < 1024);
-        va_end(args);
+        msg->size += n;
+        return TRUE;
     }
 
-    i_lock();
+    i_msg_reserve(msg, n + 1);
+    return FALSE;
+}
 
-    if (i_LOG_STDOUT == TRUE)
-        total_size = bstd_printf("%s%s\n", time_buffer, msg_buffer);
+/*---------------------------------------------------------------------------*/
 
-    if (i_LOG_STDERR == TRUE)
-        total_size = bstd_eprintf("%s%s\n", time_buffer, msg_buffer);
+#define i_msg_vformat(msg, format)\
+    {\
+        va_list args;\
+        bool_t ok;\
+        va_start(args, format);\
+        ok = i_msg_vprintf(msg, format, args);\
+        va_end(args);\
+        if (ok == FALSE)\
+        {\
+            va_start(args, format);\
+            ok = i_msg_vprintf(msg, format, args);\
+            va_end(args);\
+            cassert_unref(ok == TRUE, ok);\
+        }\
+    }
 
-    if (i_LOG_FILEPATH[0] != '\0')
+/*---------------------------------------------------------------------------*/
+
+static void i_msg_printf(i_Msg *msg, const char_t *format, ...)
+{
+    i_msg_vformat(msg, format);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_msg_prefix(i_Msg *msg, const uint64_t micro, const uint32_t level, const char_t *category, const uint32_t csize)
+{
+    Date date;
+    btime_to_date(micro, &date);
+    i_msg_printf(msg, "[%02d:%02d:%02d] ", date.hour, date.minute, date.second);
+
+    if (level > 0)
+        i_msg_printf(msg, "%s ", i_LEVELS[level - 1]);
+
+    if (csize > 0)
+        i_msg_printf(msg, "[%.*s] ", (int)csize, category);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Key and string values can be non null-terminated (decoded records) */
+static void i_msg_field(i_Msg *msg, const char_t *key, const uint32_t ksize, const LogField *field, const uint32_t ssize)
+{
+    switch (field->type) {
+    case ekLOG_INT:
+        i_msg_printf(msg, " %.*s=%" PRId64, (int)ksize, key, field->value.i);
+        break;
+    case ekLOG_UINT:
+        i_msg_printf(msg, " %.*s=%" PRIu64, (int)ksize, key, field->value.u);
+        break;
+    case ekLOG_REAL:
+        i_msg_printf(msg, " %.*s=%g", (int)ksize, key, field->value.r);
+        break;
+    case ekLOG_BOOL:
+        i_msg_printf(msg, " %.*s=%s", (int)ksize, key, field->value.b == TRUE ? "true" : "false");
+        break;
+    case ekLOG_STR:
+        i_msg_printf(msg, " %.*s=\"%.*s\"", (int)ksize, key, (int)ssize, field->value.s);
+        break;
+    cassert_default();
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_strlen(const char_t *str)
+{
+    return str != NULL ? blib_strlen(str) : 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Binary record (native endianness)
+ * [u32 size][u64 micro][u8 level][u8 nfields][u16 csize][u32 msize][category][message][fields]
+ * Field: [u8 type][u16 ksize][key][value: 8 bytes (int, uint, real), 1 byte (bool), u32 size + bytes (str)]
+ */
+static void i_msg_record(i_Msg *msg, const uint64_t micro, const uint32_t level, const char_t *category, const uint32_t moffset, const uint32_t msize, const LogField *fields, const uint32_t nfields)
+{
+    uint32_t start = msg->size;
+    uint32_t rsize = 0;
+    uint8_t lv = (uint8_t)level;
+    uint8_t nf = (uint8_t)nfields;
+    uint16_t csize = (uint16_t)i_strlen(category);
+    uint32_t i;
+
+    cassert(nfields <= i_MAX_FIELDS);
+    i_msg_append(msg, &rsize, sizeof32(rsize));
+    i_msg_append(msg, &micro, sizeof32(micro));
+    i_msg_append(msg, &lv, sizeof32(lv));
+    i_msg_append(msg, &nf, sizeof32(nf));
+    i_msg_append(msg, &csize, sizeof32(csize));
+    i_msg_append(msg, &msize, sizeof32(msize));
+    i_msg_append(msg, category, csize);
+    i_msg_copy(msg, moffset, msize);
+
+    for (i = 0; i < nfields; ++i)
     {
-        File *file = bfile_open(i_LOG_FILEPATH, ekAPPEND, NULL);
-        if (file != NULL)
+        uint8_t type = (uint8_t)fields[i].type;
+        uint16_t ksize = (uint16_t)i_strlen(fields[i].key);
+        i_msg_append(msg, &type, sizeof32(type));
+        i_msg_append(msg, &ksize, sizeof32(ksize));
+        i_msg_append(msg, fields[i].key, ksize);
+
+        switch (fields[i].type) {
+        case ekLOG_INT:
+        case ekLOG_UINT:
+        case ekLOG_REAL:
+            i_msg_append(msg, &fields[i].value, 8);
+            break;
+        case ekLOG_BOOL:
         {
-            bfile_write(file, (const byte_t*)time_buffer, time_size, NULL, NULL);
-            bfile_write(file, (const byte_t*)msg_buffer, msg_size, NULL, NULL);
-            bfile_write(file, (const byte_t*)"\r\n", 2, NULL, NULL);
-            bfile_close(&file);
+            uint8_t b = (uint8_t)fields[i].value.b;
+            i_msg_append(msg, &b, sizeof32(b));
+            break;
+        }
+        case ekLOG_STR:
+        {
+            uint32_t ssize = i_strlen(fields[i].value.s);
+            i_msg_append(msg, &ssize, sizeof32(ssize));
+            i_msg_append(msg, fields[i].value.s, ssize);
+            break;
+        }
+        cassert_default();
         }
     }
 
-    i_unlock();
-    return total_size;
+    rsize = msg->size - start - sizeof32(rsize);
+    bmem_copy((byte_t*)msg->data + start, (const byte_t*)&rsize, sizeof32(rsize));
 }
 
 /*---------------------------------------------------------------------------*/
 
-void log_output(const bool_t std, const bool_t err)
+/* Log mutex must be locked */
+static void i_file_header(void)
 {
-    i_lock();
-    i_LOG_STDOUT = std;
-    i_LOG_STDERR = err;
-    i_unlock();
+    if (i_LOG_FILE != NULL && i_LOG_FILE_SIZE == 0 && i_LOG_BINARY == TRUE)
+    {
+        uint32_t version = i_BIN_VERSION;
+        bfile_write(i_LOG_FILE, (const byte_t*)i_BIN_MAGIC, 4, NULL, NULL);
+        bfile_write(i_LOG_FILE, (const byte_t*)&version, sizeof32(version), NULL, NULL);
+        i_LOG_FILE_SIZE = 8;
+    }
 }
 
 /*---------------------------------------------------------------------------*/
 
-void log_file(const char_t *pathname)
+/* Log mutex must be locked */
+static void i_file_open(const bool_t create)
 {
-    i_lock();
-    if (pathname != NULL)
+    if (create == TRUE)
     {
-        File *file = NULL;
-        blib_strcpy(i_LOG_FILEPATH, 512, pathname);
-        file = bfile_create(i_LOG_FILEPATH, NULL);
-        if (file != NULL)
-            bfile_close(&file);
+        i_LOG_FILE = bfile_create(i_LOG_FILEPATH, NULL);
+        i_LOG_FILE_SIZE = 0;
     }
     else
     {
-        i_LOG_FILEPATH[0] = '\0';
+        i_LOG_FILE = bfile_open(i_LOG_FILEPATH, ekAPPEND, NULL);
+        if (i_LOG_FILE != NULL)
+            bfile_fstat(i_LOG_FILE, NULL, &i_LOG_FILE_SIZE, NULL, NULL);
     }
-    i_unlock();
+
+    i_LOG_FILE_TIME = btime_now();
+    i_file_header();
 }
 
 /*---------------------------------------------------------------------------*/
 
-const char_t *log_get_file(void)
+static void i_rotate(const uint32_t nfiles)
+{
+    char_t from[532];
+    char_t to[532];
+    uint32_t i;
+
+    if (i_LOG_FILE != NULL)
+        bfile_close(&i_LOG_FILE);
+
+    /* log.txt --> log.txt.1 --> log.txt.2 ... */
+    if (nfiles > 0)
+    {
+        for (i = nfiles - 1; i > 0; --i)
+        {
+            bstd_sprintf(from, sizeof(from), "%s.%u", i_LOG_FILEPATH, i);
+            bstd_sprintf(to, sizeof(to), "%s.%u", i_LOG_FILEPATH, i + 1);
+            bfile_rename(from, to, NULL);
+        }
+
+        bstd_sprintf(to, sizeof(to), "%s.1", i_LOG_FILEPATH);
+        bfile_rename(i_LOG_FILEPATH, to, NULL);
+    }
+
+    i_file_open(TRUE);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Log mutex must be locked */
+static void i_file_write(const char_t *data, const uint32_t size)
 {
     if (i_LOG_FILEPATH[0] == '\0')
-        return NULL;
+        return;
+
+    /* The handle remains open between messages */
+    if (i_LOG_FILE == NULL)
+    {
+        i_file_open(FALSE);
+        if (i_LOG_FILE == NULL)
+            return;
+    }
+
+    if (i_ROTATE_SECONDS > 0 && btime_now() - i_LOG_FILE_TIME >= (uint64_t)i_ROTATE_SECONDS * 1000000)
+        i_rotate(i_ROTATE_FILES);
+
+    if (i_ROTATE_SIZE > 0 && i_LOG_FILE_SIZE > 8 && i_LOG_FILE_SIZE + size > i_ROTATE_SIZE)
+        i_rotate(i_ROTATE_FILES);
+
+    if (i_LOG_FILE != NULL)
+    {
+        bfile_write(i_LOG_FILE, (const byte_t*)data, size, NULL, NULL);
+        i_LOG_FILE_SIZE += size;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_std_write(const char_t *data, const uint32_t size)
+{
+    if (i_LOG_STDOUT == TRUE)
+        bstd_write((const byte_t*)data, size, NULL);
+
+    if (i_LOG_STDERR == TRUE)
+        bstd_ewrite((const byte_t*)data, size, NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* 'data' has two extra bytes for the line ending after the text */
+static void i_write(char_t *data, const uint32_t size, const uint32_t rsize)
+{
+    data[size] = '\n';
+    i_std_write(data, size + 1);
+
+    if (rsize > 0)
+    {
+        i_file_write(data + size + 2, rsize);
+    }
     else
-        return i_LOG_FILEPATH;
+    {
+        data[size] = '\r';
+        data[size + 1] = '\n';
+        i_file_write(data, size + 2);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_batch_flush(void)
+{
+    if (i_BATCH_STD_SIZE > 0)
+    {
+        i_std_write(i_BATCH_STD, i_BATCH_STD_SIZE);
+        i_BATCH_STD_SIZE = 0;
+    }
+
+    if (i_BATCH_FILE_SIZE > 0)
+    {
+        i_file_write(i_BATCH_FILE, i_BATCH_FILE_SIZE);
+        i_BATCH_FILE_SIZE = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_batch_add(char_t *data, const uint32_t size, const uint32_t rsize)
+{
+    uint32_t fsize = rsize > 0 ? rsize : size + 2;
+
+    if (i_BATCH_STD_SIZE + size + 1 > i_BATCH_SIZE || i_BATCH_FILE_SIZE + fsize > i_BATCH_SIZE)
+        i_batch_flush();
+
+    /* Too big for batching */
+    if (size + 2 > i_BATCH_SIZE || fsize > i_BATCH_SIZE)
+    {
+        i_write(data, size, rsize);
+        return;
+    }
+
+    if (i_LOG_STDOUT == TRUE || i_LOG_STDERR == TRUE)
+    {
+        bmem_copy((byte_t*)i_BATCH_STD + i_BATCH_STD_SIZE, (const byte_t*)data, size);
+        i_BATCH_STD[i_BATCH_STD_SIZE + size] = '\n';
+        i_BATCH_STD_SIZE += size + 1;
+    }
+
+    if (i_LOG_FILEPATH[0] != '\0')
+    {
+        if (rsize > 0)
+        {
+            bmem_copy((byte_t*)i_BATCH_FILE + i_BATCH_FILE_SIZE, (const byte_t*)data + size + 2, rsize);
+        }
+        else
+        {
+            bmem_copy((byte_t*)i_BATCH_FILE + i_BATCH_FILE_SIZE, (const byte_t*)data, size);
+            i_BATCH_FILE[i_BATCH_FILE_SIZE + size] = '\r';
+            i_BATCH_FILE[i_BATCH_FILE_SIZE + size + 1] = '\n';
+        }
+
+        i_BATCH_FILE_SIZE += fsize;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Only one consumer at a time. Log mutex must be locked */
+static uint32_t i_drain(void)
+{
+    uint32_t n = 0;
+    if (i_RING == NULL)
+        return 0;
+
+    for (;;)
+    {
+        i_Slot *slot = &i_RING[i_RING_HEAD & (i_RING_SLOTS - 1)];
+        uint32_t seq = i_load_acquire(&slot->seq);
+        if (seq != i_RING_HEAD + 1)
+            break;
+
+        if (slot->big != NULL)
+        {
+            i_batch_add(slot->big, slot->size, slot->rsize);
+            bmem_free((byte_t*)slot->big);
+            slot->big = NULL;
+        }
+        else
+        {
+            i_batch_add(slot->data, slot->size, slot->rsize);
+        }
+
+        i_store_release(&slot->seq, i_RING_HEAD + i_RING_SLOTS);
+        i_RING_HEAD += 1;
+        n += 1;
+    }
+
+    i_batch_flush();
+    return n;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_log_thread(i_Slot *ring)
+{
+    unref(ring);
+    while (i_load_acquire(&i_LOG_RUNNING) == 1)
+    {
+        uint32_t n;
+        bmutex_lock(i_LOG_MUTEX);
+        n = i_drain();
+        bmutex_unlock(i_LOG_MUTEX);
+        if (n == 0)
+            bthread_sleep(i_IDLE_MS);
+    }
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Crash handler output: direct system calls, no locks and no heap */
+static void i_crash_write(const char_t *data, const uint32_t size, const bool_t file)
+{
+    #if defined(__UNIX__)
+    ssize_t ret = 0;
+    if (file == FALSE)
+    {
+        if (i_LOG_STDOUT == TRUE)
+            ret = write(STDOUT_FILENO, data, (size_t)size);
+        if (i_LOG_STDERR == TRUE)
+            ret = write(STDERR_FILENO, data, (size_t)size);
+    }
+    else if (i_LOG_FILE != NULL)
+    {
+        ret = write((int)(intptr_t)i_LOG_FILE, data, (size_t)size);
+    }
+    unref(ret);
+    #else
+    if (file == FALSE)
+    {
+        if (i_LOG_STDOUT == TRUE)
+            _write(1, data, (unsigned int)size);
+        if (i_LOG_STDERR == TRUE)
+            _write(2, data, (unsigned int)size);
+    }
+    else if (i_LOG_FILE != NULL)
+    {
+        /* A single WriteFile */
+        bfile_write(i_LOG_FILE, (const byte_t*)data, size, NULL, NULL);
+    }
+    #endif
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Best effort. The process is dying and the consumer may hold the lock:
+ * committed slots are written as they are, without consuming them.
+ * Then the previous handler takes the signal.
+ */
+static void i_crash_handler(int sig)
+{
+    uint32_t i;
+    if (i_RING != NULL)
+    {
+        uint32_t head = i_load_acquire(&i_RING_HEAD);
+        for (;;)
+        {
+            const i_Slot *slot = &i_RING[head & (i_RING_SLOTS - 1)];
+            const char_t *data = NULL;
+            if (i_load_acquire(&slot->seq) != head + 1)
+                break;
+
+            data = slot->big != NULL ? slot->big : slot->data;
+            i_crash_write(data, slot->size, FALSE);
+            i_crash_write("\n", 1, FALSE);
+            if (slot->rsize > 0)
+            {
+                i_crash_write(data + slot->size + 2, slot->rsize, TRUE);
+            }
+            else
+            {
+                i_crash_write(data, slot->size, TRUE);
+                i_crash_write("\r\n", 2, TRUE);
+            }
+
+            head += 1;
+        }
+    }
+
+    for (i = 0; i < i_NUM_SIGNALS; ++i)
+    {
+        if (i_SIGNALS[i] == sig)
+        {
+            #if defined(__UNIX__)
+            sigaction(sig, &i_PREV_ACTIONS[i], NULL);
+            #else
+            signal(sig, i_PREV_ACTIONS[i]);
+            #endif
+            break;
+        }
+    }
+
+    raise(sig);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Previous handlers are restored only if the application did not replace ours */
+static void i_crash_hook(const bool_t install)
+{
+    uint32_t i;
+    if (install == i_CRASH_HOOK)
+        return;
+
+    for (i = 0; i < i_NUM_SIGNALS; ++i)
+    {
+        #if defined(__UNIX__)
+        if (install == TRUE)
+        {
+            struct sigaction action;
+            bmem_zero(&action, struct sigaction);
+            action.sa_handler = i_crash_handler;
+            sigemptyset(&action.sa_mask);
+            sigaction(i_SIGNALS[i], &action, &i_PREV_ACTIONS[i]);
+        }
+        else
+        {
+            struct sigaction current;
+            sigaction(i_SIGNALS[i], NULL, &current);
+            if (current.sa_handler == i_crash_handler)
+                sigaction(i_SIGNALS[i], &i_PREV_ACTIONS[i], NULL);
+        }
+        #else
+        if (install == TRUE)
+        {
+            i_PREV_ACTIONS[i] = signal(i_SIGNALS[i], i_crash_handler);
+        }
+        else
+        {
+            void(*current)(int) = signal(i_SIGNALS[i], i_PREV_ACTIONS[i]);
+            if (current != i_crash_handler)
+                signal(i_SIGNALS[i], current);
+        }
+        #endif
+    }
+
+    i_CRASH_HOOK = install;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Heap messages are transferred to the ring */
+static bool_t i_push(i_Msg *msg, const uint32_t size, const uint32_t rsize)
+{
+    uint32_t pos = i_load_acquire(&i_RING_TAIL);
+    for (;;)
+    {
+        i_Slot *slot = &i_RING[pos & (i_RING_SLOTS - 1)];
+        uint32_t seq = i_load_acquire(&slot->seq);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0)
+        {
+            if (i_cas32(&i_RING_TAIL, &pos, pos + 1))
+            {
+                if (msg->size <= i_SLOT_DATA)
+                {
+                    bmem_copy((byte_t*)slot->data, (const byte_t*)msg->data, msg->size);
+                    slot->big = NULL;
+                }
+                else if (msg->data != msg->buffer)
+                {
+                    slot->big = msg->data;
+                    msg->data = msg->buffer;
+                }
+                else
+                {
+                    slot->big = (char_t*)bmem_malloc(msg->size);
+                    bmem_copy((byte_t*)slot->big, (const byte_t*)msg->data, msg->size);
+                }
+
+                slot->size = size;
+                slot->rsize = rsize;
+                i_store_release(&slot->seq, pos + 1);
+                return TRUE;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* Ring is full */
+            return FALSE;
+        }
+        else
+        {
+            pos = i_load_acquire(&i_RING_TAIL);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_begin(i_Msg *msg, uint64_t *micro, const uint32_t level, const char_t *category)
+{
+    i_msg_init(msg);
+    *micro = btime_now();
+    i_msg_prefix(msg, *micro, level, category, i_strlen(category));
+    return msg->size;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* Fields are serialized only here, when the message passed the filters */
+static uint32_t i_end(i_Msg *msg, const uint64_t micro, const uint32_t level, const char_t *category, const uint32_t moffset, const LogField *fields, const uint32_t nfields)
+{
+    uint32_t msize = msg->size - moffset;
+    uint32_t size = 0;
+    uint32_t rsize = 0;
+    uint32_t i;
+    bool_t pushed = FALSE;
+
+    for (i = 0; i < nfields; ++i)
+    {
+        uint32_t ssize = fields[i].type == ekLOG_STR ? i_strlen(fields[i].value.s) : 0;
+        i_msg_field(msg, fields[i].key, i_strlen(fields[i].key), &fields[i], ssize);
+    }
+
+    /* Line ending */
+    size = msg->size;
+    i_msg_reserve(msg, 2);
+    msg->size += 2;
+
+    if (i_LOG_BINARY == TRUE && i_LOG_FILEPATH[0] != '\0')
+    {
+        i_msg_record(msg, micro, level, category, moffset, msize, fields, nfields);
+        rsize = msg->size - size - 2;
+    }
+
+    if (i_load_acquire(&i_LOG_RUNNING) == 1)
+    {
+        /* Registered before the second check: log_async(FALSE) waits for us */
+        i_add_seq(&i_LOG_PRODUCERS, 1);
+        if (i_load_seq(&i_LOG_RUNNING) == 1)
+        {
+            /* Ring full --> wait the consumer */
+            while (i_push(msg, size, rsize) == FALSE)
+                bthread_sleep(1);
+            pushed = TRUE;
+        }
+        i_add_seq(&i_LOG_PRODUCERS, (uint32_t)-1);
+    }
+
+    if (pushed == FALSE)
+    {
+        i_lock();
+        i_write(msg->data, size, rsize);
+        i_unlock();
+    }
+
+    i_msg_remove(msg);
+    return size;
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t log_printf(const char_t *format, ...)
+{
+    i_Msg msg;
+    uint64_t micro = 0;
+    uint32_t moffset = i_begin(&msg, &micro, 0, NULL);
+    uint32_t size = 0;
+    i_msg_vformat(&msg, format);
+    size = i_end(&msg, micro, 0, NULL, moffset, NULL, 0);
+
+    if (i_LOG_STDOUT == TRUE || i_LOG_STDERR == TRUE)
+        return size + 1;
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_output(const bool_t std, const bool_t err)
+{
+    i_lock();
+    i_LOG_STDOUT = std;
+    i_LOG_STDERR = err;
+    i_unlock();
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_file(const char_t *pathname)
+{
+    i_lock();
+    i_drain();
+
+    if (i_LOG_FILE != NULL)
+        bfile_close(&i_LOG_FILE);
+
+    if (pathname != NULL)
+    {
+        blib_strcpy(i_LOG_FILEPATH, 512, pathname);
+        i_file_open(TRUE);
+    }
+    else
+    {
+        i_LOG_FILEPATH[0] = '\0';
+    }
+    i_unlock();
+}
+
+/*---------------------------------------------------------------------------*/
+
+const char_t *log_get_file(void)
+{
+    if (i_LOG_FILEPATH[0] == '\0')
+        return NULL;
+    else
+        return i_LOG_FILEPATH;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_async(const bool_t async)
+{
+    cassert(i_LOG_MUTEX != NULL);
+    if (async == TRUE && i_RING == NULL)
+    {
+        uint32_t i;
+        i_RING = (i_Slot*)bmem_malloc(sizeof32(i_Slot) * i_RING_SLOTS);
+        for (i = 0; i < i_RING_SLOTS; ++i)
+        {
+            i_RING[i].seq = i;
+            i_RING[i].big = NULL;
+        }
+
+        i_RING_HEAD = 0;
+        i_RING_TAIL = 0;
+        i_BATCH_STD = (char_t*)bmem_malloc(i_BATCH_SIZE);
+        i_BATCH_FILE = (char_t*)bmem_malloc(i_BATCH_SIZE);
+        i_store_release(&i_LOG_RUNNING, 1);
+        i_LOG_THREAD = bthread_create(i_log_thread, i_RING, i_Slot);
+        i_crash_hook(TRUE);
+    }
+    else if (async == FALSE && i_RING != NULL)
+    {
+        i_store_seq(&i_LOG_RUNNING, 0);
+
+        /* Producers that saw the ring running, maybe waiting for free slots */
+        for (;;)
+        {
+            bmutex_lock(i_LOG_MUTEX);
+            i_drain();
+            bmutex_unlock(i_LOG_MUTEX);
+            if (i_load_seq(&i_LOG_PRODUCERS) == 0)
+                break;
+            bthread_sleep(1);
+        }
+
+        bthread_wait(i_LOG_THREAD);
+        bthread_close(&i_LOG_THREAD);
+        i_crash_hook(FALSE);
+
+        /* Pending messages */
+        bmutex_lock(i_LOG_MUTEX);
+        i_drain();
+        bmutex_unlock(i_LOG_MUTEX);
+
+        bmem_free((byte_t*)i_RING);
+        bmem_free((byte_t*)i_BATCH_STD);
+        bmem_free((byte_t*)i_BATCH_FILE);
+        i_RING = NULL;
+        i_BATCH_STD = NULL;
+        i_BATCH_FILE = NULL;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_rotate(const uint64_t max_size, const uint32_t max_seconds, const uint32_t max_files)
+{
+    i_lock();
+    i_ROTATE_SIZE = max_size;
+    i_ROTATE_SECONDS = max_seconds;
+    i_ROTATE_FILES = max_files;
+    i_unlock();
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_flush(void)
+{
+    i_lock();
+    i_drain();
+    i_unlock();
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_update_min(void)
+{
+    uint32_t min = i_LOG_LEVEL;
+    uint32_t i;
+    for (i = 0; i < i_NUM_CATEGORIES; ++i)
+    {
+        if (i_CATEGORIES[i].level < min)
+            min = i_CATEGORIES[i].level;
+    }
+
+    i_LOG_MIN = min;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_level(const log_level_t level)
+{
+    i_lock();
+    i_LOG_LEVEL = (uint32_t)level;
+    i_update_min();
+    i_unlock();
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_category(const char_t *category, const log_level_t level)
+{
+    uint32_t i;
+    cassert_no_null(category);
+    cassert(blib_strlen(category) < i_CATEGORY_SIZE);
+    i_lock();
+
+    for (i = 0; i < i_NUM_CATEGORIES; ++i)
+    {
+        if (blib_strcmp(i_CATEGORIES[i].name, category) == 0)
+            break;
+    }
+
+    if (i < i_NUM_CATEGORIES)
+    {
+        i_CATEGORIES[i].level = (uint32_t)level;
+    }
+    else if (i < i_MAX_CATEGORIES)
+    {
+        /* Readers don't lock, publish the entry after filling it */
+        blib_strcpy(i_CATEGORIES[i].name, i_CATEGORY_SIZE, category);
+        i_CATEGORIES[i].level = (uint32_t)level;
+        i_store_release(&i_NUM_CATEGORIES, i + 1);
+    }
+    else
+    {
+        cassert_msg(FALSE, "Too many log categories");
+    }
+
+    i_update_min();
+    i_unlock();
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t log_enabled(const log_level_t level, const char_t *category)
+{
+    if ((uint32_t)level < i_LOG_MIN)
+        return FALSE;
+
+    if (category != NULL)
+    {
+        uint32_t n = i_load_acquire(&i_NUM_CATEGORIES);
+        uint32_t i;
+        for (i = 0; i < n; ++i)
+        {
+            if (blib_strcmp(i_CATEGORIES[i].name, category) == 0)
+                return (bool_t)((uint32_t)level >= i_CATEGORIES[i].level);
+        }
+    }
+
+    return (bool_t)((uint32_t)level >= i_LOG_LEVEL);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_msg(const log_level_t level, const char_t *category, const char_t *format, ...)
+{
+    if (log_enabled(level, category) == TRUE)
+    {
+        i_Msg msg;
+        uint64_t micro = 0;
+        uint32_t moffset = i_begin(&msg, &micro, (uint32_t)level, category);
+        i_msg_vformat(&msg, format);
+        i_end(&msg, micro, (uint32_t)level, category, moffset, NULL, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_trace(const char_t *category, const char_t *format, ...)
+{
+    if (log_enabled(ekLOG_TRACE, category) == TRUE)
+    {
+        i_Msg msg;
+        uint64_t micro = 0;
+        uint32_t moffset = i_begin(&msg, &micro, ekLOG_TRACE, category);
+        i_msg_vformat(&msg, format);
+        i_end(&msg, micro, ekLOG_TRACE, category, moffset, NULL, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_debug(const char_t *category, const char_t *format, ...)
+{
+    if (log_enabled(ekLOG_DEBUG, category) == TRUE)
+    {
+        i_Msg msg;
+        uint64_t micro = 0;
+        uint32_t moffset = i_begin(&msg, &micro, ekLOG_DEBUG, category);
+        i_msg_vformat(&msg, format);
+        i_end(&msg, micro, ekLOG_DEBUG, category, moffset, NULL, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_info(const char_t *category, const char_t *format, ...)
+{
+    if (log_enabled(ekLOG_INFO, category) == TRUE)
+    {
+        i_Msg msg;
+        uint64_t micro = 0;
+        uint32_t moffset = i_begin(&msg, &micro, ekLOG_INFO, category);
+        i_msg_vformat(&msg, format);
+        i_end(&msg, micro, ekLOG_INFO, category, moffset, NULL, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_warn(const char_t *category, const char_t *format, ...)
+{
+    if (log_enabled(ekLOG_WARN, category) == TRUE)
+    {
+        i_Msg msg;
+        uint64_t micro = 0;
+        uint32_t moffset = i_begin(&msg, &micro, ekLOG_WARN, category);
+        i_msg_vformat(&msg, format);
+        i_end(&msg, micro, ekLOG_WARN, category, moffset, NULL, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_error(const char_t *category, const char_t *format, ...)
+{
+    if (log_enabled(ekLOG_ERROR, category) == TRUE)
+    {
+        i_Msg msg;
+        uint64_t micro = 0;
+        uint32_t moffset = i_begin(&msg, &micro, ekLOG_ERROR, category);
+        i_msg_vformat(&msg, format);
+        i_end(&msg, micro, ekLOG_ERROR, category, moffset, NULL, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_fields(const log_level_t level, const char_t *category, const char_t *message, const LogField *fields, const uint32_t nfields)
+{
+    cassert(fields != NULL || nfields == 0);
+    if (log_enabled(level, category) == TRUE)
+    {
+        i_Msg msg;
+        uint64_t micro = 0;
+        uint32_t moffset = i_begin(&msg, &micro, (uint32_t)level, category);
+        i_msg_append(&msg, message, i_strlen(message));
+        i_end(&msg, micro, (uint32_t)level, category, moffset, fields, nfields);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+LogField log_int(const char_t *key, const int64_t value)
+{
+    LogField field;
+    field.key = key;
+    field.type = ekLOG_INT;
+    field.value.i = value;
+    return field;
+}
+
+/*---------------------------------------------------------------------------*/
+
+LogField log_uint(const char_t *key, const uint64_t value)
+{
+    LogField field;
+    field.key = key;
+    field.type = ekLOG_UINT;
+    field.value.u = value;
+    return field;
+}
+
+/*---------------------------------------------------------------------------*/
+
+LogField log_real(const char_t *key, const real64_t value)
+{
+    LogField field;
+    field.key = key;
+    field.type = ekLOG_REAL;
+    field.value.r = value;
+    return field;
+}
+
+/*---------------------------------------------------------------------------*/
+
+LogField log_bool(const char_t *key, const bool_t value)
+{
+    LogField field;
+    field.key = key;
+    field.type = ekLOG_BOOL;
+    field.value.b = value;
+    return field;
+}
+
+/*---------------------------------------------------------------------------*/
+
+LogField log_str(const char_t *key, const char_t *value)
+{
+    LogField field;
+    field.key = key;
+    field.type = ekLOG_STR;
+    field.value.s = value;
+    return field;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void log_binary(const bool_t binary)
+{
+    i_lock();
+    i_drain();
+    if (i_LOG_BINARY != binary)
+    {
+        i_LOG_BINARY = binary;
+
+        /* Text and binary records never share a file: 'log_decode' needs the
+           header at offset 0. An empty file is only stamped (or restarted), a
+           file with records moves to 'path.1' (at least one backup is kept) */
+        if (i_LOG_FILE != NULL)
+        {
+            if (i_LOG_FILE_SIZE == 0)
+                i_file_header();
+            else if (binary == FALSE && i_LOG_FILE_SIZE == 8)
+                i_rotate(0);
+            else
+                i_rotate(i_ROTATE_FILES > 0 ? i_ROTATE_FILES : 1);
+        }
+    }
+    i_unlock();
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_read(File *file, void *data, const uint32_t size)
+{
+    uint32_t total = 0;
+    while (total < size)
+    {
+        uint32_t rsize = 0;
+        if (bfile_read(file, (byte_t*)data + total, size - total, &rsize, NULL) == FALSE || rsize == 0)
+            return FALSE;
+        total += rsize;
+    }
+
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#define i_take(dest, size)\
+    if (offset + (size) > rsize)\
+        return FALSE;\
+    bmem_copy((byte_t*)(dest), record + offset, (size));\
+    offset += (size)
+
+/*---------------------------------------------------------------------------*/
+
+/* Binary record --> Text line */
+static bool_t i_decode(const byte_t *record, const uint32_t rsize, i_Msg *msg)
+{
+    uint32_t offset = 0;
+    uint64_t micro = 0;
+    uint8_t level = 0;
+    uint8_t nfields = 0;
+    uint16_t csize = 0;
+    uint32_t msize = 0;
+    const char_t *category = NULL;
+    uint32_t i;
+
+    i_take(&micro, sizeof32(micro));
+    i_take(&level, sizeof32(level));
+    i_take(&nfields, sizeof32(nfields));
+    i_take(&csize, sizeof32(csize));
+    i_take(&msize, sizeof32(msize));
+
+    if (level > ekLOG_ERROR || (uint64_t)offset + csize + msize > rsize)
+        return FALSE;
+
+    category = (const char_t*)record + offset;
+    i_msg_prefix(msg, micro, level, category, csize);
+    i_msg_append(msg, record + offset + csize, msize);
+    offset += csize + msize;
+
+    for (i = 0; i < nfields; ++i)
+    {
+        LogField field;
+        uint8_t type = 0;
+        uint16_t ksize = 0;
+        uint32_t ssize = 0;
+        const char_t *key = NULL;
+        i_take(&type, sizeof32(type));
+        i_take(&ksize, sizeof32(ksize));
+        if (offset + ksize > rsize)
+            return FALSE;
+
+        key = (const char_t*)record + offset;
+        offset += ksize;
+        field.type = (log_field_t)type;
+
+        switch (field.type) {
+        case ekLOG_INT:
+        case ekLOG_UINT:
+        case ekLOG_REAL:
+            i_take(&field.value, 8);
+            break;
+        case ekLOG_BOOL:
+        {
+            uint8_t b = 0;
+            i_take(&b, sizeof32(b));
+            field.value.b = (bool_t)b;
+            break;
+        }
+        case ekLOG_STR:
+            i_take(&ssize, sizeof32(ssize));
+            if ((uint64_t)offset + ssize > rsize)
+                return FALSE;
+            field.value.s = (const char_t*)record + offset;
+            offset += ssize;
+            break;
+        default:
+            return FALSE;
+        }
+
+        i_msg_field(msg, key, ksize, &field, ssize);
+    }
+
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t log_decode(const char_t *binpath, const char_t *txtpath, ferror_t *error)
+{
+    File *in = bfile_open(binpath, ekREAD, error);
+    File *out = NULL;
+    bool_t ok = FALSE;
+
+    if (in != NULL)
+    {
+        char_t magic[4];
+        uint32_t version = 0;
+        if (i_read(in, magic, 4) == TRUE && i_read(in, &version, sizeof32(version)) == TRUE && blib_strncmp(magic, i_BIN_MAGIC, 4) == 0 && version == i_BIN_VERSION)
+            out = bfile_create(txtpath, error);
+        else
+            ptr_assign(error, ekFUNDEF);
+    }
+
+    if (out != NULL)
+    {
+        i_Msg msg;
+        byte_t *record = NULL;
+        uint32_t ralloc = 0;
+        uint32_t rsize = 0;
+        uint64_t left = 0;
+        ok = bfile_fstat(in, NULL, &left, NULL, error);
+        left = left > 8 ? left - 8 : 0;
+
+        while (ok == TRUE && i_read(in, &rsize, sizeof32(rsize)) == TRUE)
+        {
+            /* A corrupt or truncated file never drives the allocation */
+            if (left < sizeof32(rsize) || (uint64_t)rsize > left - sizeof32(rsize))
+            {
+                ptr_assign(error, ekFUNDEF);
+                ok = FALSE;
+                break;
+            }
+
+            left -= sizeof32(rsize) + (uint64_t)rsize;
+            if ((uint64_t)rsize + 2 > (uint64_t)ralloc)
+            {
+                if (record != NULL)
+                    bmem_free(record);
+                ralloc = rsize + 2;
+                record = bmem_malloc(ralloc);
+            }
+
+            i_msg_init(&msg);
+            if (i_read(in, record, rsize) == TRUE && i_decode(record, rsize, &msg) == TRUE)
+            {
+                i_msg_append(&msg, "\r\n", 2);
+                ok = bfile_write(out, (const byte_t*)msg.data, msg.size, NULL, error);
+            }
+            else
+            {
+                ptr_assign(error, ekFUNDEF);
+                ok = FALSE;
+            }
+
+            i_msg_remove(&msg);
+        }
+
+        if (record != NULL)
+            bmem_free(record);
+
+        if (ok == TRUE)
+            ptr_assign(error, ekFOK);
+    }
+
+    if (in != NULL)
+        bfile_close(&in);
+
+    if (out != NULL)
+        bfile_close(&out);
+
+    return ok;
 }
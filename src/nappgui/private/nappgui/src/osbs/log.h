@@ -23,4 +23,69 @@ _osbs_api void log_file(const char_t *pathname);
 
 _osbs_api const char_t *log_get_file(void);
 
+_osbs_api void log_async(const bool_t async);
+
+_osbs_api void log_rotate(const uint64_t max_size, const uint32_t max_seconds, const uint32_t max_files);
+
+_osbs_api void log_flush(void);
+
+_osbs_api void log_level(const log_level_t level);
+
+_osbs_api void log_category(const char_t *category, const log_level_t level);
+
+_osbs_api bool_t log_enabled(const log_level_t level, const char_t *category);
+
+_osbs_api void log_msg(const log_level_t level, const char_t *category, const char_t *format, ...) __PRINTF(3, 4);
+
+_osbs_api void log_trace(const char_t *category, const char_t *format, ...) __PRINTF(2, 3);
+
+_osbs_api void log_debug(const char_t *category, const char_t *format, ...) __PRINTF(2, 3);
+
+_osbs_api void log_info(const char_t *category, const char_t *format, ...) __PRINTF(2, 3);
+
+_osbs_api void log_warn(const char_t *category, const char_t *format, ...) __PRINTF(2, 3);
+
+_osbs_api void log_error(const char_t *category, const char_t *format, ...) __PRINTF(2, 3);
+
+_osbs_api void log_fields(const log_level_t level, const char_t *category, const char_t *message, const LogField *fields, const uint32_t nfields);
+
+_osbs_api LogField log_int(const char_t *key, const int64_t value);
+
+_osbs_api LogField log_uint(const char_t *key, const uint64_t value);
+
+_osbs_api LogField log_real(const char_t *key, const real64_t value);
+
+_osbs_api LogField log_bool(const char_t *key, const bool_t value);
+
+_osbs_api LogField log_str(const char_t *key, const char_t *value);
+
+_osbs_api void log_binary(const bool_t binary);
+
+_osbs_api bool_t log_decode(const char_t *binpath, const char_t *txtpath, ferror_t *error);
+
 __END_C
+
+/* Calls below LOG_MIN_LEVEL are compiled out, arguments are not evaluated */
+#if !defined(LOG_MIN_LEVEL)
+    #if defined(__ASSERTS__)
+        #define LOG_MIN_LEVEL   1
+    #else
+        #define LOG_MIN_LEVEL   3
+    #endif
+#endif
+
+#if LOG_MIN_LEVEL > 1
+    #define log_trace   1 ? (void)0 : (void)log_trace
+#endif
+
+#if LOG_MIN_LEVEL > 2
+    #define log_debug   1 ? (void)0 : (void)log_debug
+#endif
+
+#if LOG_MIN_LEVEL > 3
+    #define log_info    1 ? (void)0 : (void)log_info
+#endif
+
+#if LOG_MIN_LEVEL > 4
+    #define log_warn    1 ? (void)0 : (void)log_warn
+#endif
@@ -20,6 +20,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -28,10 +29,13 @@
 
 #if defined (__MACOS__)
 #include <sys/syslimits.h>
+#include <copyfile.h>
 #endif
 
 #if defined (__LINUX__)
 #include <sys/types.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
 #include <time.h>
 int lstat(const char *path, struct stat *buf);
 
@@ -558,6 +562,214 @@ bool_t bfile_write(File *file, const byte_t *data, const uint32_t size, uint32_t
 
 /*---------------------------------------------------------------------------*/
 
+/* Single system calls are limited to 1GB */
+#define i_IO_CHUNK  0x40000000
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bfile_read64(File *file, byte_t *data, const uint64_t size, uint64_t *rsize, ferror_t *error)
+{
+    uint64_t total = 0;
+    ferror_t lerror = ekFOK;
+    cassert_no_null(file);
+    while (total < size)
+    {
+        uint64_t remain = size - total;
+        uint32_t chunk = remain < i_IO_CHUNK ? (uint32_t)remain : i_IO_CHUNK;
+        uint32_t nread = 0;
+        if (bfile_read(file, data + total, chunk, &nread, &lerror) == FALSE)
+            break;
+        total += nread;
+    }
+
+    ptr_assign(rsize, total);
+    ptr_assign(error, lerror);
+    /* End of file or error */
+    if (total == 0 && size > 0)
+        return FALSE;
+    return (bool_t)(lerror == ekFOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bfile_write64(File *file, const byte_t *data, const uint64_t size, uint64_t *wsize, ferror_t *error)
+{
+    uint64_t total = 0;
+    ferror_t lerror = ekFOK;
+    cassert_no_null(file);
+    while (total < size)
+    {
+        uint64_t remain = size - total;
+        uint32_t chunk = remain < i_IO_CHUNK ? (uint32_t)remain : i_IO_CHUNK;
+        uint32_t nwritten = 0;
+        if (bfile_write(file, data + total, chunk, &nwritten, &lerror) == FALSE)
+            break;
+        total += nwritten;
+        if (nwritten < chunk)
+            break;
+    }
+
+    ptr_assign(wsize, total);
+    ptr_assign(error, lerror);
+    return (bool_t)(lerror == ekFOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#define i_COPY_BUFFER   (256 * 1024)
+
+/*---------------------------------------------------------------------------*/
+
+static ferror_t i_copy_error(void)
+{
+    switch (errno)
+    {
+        case EFBIG:
+        case ENOSPC:
+            return ekFBIG;
+        case EACCES:
+        case EPERM:
+        case EBADF:
+            return ekFNOACCESS;
+        default:
+            return ekFUNDEF;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if defined (__LINUX__)
+
+/* Kernel-side copies. Returns FALSE if not supported for these files (fallback) */
+static bool_t i_kernel_copy(const int fdin, const int fdout, const uint64_t size, uint64_t *csize, ferror_t *error)
+{
+    bool_t use_sendfile = FALSE;
+
+    #if defined (__NR_copy_file_range)
+    while (*csize < size)
+    {
+        uint64_t remain = size - *csize;
+        size_t chunk = remain < 0x40000000 ? (size_t)remain : 0x40000000;
+        long ret = syscall(__NR_copy_file_range, fdin, NULL, fdout, NULL, chunk, 0u);
+        if (ret > 0)
+        {
+            *csize += (uint64_t)ret;
+        }
+        else if (ret == 0)
+        {
+            /* End of source file */
+            return TRUE;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (*csize == 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP))
+        {
+            use_sendfile = TRUE;
+            break;
+        }
+        else
+        {
+            *error = i_copy_error();
+            return TRUE;
+        }
+    }
+
+    if (use_sendfile == FALSE)
+        return TRUE;
+    #endif
+
+    unref(use_sendfile);
+    while (*csize < size)
+    {
+        uint64_t remain = size - *csize;
+        size_t chunk = remain < 0x40000000 ? (size_t)remain : 0x40000000;
+        ssize_t ret = sendfile(fdout, fdin, NULL, chunk);
+        if (ret > 0)
+        {
+            *csize += (uint64_t)ret;
+        }
+        else if (ret == 0)
+        {
+            return TRUE;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (*csize == 0 && (errno == ENOSYS || errno == EINVAL))
+        {
+            return FALSE;
+        }
+        else
+        {
+            *error = i_copy_error();
+            return TRUE;
+        }
+    }
+
+    return TRUE;
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bfile_copy(File *from, File *to, const uint64_t size, uint64_t *csize, ferror_t *error)
+{
+    int fdin = (int)(intptr_t)from;
+    int fdout = (int)(intptr_t)to;
+    uint64_t copied = 0;
+    ferror_t lerror = ekFOK;
+    bool_t done = FALSE;
+    cassert_no_null(from);
+    cassert_no_null(to);
+
+    #if defined (__LINUX__)
+    done = i_kernel_copy(fdin, fdout, size, &copied, &lerror);
+    #elif defined (__MACOS__)
+    /* fcopyfile copies the whole file from the current positions */
+    if (fcopyfile(fdin, fdout, NULL, COPYFILE_DATA) == 0)
+    {
+        copied = size;
+        done = TRUE;
+    }
+    #endif
+
+    /* User-space fallback with a big buffer */
+    if (done == FALSE)
+    {
+        byte_t *buffer = bmem_malloc(i_COPY_BUFFER);
+        while (copied < size)
+        {
+            uint64_t remain = size - copied;
+            uint32_t chunk = remain < i_COPY_BUFFER ? (uint32_t)remain : i_COPY_BUFFER;
+            uint32_t nread = 0, nwritten = 0;
+            if (bfile_read(from, buffer, chunk, &nread, &lerror) == FALSE)
+                break;
+
+            if (bfile_write(to, buffer, nread, &nwritten, &lerror) == FALSE)
+                break;
+
+            copied += nwritten;
+            if (nwritten < nread)
+            {
+                lerror = ekFBIG;
+                break;
+            }
+        }
+
+        bmem_free(buffer);
+    }
+
+    ptr_assign(csize, copied);
+    ptr_assign(error, lerror);
+    return (bool_t)(lerror == ekFOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
 bool_t bfile_seek(File *file, const int64_t offset, const file_seek_t whence, ferror_t *error)
 {
     int fd = (int)(intptr_t)file;
@@ -608,6 +820,61 @@ uint64_t bfile_pos(const File *file)
 
 /*---------------------------------------------------------------------------*/
 
+const byte_t *bfile_mmap(File *file, const uint64_t offset, const uint64_t size, ferror_t *error)
+{
+    int fd = (int)(intptr_t)file;
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t delta = offset % page;
+    void *data = NULL;
+    cassert_no_null(file);
+    cassert(size > 0);
+
+    if (size + delta > (uint64_t)SIZE_MAX)
+    {
+        ptr_assign(error, ekFBIG);
+        return NULL;
+    }
+
+    /* Offset must be page aligned */
+    data = mmap(NULL, (size_t)(size + delta), PROT_READ, MAP_PRIVATE, fd, (off_t)(offset - delta));
+    if (data == MAP_FAILED)
+    {
+        if (errno == ENOMEM || errno == EOVERFLOW)
+        {
+            ptr_assign(error, ekFBIG);
+        }
+        else if (errno == EACCES)
+        {
+            ptr_assign(error, ekFNOACCESS);
+        }
+        else
+        {
+            ptr_assign(error, ekFUNDEF);
+        }
+        return NULL;
+    }
+
+    ptr_assign(error, ekFOK);
+    return (const byte_t*)data + delta;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bfile_munmap(const byte_t **data, const uint64_t size)
+{
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t delta = 0;
+    int ret = 0;
+    cassert_no_null(data);
+    cassert_no_null(*data);
+    delta = (uintptr_t)*data % page;
+    ret = munmap((void*)(*data - delta), (size_t)(size + delta));
+    cassert_unref(ret == 0, ret);
+    *data = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
 bool_t bfile_delete(const char_t *filepath, ferror_t *error)
 {
     int res = unlink((const char*)filepath);
@@ -646,3 +913,39 @@ bool_t bfile_delete(const char_t *filepath, ferror_t *error)
         return FALSE;
     }
 }
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bfile_rename(const char_t *from, const char_t *to, ferror_t *error)
+{
+    int res = rename((const char*)from, (const char*)to);
+    if (res == 0)
+    {
+        ptr_assign(error, ekFOK);
+        return TRUE;
+    }
+    else
+    {
+        if (error != NULL)
+        {
+            switch (errno)
+            {
+                case EACCES:
+                case EPERM:
+                    *error = ekFNOACCESS;
+                    break;
+                case ENOENT:
+                case ENOTDIR:
+                    *error = ekFNOPATH;
+                    break;
+                case ENAMETOOLONG:
+                    *error = ekFBIGNAME;
+                    break;
+                default:
+                    *error = ekFUNDEF;
+            }
+        }
+
+        return FALSE;
+    }
+}
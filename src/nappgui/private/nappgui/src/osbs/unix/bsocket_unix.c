@@ -12,18 +12,27 @@
 
 #include "bsocket.h"
 #include "osbs.inl"
+#include "bmem.h"
+#include "bstd.h"
 #include "cassert.h"
 #include "ptr.h"
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <signal.h>
 #include <errno.h>
 #include <netdb.h>
 #include <fcntl.h>
+#if defined(__LINUX__)
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#endif
 #define SOCKET_ID       int
 #define SOCKET_NULL     -1
 #define SOCKET_FAIL     -1
@@ -34,6 +43,32 @@
 
 /*---------------------------------------------------------------------------*/
 
+#define i_POLL_EVENTS   256
+#define i_IOV_MAX       64
+
+typedef struct _pollreg_t i_PollReg;
+
+struct _pollreg_t
+{
+    Socket *socket;
+    uint32_t events;
+    void *data;
+    FPtr_sock_event func_event;
+    i_PollReg *next_dead;
+};
+
+/* Registrations indexed by socket descriptor */
+struct _sockpoll_t
+{
+    int pfd;
+    i_PollReg **regs;
+    uint32_t nregs;
+    i_PollReg *dead;
+    bool_t dispatching;
+};
+
+/*---------------------------------------------------------------------------*/
+
 static const char_t *i_WELL_KNOW_URL = "www.google.com";
 
 /*---------------------------------------------------------------------------*/
@@ -68,6 +103,29 @@ static serror_t i_socket_error(void)
 
 /*---------------------------------------------------------------------------*/
 
+static bool_t i_is_nonblock(const SOCKET_ID skID)
+{
+    int flags = fcntl(skID, F_GETFL, 0);
+    return (bool_t)(flags != -1 && (flags & O_NONBLOCK) != 0);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* EAGAIN in blocking sockets means timeout (SO_RCVTIMEO, SO_SNDTIMEO) */
+static serror_t i_io_error(const SOCKET_ID skID)
+{
+    int sock_error = errno;
+    if (sock_error == ETIMEDOUT)
+        return ekSTIMEOUT;
+
+    if ((sock_error == EAGAIN || sock_error == EWOULDBLOCK) && i_is_nonblock(skID) == TRUE)
+        return ekSAGAIN;
+
+    return ekSSTREAM;
+}
+
+/*---------------------------------------------------------------------------*/
+
 /*
 static void i_options(Socket *sock, const SockOpt *opts)
 {
@@ -98,13 +156,13 @@ static void i_options(Socket *sock, const SockOpt *opts)
 
 /*---------------------------------------------------------------------------*/
 
-Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t timeout_ms, serror_t *error)
+static Socket *i_connect(const struct sockaddr *server, const socklen_t server_size, const uint32_t timeout_ms, serror_t *error)
 {
     SOCKET_ID skID = SOCKET_NULL;
     int ok_connect = 0;
 
     /* Create the socket */
-    skID = socket(PF_INET, SOCK_STREAM, 0);
+    skID = socket(server->sa_family, SOCK_STREAM, 0);
     if(skID == SOCKET_FAIL)
     {
         if (error != NULL)
@@ -115,14 +173,9 @@ Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t t
     /* Connect to the server */
     if (skID != SOCKET_FAIL)
     {
-        struct sockaddr_in server;
-        server.sin_family = AF_INET;
-        server.sin_port = htons(port);
-        server.sin_addr.s_addr = htonl(ip);
-
         if (timeout_ms == 0)
         {
-            ok_connect = connect(skID, (struct sockaddr*)&server, sizeof(server));
+            ok_connect = connect(skID, server, server_size);
             if (ok_connect == SOCKET_FAIL && error != NULL)
                 *error = i_socket_error();
         }
@@ -150,7 +203,7 @@ Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t t
 
             if (ok_connect != SOCKET_FAIL)
             {
-                if (connect(skID, (struct sockaddr*)&server, sizeof(server)) == SOCKET_FAIL)
+                if (connect(skID, server, server_size) == SOCKET_FAIL)
                 {
                     if (errno == EINPROGRESS)
                     {
@@ -244,18 +297,25 @@ Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t t
 
 /*---------------------------------------------------------------------------*/
 
-Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t *error)
+Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t timeout_ms, serror_t *error)
 {
     struct sockaddr_in server;
+    bmem_zero(&server, struct sockaddr_in);
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(ip);
+    return i_connect((struct sockaddr*)&server, sizeof(server), timeout_ms, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Socket *i_server(const struct sockaddr *server, const socklen_t server_size, const uint32_t max_connect, serror_t *error)
+{
     SOCKET_ID skID;
     int ok;
 
-	server.sin_family = AF_INET;
-	server.sin_port = htons(port);
-	server.sin_addr.s_addr = INADDR_ANY;
-
     /* Create the socket */
-	skID = socket (PF_INET, SOCK_STREAM, 0);
+	skID = socket (server->sa_family, SOCK_STREAM, 0);
     if(skID == -1)
     {
         if (error != NULL)
@@ -271,7 +331,14 @@ Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t
         cassert_unref(sok == 0, sok);
     }
 
-	ok = bind(skID, (struct sockaddr*)&server, sizeof(server));
+    /* IPv6 wildcard servers also attend IPv4 clients (dual-stack) */
+    if (server->sa_family == AF_INET6)
+    {
+        int v6only = 0;
+        setsockopt(skID, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&v6only, sizeof(v6only));
+    }
+
+	ok = bind(skID, server, server_size);
     if (ok == SOCKET_FAIL)
     {
         close(skID);
@@ -288,25 +355,116 @@ Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t
         close(skID);
 
         if (error != NULL)
-            i_socket_error();
+            *error = i_socket_error();
 
         return NULL;
 	}
 
     /* All Ok! */
+    ptr_assign(error, ekSOK);
     _osbs_socket_alloc();
     return (Socket*)(intptr_t)skID;
 }
 
 /*---------------------------------------------------------------------------*/
 
+Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t *error)
+{
+    struct sockaddr_in server;
+    bmem_zero(&server, struct sockaddr_in);
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+	server.sin_addr.s_addr = INADDR_ANY;
+    return i_server((struct sockaddr*)&server, sizeof(server), max_connect, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static struct addrinfo *i_addrinfo(const char_t *host, const uint16_t port, const bool_t passive, serror_t *error)
+{
+    struct addrinfo hints, *info = NULL;
+    char_t service[16];
+    int ret;
+    bmem_zero(&hints, struct addrinfo);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV | (passive == TRUE ? AI_PASSIVE : AI_ADDRCONFIG);
+    bstd_sprintf(service, sizeof(service), "%d", (int)port);
+    ret = getaddrinfo((const char*)host, (const char*)service, &hints, &info);
+    if (ret != 0)
+    {
+        if (error != NULL)
+        {
+            if (bsocket_url_ip(i_WELL_KNOW_URL, NULL) == 0)
+                *error = ekSNONET;
+            else
+                *error = ekSNOHOST;
+        }
+
+        return NULL;
+    }
+
+    return info;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Socket *bsocket_connect_host(const char_t *host, const uint16_t port, const uint32_t timeout_ms, serror_t *error)
+{
+    struct addrinfo *info = NULL, *addr = NULL;
+    Socket *socket = NULL;
+    cassert_no_null(host);
+    info = i_addrinfo(host, port, FALSE, error);
+
+    /* Try every address (IPv6, IPv4) until one connects */
+    for (addr = info; addr != NULL && socket == NULL; addr = addr->ai_next)
+        socket = i_connect(addr->ai_addr, addr->ai_addrlen, timeout_ms, error);
+
+    if (info != NULL)
+        freeaddrinfo(info);
+
+    return socket;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Socket *bsocket_server_host(const char_t *host, const uint16_t port, const uint32_t max_connect, serror_t *error)
+{
+    Socket *socket = NULL;
+    if (host == NULL)
+    {
+        /* Dual-stack wildcard server, IPv4 only if IPv6 is not available */
+        struct sockaddr_in6 server;
+        bmem_zero(&server, struct sockaddr_in6);
+        server.sin6_family = AF_INET6;
+        server.sin6_port = htons(port);
+        server.sin6_addr = in6addr_any;
+        socket = i_server((struct sockaddr*)&server, sizeof(server), max_connect, error);
+        if (socket == NULL)
+            socket = bsocket_server(port, max_connect, error);
+    }
+    else
+    {
+        struct addrinfo *info = i_addrinfo(host, port, TRUE, error), *addr = NULL;
+        for (addr = info; addr != NULL && socket == NULL; addr = addr->ai_next)
+            socket = i_server(addr->ai_addr, addr->ai_addrlen, max_connect, error);
+
+        if (info != NULL)
+            freeaddrinfo(info);
+    }
+
+    return socket;
+}
+
+/*---------------------------------------------------------------------------*/
+
 Socket *bsocket_accept(Socket *lsocket, const uint32_t timeout_ms, serror_t *error)
 {
     SOCKET_ID lsockid = 0;
     fd_set set;
     int select_id;
     SOCKET_ID cliID;
-    struct sockaddr_in clData;
+    struct sockaddr_storage clData;
     socklen_t sizeSt;
     cassert_no_null(lsocket);
 
@@ -314,7 +472,12 @@ Socket *bsocket_accept(Socket *lsocket, const uint32_t timeout_ms, serror_t *err
     FD_ZERO(&set);
     FD_SET(lsockid, &set);
 
-    if (timeout_ms > 0)
+    /* Non-blocking servers (bsocket_poll) accept without waiting */
+    if (i_is_nonblock(lsockid) == TRUE)
+    {
+        select_id = 1;
+    }
+    else if (timeout_ms > 0)
     {
         struct timeval timeout;
         timeout.tv_sec = timeout_ms / 1000;
@@ -342,8 +505,14 @@ Socket *bsocket_accept(Socket *lsocket, const uint32_t timeout_ms, serror_t *err
 	cliID = accept((SOCKET_ID)(intptr_t)lsocket, (struct sockaddr*)&clData, &sizeSt);
     if (cliID == SOCKET_FAIL)
     {
-        if (error != NULL)
-            i_socket_error();
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            ptr_assign(error, ekSAGAIN);
+        }
+        else if (error != NULL)
+        {
+            *error = i_socket_error();
+        }
         return NULL;
     }
 
@@ -369,16 +538,48 @@ void bsocket_close(Socket **lsocket)
 
 /*---------------------------------------------------------------------------*/
 
+/* IPv4 address of IPv4 and IPv4-mapped IPv6 sockets */
+static void i_addr_ip(const struct sockaddr_storage *address, uint32_t *ip, uint16_t *port)
+{
+    if (address->ss_family == AF_INET)
+    {
+        const struct sockaddr_in *addr = (const struct sockaddr_in*)address;
+        ptr_assign(ip, ntohl(addr->sin_addr.s_addr));
+        ptr_assign(port, ntohs(addr->sin_port));
+    }
+    else if (address->ss_family == AF_INET6)
+    {
+        const struct sockaddr_in6 *addr = (const struct sockaddr_in6*)address;
+        if (IN6_IS_ADDR_V4MAPPED(&addr->sin6_addr))
+        {
+            const uint8_t *b = (const uint8_t*)&addr->sin6_addr + 12;
+            ptr_assign(ip, ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3]);
+        }
+        else
+        {
+            ptr_assign(ip, 0);
+        }
+
+        ptr_assign(port, ntohs(addr->sin6_port));
+    }
+    else
+    {
+        ptr_assign(ip, 0);
+        ptr_assign(port, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
 void bsocket_local_ip(Socket *lsocket, uint32_t *ip, uint16_t *port)
 {
-    struct sockaddr_in laddress;
+    struct sockaddr_storage laddress;
     socklen_t addr_size = sizeof(laddress);
     cassert_no_null(lsocket);
     cassert(ip != NULL || port != NULL);
     if (getsockname((SOCKET_ID)(intptr_t)lsocket, (struct sockaddr*)&laddress, &addr_size) != -1)
     {
-        ptr_assign(ip, ntohl(laddress.sin_addr.s_addr));
-        ptr_assign(port, ntohs(laddress.sin_port));
+        i_addr_ip(&laddress, ip, port);
     }
     else
     {
@@ -391,14 +592,13 @@ void bsocket_local_ip(Socket *lsocket, uint32_t *ip, uint16_t *port)
 
 void bsocket_remote_ip(Socket *lsocket, uint32_t *ip, uint16_t *port)
 {
-    struct sockaddr_in laddress;
+    struct sockaddr_storage laddress;
     socklen_t addr_size = sizeof(laddress);
     cassert_no_null(lsocket);
     cassert(ip != NULL || port != NULL);
     if (getpeername((SOCKET_ID)(intptr_t)lsocket, (struct sockaddr*)&laddress, &addr_size) != -1)
     {
-        ptr_assign(ip, ntohl(laddress.sin_addr.s_addr));
-        ptr_assign(port, ntohs(laddress.sin_port));
+        i_addr_ip(&laddress, ip, port);
     }
     else
     {
@@ -409,6 +609,59 @@ void bsocket_remote_ip(Socket *lsocket, uint32_t *ip, uint16_t *port)
 
 /*---------------------------------------------------------------------------*/
 
+static bool_t i_addr_str(const struct sockaddr_storage *address, const socklen_t addr_size, char_t *addr, const uint32_t size, uint16_t *port)
+{
+    if (getnameinfo((const struct sockaddr*)address, addr_size, (char*)addr, (socklen_t)size, NULL, 0, NI_NUMERICHOST) == 0)
+    {
+        i_addr_ip(address, NULL, port);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_local_addr(Socket *lsocket, char_t *addr, const uint32_t size, uint16_t *port)
+{
+    struct sockaddr_storage laddress;
+    socklen_t addr_size = sizeof(laddress);
+    cassert_no_null(lsocket);
+    cassert_no_null(addr);
+    cassert(size > 0);
+    if (getsockname((SOCKET_ID)(intptr_t)lsocket, (struct sockaddr*)&laddress, &addr_size) != -1)
+    {
+        if (i_addr_str(&laddress, addr_size, addr, size, port) == TRUE)
+            return TRUE;
+    }
+
+    addr[0] = '\0';
+    ptr_assign(port, 0);
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_remote_addr(Socket *lsocket, char_t *addr, const uint32_t size, uint16_t *port)
+{
+    struct sockaddr_storage laddress;
+    socklen_t addr_size = sizeof(laddress);
+    cassert_no_null(lsocket);
+    cassert_no_null(addr);
+    cassert(size > 0);
+    if (getpeername((SOCKET_ID)(intptr_t)lsocket, (struct sockaddr*)&laddress, &addr_size) != -1)
+    {
+        if (i_addr_str(&laddress, addr_size, addr, size, port) == TRUE)
+            return TRUE;
+    }
+
+    addr[0] = '\0';
+    ptr_assign(port, 0);
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void bsocket_read_timeout(Socket *sock, const uint32_t timeout_ms)
 {
     struct timeval timeout;
@@ -433,6 +686,54 @@ void bsocket_write_timeout(Socket *sock, const uint32_t timeout_ms)
 
 /*---------------------------------------------------------------------------*/
 
+void bsocket_nodelay(Socket *sock, const bool_t nodelay)
+{
+    int value = nodelay == TRUE ? 1 : 0;
+    int ret = setsockopt((SOCKET_ID)(intptr_t)sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&value, sizeof(value));
+    cassert_unref(ret == 0, ret);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_keepalive(Socket *sock, const bool_t keepalive, const uint32_t idle_s)
+{
+    int value = keepalive == TRUE ? 1 : 0;
+    int ret = setsockopt((SOCKET_ID)(intptr_t)sock, SOL_SOCKET, SO_KEEPALIVE, (const char*)&value, sizeof(value));
+    cassert_unref(ret == 0, ret);
+
+    /* idle_s = 0 --> System default idle time before the first probe */
+    if (keepalive == TRUE && idle_s > 0)
+    {
+        int idle = (int)idle_s;
+#if defined(TCP_KEEPIDLE)
+        ret = setsockopt((SOCKET_ID)(intptr_t)sock, IPPROTO_TCP, TCP_KEEPIDLE, (const char*)&idle, sizeof(idle));
+#else
+        ret = setsockopt((SOCKET_ID)(intptr_t)sock, IPPROTO_TCP, TCP_KEEPALIVE, (const char*)&idle, sizeof(idle));
+#endif
+        cassert_unref(ret == 0, ret);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_read_bufsize(Socket *sock, const uint32_t size)
+{
+    int value = (int)size;
+    int ret = setsockopt((SOCKET_ID)(intptr_t)sock, SOL_SOCKET, SO_RCVBUF, (const char*)&value, sizeof(value));
+    cassert_unref(ret == 0, ret);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_write_bufsize(Socket *sock, const uint32_t size)
+{
+    int value = (int)size;
+    int ret = setsockopt((SOCKET_ID)(intptr_t)sock, SOL_SOCKET, SO_SNDBUF, (const char*)&value, sizeof(value));
+    cassert_unref(ret == 0, ret);
+}
+
+/*---------------------------------------------------------------------------*/
+
 bool_t bsocket_read(Socket *lsocket, byte_t *data, const uint32_t size, uint32_t *rsize, serror_t *error)
 {
     SSIZE_T lrsize = 0;
@@ -464,12 +765,10 @@ bool_t bsocket_read(Socket *lsocket, byte_t *data, const uint32_t size, uint32_t
         }
         else if (num_rbytes == SOCKET_FAIL)
         {
-            int sock_error = errno;
-            if (sock_error == ETIMEDOUT)
-                lerror = ekSTIMEOUT;
-            else
-                lerror = ekSSTREAM;
+            if (errno == EINTR)
+                continue;
 
+            lerror = i_io_error((SOCKET_ID)(intptr_t)lsocket);
             break;
         }
         else
@@ -490,6 +789,7 @@ bool_t bsocket_write(Socket *lsocket, const byte_t *data, const uint32_t size, u
 {
     SSIZE_T lwsize = 0;
     bool_t ok = FALSE;
+    serror_t lerror = ekSSTREAM;
     cassert_no_null(lsocket);
     cassert_no_null(data);
 
@@ -517,6 +817,10 @@ bool_t bsocket_write(Socket *lsocket, const byte_t *data, const uint32_t size, u
         }
         else if (num_wbytes == SOCKET_FAIL)
         {
+            if (errno == EINTR)
+                continue;
+
+            lerror = i_io_error((SOCKET_ID)(intptr_t)lsocket);
             ok = FALSE;
             break;
         }
@@ -529,12 +833,387 @@ bool_t bsocket_write(Socket *lsocket, const byte_t *data, const uint32_t size, u
     }
 
     ptr_assign(wsize, (uint32_t)lwsize);
-    ptr_assign(error, ok == TRUE ? ekSOK : ekSSTREAM);
+    ptr_assign(error, ok == TRUE ? ekSOK : lerror);
     return ok;
 }
 
 /*---------------------------------------------------------------------------*/
 
+/* iovec array from the current buffer and offset */
+static int i_iovec(struct iovec *iov, const SockBuf *bufs, const uint32_t n, const uint32_t cbuf, const uint32_t offset)
+{
+    uint32_t i, niov = 0;
+    for (i = cbuf; i < n && niov < i_IOV_MAX; ++i)
+    {
+        uint32_t off = (i == cbuf) ? offset : 0;
+        if (bufs[i].size > off)
+        {
+            cassert_no_null(bufs[i].data);
+            iov[niov].iov_base = (void*)(bufs[i].data + off);
+            iov[niov].iov_len = (SIZE_T)(bufs[i].size - off);
+            niov += 1;
+        }
+    }
+
+    return (int)niov;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_iov_advance(const SockBuf *bufs, const uint32_t n, uint32_t *cbuf, uint32_t *offset, uint32_t nbytes)
+{
+    while (*cbuf < n)
+    {
+        uint32_t remain = bufs[*cbuf].size - *offset;
+        if (remain > nbytes)
+        {
+            *offset += nbytes;
+            break;
+        }
+
+        nbytes -= remain;
+        *cbuf += 1;
+        *offset = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_iov_io(Socket *lsocket, const SockBuf *bufs, const uint32_t n, const bool_t read, uint32_t *size, serror_t *error)
+{
+    struct iovec iov[i_IOV_MAX];
+    uint32_t cbuf = 0, offset = 0, lsize = 0;
+    serror_t lerror = ekSOK;
+
+    cassert_no_null(lsocket);
+    cassert(bufs != NULL || n == 0);
+
+    for (;;)
+    {
+        SSIZE_T num_bytes = 0;
+        int niov = i_iovec(iov, bufs, n, cbuf, offset);
+        if (niov == 0)
+            break;
+
+        if (read == TRUE)
+            num_bytes = readv((SOCKET_ID)(intptr_t)lsocket, iov, niov);
+        else
+            num_bytes = writev((SOCKET_ID)(intptr_t)lsocket, iov, niov);
+
+        if (num_bytes > 0)
+        {
+            lsize += (uint32_t)num_bytes;
+            i_iov_advance(bufs, n, &cbuf, &offset, (uint32_t)num_bytes);
+        }
+        /* Connection closed by peer */
+        else if (num_bytes == 0)
+        {
+            cassert(read == TRUE);
+            break;
+        }
+        else
+        {
+            if (errno == EINTR)
+                continue;
+
+            lerror = i_io_error((SOCKET_ID)(intptr_t)lsocket);
+            break;
+        }
+    }
+
+    ptr_assign(size, lsize);
+    ptr_assign(error, lerror);
+    return (bool_t)(lerror == ekSOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_readv(Socket *lsocket, const SockBuf *bufs, const uint32_t n, uint32_t *rsize, serror_t *error)
+{
+    return i_iov_io(lsocket, bufs, n, TRUE, rsize, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_writev(Socket *lsocket, const SockBuf *bufs, const uint32_t n, uint32_t *wsize, serror_t *error)
+{
+    return i_iov_io(lsocket, bufs, n, FALSE, wsize, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_nonblock(Socket *lsocket, const bool_t nonblock)
+{
+    int flags = 0;
+    int ret = 0;
+    cassert_no_null(lsocket);
+    flags = fcntl((SOCKET_ID)(intptr_t)lsocket, F_GETFL, 0);
+    cassert(flags != -1);
+    if (nonblock == TRUE)
+        flags |= O_NONBLOCK;
+    else
+        flags &= ~O_NONBLOCK;
+    ret = fcntl((SOCKET_ID)(intptr_t)lsocket, F_SETFL, flags);
+    cassert_unref(ret != -1, ret);
+}
+
+/*---------------------------------------------------------------------------*/
+
+SockPoll *bsocket_poll_create(void)
+{
+    SockPoll *poll = NULL;
+#if defined(__LINUX__)
+    int pfd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    int pfd = kqueue();
+#endif
+
+    if (pfd == -1)
+        return NULL;
+
+    poll = (SockPoll*)bmem_malloc(sizeof(SockPoll));
+    poll->pfd = pfd;
+    poll->regs = NULL;
+    poll->nregs = 0;
+    poll->dead = NULL;
+    poll->dispatching = FALSE;
+    return poll;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_free_dead(SockPoll *poll)
+{
+    while (poll->dead != NULL)
+    {
+        i_PollReg *reg = poll->dead;
+        poll->dead = reg->next_dead;
+        bmem_free((byte_t*)reg);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_poll_destroy(SockPoll **poll)
+{
+    uint32_t i;
+    cassert_no_null(poll);
+    cassert_no_null(*poll);
+    cassert((*poll)->dispatching == FALSE);
+    for (i = 0; i < (*poll)->nregs; ++i)
+    {
+        if ((*poll)->regs[i] != NULL)
+            bmem_free((byte_t*)(*poll)->regs[i]);
+    }
+
+    i_free_dead(*poll);
+    if ((*poll)->regs != NULL)
+        bmem_free((byte_t*)(*poll)->regs);
+    close((*poll)->pfd);
+    bmem_free((byte_t*)*poll);
+    *poll = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if defined(__LINUX__)
+
+static int i_ctl(SockPoll *poll, i_PollReg *reg, const uint32_t events, const bool_t add)
+{
+    struct epoll_event ev;
+    ev.events = EPOLLRDHUP;
+    ev.data.ptr = reg;
+    if (events & ekSOCK_READ)
+        ev.events |= EPOLLIN;
+    if (events & ekSOCK_WRITE)
+        ev.events |= EPOLLOUT;
+    if (events & ekSOCK_EDGE)
+        ev.events |= EPOLLET;
+    return epoll_ctl(poll->pfd, add == TRUE ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, (SOCKET_ID)(intptr_t)reg->socket, &ev);
+}
+
+#else
+
+/* kqueue has a filter for each direction, EV_CLEAR is edge-triggered */
+static int i_ctl(SockPoll *poll, i_PollReg *reg, const uint32_t events, const bool_t add)
+{
+    struct kevent ev[2];
+    SOCKET_ID skID = (SOCKET_ID)(intptr_t)reg->socket;
+    u_short flags = (events & ekSOCK_EDGE) ? EV_CLEAR : 0;
+    unref(add);
+    EV_SET(&ev[0], skID, EVFILT_READ, ((events & ekSOCK_READ) ? EV_ADD | EV_ENABLE : EV_ADD | EV_DISABLE) | flags, 0, 0, reg);
+    EV_SET(&ev[1], skID, EVFILT_WRITE, ((events & ekSOCK_WRITE) ? EV_ADD | EV_ENABLE : EV_ADD | EV_DISABLE) | flags, 0, 0, reg);
+    return kevent(poll->pfd, ev, 2, NULL, 0, NULL);
+}
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_poll_add_imp(SockPoll *poll, Socket *socket, const uint32_t events, void *data, FPtr_sock_event func_event)
+{
+    uint32_t skID = 0;
+    i_PollReg *reg = NULL;
+    cassert_no_null(poll);
+    cassert_no_null(socket);
+    cassert_no_nullf(func_event);
+    skID = (uint32_t)(intptr_t)socket;
+
+    if (skID >= poll->nregs)
+    {
+        uint32_t nregs = poll->nregs > 0 ? poll->nregs : 64;
+        i_PollReg **regs = NULL;
+        while (skID >= nregs)
+            nregs *= 2;
+
+        regs = (i_PollReg**)bmem_malloc(nregs * sizeof32(i_PollReg*));
+        bmem_set_zero((byte_t*)regs, nregs * sizeof32(i_PollReg*));
+        if (poll->regs != NULL)
+        {
+            bmem_copy((byte_t*)regs, (const byte_t*)poll->regs, poll->nregs * sizeof32(i_PollReg*));
+            bmem_free((byte_t*)poll->regs);
+        }
+
+        poll->regs = regs;
+        poll->nregs = nregs;
+    }
+
+    cassert(poll->regs[skID] == NULL);
+    reg = (i_PollReg*)bmem_malloc(sizeof(i_PollReg));
+    reg->socket = socket;
+    reg->events = events;
+    reg->data = data;
+    reg->func_event = func_event;
+    reg->next_dead = NULL;
+
+    if (i_ctl(poll, reg, events, TRUE) == -1)
+    {
+        bmem_free((byte_t*)reg);
+        return FALSE;
+    }
+
+    poll->regs[skID] = reg;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static i_PollReg *i_reg(SockPoll *poll, Socket *socket)
+{
+    uint32_t skID = (uint32_t)(intptr_t)socket;
+    cassert_no_null(poll);
+    if (skID < poll->nregs)
+        return poll->regs[skID];
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_poll_mod(SockPoll *poll, Socket *socket, const uint32_t events)
+{
+    i_PollReg *reg = i_reg(poll, socket);
+    cassert_no_null(reg);
+    if (i_ctl(poll, reg, events, FALSE) == -1)
+        return FALSE;
+    reg->events = events;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_poll_remove(SockPoll *poll, Socket *socket)
+{
+    i_PollReg *reg = i_reg(poll, socket);
+    if (reg != NULL)
+    {
+#if defined(__LINUX__)
+        struct epoll_event ev;
+        epoll_ctl(poll->pfd, EPOLL_CTL_DEL, (SOCKET_ID)(intptr_t)socket, &ev);
+#else
+        struct kevent ev[2];
+        EV_SET(&ev[0], (SOCKET_ID)(intptr_t)socket, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+        EV_SET(&ev[1], (SOCKET_ID)(intptr_t)socket, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+        kevent(poll->pfd, ev, 2, NULL, 0, NULL);
+#endif
+
+        poll->regs[(uint32_t)(intptr_t)socket] = NULL;
+
+        /* Pending events of this wait could still point to 'reg' */
+        if (poll->dispatching == TRUE)
+        {
+            reg->socket = NULL;
+            reg->next_dead = poll->dead;
+            poll->dead = reg;
+        }
+        else
+        {
+            bmem_free((byte_t*)reg);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t bsocket_poll_wait(SockPoll *poll, const uint32_t timeout_ms)
+{
+    int n = 0, i = 0;
+#if defined(__LINUX__)
+    struct epoll_event events[i_POLL_EVENTS];
+    cassert_no_null(poll);
+    cassert(poll->dispatching == FALSE);
+    n = epoll_wait(poll->pfd, events, i_POLL_EVENTS, timeout_ms == UINT32_MAX ? -1 : (int)timeout_ms);
+#else
+    struct kevent events[i_POLL_EVENTS];
+    struct timespec timeout;
+    cassert_no_null(poll);
+    cassert(poll->dispatching == FALSE);
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+    n = kevent(poll->pfd, NULL, 0, events, i_POLL_EVENTS, timeout_ms == UINT32_MAX ? NULL : &timeout);
+#endif
+
+    /* EINTR */
+    if (n <= 0)
+        return 0;
+
+    poll->dispatching = TRUE;
+    for (i = 0; i < n; ++i)
+    {
+        uint32_t ev = 0;
+#if defined(__LINUX__)
+        i_PollReg *reg = (i_PollReg*)events[i].data.ptr;
+        if (events[i].events & EPOLLIN)
+            ev |= ekSOCK_READ;
+        if (events[i].events & EPOLLOUT)
+            ev |= ekSOCK_WRITE;
+        if (events[i].events & (EPOLLHUP | EPOLLRDHUP))
+            ev |= ekSOCK_CLOSE;
+        if (events[i].events & EPOLLERR)
+            ev |= ekSOCK_ERROR;
+#else
+        i_PollReg *reg = (i_PollReg*)events[i].udata;
+        if (events[i].filter == EVFILT_READ)
+            ev |= ekSOCK_READ;
+        if (events[i].filter == EVFILT_WRITE)
+            ev |= ekSOCK_WRITE;
+        if (events[i].flags & EV_EOF)
+            ev |= ekSOCK_CLOSE;
+        if (events[i].flags & EV_ERROR)
+            ev |= ekSOCK_ERROR;
+#endif
+
+        /* Removed by a previous callback */
+        if (reg->socket != NULL)
+            reg->func_event(reg->data, reg->socket, ev);
+    }
+
+    poll->dispatching = FALSE;
+    i_free_dead(poll);
+    return (uint32_t)n;
+}
+
+/*---------------------------------------------------------------------------*/
+
 uint32_t bsocket_url_ip(const char_t *url, serror_t *error)
 {
     struct hostent *host = NULL;
@@ -625,6 +625,99 @@ bool_t bfile_write(File *file, const byte_t *data, const uint32_t size, uint32_t
 
 /*---------------------------------------------------------------------------*/
 
+/* Single system calls are limited to 1GB */
+#define i_IO_CHUNK  0x40000000
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bfile_read64(File *file, byte_t *data, const uint64_t size, uint64_t *rsize, ferror_t *error)
+{
+    uint64_t total = 0;
+    ferror_t lerror = ekFOK;
+    cassert_no_null(file);
+    while (total < size)
+    {
+        uint64_t remain = size - total;
+        uint32_t chunk = remain < i_IO_CHUNK ? (uint32_t)remain : i_IO_CHUNK;
+        uint32_t nread = 0;
+        if (bfile_read(file, data + total, chunk, &nread, &lerror) == FALSE)
+            break;
+        total += nread;
+    }
+
+    ptr_assign(rsize, total);
+    ptr_assign(error, lerror);
+    /* End of file or error */
+    if (total == 0 && size > 0)
+        return FALSE;
+    return (bool_t)(lerror == ekFOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bfile_write64(File *file, const byte_t *data, const uint64_t size, uint64_t *wsize, ferror_t *error)
+{
+    uint64_t total = 0;
+    ferror_t lerror = ekFOK;
+    cassert_no_null(file);
+    while (total < size)
+    {
+        uint64_t remain = size - total;
+        uint32_t chunk = remain < i_IO_CHUNK ? (uint32_t)remain : i_IO_CHUNK;
+        uint32_t nwritten = 0;
+        if (bfile_write(file, data + total, chunk, &nwritten, &lerror) == FALSE)
+            break;
+        total += nwritten;
+        if (nwritten < chunk)
+            break;
+    }
+
+    ptr_assign(wsize, total);
+    ptr_assign(error, lerror);
+    return (bool_t)(lerror == ekFOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+#define i_COPY_BUFFER   (256 * 1024)
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bfile_copy(File *from, File *to, const uint64_t size, uint64_t *csize, ferror_t *error)
+{
+    uint64_t copied = 0;
+    ferror_t lerror = ekFOK;
+    byte_t *buffer = NULL;
+    cassert_no_null(from);
+    cassert_no_null(to);
+    buffer = bmem_malloc(i_COPY_BUFFER);
+    while (copied < size)
+    {
+        uint64_t remain = size - copied;
+        uint32_t chunk = remain < i_COPY_BUFFER ? (uint32_t)remain : i_COPY_BUFFER;
+        uint32_t nread = 0, nwritten = 0;
+        if (bfile_read(from, buffer, chunk, &nread, &lerror) == FALSE)
+            break;
+
+        if (bfile_write(to, buffer, nread, &nwritten, &lerror) == FALSE)
+            break;
+
+        copied += nwritten;
+        if (nwritten < nread)
+        {
+            lerror = ekFBIG;
+            break;
+        }
+    }
+
+    bmem_free(buffer);
+    ptr_assign(csize, copied);
+    ptr_assign(error, lerror);
+    return (bool_t)(lerror == ekFOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
 bool_t bfile_seek(File *file, const int64_t offset, const file_seek_t whence, ferror_t *error)
 {
     LARGE_INTEGER li;
@@ -682,6 +775,67 @@ uint64_t bfile_pos(const File *file)
 
 /*---------------------------------------------------------------------------*/
 
+static uint64_t i_map_granularity(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint64_t)info.dwAllocationGranularity;
+}
+
+/*---------------------------------------------------------------------------*/
+
+const byte_t *bfile_mmap(File *file, const uint64_t offset, const uint64_t size, ferror_t *error)
+{
+    uint64_t delta = offset % i_map_granularity();
+    uint64_t base = offset - delta;
+    HANDLE map = NULL;
+    LPVOID data = NULL;
+    cassert_no_null(file);
+    cassert(size > 0);
+
+    if (size + delta > (uint64_t)SIZE_MAX)
+    {
+        ptr_assign(error, ekFBIG);
+        return NULL;
+    }
+
+    map = CreateFileMapping((HANDLE)file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (map == NULL)
+    {
+        i_file_error(error);
+        return NULL;
+    }
+
+    /* Offset must be aligned to allocation granularity. The view keeps the mapping alive */
+    data = MapViewOfFile(map, FILE_MAP_READ, (DWORD)(base >> 32), (DWORD)(base & 0xFFFFFFFF), (SIZE_T)(size + delta));
+    CloseHandle(map);
+    if (data == NULL)
+    {
+        i_file_error(error);
+        return NULL;
+    }
+
+    ptr_assign(error, ekFOK);
+    return (const byte_t*)data + delta;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bfile_munmap(const byte_t **data, const uint64_t size)
+{
+    uintptr_t delta = 0;
+    BOOL ok = FALSE;
+    cassert_no_null(data);
+    cassert_no_null(*data);
+    unref(size);
+    delta = (uintptr_t)*data % (uintptr_t)i_map_granularity();
+    ok = UnmapViewOfFile((LPCVOID)(*data - delta));
+    cassert_unref(ok != 0, ok);
+    *data = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
 bool_t bfile_delete(const char_t *pathname, ferror_t *error)
 {
     WCHAR pathnamew[MAX_PATH + 1];
@@ -705,3 +859,31 @@ bool_t bfile_delete(const char_t *pathname, ferror_t *error)
         return FALSE;
     }
 }
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bfile_rename(const char_t *from, const char_t *to, ferror_t *error)
+{
+    WCHAR fromw[MAX_PATH + 1];
+    WCHAR tow[MAX_PATH + 1];
+    uint32_t num_bytes1 = unicode_convers(from, (char_t*)fromw, ekUTF8, ekUTF16, sizeof(fromw));
+    uint32_t num_bytes2 = unicode_convers(to, (char_t*)tow, ekUTF8, ekUTF16, sizeof(tow));
+    if (num_bytes1 < sizeof(fromw) && num_bytes2 < sizeof(tow))
+    {
+        if (MoveFileEx(fromw, tow, MOVEFILE_REPLACE_EXISTING) != 0)
+        {
+            ptr_assign(error, ekFOK);
+            return TRUE;
+        }
+        else
+        {
+            i_file_error(error);
+            return FALSE;
+        }
+    }
+    else
+    {
+        ptr_assign(error, ekFBIGNAME);
+        return FALSE;
+    }
+}
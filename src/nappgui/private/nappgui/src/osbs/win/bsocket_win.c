@@ -12,6 +12,8 @@
 
 #include "bsocket.h"
 #include "osbs.inl"
+#include "bmem.h"
+#include "bstd.h"
 #include "cassert.h"
 #include "ptr.h"
 
@@ -37,6 +39,31 @@
 
 /*---------------------------------------------------------------------------*/
 
+#define i_IOV_MAX       64
+
+typedef struct _pollreg_t i_PollReg;
+
+struct _pollreg_t
+{
+    Socket *socket;
+    uint32_t events;
+    void *data;
+    FPtr_sock_event func_event;
+};
+
+/* WSAPoll is level-triggered, ekSOCK_EDGE is ignored */
+struct _sockpoll_t
+{
+    WSAPOLLFD *fds;
+    i_PollReg **regs;
+    uint32_t count;
+    uint32_t alloc;
+    bool_t dispatching;
+    bool_t removed;
+};
+
+/*---------------------------------------------------------------------------*/
+
 static const char_t *i_WELL_KNOW_URL = "www.google.com";
 
 /*---------------------------------------------------------------------------*/
@@ -170,13 +197,13 @@ static serror_t i_socket_error(void)
 
 /*---------------------------------------------------------------------------*/
 
-Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t timeout_ms, serror_t *error)
+static Socket *i_connect(const struct sockaddr *server, const int server_size, const uint32_t timeout_ms, serror_t *error)
 {
     SOCKET skID = INVALID_SOCKET;
     int ok_connect = SOCKET_ERROR;
 
     /* Create the socket */
-	skID = WSASocket(AF_INET, SOCK_STREAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
+	skID = WSASocket(server->sa_family, SOCK_STREAM, 0, NULL, 0, WSA_FLAG_OVERLAPPED);
     if(skID == INVALID_SOCKET) 
     {
         if (error != NULL)
@@ -187,14 +214,9 @@ Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t t
     /* Connect to the server */
     if (skID != SOCKET_ERROR)
     {
-        struct sockaddr_in server;
-        server.sin_family = AF_INET;
-        server.sin_port = htons(port);
-        server.sin_addr.s_addr = htonl(ip);
-
         if (timeout_ms == 0)
         {
-            ok_connect = connect(skID, (struct sockaddr*)&server, sizeof(server));
+            ok_connect = connect(skID, server, server_size);
             if (ok_connect == SOCKET_ERROR && error != NULL)
                 *error = i_socket_error();
         }
@@ -205,7 +227,7 @@ Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t t
             ok_connect = ioctlsocket(skID, FIONBIO, &block);
             if (ok_connect != SOCKET_ERROR)
             {
-                if (connect(skID, (struct sockaddr*)&server, sizeof(server)) == SOCKET_ERROR)
+                if (connect(skID, server, server_size) == SOCKET_ERROR)
                 {
                     if (WSAGetLastError() == WSAEWOULDBLOCK)
                     {
@@ -288,18 +310,25 @@ Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t t
 
 /*---------------------------------------------------------------------------*/
 
-Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t *error)
+Socket *bsocket_connect(const uint32_t ip, const uint16_t port, const uint32_t timeout_ms, serror_t *error)
 {
     struct sockaddr_in server;
+    bmem_zero(&server, struct sockaddr_in);
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(ip);
+    return i_connect((struct sockaddr*)&server, sizeof(server), timeout_ms, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static Socket *i_server(const struct sockaddr *server, const int server_size, const uint32_t max_connect, serror_t *error)
+{
     SOCKET skID;
     int ok;
 
-	server.sin_family = AF_INET;
-	server.sin_port = htons(port);
-	server.sin_addr.s_addr = INADDR_ANY;
-     
     /* Create the socket */
-	skID = socket (PF_INET, SOCK_STREAM, 0);
+	skID = socket (server->sa_family, SOCK_STREAM, 0);
     if(skID == -1)
     {
         if (error != NULL)
@@ -315,7 +344,14 @@ Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t
         cassert(sok == 0);
     }
 
-	ok = bind(skID, (struct sockaddr*)&server, sizeof(server));
+    /* IPv6 wildcard servers also attend IPv4 clients (dual-stack) */
+    if (server->sa_family == AF_INET6)
+    {
+        DWORD v6only = 0;
+        setsockopt(skID, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&v6only, sizeof(v6only));
+    }
+
+	ok = bind(skID, server, server_size);
     if (ok == SOCKET_ERROR)
     {
         closesocket(skID);
@@ -332,25 +368,116 @@ Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t
         closesocket(skID);
 
         if (error != NULL)
-            i_socket_error();
+            *error = i_socket_error();
 
         return NULL;
 	}    
 
     /* All Ok! */
+    ptr_assign(error, ekSOK);
     _osbs_socket_alloc();
     return (Socket*)(intptr_t)skID;
 }
 
 /*---------------------------------------------------------------------------*/
 
+Socket *bsocket_server(const uint16_t port, const uint32_t max_connect, serror_t *error)
+{
+    struct sockaddr_in server;
+    bmem_zero(&server, struct sockaddr_in);
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+	server.sin_addr.s_addr = INADDR_ANY;
+    return i_server((struct sockaddr*)&server, sizeof(server), max_connect, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+static struct addrinfo *i_addrinfo(const char_t *host, const uint16_t port, const bool_t passive, serror_t *error)
+{
+    struct addrinfo hints, *info = NULL;
+    char_t service[16];
+    int ret;
+    bmem_zero(&hints, struct addrinfo);
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV | (passive == TRUE ? AI_PASSIVE : AI_ADDRCONFIG);
+    bstd_sprintf(service, sizeof(service), "%d", (int)port);
+    ret = getaddrinfo((const char*)host, (const char*)service, &hints, &info);
+    if (ret != 0)
+    {
+        if (error != NULL)
+        {
+            if (bsocket_url_ip(i_WELL_KNOW_URL, NULL) == 0)
+                *error = ekSNONET;
+            else
+                *error = ekSNOHOST;
+        }
+
+        return NULL;
+    }
+
+    return info;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Socket *bsocket_connect_host(const char_t *host, const uint16_t port, const uint32_t timeout_ms, serror_t *error)
+{
+    struct addrinfo *info = NULL, *addr = NULL;
+    Socket *socket = NULL;
+    cassert_no_null(host);
+    info = i_addrinfo(host, port, FALSE, error);
+
+    /* Try every address (IPv6, IPv4) until one connects */
+    for (addr = info; addr != NULL && socket == NULL; addr = addr->ai_next)
+        socket = i_connect(addr->ai_addr, (int)addr->ai_addrlen, timeout_ms, error);
+
+    if (info != NULL)
+        freeaddrinfo(info);
+
+    return socket;
+}
+
+/*---------------------------------------------------------------------------*/
+
+Socket *bsocket_server_host(const char_t *host, const uint16_t port, const uint32_t max_connect, serror_t *error)
+{
+    Socket *socket = NULL;
+    if (host == NULL)
+    {
+        /* Dual-stack wildcard server, IPv4 only if IPv6 is not available */
+        struct sockaddr_in6 server;
+        bmem_zero(&server, struct sockaddr_in6);
+        server.sin6_family = AF_INET6;
+        server.sin6_port = htons(port);
+        server.sin6_addr = in6addr_any;
+        socket = i_server((struct sockaddr*)&server, sizeof(server), max_connect, error);
+        if (socket == NULL)
+            socket = bsocket_server(port, max_connect, error);
+    }
+    else
+    {
+        struct addrinfo *info = i_addrinfo(host, port, TRUE, error), *addr = NULL;
+        for (addr = info; addr != NULL && socket == NULL; addr = addr->ai_next)
+            socket = i_server(addr->ai_addr, (int)addr->ai_addrlen, max_connect, error);
+
+        if (info != NULL)
+            freeaddrinfo(info);
+    }
+
+    return socket;
+}
+
+/*---------------------------------------------------------------------------*/
+
 Socket *bsocket_accept(Socket *lsocket, const uint32_t timeout_ms, serror_t *error)
 {
     SOCKET lsockid = 0;
     fd_set set;
     int select_id;
     SOCKET cliID;
-    struct sockaddr_in clData;
+    struct sockaddr_storage clData;
     socklen_t sizeSt;
     cassert_no_null(lsocket);
 
@@ -390,8 +517,14 @@ Socket *bsocket_accept(Socket *lsocket, const uint32_t timeout_ms, serror_t *err
 	cliID = accept((SOCKET)(intptr_t)lsocket, (struct sockaddr*)&clData, &sizeSt);
     if (cliID == SOCKET_ERROR)
     {
-        if (error != NULL)
-            i_socket_error();
+        if (WSAGetLastError() == WSAEWOULDBLOCK)
+        {
+            ptr_assign(error, ekSAGAIN);
+        }
+        else if (error != NULL)
+        {
+            *error = i_socket_error();
+        }
         return NULL;
     }
 
@@ -417,16 +550,48 @@ void bsocket_close(Socket **lsocket)
 
 /*---------------------------------------------------------------------------*/
         
+/* IPv4 address of IPv4 and IPv4-mapped IPv6 sockets */
+static void i_addr_ip(const struct sockaddr_storage *address, uint32_t *ip, uint16_t *port)
+{
+    if (address->ss_family == AF_INET)
+    {
+        const struct sockaddr_in *addr = (const struct sockaddr_in*)address;
+        ptr_assign(ip, ntohl(addr->sin_addr.s_addr));
+        ptr_assign(port, ntohs(addr->sin_port));
+    }
+    else if (address->ss_family == AF_INET6)
+    {
+        const struct sockaddr_in6 *addr = (const struct sockaddr_in6*)address;
+        if (IN6_IS_ADDR_V4MAPPED(&addr->sin6_addr))
+        {
+            const uint8_t *b = (const uint8_t*)&addr->sin6_addr + 12;
+            ptr_assign(ip, ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3]);
+        }
+        else
+        {
+            ptr_assign(ip, 0);
+        }
+
+        ptr_assign(port, ntohs(addr->sin6_port));
+    }
+    else
+    {
+        ptr_assign(ip, 0);
+        ptr_assign(port, 0);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
 void bsocket_local_ip(Socket *lsocket, uint32_t *ip, uint16_t *port)
 {
-    struct sockaddr_in laddress;
+    struct sockaddr_storage laddress;
     socklen_t addr_size = sizeof(laddress);
     cassert_no_null(lsocket);
     cassert(ip != NULL || port != NULL);
     if (getsockname((SOCKET)(intptr_t)lsocket, (struct sockaddr*)&laddress, &addr_size) != -1)
     {
-        ptr_assign(ip, ntohl(laddress.sin_addr.s_addr));
-        ptr_assign(port, ntohs(laddress.sin_port));
+        i_addr_ip(&laddress, ip, port);
     }
     else
     {
@@ -439,14 +604,13 @@ void bsocket_local_ip(Socket *lsocket, uint32_t *ip, uint16_t *port)
 
 void bsocket_remote_ip(Socket *lsocket, uint32_t *ip, uint16_t *port)
 {
-    struct sockaddr_in laddress;
+    struct sockaddr_storage laddress;
     socklen_t addr_size = sizeof(laddress);
     cassert_no_null(lsocket);
     cassert(ip != NULL || port != NULL);
     if (getpeername((SOCKET)(intptr_t)lsocket, (struct sockaddr*)&laddress, &addr_size) != -1)
     {
-        ptr_assign(ip, ntohl(laddress.sin_addr.s_addr));
-        ptr_assign(port, ntohs(laddress.sin_port));
+        i_addr_ip(&laddress, ip, port);
     }
     else
     {
@@ -457,6 +621,59 @@ void bsocket_remote_ip(Socket *lsocket, uint32_t *ip, uint16_t *port)
 
 /*---------------------------------------------------------------------------*/
 
+static bool_t i_addr_str(const struct sockaddr_storage *address, const socklen_t addr_size, char_t *addr, const uint32_t size, uint16_t *port)
+{
+    if (getnameinfo((const struct sockaddr*)address, addr_size, (char*)addr, (DWORD)size, NULL, 0, NI_NUMERICHOST) == 0)
+    {
+        i_addr_ip(address, NULL, port);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_local_addr(Socket *lsocket, char_t *addr, const uint32_t size, uint16_t *port)
+{
+    struct sockaddr_storage laddress;
+    socklen_t addr_size = sizeof(laddress);
+    cassert_no_null(lsocket);
+    cassert_no_null(addr);
+    cassert(size > 0);
+    if (getsockname((SOCKET)(intptr_t)lsocket, (struct sockaddr*)&laddress, &addr_size) != -1)
+    {
+        if (i_addr_str(&laddress, addr_size, addr, size, port) == TRUE)
+            return TRUE;
+    }
+
+    addr[0] = '\0';
+    ptr_assign(port, 0);
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_remote_addr(Socket *lsocket, char_t *addr, const uint32_t size, uint16_t *port)
+{
+    struct sockaddr_storage laddress;
+    socklen_t addr_size = sizeof(laddress);
+    cassert_no_null(lsocket);
+    cassert_no_null(addr);
+    cassert(size > 0);
+    if (getpeername((SOCKET)(intptr_t)lsocket, (struct sockaddr*)&laddress, &addr_size) != -1)
+    {
+        if (i_addr_str(&laddress, addr_size, addr, size, port) == TRUE)
+            return TRUE;
+    }
+
+    addr[0] = '\0';
+    ptr_assign(port, 0);
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+
 void bsocket_read_timeout(Socket *socket, const uint32_t timeout_ms)
 {
     int sok = SOCKET_ERROR;
@@ -479,6 +696,64 @@ void bsocket_write_timeout(Socket *socket, const uint32_t timeout_ms)
 
 /*---------------------------------------------------------------------------*/
 
+void bsocket_nodelay(Socket *socket, const bool_t nodelay)
+{
+    int sok = SOCKET_ERROR;
+    BOOL value = nodelay == TRUE ? TRUE : FALSE;
+    cassert_no_null(socket);
+    sok = setsockopt((SOCKET)(intptr_t)socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&value, sizeof(value));
+    cassert_unref(sok == 0, sok);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_keepalive(Socket *socket, const bool_t keepalive, const uint32_t idle_s)
+{
+    int sok = SOCKET_ERROR;
+    cassert_no_null(socket);
+    /* idle_s = 0 --> System default idle time before the first probe */
+    if (keepalive == TRUE && idle_s > 0)
+    {
+        struct tcp_keepalive alive;
+        DWORD bytes = 0;
+        alive.onoff = 1;
+        alive.keepalivetime = (ULONG)idle_s * 1000;
+        alive.keepaliveinterval = 1000;
+        sok = WSAIoctl((SOCKET)(intptr_t)socket, SIO_KEEPALIVE_VALS, &alive, sizeof(alive), NULL, 0, &bytes, NULL, NULL);
+    }
+    else
+    {
+        BOOL value = keepalive == TRUE ? TRUE : FALSE;
+        sok = setsockopt((SOCKET)(intptr_t)socket, SOL_SOCKET, SO_KEEPALIVE, (const char*)&value, sizeof(value));
+    }
+
+    cassert_unref(sok == 0, sok);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_read_bufsize(Socket *socket, const uint32_t size)
+{
+    int sok = SOCKET_ERROR;
+    int value = (int)size;
+    cassert_no_null(socket);
+    sok = setsockopt((SOCKET)(intptr_t)socket, SOL_SOCKET, SO_RCVBUF, (const char*)&value, sizeof(value));
+    cassert_unref(sok == 0, sok);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_write_bufsize(Socket *socket, const uint32_t size)
+{
+    int sok = SOCKET_ERROR;
+    int value = (int)size;
+    cassert_no_null(socket);
+    sok = setsockopt((SOCKET)(intptr_t)socket, SOL_SOCKET, SO_SNDBUF, (const char*)&value, sizeof(value));
+    cassert_unref(sok == 0, sok);
+}
+
+/*---------------------------------------------------------------------------*/
+
 //uint32_t bsocket_get_timeout(Socket *socket);
 //uint32_t bsocket_get_timeout(Socket *lsocket)
 //{
@@ -538,6 +813,8 @@ bool_t bsocket_read(Socket *lsocket, byte_t *data, const uint32_t size, uint32_t
             int sock_error = WSAGetLastError();
             if (sock_error == WSAETIMEDOUT)
                 lerror = ekSTIMEOUT;
+            else if (sock_error == WSAEWOULDBLOCK)
+                lerror = ekSAGAIN;
             else
                 lerror = ekSSTREAM;
 
@@ -561,6 +838,7 @@ bool_t bsocket_write(Socket *lsocket, const byte_t *data, const uint32_t size, u
 {
     SSIZE_T lwsize = 0;
     bool_t ok = FALSE;
+    serror_t lerror = ekSSTREAM;
     cassert_no_null(lsocket);
     cassert_no_null(data);
 
@@ -588,6 +866,11 @@ bool_t bsocket_write(Socket *lsocket, const byte_t *data, const uint32_t size, u
         }
         else if (num_wbytes == SOCKET_ERROR)
         {
+            int sock_error = WSAGetLastError();
+            if (sock_error == WSAETIMEDOUT)
+                lerror = ekSTIMEOUT;
+            else if (sock_error == WSAEWOULDBLOCK)
+                lerror = ekSAGAIN;
             ok = FALSE;
             break;
         }
@@ -600,12 +883,341 @@ bool_t bsocket_write(Socket *lsocket, const byte_t *data, const uint32_t size, u
     }
 
     ptr_assign(wsize, (uint32_t)lwsize);
-    ptr_assign(error, ok == TRUE ? ekSOK : ekSSTREAM);
+    ptr_assign(error, ok == TRUE ? ekSOK : lerror);
     return ok;
 }
 
 /*---------------------------------------------------------------------------*/
 
+/* WSABUF array from the current buffer and offset */
+static DWORD i_wsabuf(WSABUF *wbuf, const SockBuf *bufs, const uint32_t n, const uint32_t cbuf, const uint32_t offset)
+{
+    uint32_t i;
+    DWORD nbuf = 0;
+    for (i = cbuf; i < n && nbuf < i_IOV_MAX; ++i)
+    {
+        uint32_t off = (i == cbuf) ? offset : 0;
+        if (bufs[i].size > off)
+        {
+            cassert_no_null(bufs[i].data);
+            wbuf[nbuf].buf = (CHAR*)(bufs[i].data + off);
+            wbuf[nbuf].len = (ULONG)(bufs[i].size - off);
+            nbuf += 1;
+        }
+    }
+
+    return nbuf;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_iov_advance(const SockBuf *bufs, const uint32_t n, uint32_t *cbuf, uint32_t *offset, uint32_t nbytes)
+{
+    while (*cbuf < n)
+    {
+        uint32_t remain = bufs[*cbuf].size - *offset;
+        if (remain > nbytes)
+        {
+            *offset += nbytes;
+            break;
+        }
+
+        nbytes -= remain;
+        *cbuf += 1;
+        *offset = 0;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+static bool_t i_iov_io(Socket *lsocket, const SockBuf *bufs, const uint32_t n, const bool_t read, uint32_t *size, serror_t *error)
+{
+    WSABUF wbuf[i_IOV_MAX];
+    uint32_t cbuf = 0, offset = 0, lsize = 0;
+    serror_t lerror = ekSOK;
+
+    cassert_no_null(lsocket);
+    cassert(bufs != NULL || n == 0);
+
+    for (;;)
+    {
+        DWORD num_bytes = 0, flags = 0;
+        int ret = 0;
+        DWORD nbuf = i_wsabuf(wbuf, bufs, n, cbuf, offset);
+        if (nbuf == 0)
+            break;
+
+        if (read == TRUE)
+            ret = WSARecv((SOCKET)(intptr_t)lsocket, wbuf, nbuf, &num_bytes, &flags, NULL, NULL);
+        else
+            ret = WSASend((SOCKET)(intptr_t)lsocket, wbuf, nbuf, &num_bytes, 0, NULL, NULL);
+
+        if (ret == SOCKET_ERROR)
+        {
+            int sock_error = WSAGetLastError();
+            if (sock_error == WSAETIMEDOUT)
+                lerror = ekSTIMEOUT;
+            else if (sock_error == WSAEWOULDBLOCK)
+                lerror = ekSAGAIN;
+            else
+                lerror = ekSSTREAM;
+            break;
+        }
+
+        /* Connection closed by peer */
+        if (num_bytes == 0)
+        {
+            cassert(read == TRUE);
+            break;
+        }
+
+        lsize += (uint32_t)num_bytes;
+        i_iov_advance(bufs, n, &cbuf, &offset, (uint32_t)num_bytes);
+    }
+
+    ptr_assign(size, lsize);
+    ptr_assign(error, lerror);
+    return (bool_t)(lerror == ekSOK);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_readv(Socket *lsocket, const SockBuf *bufs, const uint32_t n, uint32_t *rsize, serror_t *error)
+{
+    return i_iov_io(lsocket, bufs, n, TRUE, rsize, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_writev(Socket *lsocket, const SockBuf *bufs, const uint32_t n, uint32_t *wsize, serror_t *error)
+{
+    return i_iov_io(lsocket, bufs, n, FALSE, wsize, error);
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_nonblock(Socket *socket, const bool_t nonblock)
+{
+    u_long mode = nonblock == TRUE ? 1 : 0;
+    int ret = 0;
+    cassert_no_null(socket);
+    ret = ioctlsocket((SOCKET)(intptr_t)socket, FIONBIO, &mode);
+    cassert_unref(ret == 0, ret);
+}
+
+/*---------------------------------------------------------------------------*/
+
+SockPoll *bsocket_poll_create(void)
+{
+    SockPoll *poll = (SockPoll*)bmem_malloc(sizeof(SockPoll));
+    poll->fds = NULL;
+    poll->regs = NULL;
+    poll->count = 0;
+    poll->alloc = 0;
+    poll->dispatching = FALSE;
+    poll->removed = FALSE;
+    return poll;
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_poll_destroy(SockPoll **poll)
+{
+    uint32_t i;
+    cassert_no_null(poll);
+    cassert_no_null(*poll);
+    cassert((*poll)->dispatching == FALSE);
+    for (i = 0; i < (*poll)->count; ++i)
+        bmem_free((byte_t*)(*poll)->regs[i]);
+
+    if ((*poll)->fds != NULL)
+    {
+        bmem_free((byte_t*)(*poll)->fds);
+        bmem_free((byte_t*)(*poll)->regs);
+    }
+
+    bmem_free((byte_t*)*poll);
+    *poll = NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static SHORT i_poll_events(const uint32_t events)
+{
+    SHORT ev = 0;
+    if (events & ekSOCK_READ)
+        ev = (SHORT)(ev | POLLRDNORM);
+    if (events & ekSOCK_WRITE)
+        ev = (SHORT)(ev | POLLWRNORM);
+    return ev;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_poll_add_imp(SockPoll *poll, Socket *socket, const uint32_t events, void *data, FPtr_sock_event func_event)
+{
+    i_PollReg *reg = NULL;
+    cassert_no_null(poll);
+    cassert_no_null(socket);
+    cassert_no_nullf(func_event);
+
+    if (poll->count == poll->alloc)
+    {
+        uint32_t alloc = poll->alloc > 0 ? poll->alloc * 2 : 64;
+        WSAPOLLFD *fds = (WSAPOLLFD*)bmem_malloc(alloc * sizeof32(WSAPOLLFD));
+        i_PollReg **regs = (i_PollReg**)bmem_malloc(alloc * sizeof32(i_PollReg*));
+        if (poll->count > 0)
+        {
+            bmem_copy((byte_t*)fds, (const byte_t*)poll->fds, poll->count * sizeof32(WSAPOLLFD));
+            bmem_copy((byte_t*)regs, (const byte_t*)poll->regs, poll->count * sizeof32(i_PollReg*));
+        }
+
+        if (poll->fds != NULL)
+        {
+            bmem_free((byte_t*)poll->fds);
+            bmem_free((byte_t*)poll->regs);
+        }
+
+        poll->fds = fds;
+        poll->regs = regs;
+        poll->alloc = alloc;
+    }
+
+    reg = (i_PollReg*)bmem_malloc(sizeof(i_PollReg));
+    reg->socket = socket;
+    reg->events = events;
+    reg->data = data;
+    reg->func_event = func_event;
+    poll->fds[poll->count].fd = (SOCKET)(intptr_t)socket;
+    poll->fds[poll->count].events = i_poll_events(events);
+    poll->fds[poll->count].revents = 0;
+    poll->regs[poll->count] = reg;
+    poll->count += 1;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t i_find(const SockPoll *poll, const Socket *socket)
+{
+    uint32_t i;
+    cassert_no_null(poll);
+    for (i = 0; i < poll->count; ++i)
+    {
+        if (poll->regs[i]->socket == socket)
+            return i;
+    }
+
+    return UINT32_MAX;
+}
+
+/*---------------------------------------------------------------------------*/
+
+bool_t bsocket_poll_mod(SockPoll *poll, Socket *socket, const uint32_t events)
+{
+    uint32_t i = i_find(poll, socket);
+    cassert(i != UINT32_MAX);
+    poll->regs[i]->events = events;
+    poll->fds[i].events = i_poll_events(events);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void i_remove(SockPoll *poll, const uint32_t i)
+{
+    bmem_free((byte_t*)poll->regs[i]);
+    poll->count -= 1;
+    poll->fds[i] = poll->fds[poll->count];
+    poll->regs[i] = poll->regs[poll->count];
+}
+
+/*---------------------------------------------------------------------------*/
+
+void bsocket_poll_remove(SockPoll *poll, Socket *socket)
+{
+    uint32_t i = i_find(poll, socket);
+    if (i != UINT32_MAX)
+    {
+        /* Compacted after dispatching */
+        if (poll->dispatching == TRUE)
+        {
+            poll->regs[i]->socket = NULL;
+            poll->removed = TRUE;
+        }
+        else
+        {
+            i_remove(poll, i);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+
+uint32_t bsocket_poll_wait(SockPoll *poll, const uint32_t timeout_ms)
+{
+    int n = 0;
+    uint32_t i, count;
+    cassert_no_null(poll);
+    cassert(poll->dispatching == FALSE);
+
+    if (poll->count == 0)
+    {
+        if (timeout_ms != UINT32_MAX)
+            Sleep((DWORD)timeout_ms);
+        return 0;
+    }
+
+    n = WSAPoll(poll->fds, (ULONG)poll->count, timeout_ms == UINT32_MAX ? -1 : (INT)timeout_ms);
+    if (n <= 0)
+        return 0;
+
+    /* Sockets added by callbacks are not polled in this round */
+    count = poll->count;
+    poll->dispatching = TRUE;
+    for (i = 0; i < count; ++i)
+    {
+        SHORT revents = poll->fds[i].revents;
+        i_PollReg *reg = poll->regs[i];
+        uint32_t ev = 0;
+
+        if (revents == 0 || reg->socket == NULL)
+            continue;
+
+        poll->fds[i].revents = 0;
+        if (revents & POLLRDNORM)
+            ev |= ekSOCK_READ;
+        if (revents & POLLWRNORM)
+            ev |= ekSOCK_WRITE;
+        if (revents & POLLHUP)
+            ev |= ekSOCK_CLOSE | ekSOCK_READ;
+        if (revents & (POLLERR | POLLNVAL))
+            ev |= ekSOCK_ERROR;
+
+        reg->func_event(reg->data, reg->socket, ev);
+    }
+
+    poll->dispatching = FALSE;
+
+    if (poll->removed == TRUE)
+    {
+        i = 0;
+        while (i < poll->count)
+        {
+            if (poll->regs[i]->socket == NULL)
+                i_remove(poll, i);
+            else
+                i += 1;
+        }
+
+        poll->removed = FALSE;
+    }
+
+    return (uint32_t)n;
+}
+
+/*---------------------------------------------------------------------------*/
+
 //bool_t bsocket_shutdown(Socket *socket, serror_t *error);
 //bool_t bsocket_shutdown(Socket *lsocket, serror_t *error)
 //{
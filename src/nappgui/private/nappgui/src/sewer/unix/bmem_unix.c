@@ -18,6 +18,7 @@
 #endif
 
 #include "cassert.h"
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -84,6 +85,38 @@ byte_t *bmem_aligned_malloc(const uint32_t size, const uint32_t align)
 
 /*---------------------------------------------------------------------------*/
 
+byte_t *bmem_aligned_malloc64(const uint64_t size, const uint32_t align)
+{
+    byte_t *mem = NULL;
+    /* Align must be power of 2 */
+    cassert((align != 0) && (align & (align - 1)) == 0);
+    /* Address space too small (32-bit systems) */
+    if (size > (uint64_t)(SIZE_MAX - align - sizeof(void*)))
+        return NULL;
+
+    #if defined(HAVE_POSIX_MEMALIGN)
+    {
+        void *mem1 = NULL;
+        if (posix_memalign(&mem1, (size_t)align, (size_t)size) == 0)
+            mem = (byte_t*)mem1;
+    }
+    #else
+    {
+        void *alloc_mem = malloc((size_t)(size + (align - 1) + sizeof(void*)));
+        if (alloc_mem != NULL)
+        {
+            mem = ((byte_t*)alloc_mem) + sizeof(void*);
+            mem += (align - ((size_t)mem & (align - 1)) & (align - 1));
+            ((void**)mem)[-1] = alloc_mem;
+        }
+    }
+    #endif
+
+    return mem;
+}
+
+/*---------------------------------------------------------------------------*/
+
 byte_t *bmem_aligned_realloc(byte_t *mem, const uint32_t size, const uint32_t new_size, const uint32_t align)
 {
     /* Align must be power of 2 */
@@ -19,6 +19,7 @@
 #endif
 
 #include "nowarn.hxx"
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <windows.h>
@@ -31,6 +32,7 @@
 #if defined(__MEMORY_AUDITOR__)
 #define _CRTDBG_MAP_ALLOC
 #pragma warning(push, 0) 
+#include <stdint.h>
 #include <stdlib.h>
 
 #if _MSC_VER > 1400
@@ -165,6 +167,26 @@ byte_t *bmem_aligned_malloc(const uint32_t size, const uint32_t align)
 
 /*---------------------------------------------------------------------------*/
 
+byte_t *bmem_aligned_malloc64(const uint64_t size, const uint32_t align)
+{
+    void *mem = NULL;
+
+    /* Address space too small (32-bit systems) */
+    if (size > (uint64_t)SIZE_MAX)
+        return NULL;
+
+    mem = _aligned_malloc((size_t)size, (size_t)align);
+
+    #if defined (__MEMORY_SUBSYTEM_CHECKING__)
+    if (mem != NULL)
+        i_mem_append(mem);
+    #endif
+    cassert(((intptr_t)mem % align) == 0);
+    return (byte_t*)mem;
+}
+
+/*---------------------------------------------------------------------------*/
+
 byte_t *bmem_aligned_realloc(byte_t *mem, const uint32_t size, const uint32_t new_size, const uint32_t align)
 {
     void *new_mem;
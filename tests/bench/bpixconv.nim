@@ -0,0 +1,71 @@
+## Pixel format conversion benchmark: SIMD kernels against the scalar paths.
+##
+## Run with `nim c -r -d:release tests/bench/bpixconv.nim`
+
+import std/[monotimes, random, strformat, times]
+
+import nappgui/bindings/[sewer, draw2d]
+
+# Internal kernel controls (draw2d/pixconv.inl), not part of the public API
+proc pixconv_simd(enable: bool_t) {.importc, noconv.}
+proc pixconv_isa(): cstring {.importc, noconv.}
+
+const
+  width = 1920'u32
+  height = 1080'u32
+  rounds = 20
+
+  pairs = [
+    (ekRGBA32, ekRGB24),
+    (ekRGBA32, ekGRAY8),
+    (ekRGB24, ekRGBA32),
+    (ekRGB24, ekGRAY8),
+    (ekGRAY8, ekRGB24),
+    (ekGRAY8, ekRGBA32),
+    (ekINDEX1, ekRGBA32),
+    (ekINDEX2, ekRGB24),
+    (ekINDEX4, ekRGBA32),
+    (ekINDEX4, ekGRAY8),
+    (ekINDEX8, ekRGB24),
+    (ekINDEX8, ekRGBA32)
+  ]
+
+proc fill(pixbuf: ptr Pixbuf) =
+  let data = cast[ptr UncheckedArray[uint8]](pixbuf_data(pixbuf))
+  for i in 0 ..< pixbuf_dsize(pixbuf).int:
+    data[i] = rand(255).uint8
+
+proc run(src: ptr Pixbuf, oformat: pixformat_t, simd: bool): (float, ptr Pixbuf) =
+  pixconv_simd(if simd: TRUE else: FALSE)
+  var best = Inf
+  for i in 0 ..< rounds:
+    let t0 = getMonoTime()
+    var dest = pixbuf_convert(src, nil, oformat)
+    let t = (getMonoTime() - t0).inNanoseconds.float
+    best = min(best, t)
+    if i == rounds - 1:
+      result[1] = dest
+    else:
+      pixbuf_destroy(dest.addr)
+  result[0] = best
+
+proc main() =
+  draw2d_start()
+  let pixels = float(width * height)
+  echo &"{width}x{height} pixels, best of {rounds}, kernels: {pixconv_isa()}"
+  echo &"""{"conversion":<20}{"scalar MP/s":>14}{"simd MP/s":>14}{"speedup":>10}"""
+  for (iformat, oformat) in pairs:
+    var src = pixbuf_create(width, height, iformat)
+    fill(src)
+    var (ts, ds) = run(src, oformat, false)
+    var (tv, dv) = run(src, oformat, true)
+    let same = equalMem(pixbuf_data(ds), pixbuf_data(dv), pixbuf_dsize(ds).int)
+    let name = &"{iformat} -> {oformat}"
+    echo &"{name:<20}{pixels * 1000 / ts:>14.1f}{pixels * 1000 / tv:>14.1f}{ts / tv:>9.2f}x" &
+      (if same: "" else: "  MISMATCH")
+    pixbuf_destroy(ds.addr)
+    pixbuf_destroy(dv.addr)
+    pixbuf_destroy(src.addr)
+  draw2d_finish()
+
+main()
@@ -2,6 +2,12 @@
 import units/[
   tbindings,
   tarray,
+  theap,
+  thashtab,
+  tjson,
+  tlog,
+  tregex,
+  tsocket,
   tdraw2d,
   tgeom2d
 ]
@@ -25,4 +25,39 @@ test "getInstalledFonts()":
 test "Font.`=copy`":
   let font = Font.init(DefaultFont.system, 12)
   let copy = font
-  check font == copy
\ No newline at end of file
+  check font == copy
+test "Pixbuf.quantize":
+  # 64x64 gradient, 4096 distinct colors
+  var rgb = Pixbuf.init(64, 64, Pixformat.rgb24)
+  for y in 0..<64:
+    for x in 0..<64:
+      let i = (y * 64 + x) * 3
+      rgb.data[i] = byte(x * 4)
+      rgb.data[i + 1] = byte(y * 4)
+      rgb.data[i + 2] = byte((x + y) * 2)
+  for dither in [false, true]:
+    var palette: Palette
+    let indexed = rgb.quantize(palette, dither)
+    check indexed.format == Pixformat.index8
+    check palette.len > 0 and palette.len <= 256
+    var valid = true
+    for y in 0..<64:
+      for x in 0..<64:
+        if indexed.get(x, y).int >= palette.len:
+          valid = false
+    check valid
+
+test "Pixbuf.quantize few colors":
+  var rgb = Pixbuf.init(8, 8, Pixformat.rgb24)
+  for i in 0..<64:
+    let c = byte((i mod 3) * 100)
+    rgb.data[i * 3] = c
+    rgb.data[i * 3 + 1] = c
+    rgb.data[i * 3 + 2] = c
+  var palette: Palette
+  let indexed = rgb.quantize(palette)
+  check indexed.format == Pixformat.index2
+  check palette.len == 3
+  for i in 0..<64:
+    let c = palette[indexed.get(i mod 8, i div 8).int]
+    check c == color(uint8((i mod 3) * 100), uint8((i mod 3) * 100), uint8((i mod 3) * 100))
@@ -0,0 +1,76 @@
+import nappgui/bindings/[core, sewer]
+
+import std/unittest
+
+type KV = object
+  k, v: uint32
+
+proc kvHash(obj: pointer): uint32_t {.noconv.} =
+  cast[ptr KV](obj).k * 2654435761'u32
+
+proc kvCompare(a, b: pointer): cint {.noconv.} =
+  cint(cast[ptr KV](a).k) - cint(cast[ptr KV](b).k)
+
+proc put(tab: ptr HashTab[KV], k: uint32) =
+  var key = KV(k: k)
+  cast[ptr KV](hashtab_insert(tab, key.addr)).v = k * 3
+
+proc find(tab: ptr HashTab[KV], k: uint32): ptr KV =
+  var key = KV(k: k)
+  cast[ptr KV](hashtab_get(tab, key.addr))
+
+proc count(tab: ptr HashTab[KV]): uint32 =
+  var it: uint32
+  var e = hashtab_first(tab, it.addr)
+  while e != nil:
+    result += 1
+    e = hashtab_next(tab, it.addr)
+
+test "hash table insert, delete and rehash":
+  var tab = hashtab_create[KV](kvHash, kvCompare, sizeof(KV).uint16, "KV")
+  check tab != nil
+  for i in 0'u32 ..< 1000'u32:
+    put(tab, i)
+  check hashtab_size(tab) == 1000
+  # insert of an existing key returns nil
+  var dup = KV(k: 10)
+  check hashtab_insert(tab, dup.addr) == nil
+  for i in countup(0'u32, 999'u32, 2):
+    var key = KV(k: i)
+    check hashtab_delete(tab, key.addr, nil) == TRUE
+  check hashtab_size(tab) == 500
+  var ok = true
+  for i in 0'u32 ..< 1000'u32:
+    let e = find(tab, i)
+    if (i and 1) == 1:
+      if e == nil or e.v != i * 3: ok = false
+    elif e != nil:
+      ok = false
+  check ok
+  # reinsert over deleted slots and grow past the reserve
+  hashtab_reserve(tab, 4000)
+  for i in 1000'u32 ..< 3000'u32:
+    put(tab, i)
+  check hashtab_size(tab) == 2500
+  check find(tab, 2999).v == 2999 * 3
+  hashtab_destroy(tab.addr, nil, "KV")
+  check tab == nil
+
+test "hash table iteration":
+  var tab = hashtab_create[KV](kvHash, kvCompare, sizeof(KV).uint16, "KV")
+  var it: uint32
+  check hashtab_first(tab, it.addr) == nil
+  for i in 0'u32 ..< 100'u32:
+    put(tab, i)
+  var sum, nested: uint32
+  var e = hashtab_first(tab, it.addr)
+  while e != nil:
+    sum += cast[ptr KV](e).k
+    # independent iterators over the same table
+    nested += count(tab)
+    e = hashtab_next(tab, it.addr)
+  check sum == 4950
+  check nested == 100 * 100
+  hashtab_clear(tab, nil)
+  check count(tab) == 0
+  hashtab_destroy(tab.addr, nil, "KV")
@@ -0,0 +1,30 @@
+import nappgui/bindings/[core, sewer]
+
+import std/unittest
+
+test "outside array grows inside arena":
+  var arr = array_create[uint32](sizeof(uint32).uint16, $uint32)
+  for i in 0'u32 ..< 4'u32:
+    cast[ptr uint32](array_insert(arr, array_size(arr), 1))[] = i
+
+  var arena = heap_arena_create(4096)
+  heap_arena_push(arena)
+  for i in 4'u32 ..< 20000'u32:
+    cast[ptr uint32](array_insert(arr, array_size(arr), 1))[] = i
+  var tmp = heap_malloc(100, "Tmp")
+  tmp = heap_realloc(tmp, 100, 5000, "Tmp")
+  heap_arena_pop(arena)
+  check heap_arena_bytes(arena) >= 5000
+  heap_arena_destroy(arena.addr)
+  check arena == nil
+
+  check array_size(arr) == 20000
+  var ok = true
+  for i in 0'u32 ..< 20000'u32:
+    if cast[ptr uint32](array_get(arr, i))[] != i:
+      ok = false
+  check ok
+  cast[ptr uint32](array_insert(arr, array_size(arr), 1))[] = 20000
+  check array_size(arr) == 20001
+  array_destroy(arr.addr, nil, $uint32)
+  check arr == nil
@@ -0,0 +1,61 @@
+import nappgui/bindings/[core, inet, sewer]
+
+import std/unittest
+
+type Nums = object
+  a0, a1, a2, a3, a4, a5, d: real64_t
+  f, g: real32_t
+
+proc bindNums() =
+  template real64(name: string, offset: int) =
+    dbind_imp("Nums", sizeof(Nums).uint16, name, "real64_t", offset.uint16, 8)
+  real64("a0", offsetOf(Nums, a0))
+  real64("a1", offsetOf(Nums, a1))
+  real64("a2", offsetOf(Nums, a2))
+  real64("a3", offsetOf(Nums, a3))
+  real64("a4", offsetOf(Nums, a4))
+  real64("a5", offsetOf(Nums, a5))
+  real64("d", offsetOf(Nums, d))
+  dbind_imp("Nums", sizeof(Nums).uint16, "f", "real32_t", offsetOf(Nums, f).uint16, 4)
+  dbind_imp("Nums", sizeof(Nums).uint16, "g", "real32_t", offsetOf(Nums, g).uint16, 4)
+  # Full range and finest precision, so any double is kept as read
+  var lo = -high(float64)
+  var hi = high(float64)
+  var prec = 5e-324
+  for m in ["a0", "a1", "a2", "a3", "a4", "a5"]:
+    dbind_range_imp("Nums", m.cstring, lo.addr, hi.addr)
+    dbind_precision_imp("Nums", m.cstring, prec.addr)
+  var lof = -high(float32)
+  var hif = high(float32)
+  var precf = 1.4e-45'f32
+  dbind_range_imp("Nums", "g", lof.addr, hif.addr)
+  dbind_precision_imp("Nums", "g", precf.addr)
+
+test "json real members round trip":
+  bindNums()
+  let js = """{ "a0": 1e-7, "a1": 1E+2, "a2": 1.5e308, "a3": 5e-324,
+    "a4": 123456789012345678901234567890, "a5": -2.5e-310,
+    "d": 1.5e308, "f": 1e-7, "g": 3.4e38 }"""
+  var stm = stm_from_block(cast[ptr byte_t](js.cstring), js.len.uint32)
+  var n = cast[ptr Nums](json_read_imp(stm, nil, "Nums"))
+  stm_close(stm.addr)
+  check n != nil
+  check n.a0 == 1e-7
+  check n.a1 == 100.0
+  check n.a2 == 1.5e308
+  check n.a3 == 5e-324
+  check n.a4 == 123456789012345678901234567890.0
+  check n.a5 == -2.5e-310
+  # Default member range (+/-1e8) and precision (.01) still apply
+  check n.d == 1e8
+  check n.f == 0.0'f32
+  check n.g == 3.4e38'f32
+
+  var output = stm_memory(1024)
+  json_write_imp(output, n, nil, "Nums")
+  var n2 = cast[ptr Nums](json_read_imp(output, nil, "Nums"))
+  stm_close(output.addr)
+  check n2 != nil
+  check n2[] == n[]
+  json_destroy_imp(cast[ptr pointer](n.addr), "Nums")
+  json_destroy_imp(cast[ptr pointer](n2.addr), "Nums")
@@ -0,0 +1,141 @@
+import nappgui/bindings/[osbs, sewer]
+
+import std/[os, sets, strutils, unittest]
+
+const Producers = 4
+const Lines = 2000
+
+proc tmpPath(name: string): string =
+  getTempDir() / ("nappgui_tlog_" & name)
+
+proc producer(data: pointer): uint32_t {.noconv.} =
+  let t = cast[int](data)
+  for i in 0 ..< Lines:
+    log_info("ring", "t%d line %d", t.cint, i.cint)
+
+test "log async ring drains every line":
+  osbs_start()
+  log_output(FALSE, FALSE)
+  let path = tmpPath("ring.txt")
+  removeFile(path)
+  log_file(path.cstring)
+  log_async(TRUE)
+  # More lines than ring slots, producers wait for the consumer
+  var threads: array[Producers, ptr osbs.Thread]
+  for t in 0 ..< Producers:
+    threads[t] = bthread_create_imp(cast[ptr FPtr_thread_main](producer),
+                                    cast[pointer](t))
+  for th in threads.mitems:
+    discard bthread_wait(th)
+    bthread_close(th.addr)
+  log_flush()
+  log_async(FALSE)
+  log_file(nil)
+
+  # "[hh:mm:ss] INFO [ring] t0 line 0"
+  var count = 0
+  var messages = initHashSet[string]()
+  for line in lines(path):
+    messages.incl line.split("] ")[^1]
+    count += 1
+  check count == Producers * Lines
+  var missing = 0
+  for t in 0 ..< Producers:
+    for i in 0 ..< Lines:
+      if ("t" & $t & " line " & $i) notin messages:
+        missing += 1
+  check missing == 0
+  removeFile(path)
+  log_output(TRUE, FALSE)
+  osbs_finish()
+
+test "log levels and categories":
+  osbs_start()
+  log_output(FALSE, FALSE)
+  check log_enabled(ekLOG_INFO, nil) == TRUE
+  check log_enabled(ekLOG_DEBUG, nil) == FALSE
+  log_level(ekLOG_WARN)
+  log_category("net", ekLOG_DEBUG)
+  check log_enabled(ekLOG_INFO, "db") == FALSE
+  check log_enabled(ekLOG_ERROR, "db") == TRUE
+  check log_enabled(ekLOG_DEBUG, "net") == TRUE
+  check log_enabled(ekLOG_TRACE, "net") == FALSE
+
+  let path = tmpPath("levels.txt")
+  removeFile(path)
+  log_file(path.cstring)
+  log_info("db", "hidden")
+  log_debug("net", "shown")
+  log_error("db", "failed")
+  log_file(nil)
+  let text = readFile(path)
+  check "hidden" notin text
+  check "DEBUG [net] shown" in text
+  check "ERROR [db] failed" in text
+  removeFile(path)
+
+  log_category("net", ekLOG_INFO)
+  log_level(ekLOG_INFO)
+  log_output(TRUE, FALSE)
+  osbs_finish()
+
+test "log binary records decode to text":
+  osbs_start()
+  log_output(FALSE, FALSE)
+  let bin = tmpPath("records.bin")
+  let txt = tmpPath("records.txt")
+  removeFile(bin)
+  log_binary(TRUE)
+  log_file(bin.cstring)
+  log_warn("net", "binary %d", 42.cint)
+  var fields = [log_int("a", -3), log_str("s", "xyz"), log_bool("b", TRUE)]
+  log_fields(ekLOG_ERROR, "db", "fields", fields[0].addr, fields.len.uint32)
+  log_file(nil)
+  log_binary(FALSE)
+
+  var error = ekFUNDEF
+  check log_decode(bin.cstring, txt.cstring, error.addr) == TRUE
+  check error == ekFOK
+  let text = readFile(txt)
+  check "WARN [net] binary 42" in text
+  check "ERROR [db] fields a=-3 s=\"xyz\" b=true" in text
+  removeFile(bin)
+  removeFile(txt)
+  log_output(TRUE, FALSE)
+  osbs_finish()
+
+test "log decode rejects truncated and corrupt files":
+  osbs_start()
+  log_output(FALSE, FALSE)
+  let bin = tmpPath("corrupt.bin")
+  let bad = tmpPath("bad.bin")
+  let txt = tmpPath("corrupt.txt")
+  removeFile(bin)
+  log_binary(TRUE)
+  log_file(bin.cstring)
+  log_info("db", "record %d", 1.cint)
+  log_info("db", "record %d", 2.cint)
+  log_file(nil)
+  log_binary(FALSE)
+  let data = readFile(bin)
+
+  proc decodeFails(content: string): bool =
+    writeFile(bad, content)
+    var error = ekFOK
+    result = log_decode(bad.cstring, txt.cstring, error.addr) == FALSE and
+             error == ekFUNDEF
+
+  # Last record cut short
+  check decodeFails(data[0 ..< data.len - 3])
+  # First record size far beyond the end of file
+  var huge = data
+  for i in 8 ..< 12:
+    huge[i] = '\xFF'
+  check decodeFails(huge)
+  # Not a binary log
+  check decodeFails("NOTALOG!")
+  removeFile(bin)
+  removeFile(bad)
+  removeFile(txt)
+  log_output(TRUE, FALSE)
+  osbs_finish()
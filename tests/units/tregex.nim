@@ -0,0 +1,166 @@
+import nappgui/bindings/[core, osbs, sewer]
+
+import std/unittest
+
+proc window(w: int): string =
+  # "w-th symbol from the end is 'a'", its DFA has 2^w states
+  result = "[ab]*a"
+  for i in 1 ..< w:
+    result.add "[ab]"
+
+proc mismatches(r: ptr RegEx, w: int): uint32 =
+  # Every {a,b} string up to w + 1 chars, so all the states are reached
+  var s: array[16, char]
+  for n in 0 .. w + 1:
+    for k in 0 ..< (1 shl n):
+      for i in 0 ..< n:
+        s[i] = if ((k shr i) and 1) == 1: 'b' else: 'a'
+      s[n] = '\0'
+      let expected = n >= w and s[n - w] == 'a'
+      if (regex_match(r, cast[cstring](s[0].addr)) == TRUE) != expected:
+        result += 1
+
+proc matchThread(data: pointer): uint32_t {.noconv.} =
+  mismatches(cast[ptr RegEx](data), 7)
+
+test "regex match and no match":
+  core_start()
+  var r = regex_create("ab*c")
+  check r != nil
+  check regex_match(r, "ac") == TRUE
+  check regex_match(r, "abbbc") == TRUE
+  check regex_match(r, "abx") == FALSE
+  check regex_match(r, "") == FALSE
+  regex_destroy(r.addr)
+  check r == nil
+  check regex_create("[b") == nil
+  core_finish()
+
+test "regex match is anchored at both ends":
+  core_start()
+  var r = regex_create("ab*c")
+  check regex_match(r, "xabc") == FALSE
+  check regex_match(r, "abcx") == FALSE
+  regex_destroy(r.addr)
+  r = regex_create(".*abc.*")
+  check regex_match(r, "zzabczz") == TRUE
+  regex_destroy(r.addr)
+  core_finish()
+
+test "regex DFA grows past the first state block":
+  core_start()
+  var r = regex_create(window(7).cstring)
+  check mismatches(r, 7) == 0
+  # States are cached now, a second pass must agree
+  check mismatches(r, 7) == 0
+  regex_destroy(r.addr)
+  core_finish()
+
+test "regex DFA falls back to the NFA when the cache is full":
+  core_start()
+  var r = regex_create(window(13).cstring)
+  check mismatches(r, 13) == 0
+  regex_destroy(r.addr)
+  core_finish()
+
+test "regex DFA shared by several threads":
+  core_start()
+  # Fresh regex, so the threads race to build the same states
+  var r = regex_create(window(7).cstring)
+  var threads: array[4, ptr osbs.Thread]
+  for th in threads.mitems:
+    th = bthread_create_imp(cast[ptr FPtr_thread_main](matchThread), r)
+  for th in threads.mitems:
+    check bthread_wait(th) == 0
+    bthread_close(th.addr)
+  check mismatches(r, 7) == 0
+  regex_destroy(r.addr)
+  core_finish()
+
+type Found = object
+  rows, starts, ends: seq[uint32]
+  stopAfter: int
+
+proc onMatch(obj: pointer, evt: ptr Event) {.noconv.} =
+  let found = cast[ptr Found](obj)
+  let p = cast[ptr EvRegEx](event_params_imp(evt, "EvRegEx"))
+  found.rows.add p.row
+  found.starts.add p.start
+  found.ends.add p.`end`
+  if found.rows.len == found.stopAfter:
+    cast[ptr bool_t](event_result_imp(evt, "bool_t"))[] = FALSE
+
+proc search(pattern, str: string, size = -1): (bool, uint32, uint32) =
+  var r = regex_create(pattern.cstring)
+  var st, ed: uint32_t
+  let ok =
+    if size < 0: regex_search(r, str.cstring, st.addr, ed.addr)
+    else: regex_search_n(r, str.cstring, size.uint32, st.addr, ed.addr)
+  regex_destroy(r.addr)
+  if ok == TRUE: (true, st, ed) else: (false, 0'u32, 0'u32)
+
+test "regex search is leftmost longest":
+  core_start()
+  check search("[(ab)(abc)a]", "xxabcd") == (true, 2'u32, 5'u32)
+  # Tie at the same start, the longer alternative wins
+  check search("[a(ab)]", "ab") == (true, 0'u32, 2'u32)
+  # Overlapping alternatives on both halves
+  check search("[a(ab)][c(bcd)]", "abcd") == (true, 0'u32, 4'u32)
+  # Leftmost wins over longer
+  check search("[(bcd)a]", "abcd") == (true, 0'u32, 1'u32)
+  core_finish()
+
+test "regex search no match, empty match and bounded size":
+  core_start()
+  check search("z", "abc") == (false, 0'u32, 0'u32)
+  check search("x*", "abc") == (true, 0'u32, 0'u32)
+  check search("c", "abcabc", 2) == (false, 0'u32, 0'u32)
+  check search("c", "abcabc", 3) == (true, 2'u32, 3'u32)
+  # Byte offsets over UTF-8
+  check search("ñ*ñ", "aññb") == (true, 1'u32, 5'u32)
+  core_finish()
+
+test "regex search over a stream":
+  core_start()
+  const text = "a1 22\nb333\n"
+  var r = regex_create("[0-9][0-9]*")
+  var found = Found(stopAfter: -1)
+  var stm = stm_from_block(cast[ptr byte_t](text.cstring), text.len.uint32)
+  let n = regex_search_stm(r, stm,
+    listener_imp(found.addr, cast[ptr FPtr_event_handler](onMatch)))
+  stm_close(stm.addr)
+  check n == 3
+  check found.rows == @[1'u32, 1, 2]
+  check found.starts == @[1'u32, 3, 1]
+  check found.ends == @[2'u32, 5, 4]
+
+  # The handler stops the iteration
+  found = Found(stopAfter: 1)
+  stm = stm_from_block(cast[ptr byte_t](text.cstring), text.len.uint32)
+  check regex_search_stm(r, stm,
+    listener_imp(found.addr, cast[ptr FPtr_event_handler](onMatch))) == 1
+  stm_close(stm.addr)
+  check found.rows == @[1'u32]
+  regex_destroy(r.addr)
+  core_finish()
+
+test "regex set returns every matching pattern":
+  core_start()
+  var patterns = allocCStringArray(["a.*", ".*b", "c"])
+  var rs = regex_set_create(patterns, 3)
+  var ids: array[4, uint32_t]
+  check regex_set_match(rs, "ab", ids[0].addr, 4) == 2
+  check ids[0] == 0 and ids[1] == 1
+  check regex_set_match(rs, "acb", ids[0].addr, 4) == 2
+  check ids[0] == 0 and ids[1] == 1
+  check regex_set_match(rs, "c", ids[0].addr, 4) == 1
+  check ids[0] == 2
+  check regex_set_match(rs, "x", ids[0].addr, 4) == 0
+  regex_set_destroy(rs.addr)
+  deallocCStringArray(patterns)
+
+  # One invalid pattern fails the whole set
+  patterns = allocCStringArray(["a", "[b"])
+  check regex_set_create(patterns, 2) == nil
+  deallocCStringArray(patterns)
+  core_finish()
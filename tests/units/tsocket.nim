@@ -0,0 +1,116 @@
+import nappgui/bindings/[core, osbs, sewer]
+
+import std/unittest
+
+const Port = 47131'u16
+
+proc onPoll(data: pointer, socket: ptr Socket, events: uint32_t) {.noconv.} =
+  let seen = cast[ptr uint32](data)
+  seen[] = seen[] or events
+
+proc loopback(cli, srv: var ptr Socket): ptr Socket =
+  # Listener, client and accepted end, all in this thread (backlog)
+  var err: serror_t
+  result = bsocket_server(Port, 4, err.addr)
+  cli = bsocket_connect(bsocket_str_ip("127.0.0.1"), Port, 1000, err.addr)
+  srv = bsocket_accept(result, 1000, err.addr)
+
+test "socket stream partial reads are retried after ekSAGAIN":
+  core_start()
+  var cli, srv: ptr Socket
+  var listen = loopback(cli, srv)
+  check listen != nil and cli != nil and srv != nil
+  var input = stm_socket_async(srv)
+  stm_set_read_endian(input, ekLITEND)
+  var seen: uint32
+  var poll = bsocket_poll_create()
+  check bsocket_poll_add_imp(poll, srv, ekSOCK_READ.uint32, seen.addr,
+                             cast[ptr FPtr_sock_event](onPoll)) == TRUE
+
+  # Only half of the u32 arrives
+  var bytes = [1'u8, 2, 3, 4]
+  var wsize: uint32_t
+  var err: serror_t
+  check bsocket_write(cli, bytes[0].addr, 2, wsize.addr, err.addr) == TRUE
+  check bsocket_poll_wait(poll, 2000) >= 1
+  check (seen and ekSOCK_READ.uint32) != 0
+  check stm_sock_recv(input) == 2
+  check stm_read_u32(input) == 0
+  check stm_sock_err(input) == ekSAGAIN
+  check stm_state(input) == ekSTOK
+  # Nothing consumed, the value is never split
+  check stm_sock_available(input) == 2
+
+  # The rest arrives, the same read succeeds
+  seen = 0
+  check bsocket_write(cli, bytes[2].addr, 2, wsize.addr, err.addr) == TRUE
+  check bsocket_poll_wait(poll, 2000) >= 1
+  check (seen and ekSOCK_READ.uint32) != 0
+  check stm_sock_recv(input) == 2
+  check stm_read_u32(input) == 0x04030201'u32
+  check stm_sock_err(input) == ekSOK
+  check stm_state(input) == ekSTOK
+  check stm_sock_available(input) == 0
+
+  bsocket_poll_remove(poll, srv)
+  bsocket_poll_destroy(poll.addr)
+  check poll == nil
+  stm_close(input.addr)
+  bsocket_close(cli.addr)
+  bsocket_close(listen.addr)
+  core_finish()
+
+test "socket stream partial writes and bounded receive buffer":
+  core_start()
+  const Size = 32 shl 20
+  const RecvMax = 4 shl 20
+  var cli, srv: ptr Socket
+  var listen = loopback(cli, srv)
+  var input = stm_socket_async(srv)
+  var output = stm_socket_async(cli)
+  var data = newSeq[byte](Size)
+  for i in 0 ..< Size:
+    data[i] = byte((i * 7) and 0xFF)
+
+  # Async writes stay in the stream until stm_flush
+  stm_write(output, data[0].addr, Size.uint32)
+  check stm_sock_pending(output) == Size.uint32
+  stm_flush(output)
+  # The kernel can't take 32Mb at once, the rest keeps pending
+  check stm_sock_pending(output) > 0
+  check stm_sock_err(output) == ekSOK
+
+  var buf: array[65536, byte]
+  var got, maxAvail, bad = 0
+  while got < Size:
+    stm_flush(output)
+    discard stm_sock_recv(input)
+    var avail = stm_sock_available(input).int
+    maxAvail = max(maxAvail, avail)
+    if avail == 0:
+      bthread_sleep(1)
+      continue
+    while avail > 0:
+      let n = min(avail, buf.len)
+      if stm_read(input, buf[0].addr, n.uint32) != n.uint32:
+        bad += 1
+      for i in 0 ..< n:
+        if buf[i] != data[got + i]:
+          bad += 1
+      got += n
+      avail -= n
+
+  check bad == 0
+  check maxAvail > 0 and maxAvail <= RecvMax
+  check stm_sock_pending(output) == 0
+
+  # Peer closed: once drained, reads end the stream
+  stm_close(output.addr)
+  while stm_sock_closed(input) == FALSE:
+    discard stm_sock_recv(input)
+    bthread_sleep(1)
+  check stm_read_u32(input) == 0
+  check stm_state(input) == ekSTEND
+  stm_close(input.addr)
+  bsocket_close(listen.addr)
+  core_finish()